@@ -0,0 +1,187 @@
+#include "wamble/wamble_client.h"
+
+#define WAMBLE_LZ_HASH_BITS 12
+#define WAMBLE_LZ_MIN_MATCH 4
+#define WAMBLE_LZ_LAST_LITERALS 5
+#define WAMBLE_LZ_MF_LIMIT 12
+#define WAMBLE_LZ_MAX_OFFSET 65535u
+#define WAMBLE_LZ_PREFIX_SIZE 4
+
+static uint32_t lz_read32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static uint32_t lz_hash(uint32_t v) {
+  return (v * 2654435761u) >> (32 - WAMBLE_LZ_HASH_BITS);
+}
+
+static int lz_write_length(uint8_t **op, const uint8_t *oend, size_t len) {
+  while (len >= 255) {
+    if (*op >= oend)
+      return -1;
+    *(*op)++ = 255;
+    len -= 255;
+  }
+  if (*op >= oend)
+    return -1;
+  *(*op)++ = (uint8_t)len;
+  return 0;
+}
+
+static int lz_emit_sequence(uint8_t **op, const uint8_t *oend,
+                            const uint8_t *literals, size_t literal_len,
+                            size_t offset, size_t match_len) {
+  if (*op >= oend)
+    return -1;
+  uint8_t *token = (*op)++;
+  size_t ml = match_len ? match_len - WAMBLE_LZ_MIN_MATCH : 0;
+  *token = (uint8_t)(((literal_len >= 15 ? 15u : literal_len) << 4) |
+                     (ml >= 15 ? 15u : ml));
+  if (literal_len >= 15 && lz_write_length(op, oend, literal_len - 15) != 0)
+    return -1;
+  if ((size_t)(oend - *op) < literal_len)
+    return -1;
+  if (literal_len)
+    memcpy(*op, literals, literal_len);
+  *op += literal_len;
+  if (!match_len)
+    return 0;
+  if (oend - *op < 2)
+    return -1;
+  (*op)[0] = (uint8_t)(offset & 0xFFu);
+  (*op)[1] = (uint8_t)((offset >> 8) & 0xFFu);
+  *op += 2;
+  if (ml >= 15 && lz_write_length(op, oend, ml - 15) != 0)
+    return -1;
+  return 0;
+}
+
+static int lz_read_length(const uint8_t **ip, const uint8_t *iend,
+                          size_t *len) {
+  uint8_t b;
+  do {
+    if (*ip >= iend)
+      return -1;
+    b = *(*ip)++;
+    *len += b;
+  } while (b == 255);
+  return 0;
+}
+
+size_t wamble_lz_compress_bound(size_t src_len) {
+  return WAMBLE_LZ_PREFIX_SIZE + src_len + src_len / 255u + 16u;
+}
+
+int wamble_lz_compress(const uint8_t *src, size_t src_len, uint8_t *dst,
+                       size_t dst_capacity, size_t *out_len) {
+  if ((!src && src_len) || !dst || !out_len || src_len > UINT32_MAX ||
+      dst_capacity < WAMBLE_LZ_PREFIX_SIZE)
+    return -1;
+  uint32_t raw_be = htonl((uint32_t)src_len);
+  memcpy(dst, &raw_be, WAMBLE_LZ_PREFIX_SIZE);
+
+  uint32_t table[1u << WAMBLE_LZ_HASH_BITS];
+  memset(table, 0, sizeof(table));
+  const uint8_t *ip = src;
+  const uint8_t *anchor = src;
+  const uint8_t *iend = src + src_len;
+  uint8_t *op = dst + WAMBLE_LZ_PREFIX_SIZE;
+  const uint8_t *oend = dst + dst_capacity;
+
+  if (src_len > WAMBLE_LZ_MF_LIMIT) {
+    const uint8_t *mflimit = iend - WAMBLE_LZ_MF_LIMIT;
+    const uint8_t *mlimit = iend - WAMBLE_LZ_LAST_LITERALS;
+    while (ip < mflimit) {
+      uint32_t seq = lz_read32(ip);
+      uint32_t h = lz_hash(seq);
+      uint32_t ref_pos = table[h];
+      table[h] = (uint32_t)(ip - src) + 1u;
+      if (ref_pos == 0) {
+        ip++;
+        continue;
+      }
+      const uint8_t *ref = src + ref_pos - 1u;
+      if ((size_t)(ip - ref) > WAMBLE_LZ_MAX_OFFSET || lz_read32(ref) != seq) {
+        ip++;
+        continue;
+      }
+      while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+        ip--;
+        ref--;
+      }
+      const uint8_t *mp = ip + WAMBLE_LZ_MIN_MATCH;
+      const uint8_t *rp = ref + WAMBLE_LZ_MIN_MATCH;
+      while (mp < mlimit && *mp == *rp) {
+        mp++;
+        rp++;
+      }
+      if (lz_emit_sequence(&op, oend, anchor, (size_t)(ip - anchor),
+                           (size_t)(ip - ref), (size_t)(mp - ip)) != 0)
+        return -1;
+      ip = mp;
+      anchor = ip;
+    }
+  }
+  if (lz_emit_sequence(&op, oend, anchor, (size_t)(iend - anchor), 0, 0) != 0)
+    return -1;
+  *out_len = (size_t)(op - dst);
+  return 0;
+}
+
+int wamble_lz_decompressed_len(const uint8_t *src, size_t src_len,
+                               size_t *out_len) {
+  if (!src || !out_len || src_len < WAMBLE_LZ_PREFIX_SIZE + 1u)
+    return -1;
+  uint32_t raw_be = 0;
+  memcpy(&raw_be, src, WAMBLE_LZ_PREFIX_SIZE);
+  *out_len = (size_t)ntohl(raw_be);
+  return 0;
+}
+
+int wamble_lz_decompress(const uint8_t *src, size_t src_len, uint8_t *dst,
+                         size_t dst_capacity, size_t *out_len) {
+  size_t raw_len = 0;
+  if (!out_len || wamble_lz_decompressed_len(src, src_len, &raw_len) != 0 ||
+      raw_len > dst_capacity || (!dst && raw_len))
+    return -1;
+  const uint8_t *ip = src + WAMBLE_LZ_PREFIX_SIZE;
+  const uint8_t *iend = src + src_len;
+  uint8_t *op = dst;
+  const uint8_t *oend = dst + raw_len;
+  while (ip < iend) {
+    uint8_t token = *ip++;
+    size_t literal_len = (size_t)(token >> 4);
+    if (literal_len == 15 && lz_read_length(&ip, iend, &literal_len) != 0)
+      return -1;
+    if (literal_len > (size_t)(iend - ip) || literal_len > (size_t)(oend - op))
+      return -1;
+    if (literal_len)
+      memcpy(op, ip, literal_len);
+    op += literal_len;
+    ip += literal_len;
+    if (ip == iend)
+      break;
+    if (iend - ip < 2)
+      return -1;
+    size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > (size_t)(op - dst))
+      return -1;
+    size_t match_len = (size_t)(token & 0x0Fu);
+    if (match_len == 15 && lz_read_length(&ip, iend, &match_len) != 0)
+      return -1;
+    match_len += WAMBLE_LZ_MIN_MATCH;
+    if (match_len > (size_t)(oend - op))
+      return -1;
+    const uint8_t *match = op - offset;
+    for (size_t i = 0; i < match_len; i++)
+      op[i] = match[i];
+    op += match_len;
+  }
+  if (op != oend)
+    return -1;
+  *out_len = raw_len;
+  return 0;
+}
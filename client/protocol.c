@@ -256,6 +256,9 @@ static NetworkStatus encode_fragment_payload(const struct WambleMsg *msg,
     return NET_ERR_INVALID;
   if (msg->fragment.fragment_hash_algo != WAMBLE_FRAGMENT_HASH_BLAKE2B_256)
     return NET_ERR_INVALID;
+  if (msg->fragment.fragment_codec != WAMBLE_FRAGMENT_CODEC_NONE &&
+      msg->fragment.fragment_codec != WAMBLE_FRAGMENT_CODEC_LZ)
+    return NET_ERR_INVALID;
   if (msg->fragment.fragment_chunk_count == 0 ||
       msg->fragment.fragment_chunk_index >= msg->fragment.fragment_chunk_count)
     return NET_ERR_INVALID;
@@ -268,7 +271,8 @@ static NetworkStatus encode_fragment_payload(const struct WambleMsg *msg,
       return NET_ERR_TRUNCATED;
 
     payload[0] = WAMBLE_FRAGMENT_VERSION;
-    payload[1] = WAMBLE_FRAGMENT_HASH_BLAKE2B_256;
+    payload[1] = (uint8_t)(WAMBLE_FRAGMENT_HASH_BLAKE2B_256 |
+                           msg->fragment.fragment_codec);
     {
       uint16_t idx_be = htons(msg->fragment.fragment_chunk_index);
       uint16_t count_be = htons(msg->fragment.fragment_chunk_count);
@@ -318,12 +322,17 @@ static NetworkStatus decode_fragment_payload(const uint8_t *payload,
          WAMBLE_FRAGMENT_HASH_LENGTH);
   memcpy(&chunk_len_be, payload + 14 + WAMBLE_FRAGMENT_HASH_LENGTH, 2);
   msg->fragment.fragment_version = WAMBLE_FRAGMENT_VERSION;
-  msg->fragment.fragment_hash_algo = hash_algo;
+  msg->fragment.fragment_hash_algo =
+      (uint8_t)(hash_algo & WAMBLE_FRAGMENT_HASH_ALGO_MASK);
+  msg->fragment.fragment_codec =
+      (uint8_t)(hash_algo & WAMBLE_FRAGMENT_CODEC_MASK);
   msg->fragment.fragment_chunk_index = ntohs(chunk_index_be);
   msg->fragment.fragment_chunk_count = ntohs(chunk_count_be);
   msg->fragment.fragment_total_len = ntohl(total_be);
   msg->fragment.fragment_transfer_id = ntohl(transfer_id_be);
-  if (msg->fragment.fragment_hash_algo != WAMBLE_FRAGMENT_HASH_BLAKE2B_256)
+  if (msg->fragment.fragment_hash_algo != WAMBLE_FRAGMENT_HASH_BLAKE2B_256 ||
+      (msg->fragment.fragment_codec != WAMBLE_FRAGMENT_CODEC_NONE &&
+       msg->fragment.fragment_codec != WAMBLE_FRAGMENT_CODEC_LZ))
     return NET_ERR_INVALID;
   {
     size_t chunk_len = (size_t)ntohs(chunk_len_be);
@@ -410,8 +419,18 @@ NetworkStatus wamble_payload_serialize(const struct WambleMsg *msg,
 
   size_t body_len = 0;
   switch (msg->ctrl) {
-  case WAMBLE_CTRL_CLIENT_HELLO:
   case WAMBLE_CTRL_ACK:
+    if (msg->ack.cumulative_seq != 0 || msg->ack.bitmap != 0) {
+      uint32_t cumulative_be = htonl(msg->ack.cumulative_seq);
+      uint32_t bitmap_be = htonl(msg->ack.bitmap);
+      if (payload_capacity < WAMBLE_ACK_PAYLOAD_SIZE)
+        return NET_ERR_TRUNCATED;
+      memcpy(payload, &cumulative_be, 4);
+      memcpy(payload + 4, &bitmap_be, 4);
+      body_len = WAMBLE_ACK_PAYLOAD_SIZE;
+    }
+    break;
+  case WAMBLE_CTRL_CLIENT_HELLO:
   case WAMBLE_CTRL_LIST_PROFILES:
   case WAMBLE_CTRL_CLIENT_GOODBYE:
   case WAMBLE_CTRL_LOGOUT:
@@ -1157,6 +1176,16 @@ NetworkStatus wamble_packet_serialize(const struct WambleMsg *msg,
   if (payload_status != NET_OK)
     return payload_status;
   hdr.flags |= transport_flags;
+  if (msg->ack.highest_seq != 0 && msg->ctrl != WAMBLE_CTRL_ACK &&
+      payload_len + WAMBLE_ACK_TRAILER_SIZE <= sizeof(payload)) {
+    uint32_t trailer[3];
+    trailer[0] = htonl(msg->ack.highest_seq);
+    trailer[1] = htonl(msg->ack.cumulative_seq);
+    trailer[2] = htonl(msg->ack.bitmap);
+    memcpy(payload + payload_len, trailer, WAMBLE_ACK_TRAILER_SIZE);
+    payload_len += WAMBLE_ACK_TRAILER_SIZE;
+    hdr.reserved = WAMBLE_HEADER_OPT_ACK_TRAILER;
+  }
   hdr.payload_len = htons((uint16_t)payload_len);
 
   if (WAMBLE_HEADER_SIZE + payload_len > buffer_capacity)
@@ -1170,40 +1199,102 @@ NetworkStatus wamble_packet_serialize(const struct WambleMsg *msg,
   return NET_OK;
 }
 
-NetworkStatus wamble_packet_deserialize(const uint8_t *buffer,
-                                        size_t buffer_size,
-                                        struct WambleMsg *msg,
-                                        uint8_t *out_flags) {
-  if (!buffer || buffer_size < WAMBLE_HEADER_SIZE || !msg)
+NetworkStatus wamble_msg_view_parse(const uint8_t *buffer, size_t buffer_size,
+                                    WambleMsgView *view) {
+  if (!buffer || buffer_size < WAMBLE_HEADER_SIZE || !view)
     return NET_ERR_INVALID;
 
   WambleHeader hdr;
   memcpy(&hdr, buffer, sizeof(hdr));
-  if (hdr.reserved != 0)
+  if ((hdr.reserved & (uint8_t)~WAMBLE_HEADER_OPT_ACK_TRAILER) != 0)
     return NET_ERR_INVALID;
 
   size_t payload_len = ntohs(hdr.payload_len);
   if (buffer_size < WAMBLE_HEADER_SIZE + payload_len)
     return NET_ERR_TRUNCATED;
 
-  memset(msg, 0, sizeof(*msg));
-  msg->ctrl = hdr.ctrl;
-  msg->flags = hdr.flags;
-  memcpy(msg->token, hdr.token, TOKEN_LENGTH);
-  msg->board_id = wamble_net_to_host64(hdr.board_id);
-  msg->seq_num = ntohl(hdr.seq_num);
-  msg->header_version = hdr.version;
-  if (out_flags)
-    *out_flags = hdr.flags;
+  memset(&view->ack, 0, sizeof(view->ack));
+  if (hdr.reserved & WAMBLE_HEADER_OPT_ACK_TRAILER) {
+    uint32_t trailer[3];
+    if (hdr.ctrl == WAMBLE_CTRL_ACK || payload_len < WAMBLE_ACK_TRAILER_SIZE)
+      return NET_ERR_INVALID;
+    payload_len -= WAMBLE_ACK_TRAILER_SIZE;
+    memcpy(trailer, buffer + WAMBLE_HEADER_SIZE + payload_len,
+           WAMBLE_ACK_TRAILER_SIZE);
+    view->ack.highest_seq = ntohl(trailer[0]);
+    view->ack.cumulative_seq = ntohl(trailer[1]);
+    view->ack.bitmap = ntohl(trailer[2]);
+  } else if (hdr.ctrl == WAMBLE_CTRL_ACK) {
+    view->ack.highest_seq = ntohl(hdr.seq_num);
+    if (payload_len == WAMBLE_ACK_PAYLOAD_SIZE) {
+      uint32_t selective[2];
+      memcpy(selective, buffer + WAMBLE_HEADER_SIZE, WAMBLE_ACK_PAYLOAD_SIZE);
+      view->ack.cumulative_seq = ntohl(selective[0]);
+      view->ack.bitmap = ntohl(selective[1]);
+      payload_len = 0;
+    }
+  }
+
+  view->ctrl = hdr.ctrl;
+  view->flags = hdr.flags;
+  view->header_version = hdr.version;
+  view->board_id = wamble_net_to_host64(hdr.board_id);
+  view->seq_num = ntohl(hdr.seq_num);
+  view->token = buffer + offsetof(WambleHeader, token);
+  view->payload = buffer + WAMBLE_HEADER_SIZE;
+  view->payload_len = payload_len;
+  return NET_OK;
+}
+
+static void msg_reset_for_decode(struct WambleMsg *msg) {
+  msg->text.uci_len = 0;
+  msg->text.profile_name_len = 0;
+  msg->text.profile_name[0] = '\0';
+  msg->text.profile_info_len = 0;
+  msg->text.profile_info[0] = '\0';
+  memset(&msg->fragment, 0, offsetof(WambleMsgFragmentPayload, fragment_data));
+  msg->view.profiles_list_len = 0;
+  msg->view.profiles_list[0] = '\0';
+  msg->view.fen[0] = '\0';
+  msg->view.error_code = 0;
+  msg->view.error_reason[0] = '\0';
+  memset(msg->login.public_key, 0, sizeof(msg->login.public_key));
+  msg->login.has_signature = 0;
+  memset(&msg->stats.player_stats, 0, sizeof(msg->stats.player_stats));
+  msg->stats.legal_moves.square = 0;
+  msg->stats.legal_moves.count = 0;
+  msg->leaderboard_payload.type = 0;
+  msg->leaderboard_payload.limit = 0;
+  msg->leaderboard_payload.count = 0;
+  msg->leaderboard_payload.self_rank = 0;
+  wamble_msg_release_dynamic(msg);
+  msg->prediction.parent_id = 0;
+  msg->prediction.depth = 0;
+  msg->prediction.limit = 0;
+  msg->prediction.count = 0;
+  memset(&msg->session, 0, sizeof(msg->session));
+  msg->extensions.count = 0;
+}
 
-  const uint8_t *payload = buffer + WAMBLE_HEADER_SIZE;
-  int has_ext_payload = (hdr.flags & WAMBLE_FLAG_EXT_PAYLOAD) != 0;
-  int has_fragment_payload = (hdr.flags & WAMBLE_FLAG_FRAGMENT_PAYLOAD) != 0;
+static NetworkStatus decode_msg_view_body(const WambleMsgView *view,
+                                          struct WambleMsg *msg) {
+  msg->ctrl = view->ctrl;
+  msg->flags = view->flags;
+  memcpy(msg->token, view->token, TOKEN_LENGTH);
+  msg->board_id = view->board_id;
+  msg->seq_num = view->seq_num;
+  msg->header_version = view->header_version;
+  msg->ack = view->ack;
+
+  const uint8_t *payload = view->payload;
+  size_t payload_len = view->payload_len;
+  int has_ext_payload = (view->flags & WAMBLE_FLAG_EXT_PAYLOAD) != 0;
+  int has_fragment_payload = (view->flags & WAMBLE_FLAG_FRAGMENT_PAYLOAD) != 0;
   if (has_ext_payload && has_fragment_payload)
     return NET_ERR_INVALID;
   if (has_fragment_payload) {
     int is_fragmented = 0;
-    if (!ctrl_supports_fragment_payload(hdr.ctrl))
+    if (!ctrl_supports_fragment_payload(view->ctrl))
       return NET_ERR_INVALID;
     {
       NetworkStatus frag_status =
@@ -1217,7 +1308,7 @@ NetworkStatus wamble_packet_deserialize(const uint8_t *buffer,
     size_t preview_copy = msg->fragment.fragment_data_len;
     if (preview_copy > FEN_MAX_LENGTH - 1)
       preview_copy = FEN_MAX_LENGTH - 1;
-    switch (hdr.ctrl) {
+    switch (view->ctrl) {
     case WAMBLE_CTRL_SERVER_HELLO:
     case WAMBLE_CTRL_LOGIN_SUCCESS:
     case WAMBLE_CTRL_BOARD_UPDATE:
@@ -1276,7 +1367,77 @@ NetworkStatus wamble_packet_deserialize(const uint8_t *buffer,
     }
     return NET_OK;
   }
-  return decode_message_payload(hdr.ctrl, hdr.flags, payload, payload_len, msg);
+  return decode_message_payload(view->ctrl, view->flags, payload, payload_len, msg);
+}
+
+NetworkStatus wamble_msg_view_decode(const WambleMsgView *view,
+                                     struct WambleMsg *msg) {
+  if (!view || !view->token || !msg)
+    return NET_ERR_INVALID;
+  msg_reset_for_decode(msg);
+  return decode_msg_view_body(view, msg);
+}
+
+NetworkStatus wamble_packet_deserialize(const uint8_t *buffer,
+                                        size_t buffer_size,
+                                        struct WambleMsg *msg,
+                                        uint8_t *out_flags) {
+  WambleMsgView view;
+  if (!msg)
+    return NET_ERR_INVALID;
+  NetworkStatus status = wamble_msg_view_parse(buffer, buffer_size, &view);
+  if (status != NET_OK)
+    return status;
+  memset(msg, 0, sizeof(*msg));
+  if (out_flags)
+    *out_flags = view.flags;
+  return decode_msg_view_body(&view, msg);
+}
+
+int wamble_ack_state_record(WambleAckState *state, uint32_t seq) {
+  if (!state || seq == 0)
+    return 0;
+  if (state->highest_seq == 0) {
+    state->highest_seq = seq;
+    state->bitmap = 0;
+  } else if (seq != state->highest_seq &&
+             (uint32_t)(seq - state->highest_seq) < 0x80000000u) {
+    uint32_t shift = seq - state->highest_seq;
+    if (shift > WAMBLE_ACK_BITMAP_BITS)
+      state->bitmap = 0;
+    else if (shift == WAMBLE_ACK_BITMAP_BITS)
+      state->bitmap = 1u << (shift - 1u);
+    else
+      state->bitmap = (state->bitmap << shift) | (1u << (shift - 1u));
+    state->highest_seq = seq;
+  } else if (seq != state->highest_seq) {
+    uint32_t distance = state->highest_seq - seq;
+    if (distance <= WAMBLE_ACK_BITMAP_BITS)
+      state->bitmap |= 1u << (distance - 1u);
+  }
+  while (state->cumulative_seq != state->highest_seq) {
+    uint32_t next = state->cumulative_seq + 1u;
+    uint32_t distance = state->highest_seq - next;
+    if (distance != 0 && (distance > WAMBLE_ACK_BITMAP_BITS ||
+                          (state->bitmap & (1u << (distance - 1u))) == 0))
+      break;
+    state->cumulative_seq = next;
+  }
+  return wamble_ack_state_covers(state, seq);
+}
+
+int wamble_ack_state_covers(const WambleAckState *state, uint32_t seq) {
+  if (!state || seq == 0 || state->highest_seq == 0)
+    return 0;
+  if (seq == state->highest_seq)
+    return 1;
+  if (state->cumulative_seq != 0 &&
+      (uint32_t)(state->cumulative_seq - seq) < 0x80000000u)
+    return 1;
+  uint32_t distance = state->highest_seq - seq;
+  if (distance == 0 || distance > WAMBLE_ACK_BITMAP_BITS)
+    return 0;
+  return (state->bitmap & (1u << (distance - 1u))) != 0;
 }
 
 void format_token_for_url(const uint8_t *token, char *url_buffer) {
@@ -1332,6 +1493,7 @@ typedef struct WambleFragmentReassemblyState {
   uint8_t active;
   uint8_t ctrl;
   uint8_t hash_algo;
+  uint8_t codec;
   uint16_t chunk_count;
   uint16_t received_chunks;
   uint32_t total_len;
@@ -1342,6 +1504,9 @@ typedef struct WambleFragmentReassemblyState {
   size_t data_capacity;
   uint8_t *chunk_seen;
   size_t chunk_seen_capacity;
+  uint8_t *plain;
+  size_t plain_capacity;
+  size_t plain_len;
 } WambleFragmentReassemblyState;
 
 static WambleFragmentReassemblyState *
@@ -1377,6 +1542,8 @@ void wamble_fragment_reassembly_reset(WambleFragmentReassembly *reassembly) {
   state->active = 0;
   state->ctrl = 0;
   state->hash_algo = 0;
+  state->codec = 0;
+  state->plain_len = 0;
   state->chunk_count = 0;
   state->received_chunks = 0;
   state->total_len = 0;
@@ -1394,6 +1561,7 @@ void wamble_fragment_reassembly_free(WambleFragmentReassembly *reassembly) {
   if (state) {
     free(state->data);
     free(state->chunk_seen);
+    free(state->plain);
     free(state);
   }
   wamble_fragment_reassembly_init(reassembly);
@@ -1415,6 +1583,11 @@ const uint8_t *
 wamble_fragment_reassembly_data(const WambleFragmentReassembly *reassembly,
                                 size_t *out_len) {
   WambleFragmentReassemblyState *state = reassembly_state(reassembly);
+  if (state && state->codec != WAMBLE_FRAGMENT_CODEC_NONE) {
+    if (out_len)
+      *out_len = state->plain_len;
+    return state->plain;
+  }
   if (out_len)
     *out_len = state ? (size_t)state->total_len : 0;
   return state ? state->data : NULL;
@@ -1492,6 +1665,8 @@ static int reassembly_begin_transfer(WambleFragmentReassemblyState *state,
   state->active = 1;
   state->ctrl = msg->ctrl;
   state->hash_algo = msg->fragment.fragment_hash_algo;
+  state->codec = msg->fragment.fragment_codec;
+  state->plain_len = 0;
   state->chunk_count = msg->fragment.fragment_chunk_count;
   state->received_chunks = 0;
   state->total_len = msg->fragment.fragment_total_len;
@@ -1502,6 +1677,21 @@ static int reassembly_begin_transfer(WambleFragmentReassemblyState *state,
   return 0;
 }
 
+static int reassembly_decompress(WambleFragmentReassemblyState *state) {
+  size_t plain_len = 0;
+  if (state->codec != WAMBLE_FRAGMENT_CODEC_LZ ||
+      wamble_lz_decompressed_len(state->data, (size_t)state->total_len,
+                                 &plain_len) != 0 ||
+      plain_len > WAMBLE_FRAGMENT_REASSEMBLY_MAX)
+    return -1;
+  if (reassembly_ensure_capacity(&state->plain, &state->plain_capacity,
+                                 plain_len ? plain_len : 1u, 0) != 0)
+    return -1;
+  return wamble_lz_decompress(state->data, (size_t)state->total_len,
+                              state->plain, state->plain_capacity,
+                              &state->plain_len);
+}
+
 static int reassembly_payload_base_len(const uint8_t *payload,
                                        size_t payload_len,
                                        size_t *out_base_len) {
@@ -1536,6 +1726,7 @@ wamble_fragment_reassembly_push(WambleFragmentReassembly *reassembly,
   int same_transfer =
       state->active && state->ctrl == msg->ctrl &&
       state->hash_algo == msg->fragment.fragment_hash_algo &&
+      state->codec == msg->fragment.fragment_codec &&
       state->chunk_count == msg->fragment.fragment_chunk_count &&
       state->total_len == msg->fragment.fragment_total_len &&
       state->transfer_id == msg->fragment.fragment_transfer_id &&
@@ -1570,6 +1761,18 @@ wamble_fragment_reassembly_push(WambleFragmentReassembly *reassembly,
   if (memcmp(computed_hash, state->expected_hash,
              WAMBLE_FRAGMENT_HASH_LENGTH) == 0) {
     state->integrity = WAMBLE_FRAGMENT_INTEGRITY_OK;
+    if (state->codec != WAMBLE_FRAGMENT_CODEC_NONE) {
+      if (reassembly_decompress(state) != 0) {
+        state->integrity = WAMBLE_FRAGMENT_INTEGRITY_MISMATCH;
+        return WAMBLE_FRAGMENT_REASSEMBLY_ERR_INVALID;
+      }
+      size_t base_len = 0;
+      if (state->ctrl == WAMBLE_CTRL_PROFILE_TOS_DATA &&
+          reassembly_payload_base_len(state->plain, state->plain_len,
+                                      &base_len))
+        state->plain_len = base_len;
+      return WAMBLE_FRAGMENT_REASSEMBLY_COMPLETE;
+    }
     if (state->ctrl == WAMBLE_CTRL_PROFILE_TOS_DATA) {
       size_t base_len = 0;
       if (reassembly_payload_base_len(state->data, (size_t)state->total_len,
@@ -1,5 +1,59 @@
 #include "wamble/wamble_client.h"
 
+static int client_send_raw(wamble_client_t *c, struct WambleMsg *msg);
+
+static void client_reset_ack_state(wamble_client_t *c) {
+  c->udp_rx_len = 0;
+  c->requested_caps = 0;
+  c->caps = 0;
+  c->ack_pending = 0;
+  memset(&c->ack_state, 0, sizeof(c->ack_state));
+  memset(c->ack_token, 0, sizeof(c->ack_token));
+  c->ack_board_id = 0;
+}
+
+static void client_note_inbound(wamble_client_t *c,
+                                const struct WambleMsg *msg) {
+  if (msg->ctrl == WAMBLE_CTRL_SERVER_HELLO)
+    c->caps =
+        (uint8_t)(c->requested_caps & msg->flags & WAMBLE_CAPABILITY_MASK);
+}
+
+static int client_serialize_outbound(wamble_client_t *c, struct WambleMsg *msg,
+                                     uint8_t *buf, size_t cap,
+                                     size_t *out_len) {
+  int piggyback = c->ack_pending && msg->ctrl != WAMBLE_CTRL_ACK;
+  if (msg->ctrl == WAMBLE_CTRL_CLIENT_HELLO)
+    c->requested_caps = (uint8_t)(msg->flags & WAMBLE_CAPABILITY_MASK);
+  if (piggyback)
+    msg->ack = c->ack_state;
+  NetworkStatus status =
+      wamble_packet_serialize(msg, buf, cap, out_len, msg->flags);
+  if (piggyback)
+    memset(&msg->ack, 0, sizeof(msg->ack));
+  if (status != NET_OK)
+    return -1;
+  if (piggyback && (buf[3] & WAMBLE_HEADER_OPT_ACK_TRAILER) != 0)
+    c->ack_pending = 0;
+  return 0;
+}
+
+static int client_flush_acks(wamble_client_t *c) {
+  struct WambleMsg ack;
+  if (!c->ack_pending)
+    return 0;
+  memset(&ack, 0, sizeof(ack));
+  ack.ctrl = WAMBLE_CTRL_ACK;
+  memcpy(ack.token, c->ack_token, TOKEN_LENGTH);
+  ack.board_id = c->ack_board_id;
+  ack.seq_num = c->ack_state.highest_seq;
+  ack.ack = c->ack_state;
+  if (client_send_raw(c, &ack) != 0)
+    return -1;
+  c->ack_pending = 0;
+  return 0;
+}
+
 #if defined(WAMBLE_PLATFORM_WASM)
 /* ---- WASM transport: Emscripten WebSocket API + ring buffer ---- */
 #include <emscripten/emscripten.h>
@@ -169,6 +223,20 @@ static int wasm_client_send_msg(struct WambleMsg *msg) {
   return (r == EMSCRIPTEN_RESULT_SUCCESS) ? 0 : -1;
 }
 
+static int wasm_client_send_packet(const uint8_t *buf, size_t len) {
+  if (!wasm_ws_connected || !wasm_ws_handle)
+    return -1;
+  EMSCRIPTEN_RESULT r =
+      emscripten_websocket_send_binary(wasm_ws_handle, (void *)buf,
+                                       (uint32_t)len);
+  return (r == EMSCRIPTEN_RESULT_SUCCESS) ? 0 : -1;
+}
+
+static int client_send_raw(wamble_client_t *c, struct WambleMsg *msg) {
+  (void)c;
+  return wasm_client_send_msg(msg);
+}
+
 static int wasm_client_recv_msg(struct WambleMsg *out) {
   return wasm_ring_pop(out);
 }
@@ -197,6 +265,7 @@ static WambleClientStatus wasm_client_init_ws(wamble_client_t *c,
   c->sock = sock;
   memset(&c->peer, 0, sizeof(c->peer));
   c->seq = 0;
+  client_reset_ack_state(c);
   return (WambleClientStatus){WAMBLE_CLIENT_STATUS_OK, 0};
 }
 static WambleClientStatus wasm_client_connect_web(wamble_client_t *c,
@@ -214,8 +283,11 @@ static WambleClientStatus wasm_client_send(wamble_client_t *c,
                                            struct WambleMsg *msg) {
   if (!c || !msg || c->kind != WAMBLE_TRANSPORT_WS)
     return (WambleClientStatus){WAMBLE_CLIENT_STATUS_INVALID_ARGUMENT, 0};
+  uint8_t buf[WAMBLE_MAX_PACKET_SIZE];
+  size_t len = 0;
   msg->seq_num = c->seq++;
-  if (wasm_client_send_msg(msg) != 0)
+  if (client_serialize_outbound(c, msg, buf, sizeof(buf), &len) != 0 ||
+      wasm_client_send_packet(buf, len) != 0)
     return (WambleClientStatus){WAMBLE_CLIENT_STATUS_NETWORK, 0};
   return (WambleClientStatus){WAMBLE_CLIENT_STATUS_OK, 0};
 }
@@ -224,8 +296,12 @@ wasm_client_recv(wamble_client_t *c, struct WambleMsg *out, int timeout_ms) {
   (void)timeout_ms;
   if (!c || !out || c->kind != WAMBLE_TRANSPORT_WS)
     return (WambleClientStatus){WAMBLE_CLIENT_STATUS_INVALID_ARGUMENT, 0};
-  if (wasm_client_recv_msg(out) == 0)
+  if (wasm_client_recv_msg(out) == 0) {
+    client_note_inbound(c, out);
     return (WambleClientStatus){WAMBLE_CLIENT_STATUS_OK, 0};
+  }
+  if (client_flush_acks(c) != 0)
+    return (WambleClientStatus){WAMBLE_CLIENT_STATUS_NETWORK, 0};
   return (WambleClientStatus){WAMBLE_CLIENT_STATUS_TIMEOUT, 0};
 }
 static void wasm_client_shutdown(wamble_client_t *c) {
@@ -587,13 +663,8 @@ static wamble_socket_t udp_open(void) {
   return sock;
 }
 
-static int udp_send(wamble_socket_t sock, struct WambleMsg *msg,
+static int udp_send(wamble_socket_t sock, const uint8_t *buf, size_t len,
                     const struct sockaddr_in *server) {
-  uint8_t buf[WAMBLE_MAX_PACKET_SIZE];
-  size_t len = 0;
-  if (wamble_packet_serialize(msg, buf, sizeof(buf), &len, msg->flags) !=
-      NET_OK)
-    return -1;
 #ifdef WAMBLE_PLATFORM_WINDOWS
   int rc = sendto(sock, (const char *)buf, (int)len, 0,
                   (const struct sockaddr *)server, (int)sizeof(*server));
@@ -634,14 +705,11 @@ static int udp_recv_msg(wamble_socket_t sock, struct WambleMsg *out_msg,
   return 0;
 }
 
-static int udp_send_reliable(wamble_socket_t sock, struct WambleMsg *msg,
-                             const struct sockaddr_in *server, int timeout_ms,
-                             int max_retries) {
-  uint8_t buf[WAMBLE_MAX_PACKET_SIZE];
-  size_t len = 0;
-  if (wamble_packet_serialize(msg, buf, sizeof(buf), &len, msg->flags) !=
-      NET_OK)
-    return -1;
+static int udp_send_reliable(wamble_client_t *c, const uint8_t *buf,
+                             size_t len, const struct WambleMsg *msg,
+                             int timeout_ms, int max_retries) {
+  wamble_socket_t sock = c->sock;
+  const struct sockaddr_in *server = &c->peer;
   int current_timeout = timeout_ms;
   for (int attempt = 0; attempt < max_retries; attempt++) {
 #ifdef WAMBLE_PLATFORM_WINDOWS
@@ -673,9 +741,12 @@ static int udp_send_reliable(wamble_socket_t sock, struct WambleMsg *msg,
         uint8_t ack_flags = 0;
         if (wamble_packet_deserialize(ack_buf, (size_t)rcv, &ack_msg,
                                       &ack_flags) == NET_OK &&
-            ack_msg.ctrl == WAMBLE_CTRL_ACK &&
-            ack_msg.seq_num == msg->seq_num &&
+            wamble_ack_state_covers(&ack_msg.ack, msg->seq_num) &&
             memcmp(ack_msg.token, msg->token, TOKEN_LENGTH) == 0) {
+          if (ack_msg.ctrl != WAMBLE_CTRL_ACK && c->udp_rx_len == 0) {
+            memcpy(c->udp_rx_buf, ack_buf, (size_t)rcv);
+            c->udp_rx_len = (size_t)rcv;
+          }
           return 0;
         }
       }
@@ -697,6 +768,7 @@ static int native_client_init_ws(wamble_client_t *c, wamble_socket_t sock) {
   c->seq = 0;
   c->ws_rx_len = 0;
   c->ws_rx_offset = 0;
+  client_reset_ack_state(c);
   return 0;
 }
 
@@ -728,6 +800,7 @@ static int native_client_init_udp(wamble_client_t *c,
   c->seq = 1;
   c->ws_rx_len = 0;
   c->ws_rx_offset = 0;
+  client_reset_ack_state(c);
   return 0;
 }
 
@@ -765,27 +838,35 @@ static int native_client_connect_udp(wamble_client_t *c, const char *host,
   return native_client_init_udp(c, &server);
 }
 
+static int client_send_raw(wamble_client_t *c, struct WambleMsg *msg) {
+  uint8_t buf[WAMBLE_MAX_PACKET_SIZE];
+  size_t len = 0;
+  if (wamble_packet_serialize(msg, buf, sizeof(buf), &len, msg->flags) !=
+      NET_OK)
+    return -1;
+  if (c->kind == WAMBLE_TRANSPORT_WS)
+    return native_ws_send_frame(c->sock, 0x2u, buf, len, 0);
+  if (c->kind == WAMBLE_TRANSPORT_UDP)
+    return udp_send(c->sock, buf, len, &c->peer);
+  return -1;
+}
+
 static int native_client_send(wamble_client_t *c, struct WambleMsg *msg) {
   if (!c || !msg)
     return -1;
-  if (c->kind == WAMBLE_TRANSPORT_WS) {
-    msg->seq_num = c->seq++;
-    uint8_t buf[WAMBLE_MAX_PACKET_SIZE];
-    size_t len = 0;
-    if (wamble_packet_serialize(msg, buf, sizeof(buf), &len, msg->flags) !=
-        NET_OK)
-      return -1;
+  if (c->kind != WAMBLE_TRANSPORT_WS && c->kind != WAMBLE_TRANSPORT_UDP)
+    return -1;
+  uint8_t buf[WAMBLE_MAX_PACKET_SIZE];
+  size_t len = 0;
+  msg->seq_num = c->seq++;
+  if (client_serialize_outbound(c, msg, buf, sizeof(buf), &len) != 0)
+    return -1;
+  if (c->kind == WAMBLE_TRANSPORT_WS)
     return native_ws_send_frame(c->sock, 0x2u, buf, len, 0);
-  }
-  if (c->kind == WAMBLE_TRANSPORT_UDP) {
-    msg->seq_num = c->seq++;
-    if (msg->flags & WAMBLE_FLAG_UNRELIABLE)
-      return udp_send(c->sock, msg, &c->peer);
-    return udp_send_reliable(c->sock, msg, &c->peer,
-                             WAMBLE_CLIENT_DEFAULT_TIMEOUT_MS,
-                             WAMBLE_CLIENT_DEFAULT_MAX_RETRIES);
-  }
-  return -1;
+  if (msg->flags & WAMBLE_FLAG_UNRELIABLE)
+    return udp_send(c->sock, buf, len, &c->peer);
+  return udp_send_reliable(c, buf, len, msg, WAMBLE_CLIENT_DEFAULT_TIMEOUT_MS,
+                           WAMBLE_CLIENT_DEFAULT_MAX_RETRIES);
 }
 
 static int native_client_recv_ws_packet(wamble_client_t *c,
@@ -829,8 +910,12 @@ static int native_client_recv(wamble_client_t *c, struct WambleMsg *out,
     return -1;
   if (c->kind == WAMBLE_TRANSPORT_WS) {
     int buffered_rc = native_client_recv_ws_packet(c, out);
+    if (buffered_rc == 0)
+      client_note_inbound(c, out);
     if (buffered_rc <= 0)
       return buffered_rc;
+    if (client_flush_acks(c) != 0)
+      return -1;
 
     uint8_t buf[WAMBLE_CLIENT_WS_FRAME_MAX];
     uint8_t opcode = 0;
@@ -846,10 +931,29 @@ static int native_client_recv(wamble_client_t *c, struct WambleMsg *out,
     memcpy(c->ws_rx_buf, buf, len);
     c->ws_rx_len = len;
     c->ws_rx_offset = 0;
-    return native_client_recv_ws_packet(c, out);
+    int rc = native_client_recv_ws_packet(c, out);
+    if (rc == 0)
+      client_note_inbound(c, out);
+    return rc;
+  }
+  if (c->kind == WAMBLE_TRANSPORT_UDP) {
+    int rc = 0;
+    if (c->udp_rx_len > 0) {
+      uint8_t flags = 0;
+      rc = wamble_packet_deserialize(c->udp_rx_buf, c->udp_rx_len, out,
+                                     &flags) == NET_OK
+               ? 0
+               : -1;
+      c->udp_rx_len = 0;
+    } else {
+      if (client_flush_acks(c) != 0)
+        return -1;
+      rc = udp_recv_msg(c->sock, out, NULL, timeout_ms);
+    }
+    if (rc == 0)
+      client_note_inbound(c, out);
+    return rc;
   }
-  if (c->kind == WAMBLE_TRANSPORT_UDP)
-    return udp_recv_msg(c->sock, out, NULL, timeout_ms);
   return -1;
 }
 
@@ -1107,6 +1211,40 @@ WambleClientStatus wamble_client_recv(wamble_client_t *c, struct WambleMsg *out,
 #endif
 }
 
+WambleClientStatus wamble_client_ack(wamble_client_t *c,
+                                     const struct WambleMsg *msg) {
+  if (!c || !msg)
+    return (WambleClientStatus){WAMBLE_CLIENT_STATUS_INVALID_ARGUMENT, 0};
+  if (msg->ctrl == WAMBLE_CTRL_ACK || (msg->flags & WAMBLE_FLAG_UNRELIABLE))
+    return (WambleClientStatus){WAMBLE_CLIENT_STATUS_OK, 0};
+  if ((c->caps & WAMBLE_CAP_SELECTIVE_ACK) && msg->seq_num != 0 &&
+      wamble_ack_state_record(&c->ack_state, msg->seq_num)) {
+    memcpy(c->ack_token, msg->token, TOKEN_LENGTH);
+    c->ack_board_id = msg->board_id;
+    c->ack_pending = 1;
+    return (WambleClientStatus){WAMBLE_CLIENT_STATUS_OK, 0};
+  }
+  struct WambleMsg ack;
+  memset(&ack, 0, sizeof(ack));
+  ack.ctrl = WAMBLE_CTRL_ACK;
+  memcpy(ack.token, msg->token, TOKEN_LENGTH);
+  ack.board_id = msg->board_id;
+  ack.seq_num = msg->seq_num;
+  if (client_send_raw(c, &ack) != 0)
+    return (WambleClientStatus){WAMBLE_CLIENT_STATUS_NETWORK,
+                                wamble_last_error()};
+  return (WambleClientStatus){WAMBLE_CLIENT_STATUS_OK, 0};
+}
+
+WambleClientStatus wamble_client_flush_acks(wamble_client_t *c) {
+  if (!c)
+    return (WambleClientStatus){WAMBLE_CLIENT_STATUS_INVALID_ARGUMENT, 0};
+  if (client_flush_acks(c) != 0)
+    return (WambleClientStatus){WAMBLE_CLIENT_STATUS_NETWORK,
+                                wamble_last_error()};
+  return (WambleClientStatus){WAMBLE_CLIENT_STATUS_OK, 0};
+}
+
 void wamble_client_close(wamble_client_t *c) {
 #if defined(WAMBLE_PLATFORM_WASM)
   wasm_client_shutdown(c);
@@ -421,6 +421,12 @@ static inline int wamble_cond_broadcast(wamble_cond_t *cond) {
   (void)cond;
   return 0;
 }
+static inline uint64_t wamble_atomic_load_u64(volatile uint64_t *value) {
+  return *value;
+}
+static inline void wamble_atomic_inc_u64(volatile uint64_t *value) {
+  (*value)++;
+}
 #elif defined(_WIN32)
 
 typedef HANDLE wamble_thread_t;
@@ -491,6 +497,15 @@ static inline int wamble_cond_broadcast(wamble_cond_t *cond) {
   return 0;
 }
 
+static inline uint64_t wamble_atomic_load_u64(volatile uint64_t *value) {
+  return (uint64_t)InterlockedCompareExchange64((volatile LONG64 *)value, 0,
+                                                0);
+}
+
+static inline void wamble_atomic_inc_u64(volatile uint64_t *value) {
+  (void)InterlockedIncrement64((volatile LONG64 *)value);
+}
+
 #else
 typedef pthread_t wamble_thread_t;
 typedef pthread_mutex_t wamble_mutex_t;
@@ -545,6 +560,14 @@ static inline int wamble_cond_signal(wamble_cond_t *cond) {
 static inline int wamble_cond_broadcast(wamble_cond_t *cond) {
   return pthread_cond_broadcast(cond);
 }
+
+static inline uint64_t wamble_atomic_load_u64(volatile uint64_t *value) {
+  return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+static inline void wamble_atomic_inc_u64(volatile uint64_t *value) {
+  (void)__atomic_add_fetch(value, 1, __ATOMIC_RELEASE);
+}
 #endif
 
 typedef struct WambleConfig {
@@ -558,8 +581,10 @@ typedef struct WambleConfig {
   int rto_cap_ms;
   int max_message_size;
   int buffer_size;
+  int udp_segment_offload;
   int terminal_cache_ttl_ms;
   int rate_limit_requests_per_sec;
+  int rate_limit_addr_packets_per_sec;
   int session_timeout;
   int max_boards;
   int min_boards;
@@ -587,6 +612,7 @@ typedef struct WambleConfig {
   int max_token_local_attempts;
   int persistence_max_intents;
   int persistence_max_payload_bytes;
+  int response_cache_bytes;
   double new_player_early_phase_mult;
   double new_player_mid_phase_mult;
   double new_player_end_phase_mult;
@@ -801,6 +827,52 @@ struct WamblePolicyDecision {
   char policy_version[64];
 };
 
+typedef struct WamblePolicyRuleRow {
+  uint64_t id;
+  uint64_t global_identity_id;
+  uint64_t snapshot_revision_id;
+  int permission_level;
+  int has_context;
+  int64_t not_before_at;
+  int64_t not_after_at;
+  char action[128];
+  char resource[256];
+  char scope[256];
+  char effect[8];
+  char policy_version[64];
+  char reason[256];
+  char context_key[128];
+  char context_value[256];
+} WamblePolicyRuleRow;
+
+typedef struct WambleTreatmentOutputRow {
+  uint64_t id;
+  char group_key[128];
+  char fact_ref[128];
+  WambleTreatmentAction action;
+} WambleTreatmentOutputRow;
+
+typedef enum {
+  WAMBLE_RESPONSE_CACHE_PROFILE_TERMS = 0,
+  WAMBLE_RESPONSE_CACHE_PREDICTION_PROJECTION,
+  WAMBLE_RESPONSE_CACHE_TRUST_TIER,
+  WAMBLE_RESPONSE_CACHE_SESSION_CAPS,
+  WAMBLE_RESPONSE_CACHE_PROFILES_LIST,
+  WAMBLE_RESPONSE_CACHE_LEADERBOARD,
+  WAMBLE_RESPONSE_CACHE_NAMESPACE_COUNT
+} WambleResponseCacheNamespace;
+
+typedef struct WambleResponseCacheStats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t stores;
+  uint64_t evictions;
+  uint64_t expirations;
+  uint64_t invalidations;
+  size_t bytes;
+  int entries;
+} WambleResponseCacheStats;
+
 typedef enum {
   NET_OK = 0,
   NET_ERR_INVALID = -1,
@@ -1112,10 +1184,16 @@ static inline void wamble_log(int level, const char *file, int line,
 #define WAMBLE_FRAGMENT_HASH_LENGTH 32
 #define WAMBLE_FRAGMENT_VERSION 1
 #define WAMBLE_FRAGMENT_HASH_BLAKE2B_256 1
+#define WAMBLE_FRAGMENT_HASH_ALGO_MASK 0x0F
+#define WAMBLE_FRAGMENT_CODEC_MASK 0xF0
+#define WAMBLE_FRAGMENT_CODEC_NONE 0x00
+#define WAMBLE_FRAGMENT_CODEC_LZ 0x10
 #define WAMBLE_FRAGMENT_WIRE_HEADER_LENGTH                                     \
   (1 + 1 + 2 + 2 + 4 + 4 + WAMBLE_FRAGMENT_HASH_LENGTH + 2)
 #define WAMBLE_FRAGMENT_DATA_MAX                                               \
   (WAMBLE_MAX_PAYLOAD - WAMBLE_FRAGMENT_WIRE_HEADER_LENGTH)
+#define WAMBLE_FRAGMENT_REASSEMBLY_MAX                                         \
+  ((size_t)UINT16_MAX * (size_t)WAMBLE_FRAGMENT_DATA_MAX)
 
 static inline NetworkStatus wamble_wire_packet_size(const uint8_t *packet,
                                                     size_t packet_cap,
@@ -1208,6 +1286,19 @@ typedef struct {
   uint32_t total_count;
 } DbLeaderboardResult;
 
+#define WAMBLE_LEADERBOARD_HANDLE_MAX 64
+
+typedef struct {
+  uint64_t session_id;
+  uint64_t player_id;
+  double score;
+  double rating;
+  uint32_t games_played;
+  uint8_t has_identity;
+  uint8_t public_key[WAMBLE_PUBLIC_KEY_LENGTH];
+  char handle[WAMBLE_LEADERBOARD_HANDLE_MAX];
+} WambleLeaderboardRow;
+
 typedef struct {
   uint64_t board_id;
   time_t reserved_at;
@@ -1390,6 +1481,12 @@ typedef enum {
 #define WAMBLE_CAPABILITY_MASK 0x7F
 #define WAMBLE_CAP_HOT_RELOAD 0x01
 #define WAMBLE_CAP_PROFILE_STATE 0x02
+#define WAMBLE_CAP_SELECTIVE_ACK 0x04
+#define WAMBLE_CAP_PAYLOAD_COMPRESSION 0x20
+#define WAMBLE_HEADER_OPT_ACK_TRAILER 0x01
+#define WAMBLE_ACK_PAYLOAD_SIZE 8
+#define WAMBLE_ACK_TRAILER_SIZE 12
+#define WAMBLE_ACK_BITMAP_BITS 32
 #define WAMBLE_ERR_UNSUPPORTED_VERSION 1000
 #define WAMBLE_ERR_ACCESS_DENIED 1001
 #define WAMBLE_ERR_SPECTATE_VISIBILITY_DENIED 1002
@@ -1529,7 +1626,8 @@ typedef struct {
   uint8_t fragment_hash_algo;
   uint16_t fragment_chunk_index;
   uint16_t fragment_chunk_count;
-  uint8_t reserved[2];
+  uint8_t fragment_codec;
+  uint8_t reserved;
   uint32_t fragment_total_len;
   uint32_t fragment_transfer_id;
   uint8_t fragment_hash[WAMBLE_FRAGMENT_HASH_LENGTH];
@@ -1600,6 +1698,12 @@ typedef struct {
   WambleMessageExtField fields[WAMBLE_MAX_MESSAGE_EXT_FIELDS];
 } WambleMsgExtensions;
 
+typedef struct {
+  uint32_t highest_seq;
+  uint32_t cumulative_seq;
+  uint32_t bitmap;
+} WambleAckState;
+
 struct WambleMsg {
   uint8_t ctrl;
   uint8_t flags;
@@ -1616,6 +1720,7 @@ struct WambleMsg {
   WambleMsgPredictionPayload prediction;
   WambleMsgSessionPayload session;
   WambleMsgExtensions extensions;
+  WambleAckState ack;
 };
 
 WAMBLE_STATIC_ASSERT(wamble_prediction_entries_are_aligned,
@@ -1760,6 +1865,32 @@ NetworkStatus wamble_packet_deserialize(const uint8_t *buffer,
                                         struct WambleMsg *msg,
                                         uint8_t *out_flags);
 
+typedef struct WambleMsgView {
+  uint8_t ctrl;
+  uint8_t flags;
+  uint8_t header_version;
+  uint64_t board_id;
+  uint32_t seq_num;
+  const uint8_t *token;
+  const uint8_t *payload;
+  size_t payload_len;
+  WambleAckState ack;
+} WambleMsgView;
+
+NetworkStatus wamble_msg_view_parse(const uint8_t *buffer, size_t buffer_size,
+                                    WambleMsgView *view);
+NetworkStatus wamble_msg_view_decode(const WambleMsgView *view,
+                                     struct WambleMsg *msg);
+int wamble_ack_state_record(WambleAckState *state, uint32_t seq);
+int wamble_ack_state_covers(const WambleAckState *state, uint32_t seq);
+size_t wamble_lz_compress_bound(size_t src_len);
+int wamble_lz_compress(const uint8_t *src, size_t src_len, uint8_t *dst,
+                       size_t dst_capacity, size_t *out_len);
+int wamble_lz_decompressed_len(const uint8_t *src, size_t src_len,
+                               size_t *out_len);
+int wamble_lz_decompress(const uint8_t *src, size_t src_len, uint8_t *dst,
+                         size_t dst_capacity, size_t *out_len);
+
 typedef enum {
   SPECTATOR_INIT_OK = 0,
   SPECTATOR_INIT_ERR_NO_CAPACITY = -1,
@@ -1785,6 +1916,7 @@ typedef struct SpectatorUpdate {
   uint8_t flags;
   uint8_t notification_type;
   uint64_t summary_generation;
+  uint64_t summary_base_generation;
 } SpectatorUpdate;
 
 typedef struct ReservationReleaseNotification {
@@ -1807,6 +1939,7 @@ int spectator_get_state_by_token(const uint8_t *token,
                                  SpectatorState *out_state,
                                  uint64_t *out_focus_board_id);
 void spectator_discard_by_token(const uint8_t *token);
+void spectator_board_changed(uint64_t board_id);
 int wamble_architecture_spectator_lock_held(void);
 #define WAMBLE_DUP_WINDOW 1024
 
@@ -2072,13 +2205,52 @@ typedef struct WambleMove {
   bool is_white_move;
 } WambleMove;
 
+typedef struct WambleContributor {
+  uint8_t player_token[TOKEN_LENGTH];
+  int white_moves;
+  int black_moves;
+} WambleContributor;
+
+typedef enum {
+  PREDICTION_STATE_PENDING,
+  PREDICTION_STATE_CORRECT,
+  PREDICTION_STATE_INCORRECT,
+  PREDICTION_STATE_EXPIRED
+} PredictionState;
+
+static inline const char *prediction_state_to_str(PredictionState state) {
+  switch (state) {
+  case PREDICTION_STATE_CORRECT:
+    return "CORRECT";
+  case PREDICTION_STATE_INCORRECT:
+    return "INCORRECT";
+  case PREDICTION_STATE_EXPIRED:
+    return "EXPIRED";
+  case PREDICTION_STATE_PENDING:
+  default:
+    return "PENDING";
+  }
+}
+
+static inline PredictionState prediction_state_from_str(const char *s) {
+  if (!s)
+    return PREDICTION_STATE_PENDING;
+  if (strcmp(s, "CORRECT") == 0)
+    return PREDICTION_STATE_CORRECT;
+  if (strcmp(s, "INCORRECT") == 0)
+    return PREDICTION_STATE_INCORRECT;
+  if (strcmp(s, "EXPIRED") == 0)
+    return PREDICTION_STATE_EXPIRED;
+  return PREDICTION_STATE_PENDING;
+}
+
 typedef struct WamblePrediction {
   uint64_t id;
   uint64_t board_id;
   uint64_t parent_id;
   uint8_t player_token[TOKEN_LENGTH];
   char predicted_move_uci[MAX_UCI_LENGTH];
-  char status[STATUS_MAX_LENGTH];
+  PredictionState state;
   int target_ply;
   int depth;
   int correct_streak;
@@ -2116,10 +2288,14 @@ int board_emit_persistent_reservation_for_token(const uint8_t *player_token);
 int board_fill_active_reservation_for_token(const uint8_t *player_token,
                                             DbActiveReservationEntry *out);
 void update_player_ratings(WambleBoard *board);
+void update_player_ratings_for_contributors(
+    WambleBoard *board, const WambleContributor *contributors, int count);
 WambleBoard *get_board_by_id(uint64_t board_id);
 int board_manager_export(WambleBoard *out, int max, int *out_count,
                          uint64_t *out_next_id);
 int board_manager_import(const WambleBoard *in, int count, uint64_t next_id);
+int board_manager_contributors(uint64_t board_id, WambleContributor *out,
+                               int max, int *out_count);
 int wamble_architecture_board_lock_held(void);
 void wamble_architecture_board_scoring_pause_for_tests(int pause);
 void wamble_architecture_board_scoring_counters_for_tests(int *out_started,
@@ -2129,6 +2305,8 @@ ScoringStatus calculate_and_distribute_pot(uint64_t board_id);
 ScoringStatus
 calculate_and_distribute_pot_for_completed_board(uint64_t board_id,
                                                  GameResult result);
+ScoringStatus calculate_and_distribute_pot_for_contributors(
+    WambleBoard *board, const WambleContributor *contributors, int count);
 int scoring_apply_prediction_points(const uint8_t *token, double points);
 
 void player_manager_init(void);
@@ -2165,6 +2343,9 @@ PredictionStatus prediction_submit_with_parent(WambleBoard *board,
                                                uint64_t *out_prediction_id);
 PredictionStatus prediction_resolve_move(WambleBoard *board,
                                          const char *actual_move_uci);
+PredictionStatus prediction_resolve_move_deferred(const WambleBoard *board,
+                                                  const char *actual_move_uci);
+int prediction_drain_deferred(int max_jobs);
 PredictionStatus prediction_collect_tree(uint64_t board_id,
                                          const uint8_t *requester_token,
                                          int trust_tier, int max_depth,
@@ -2180,6 +2361,122 @@ int prediction_get_runtime_counts(uint64_t board_id, const uint8_t *token,
 void prediction_expire_board(uint64_t board_id);
 int wamble_architecture_prediction_lock_held(void);
 
+#define WAMBLE_INDEX_STORE_KEY_MAX 640
+
+typedef struct WambleIndexStore {
+  char key[WAMBLE_INDEX_STORE_KEY_MAX];
+  int used;
+  int ready;
+  int seeding;
+  uint64_t seed;
+} WambleIndexStore;
+
+typedef struct WambleIndexSet {
+  void *stores;
+  int max_stores;
+  size_t store_size;
+  void (*clear)(void *store);
+  wamble_mutex_t mutex;
+  int mutex_ready;
+  uint64_t last_seed;
+} WambleIndexSet;
+
+typedef struct WambleIndexBucket {
+  int start;
+  int count;
+} WambleIndexBucket;
+
+typedef struct WambleIndexBuckets {
+  WambleIndexBucket *slots;
+  int cap;
+} WambleIndexBuckets;
+
+void index_set_lock(WambleIndexSet *set);
+void index_set_unlock(WambleIndexSet *set);
+void *index_set_store_locked(WambleIndexSet *set, const char *key, int create);
+void *index_set_seeding_locked(WambleIndexSet *set, const char *key,
+                               uint64_t seed);
+void index_set_clear_locked(WambleIndexSet *set, void *store);
+void index_set_reset(WambleIndexSet *set, const char *key);
+uint64_t index_set_seed_begin(WambleIndexSet *set, const char *key);
+int index_set_seed_end(WambleIndexSet *set, const char *key, uint64_t seed,
+                       int (*finish)(void *store, void *arg), void *arg);
+int index_set_ready(WambleIndexSet *set, const char *key);
+int index_rows_push(void **rows, int *count, int *capacity, size_t row_size,
+                    int initial_capacity, const void *row);
+int index_buckets_build(WambleIndexBuckets *out, int min_buckets,
+                        const void *rows, int count, size_t row_size,
+                        uint64_t (*hash)(const void *row),
+                        int (*same_group)(const void *a, const void *b));
+void index_buckets_free(WambleIndexBuckets *buckets);
+const WambleIndexBucket *
+index_buckets_find(const WambleIndexBuckets *buckets, uint64_t hash,
+                   const void *rows, size_t row_size,
+                   int (*matches)(const void *row, const void *probe),
+                   const void *probe);
+
+void leaderboard_index_reset(const char *store);
+uint64_t leaderboard_index_seed_begin(const char *store);
+int leaderboard_index_seed_row(const char *store, uint64_t seed,
+                               const WambleLeaderboardRow *row);
+int leaderboard_index_seed_end(const char *store, uint64_t seed);
+int leaderboard_index_ready(const char *store);
+int leaderboard_index_put(const char *store, const WambleLeaderboardRow *row);
+int leaderboard_index_add_score(const char *store, uint64_t session_id,
+                                double points);
+int leaderboard_index_add_game(const char *store, uint64_t session_id);
+int leaderboard_index_set_rating(const char *store, uint64_t session_id,
+                                 double rating);
+int leaderboard_index_query(const char *store, uint8_t leaderboard_type,
+                            uint64_t session_id, int limit, int offset,
+                            WambleLeaderboardRow *rows, int *out_count,
+                            WambleLeaderboardRow *out_self,
+                            uint32_t *out_self_rank, uint32_t *out_total);
+
+void policy_index_reset(const char *store);
+uint64_t policy_index_seed_begin(const char *store);
+int policy_index_seed_row(const char *store, uint64_t seed,
+                          const WamblePolicyRuleRow *row);
+int policy_index_seed_end(const char *store, uint64_t seed);
+int policy_index_ready(const char *store);
+int policy_index_has_action(const char *store, const char *action,
+                            int scoped_only);
+int policy_index_resolve(const char *store, uint64_t identity_id,
+                         const char *action, const char *resource,
+                         const char *scope_exact, const char *scope_group,
+                         const char *context_key, const char *context_value,
+                         int64_t now_epoch_seconds, WamblePolicyRuleRow *out);
+
+void treatment_index_reset(const char *store);
+uint64_t treatment_index_seed_begin(const char *store);
+int treatment_index_seed_output(const char *store, uint64_t seed,
+                                const WambleTreatmentOutputRow *row);
+int treatment_index_seed_edge(const char *store, uint64_t seed,
+                              const char *source_group_key,
+                              const char *target_group_key);
+int treatment_index_seed_end(const char *store, uint64_t seed, int has_rules);
+int treatment_index_has_rules(const char *store);
+int treatment_index_edge_allows(const char *store, const char *source_group_key,
+                                const char *target_group_key);
+int treatment_index_resolve(const char *store, const char *group_key,
+                            const char *hook_name, const WambleFact *facts,
+                            int fact_count, WambleTreatmentAction *out,
+                            int max_out, int *out_count);
+
+uint64_t response_cache_hash(const void *data, size_t len);
+void *response_cache_lookup(int ns, const void *key, size_t key_len,
+                            size_t *out_len);
+void *response_cache_store(int ns, const void *key, size_t key_len,
+                           uint64_t tag, const void *value, size_t value_len);
+void response_cache_invalidate(int ns, const void *key, size_t key_len);
+void response_cache_invalidate_tag(int ns, uint64_t tag);
+void response_cache_invalidate_tag_prefix(int ns, uint64_t tag,
+                                         const void *prefix, size_t prefix_len);
+void response_cache_bump_generation(int ns);
+uint64_t response_cache_generation(int ns);
+void response_cache_clear(void);
+void response_cache_stats(int ns, WambleResponseCacheStats *out);
+
 DbBoardIdList wamble_query_list_boards_by_status(const char *status);
 DbBoardResult wamble_query_get_board(uint64_t board_id);
 DbMovesResult wamble_query_get_moves_for_board(uint64_t board_id);
@@ -2189,6 +2486,8 @@ DbStatus wamble_query_get_active_session_count(int *out_count);
 DbStatus wamble_query_get_max_board_id(uint64_t *out_max_id);
 DbStatus wamble_query_get_session_by_token(const uint8_t *token,
                                            uint64_t *out_session);
+DbStatus wamble_query_get_sessions_by_tokens(const uint8_t *tokens, int count,
+                                             uint64_t *out_sessions);
 DbStatus wamble_query_has_profile_terms_acceptance(
     const uint8_t *token, const char *profile_name,
     const uint8_t tos_hash[WAMBLE_FRAGMENT_HASH_LENGTH], int *out_accepted);
@@ -2266,6 +2565,9 @@ DbStatus wamble_query_resolve_policy_decision(
     const uint8_t *token, const char *profile, const char *action,
     const char *resource, const char *context_key, const char *context_value,
     WamblePolicyDecision *out);
+DbStatus wamble_query_policy_action_has_rules(const char *action,
+                                              int scoped_only,
+                                              int *out_present);
 DbStatus wamble_query_resolve_treatment_actions(
     const uint8_t *token, const char *profile, const char *hook_name,
     const char *opponent_group_key, const WambleFact *facts, int fact_count,
@@ -62,6 +62,14 @@ typedef struct {
   uint8_t ws_rx_buf[WAMBLE_CLIENT_WS_FRAME_MAX];
   size_t ws_rx_len;
   size_t ws_rx_offset;
+  uint8_t udp_rx_buf[WAMBLE_MAX_PACKET_SIZE];
+  size_t udp_rx_len;
+  uint8_t requested_caps;
+  uint8_t caps;
+  int ack_pending;
+  WambleAckState ack_state;
+  uint8_t ack_token[TOKEN_LENGTH];
+  uint64_t ack_board_id;
 } wamble_client_t;
 
 typedef enum {
@@ -238,6 +246,9 @@ WambleClientStatus wamble_client_send(wamble_client_t *c,
                                       struct WambleMsg *msg);
 WambleClientStatus wamble_client_recv(wamble_client_t *c, struct WambleMsg *out,
                                       int timeout_ms);
+WambleClientStatus wamble_client_ack(wamble_client_t *c,
+                                     const struct WambleMsg *msg);
+WambleClientStatus wamble_client_flush_acks(wamble_client_t *c);
 void wamble_client_close(wamble_client_t *c);
 
 void wamble_client_keygen(const uint8_t seed[32],
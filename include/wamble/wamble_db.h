@@ -9,6 +9,10 @@ int db_set_global_store_connection(const char *connection_string);
 int db_format_connection_string(const WambleConfig *cfg, int global_store,
                                 char *out, size_t out_len);
 void db_invalidate_treatment_action_cache(void);
+void db_warm_leaderboard_index(void);
+void db_invalidate_leaderboard_index(void);
+void db_invalidate_policy_index(void);
+void db_invalidate_treatment_index(void);
 int db_validate_global_policy(void);
 int db_store_config_snapshot(const char *profile_key, const char *config_text);
 int db_load_config_snapshot(const char *profile_key, char **out_config_text);
@@ -88,6 +92,8 @@ int db_apply_record_payout_with_canonical(uint64_t board_id,
                                           double points_awarded,
                                           double points_canonical);
 int db_apply_update_player_rating(uint64_t session_id, double rating);
+int db_apply_update_player_ratings(const uint64_t *session_ids,
+                                   const double *ratings, int count);
 
 DbLeaderboardResult db_get_leaderboard(uint64_t requester_session_id,
                                        uint8_t leaderboard_type, int limit,
@@ -102,6 +108,8 @@ DbStatus db_resolve_policy_decision(const uint8_t *token, const char *profile,
                                     const char *context_key,
                                     const char *context_value,
                                     WamblePolicyDecision *out);
+DbStatus db_policy_action_has_rules(const char *action, int scoped_only,
+                                    int *out_present);
 int db_apply_config_policy_rules(const char *profile_key);
 int db_validate_global_treatments(void);
 int db_apply_config_treatment_rules(const char *profile_key);
@@ -123,6 +131,8 @@ typedef struct WambleQueryService {
   DbStatus (*get_active_session_count)(int *out_count);
   DbStatus (*get_max_board_id)(uint64_t *out_max_id);
   DbStatus (*get_session_by_token)(const uint8_t *token, uint64_t *out_session);
+  DbStatus (*get_sessions_by_tokens)(const uint8_t *tokens, int count,
+                                     uint64_t *out_sessions);
   DbStatus (*has_profile_terms_acceptance)(
       const uint8_t *token, const char *profile_name,
       const uint8_t tos_hash[WAMBLE_FRAGMENT_HASH_LENGTH], int *out_accepted);
@@ -194,6 +204,8 @@ typedef struct WambleQueryService {
                                       const char *context_key,
                                       const char *context_value,
                                       WamblePolicyDecision *out);
+  DbStatus (*policy_action_has_rules)(const char *action, int scoped_only,
+                                      int *out_present);
   DbStatus (*resolve_treatment_actions)(
       const uint8_t *token, const char *profile, const char *hook_name,
       const char *opponent_group_key, const WambleFact *facts, int fact_count,
@@ -39,7 +39,19 @@ void wamble_persist_board_archived_result(uint64_t board_id, const char *fen,
                                           const char *termination_reason);
 void profile_runtime_manager_event_signal(void);
 
+typedef struct BoardContributorLedger {
+  WambleContributor *entries;
+  int *slots;
+  int count;
+  int cap;
+  int complete;
+} BoardContributorLedger;
+
+#define BOARD_LEDGER_STATE_RECORD_SIZE 32u
+
 static WAMBLE_THREAD_LOCAL WambleBoard *board_cached;
+static WAMBLE_THREAD_LOCAL BoardContributorLedger *board_ledgers;
+static WAMBLE_THREAD_LOCAL int board_ledger_capacity = 0;
 static WAMBLE_THREAD_LOCAL int num_cached_boards = 0;
 static WAMBLE_THREAD_LOCAL int total_boards = 0;
 static WAMBLE_THREAD_LOCAL time_t last_count_update = 0;
@@ -72,6 +84,9 @@ static WAMBLE_THREAD_LOCAL ReservationReleaseNotification
 static WAMBLE_THREAD_LOCAL int reservation_release_notification_cap = 0;
 static WAMBLE_THREAD_LOCAL int reservation_release_notification_head = 0;
 static WAMBLE_THREAD_LOCAL int reservation_release_notification_count = 0;
+static WAMBLE_THREAD_LOCAL uint64_t *board_changed_pending;
+static WAMBLE_THREAD_LOCAL int board_changed_pending_count = 0;
+static WAMBLE_THREAD_LOCAL int board_changed_pending_cap = 0;
 
 typedef struct BoardSupplyRefreshState {
   wamble_mutex_t mutex;
@@ -251,6 +266,123 @@ static int token_is_zero(const uint8_t *token) {
   return 1;
 }
 
+static void board_ledger_clear(BoardContributorLedger *ledger) {
+  free(ledger->entries);
+  free(ledger->slots);
+  memset(ledger, 0, sizeof(*ledger));
+}
+
+static void board_ledgers_free(void) {
+  for (int i = 0; i < board_ledger_capacity; i++)
+    board_ledger_clear(&board_ledgers[i]);
+  free(board_ledgers);
+  board_ledgers = NULL;
+  board_ledger_capacity = 0;
+}
+
+static int board_ledger_probe(const BoardContributorLedger *ledger,
+                              const uint8_t *token) {
+  int map_size = ledger->cap * 2;
+  int idx = (int)(wamble_token_hash32(token) % (uint32_t)map_size);
+  while (ledger->slots[idx] >= 0 &&
+         !tokens_equal(ledger->entries[ledger->slots[idx]].player_token,
+                       token)) {
+    idx++;
+    if (idx == map_size)
+      idx = 0;
+  }
+  return idx;
+}
+
+static int board_ledger_grow(BoardContributorLedger *ledger) {
+  int cap = ledger->cap > 0 ? ledger->cap * 2 : 8;
+  WambleContributor *entries = (WambleContributor *)realloc(
+      ledger->entries, (size_t)cap * sizeof(*entries));
+  if (!entries)
+    return -1;
+  ledger->entries = entries;
+  int *slots = (int *)malloc((size_t)cap * 2 * sizeof(*slots));
+  if (!slots)
+    return -1;
+  free(ledger->slots);
+  ledger->slots = slots;
+  ledger->cap = cap;
+  for (int i = 0; i < cap * 2; i++)
+    slots[i] = -1;
+  for (int i = 0; i < ledger->count; i++)
+    slots[board_ledger_probe(ledger, entries[i].player_token)] = i;
+  return 0;
+}
+
+static WambleContributor *board_ledger_entry(BoardContributorLedger *ledger,
+                                             const uint8_t *token) {
+  if (ledger->cap > 0) {
+    int pos = board_ledger_probe(ledger, token);
+    if (ledger->slots[pos] >= 0)
+      return &ledger->entries[ledger->slots[pos]];
+  }
+  if (ledger->count >= get_config()->max_contributors)
+    return NULL;
+  if (ledger->count >= ledger->cap && board_ledger_grow(ledger) != 0) {
+    board_ledger_clear(ledger);
+    return NULL;
+  }
+  int e = ledger->count++;
+  WambleContributor *entry = &ledger->entries[e];
+  memset(entry, 0, sizeof(*entry));
+  memcpy(entry->player_token, token, TOKEN_LENGTH);
+  ledger->slots[board_ledger_probe(ledger, token)] = e;
+  return entry;
+}
+
+static void board_ledger_record_locked(int idx, const uint8_t *player_token) {
+  if (!board_ledgers || idx < 0 || idx >= board_ledger_capacity)
+    return;
+  BoardContributorLedger *ledger = &board_ledgers[idx];
+  const Board *position = &board_cached[idx].board;
+  int plies = (position->fullmove_number - 1) * 2;
+  if (position->turn == 'b')
+    plies += 1;
+  if (plies <= 1) {
+    board_ledger_clear(ledger);
+    ledger->complete = 1;
+  }
+  if (!ledger->complete || token_is_zero(player_token))
+    return;
+  WambleContributor *entry = board_ledger_entry(ledger, player_token);
+  if (!entry)
+    return;
+  if (position->turn == 'b')
+    entry->white_moves++;
+  else
+    entry->black_moves++;
+}
+
+static void board_changed_queue_locked(uint64_t board_id) {
+  for (int i = 0; i < board_changed_pending_count; i++) {
+    if (board_changed_pending[i] == board_id)
+      return;
+  }
+  if (board_changed_pending_count >= board_changed_pending_cap) {
+    int new_cap = board_changed_pending_cap > 0 ? board_changed_pending_cap * 2
+                                                : 16;
+    uint64_t *next = (uint64_t *)realloc(board_changed_pending,
+                                         (size_t)new_cap * sizeof(*next));
+    if (!next)
+      return;
+    board_changed_pending = next;
+    board_changed_pending_cap = new_cap;
+  }
+  board_changed_pending[board_changed_pending_count++] = board_id;
+}
+
+static void board_changed_flush(void) {
+  int count = board_changed_pending_count;
+  board_changed_pending_count = 0;
+  for (int i = 0; i < count; i++)
+    spectator_board_changed(board_changed_pending[i]);
+}
+
 static int ensure_reservation_release_notification_capacity(int need) {
   if (need <= 0)
     return 0;
@@ -410,6 +542,8 @@ static int board_supply_refresh_consume(int *observed_total,
 typedef struct BoardScoringJob {
   uint64_t board_id;
   GameResult result;
+  WambleContributor *contributors;
+  int contributor_count;
   wamble_thread_t thread;
   wamble_mutex_t mutex;
   int completed;
@@ -461,6 +595,18 @@ void wamble_architecture_board_scoring_counters_for_tests(int *out_started,
     *out_completed = g_board_scoring_completed_for_tests;
 }
 
+static ScoringStatus board_scoring_run(const BoardScoringJob *job) {
+  if (!job->contributors)
+    return calculate_and_distribute_pot_for_completed_board(job->board_id,
+                                                            job->result);
+  WambleBoard board_stub;
+  memset(&board_stub, 0, sizeof(board_stub));
+  board_stub.id = job->board_id;
+  board_stub.result = job->result;
+  return calculate_and_distribute_pot_for_contributors(
+      &board_stub, job->contributors, job->contributor_count);
+}
+
 static void *board_scoring_worker(void *arg) {
   BoardScoringJob *job = (BoardScoringJob *)arg;
   if (job) {
@@ -476,9 +622,7 @@ static void *board_scoring_worker(void *arg) {
         db_init(job->profile_conn) != 0) {
       retry_needed = 1;
     } else {
-      ScoringStatus scoring_status =
-          calculate_and_distribute_pot_for_completed_board(job->board_id,
-                                                           job->result);
+      ScoringStatus scoring_status = board_scoring_run(job);
       retry_needed = (scoring_status == SCORING_ERR_DB ||
                       scoring_status == SCORING_ERR_INVALID);
     }
@@ -554,6 +698,7 @@ static void board_scoring_jobs_reap_completed(void) {
     *link = job->next;
     wamble_intents_destroy(job->intents);
     wamble_mutex_destroy(&job->mutex);
+    free(job->contributors);
     free(job);
   }
   wamble_mutex_unlock(&g_board_scoring_jobs_mutex);
@@ -579,8 +724,7 @@ static void board_scoring_jobs_join_all(void) {
     wamble_mutex_unlock(&job->mutex);
     if (retry_needed) {
       for (int attempt = 0; attempt < 3; attempt++) {
-        ScoringStatus status = calculate_and_distribute_pot_for_completed_board(
-            job->board_id, job->result);
+        ScoringStatus status = board_scoring_run(job);
         if (status != SCORING_ERR_DB && status != SCORING_ERR_INVALID)
           break;
         wamble_sleep_ms(10);
@@ -595,6 +739,7 @@ static void board_scoring_jobs_join_all(void) {
     }
     wamble_intents_destroy(job->intents);
     wamble_mutex_destroy(&job->mutex);
+    free(job->contributors);
     free(job);
   }
 }
@@ -640,21 +785,39 @@ void board_manager_persistence_shutdown(void) {
   board_supply_refresh_state_free();
 }
 
-static void board_scoring_enqueue_async(uint64_t board_id, GameResult result) {
+static void board_scoring_run_inline(uint64_t board_id,
+                                     WambleContributor *contributors,
+                                     int contributor_count) {
+  WambleBoard *board = contributors ? get_board_by_id(board_id) : NULL;
+  if (board)
+    (void)calculate_and_distribute_pot_for_contributors(board, contributors,
+                                                        contributor_count);
+  else
+    (void)calculate_and_distribute_pot(board_id);
+  free(contributors);
+}
+
+static void board_scoring_enqueue_async(uint64_t board_id, GameResult result,
+                                        WambleContributor *contributors,
+                                        int contributor_count) {
   board_scoring_jobs_ensure_mutex();
   board_scoring_jobs_reap_completed();
   BoardScoringJob *job = (BoardScoringJob *)calloc(1, sizeof(*job));
-  if (!job)
+  if (!job) {
+    free(contributors);
     return;
+  }
   job->board_id = board_id;
   job->result = result;
+  job->contributors = contributors;
+  job->contributor_count = contributor_count;
   const WambleConfig *cfg = get_config();
   job->max_batches = 16;
   job->max_intents = cfg ? cfg->persistence_max_intents : 0;
   job->max_payload_bytes = cfg ? cfg->persistence_max_payload_bytes : 0;
   if (wamble_mutex_init(&job->mutex) != 0) {
     free(job);
-    (void)calculate_and_distribute_pot(board_id);
+    board_scoring_run_inline(board_id, contributors, contributor_count);
     return;
   }
   if (board_capture_worker_context(&job->qs, job->profile_name,
@@ -663,13 +826,13 @@ static void board_scoring_enqueue_async(uint64_t board_id, GameResult result) {
                                    sizeof(job->global_conn)) != 0) {
     wamble_mutex_destroy(&job->mutex);
     free(job);
-    (void)calculate_and_distribute_pot(board_id);
+    board_scoring_run_inline(board_id, contributors, contributor_count);
     return;
   }
   if (wamble_thread_create(&job->thread, board_scoring_worker, job) != 0) {
     wamble_mutex_destroy(&job->mutex);
     free(job);
-    (void)calculate_and_distribute_pot(board_id);
+    board_scoring_run_inline(board_id, contributors, contributor_count);
     return;
   }
   wamble_mutex_lock(&g_board_scoring_jobs_mutex);
@@ -718,6 +881,7 @@ void board_manager_tick() {
       time_t inactive_time = now - board->last_move_time;
       if (inactive_time >= get_config()->inactivity_timeout) {
         board->state = BOARD_STATE_DORMANT;
+        board_changed_queue_locked(board->id);
         if (!token_is_zero(board->last_mover_token)) {
           queue_reservation_release_notification_locked(board->last_mover_token,
                                                         board->id);
@@ -750,6 +914,7 @@ void board_manager_tick() {
     board_manager_mutex_unlock();
   }
   free(expired_checks);
+  board_changed_flush();
 
   if (!refresh_board_supply)
     return;
@@ -802,11 +967,16 @@ void board_manager_init(void) {
     board_cached = NULL;
     board_index_map = NULL;
   }
+  board_ledgers_free();
   if (reservation_release_notifications) {
     free(reservation_release_notifications);
     reservation_release_notifications = NULL;
   }
   board_supply_refresh_state_free();
+  free(board_changed_pending);
+  board_changed_pending = NULL;
+  board_changed_pending_count = 0;
+  board_changed_pending_cap = 0;
   reservation_release_notification_cap = 0;
   reservation_release_notification_head = 0;
   reservation_release_notification_count = 0;
@@ -833,13 +1003,18 @@ void board_manager_init(void) {
   board_cached = malloc(sizeof(WambleBoard) * (size_t)get_config()->max_boards);
   board_index_map =
       malloc(sizeof(int) * (size_t)(get_config()->max_boards * 2));
-  if (!board_cached || !board_index_map) {
+  board_ledgers = (BoardContributorLedger *)calloc(
+      (size_t)get_config()->max_boards, sizeof(*board_ledgers));
+  if (!board_cached || !board_index_map || !board_ledgers) {
     free(board_cached);
     free(board_index_map);
+    free(board_ledgers);
     board_cached = NULL;
     board_index_map = NULL;
+    board_ledgers = NULL;
     return;
   }
+  board_ledger_capacity = get_config()->max_boards;
   memset(board_cached, 0,
          sizeof(WambleBoard) * (size_t)get_config()->max_boards);
   rng_init();
@@ -873,6 +1048,7 @@ void board_manager_init(void) {
         uint64_t new_board_id = alloc_board_id();
         WambleBoard *b = &board_cached[slot];
         memset(b, 0, sizeof(*b));
+        board_ledger_clear(&board_ledgers[slot]);
         b->id = new_board_id;
         b->mode_params.chess960_position_id = NO_CHESS960_POSITION;
         int c960_pos_init = NO_CHESS960_POSITION;
@@ -1166,6 +1342,7 @@ static void apply_reservation_to_board(WambleBoard *board,
   board->last_assignment_time = now;
   memcpy(board->reservation_player_token, player->token, TOKEN_LENGTH);
   board->reserved_for_white = (board->board.turn == 'w');
+  board_changed_queue_locked(board->id);
 
   wamble_persist_board_reserved(
       board->id, board->fen, player->token, get_config()->reservation_timeout,
@@ -1228,6 +1405,7 @@ static WambleBoard *populate_board_cache_from_result(uint64_t board_id,
   }
 
   WambleBoard *board = &board_cached[cache_slot];
+  board_ledger_clear(&board_ledgers[cache_slot]);
   board->id = board_id;
   {
     size_t __len = strnlen(br->fen, FEN_MAX_LENGTH - 1);
@@ -1286,9 +1464,12 @@ static void remove_board_from_cache(int cache_index) {
   }
 
   num_cached_boards--;
+  board_ledger_clear(&board_ledgers[cache_index]);
 
   if (cache_index < num_cached_boards) {
     board_cached[cache_index] = board_cached[num_cached_boards];
+    board_ledgers[cache_index] = board_ledgers[num_cached_boards];
+    memset(&board_ledgers[num_cached_boards], 0, sizeof(*board_ledgers));
     uint64_t moved_board_id = board_cached[cache_index].id;
 
     uint64_t h_moved = mix64_hash(moved_board_id);
@@ -1315,7 +1496,7 @@ static int find_cache_slot_for_board(void) {
   for (int i = 0; i < num_cached_boards; i++) {
     if (board_cached[i].state != BOARD_STATE_RESERVED) {
       remove_board_from_cache(i);
-      return i;
+      return num_cached_boards;
     }
   }
 
@@ -1397,9 +1578,11 @@ void board_move_played(uint64_t board_id, const uint8_t *player_token,
       wamble_persist_board_last_mover_snapshot(
           board->id, board->last_mover_treatment_group);
     }
+    board_ledger_record_locked(idx, player_token);
   }
 
   board_manager_mutex_unlock();
+  spectator_board_changed(board_id);
 }
 
 void board_game_completed(uint64_t board_id, GameResult result) {
@@ -1407,6 +1590,8 @@ void board_game_completed(uint64_t board_id, GameResult result) {
     return;
   WambleBoard rating_snapshot;
   int have_rating_snapshot = 0;
+  WambleContributor *contributors = NULL;
+  int contributor_count = 0;
   memset(&rating_snapshot, 0, sizeof(rating_snapshot));
 
   board_manager_mutex_lock();
@@ -1416,13 +1601,24 @@ void board_game_completed(uint64_t board_id, GameResult result) {
     board->result = result;
     rating_snapshot = *board;
     have_rating_snapshot = 1;
+    BoardContributorLedger *ledger = &board_ledgers[idx];
+    if (ledger->complete && ledger->count > 0) {
+      contributors = ledger->entries;
+      contributor_count = ledger->count;
+      ledger->entries = NULL;
+    }
+    board_ledger_clear(ledger);
   }
   board_manager_mutex_unlock();
 
-  if (have_rating_snapshot)
+  if (have_rating_snapshot && contributors)
+    update_player_ratings_for_contributors(&rating_snapshot, contributors,
+                                           contributor_count);
+  else if (have_rating_snapshot)
     update_player_ratings(&rating_snapshot);
 
-  board_scoring_enqueue_async(board_id, result);
+  board_scoring_enqueue_async(board_id, result, contributors,
+                              contributor_count);
 
   board_manager_mutex_lock();
   idx = board_map_get(board_id);
@@ -1431,6 +1627,7 @@ void board_game_completed(uint64_t board_id, GameResult result) {
     transition_to_archived(board, result);
   }
   board_manager_mutex_unlock();
+  spectator_board_changed(board_id);
   prediction_expire_board(board_id);
 }
 
@@ -1458,6 +1655,7 @@ static void transition_reserved_to_dormant(WambleBoard *board) {
   queue_reservation_release_notification_locked(board->reservation_player_token,
                                                 board->id);
   board->state = BOARD_STATE_DORMANT;
+  board_changed_queue_locked(board->id);
 
   memset(board->reservation_player_token, 0, TOKEN_LENGTH);
   board->reservation_time = 0;
@@ -1480,6 +1678,7 @@ void board_release_reservation(uint64_t board_id) {
   }
 
   board_manager_mutex_unlock();
+  board_changed_flush();
 }
 
 int board_emit_persistent_reservation_for_token(const uint8_t *player_token) {
@@ -1582,11 +1781,14 @@ int board_manager_import(const WambleBoard *in, int count, uint64_t next_id) {
   board_manager_mutex_lock();
 
   memset(board_cached, 0, sizeof(WambleBoard) * (size_t)capacity);
+  for (int i = 0; i < board_ledger_capacity; i++)
+    board_ledger_clear(&board_ledgers[i]);
   for (int i = 0; i < BOARD_MAP_SIZE; i++)
     board_index_map[i] = -1;
   for (int i = 0; i < count; i++) {
     board_cached[i] = in[i];
     board_map_put(board_cached[i].id, i);
+    board_changed_queue_locked(board_cached[i].id);
   }
   num_cached_boards = count;
   total_boards = count;
@@ -1596,6 +1798,98 @@ int board_manager_import(const WambleBoard *in, int count, uint64_t next_id) {
   next_board_id_initialized = 1;
   wamble_mutex_unlock(&next_board_id_mutex);
   board_manager_mutex_unlock();
+  board_changed_flush();
+  return 0;
+}
+
+int board_manager_contributors(uint64_t board_id, WambleContributor *out,
+                               int max, int *out_count) {
+  if (out_count)
+    *out_count = 0;
+  if (max < 0 || (!out && max > 0) || !board_manager_ready())
+    return -1;
+  board_manager_mutex_lock();
+  int idx = board_map_get(board_id);
+  if (idx < 0 || !board_ledgers[idx].complete) {
+    board_manager_mutex_unlock();
+    return -1;
+  }
+  const BoardContributorLedger *ledger = &board_ledgers[idx];
+  int n = ledger->count < max ? ledger->count : max;
+  if (n > 0)
+    memcpy(out, ledger->entries, (size_t)n * sizeof(*out));
+  if (out_count)
+    *out_count = ledger->count;
+  board_manager_mutex_unlock();
+  return 0;
+}
+
+size_t board_manager_ledger_record_size(void) {
+  return BOARD_LEDGER_STATE_RECORD_SIZE;
+}
+
+int board_manager_export_ledger_records(uint8_t *out, size_t record_size,
+                                        int max, int *out_count) {
+  if (out_count)
+    *out_count = 0;
+  if (record_size != BOARD_LEDGER_STATE_RECORD_SIZE || max < 0)
+    return -1;
+  if (!board_manager_ready() || !board_ledgers)
+    return 0;
+  board_manager_mutex_lock();
+  int count = 0;
+  for (int i = 0; i < num_cached_boards; i++) {
+    const BoardContributorLedger *ledger = &board_ledgers[i];
+    if (!ledger->complete)
+      continue;
+    for (int e = 0; e < ledger->count; e++, count++) {
+      if (!out || count >= max)
+        continue;
+      const WambleContributor *c = &ledger->entries[e];
+      uint8_t *record = out + ((size_t)count * record_size);
+      uint64_t id_be = wamble_host_to_net64(board_cached[i].id);
+      uint32_t white_be = htonl((uint32_t)c->white_moves);
+      uint32_t black_be = htonl((uint32_t)c->black_moves);
+      memcpy(record, &id_be, sizeof(id_be));
+      memcpy(record + 8, c->player_token, TOKEN_LENGTH);
+      memcpy(record + 24, &white_be, sizeof(white_be));
+      memcpy(record + 28, &black_be, sizeof(black_be));
+    }
+  }
+  board_manager_mutex_unlock();
+  if (out_count)
+    *out_count = count;
+  return (out && count > max) ? -1 : 0;
+}
+
+int board_manager_import_ledger_records(const uint8_t *in, size_t record_size,
+                                        int count) {
+  if ((!in && count > 0) || count < 0 ||
+      record_size != BOARD_LEDGER_STATE_RECORD_SIZE)
+    return -1;
+  if (!board_manager_ready() || !board_ledgers)
+    return count > 0 ? -1 : 0;
+  board_manager_mutex_lock();
+  for (int i = 0; i < count; i++) {
+    const uint8_t *record = in + ((size_t)i * record_size);
+    uint64_t id_be = 0;
+    uint32_t white_be = 0;
+    uint32_t black_be = 0;
+    memcpy(&id_be, record, sizeof(id_be));
+    memcpy(&white_be, record + 24, sizeof(white_be));
+    memcpy(&black_be, record + 28, sizeof(black_be));
+    int idx = board_map_get(wamble_net_to_host64(id_be));
+    if (idx < 0 || token_is_zero(record + 8))
+      continue;
+    BoardContributorLedger *ledger = &board_ledgers[idx];
+    ledger->complete = 1;
+    WambleContributor *entry = board_ledger_entry(ledger, record + 8);
+    if (!entry)
+      continue;
+    entry->white_moves = (int)ntohl(white_be);
+    entry->black_moves = (int)ntohl(black_be);
+  }
+  board_manager_mutex_unlock();
   return 0;
 }
 
@@ -1779,6 +2073,7 @@ WambleBoard *find_board_for_player(WamblePlayer *player) {
       apply_reservation_to_board(selected_board, player);
       free(eligible_boards);
       board_manager_mutex_unlock();
+      board_changed_flush();
       return selected_board;
     }
   }
@@ -1789,6 +2084,7 @@ WambleBoard *find_board_for_player(WamblePlayer *player) {
       WambleBoard *new_board = &board_cached[new_board_index];
       free(eligible_boards);
       board_manager_mutex_unlock();
+      board_changed_flush();
       return new_board;
     }
   }
@@ -1821,6 +2117,7 @@ static int create_new_board_for_player(WamblePlayer *player) {
   }
 
   WambleBoard *board = &board_cached[cache_slot];
+  board_ledger_clear(&board_ledgers[cache_slot]);
   board->id = alloc_board_id();
   board->mode_params.chess960_position_id = NO_CHESS960_POSITION;
   if (board_should_be_chess960(board->id)) {
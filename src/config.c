@@ -1995,9 +1995,12 @@ static const ConfigVarMap config_map[] = {
     CONF_ITEM("rto-cap-ms", CONF_INT, rto_cap_ms),
     CONF_ITEM("max-message-size", CONF_INT, max_message_size),
     CONF_ITEM("buffer-size", CONF_INT, buffer_size),
+    CONF_ITEM("udp-segment-offload", CONF_INT, udp_segment_offload),
     CONF_ITEM("terminal-cache-ttl-ms", CONF_INT, terminal_cache_ttl_ms),
     CONF_ITEM("rate-limit-requests-per-sec", CONF_INT,
               rate_limit_requests_per_sec),
+    CONF_ITEM("rate-limit-addr-packets-per-sec", CONF_INT,
+              rate_limit_addr_packets_per_sec),
     CONF_ITEM("session-timeout", CONF_INT, session_timeout),
     CONF_ITEM("max-boards", CONF_INT, max_boards),
     CONF_ITEM("min-boards", CONF_INT, min_boards),
@@ -2026,6 +2029,7 @@ static const ConfigVarMap config_map[] = {
     CONF_ITEM("persistence-max-intents", CONF_INT, persistence_max_intents),
     CONF_ITEM("persistence-max-payload-bytes", CONF_INT,
               persistence_max_payload_bytes),
+    CONF_ITEM("response-cache-bytes", CONF_INT, response_cache_bytes),
     CONF_ITEM("new-player-early-phase-mult", CONF_DOUBLE,
               new_player_early_phase_mult),
     CONF_ITEM("new-player-mid-phase-mult", CONF_DOUBLE,
@@ -2117,8 +2121,10 @@ static void config_set_defaults(void) {
   g_config.rto_cap_ms = 8000;
   g_config.max_message_size = 126;
   g_config.buffer_size = 32768;
+  g_config.udp_segment_offload = 1;
   g_config.terminal_cache_ttl_ms = 2000;
   g_config.rate_limit_requests_per_sec = 120;
+  g_config.rate_limit_addr_packets_per_sec = 2000;
   g_config.session_timeout = 300;
   g_config.max_boards = 1024;
   g_config.min_boards = 4;
@@ -2146,6 +2152,7 @@ static void config_set_defaults(void) {
   g_config.max_token_local_attempts = 100;
   g_config.persistence_max_intents = 128;
   g_config.persistence_max_payload_bytes = 64 * 1024;
+  g_config.response_cache_bytes = 4 * 1024 * 1024;
   g_config.new_player_early_phase_mult = 2.0;
   g_config.new_player_mid_phase_mult = 1.0;
   g_config.new_player_end_phase_mult = 0.5;
@@ -2200,6 +2207,7 @@ static void free_profiles(void) {
   free(g_profiles);
   g_profiles = NULL;
   g_profile_count = 0;
+  response_cache_bump_generation(WAMBLE_RESPONSE_CACHE_PROFILES_LIST);
 }
 
 static LispEnv *build_policy_env_from_source(const char *source) {
@@ -21,6 +21,8 @@ static DbStatus db_get_active_session_count(int *out_count);
 static DbStatus db_get_max_board_id(uint64_t *out_max_id);
 static DbStatus db_get_session_by_token(const uint8_t *token,
                                         uint64_t *out_session);
+static DbStatus db_get_sessions_by_tokens(const uint8_t *tokens, int count,
+                                          uint64_t *out_sessions);
 DbStatus db_record_profile_terms_acceptance(
     const uint8_t *token, const char *profile_name,
     const uint8_t tos_hash[WAMBLE_FRAGMENT_HASH_LENGTH], const char *tos_text,
@@ -68,6 +70,12 @@ static DbStatus db_get_identity_handle(uint64_t global_identity_id,
                                        size_t out_handle_size);
 static DbStatus db_materialize_identity_handle(uint64_t global_identity_id,
                                                char **out_handle);
+static void db_leaderboard_note_session(uint64_t session_id);
+static void db_leaderboard_note_new_session(uint64_t session_id,
+                                            uint64_t player_id);
+static void db_leaderboard_note_payout(uint64_t session_id, double points);
+static void db_leaderboard_note_first_move(uint64_t session_id);
+static void db_leaderboard_note_rating(uint64_t session_id, double rating);
 static DbStatus db_get_global_identity_id_by_handle(const char *handle,
                                                     uint64_t *out_identity_id);
 static DbStatus db_get_session_public_key(uint64_t session_id,
@@ -192,6 +200,28 @@ int db_format_connection_string(const WambleConfig *cfg, int global_store,
   return build_conninfo_from_cfg(cfg, global_store != 0, out, out_len);
 }
 
+static int profile_conninfo(char *conn, size_t conn_size) {
+  if (g_profile_conn_configured && g_profile_conn_str[0]) {
+    size_t n = strlen(g_profile_conn_str);
+    if (n >= conn_size)
+      return -1;
+    memcpy(conn, g_profile_conn_str, n + 1);
+    return 0;
+  }
+  return build_conninfo_from_cfg(get_config(), 0, conn, conn_size);
+}
+
+static int global_conninfo(char *conn, size_t conn_size) {
+  if (g_global_conn_configured && g_global_conn_str[0]) {
+    size_t n = strlen(g_global_conn_str);
+    if (n >= conn_size)
+      return -1;
+    memcpy(conn, g_global_conn_str, n + 1);
+    return 0;
+  }
+  return build_conninfo_from_cfg(get_config(), 1, conn, conn_size);
+}
+
 static PGconn *ensure_connection(void) {
   if (db_conn_tls) {
     if (PQstatus(db_conn_tls) != CONNECTION_OK) {
@@ -205,14 +235,8 @@ static PGconn *ensure_connection(void) {
     return db_conn_tls;
   }
   char conn[512];
-  if (g_profile_conn_configured && g_profile_conn_str[0]) {
-    size_t n = strlen(g_profile_conn_str);
-    if (n >= sizeof conn)
-      return NULL;
-    memcpy(conn, g_profile_conn_str, n + 1);
-  } else if (build_conninfo_from_cfg(get_config(), 0, conn, sizeof conn) != 0) {
+  if (profile_conninfo(conn, sizeof conn) != 0)
     return NULL;
-  }
   db_conn_tls = PQconnectdb(conn);
   if (PQstatus(db_conn_tls) != CONNECTION_OK) {
     PQfinish(db_conn_tls);
@@ -990,6 +1014,9 @@ void db_write_batch_rollback(void) {
   PGresult *res = pq_exec_locked("ROLLBACK");
   if (res)
     PQclear(res);
+  char store[512];
+  if (profile_conninfo(store, sizeof store) == 0)
+    leaderboard_index_reset(store);
 }
 
 typedef enum {
@@ -1075,6 +1102,23 @@ static WAMBLE_THREAD_LOCAL TokenReadCacheU64Entry
 static WAMBLE_THREAD_LOCAL int tls_session_cache_next = 0;
 static WAMBLE_THREAD_LOCAL int tls_persistent_session_cache_next = 0;
 
+enum { TREATMENT_ASSIGNMENT_CACHE_CAP = 64 };
+
+typedef struct {
+  uint8_t token[TOKEN_LENGTH];
+  char profile_key[PROFILE_NAME_MAX_LENGTH];
+  DbStatus status;
+  WambleTreatmentAssignment assignment;
+  uint64_t generation;
+  uint64_t expires_ms;
+  int used;
+} TreatmentAssignmentCacheEntry;
+
+static volatile uint64_t g_treatment_assignment_generation = 1;
+static WAMBLE_THREAD_LOCAL TreatmentAssignmentCacheEntry
+    tls_treatment_assignment_cache[TREATMENT_ASSIGNMENT_CACHE_CAP];
+static WAMBLE_THREAD_LOCAL int tls_treatment_assignment_cache_next = 0;
+
 static int token_cache_u64_lookup(TokenReadCacheU64Entry *cache, int cap,
                                   const uint8_t *token, uint64_t now_ms,
                                   DbStatus *out_status, uint64_t *out_value) {
@@ -1150,8 +1194,11 @@ void db_cleanup_thread(void) {
   }
   memset(tls_session_cache, 0, sizeof(tls_session_cache));
   memset(tls_persistent_session_cache, 0, sizeof(tls_persistent_session_cache));
+  memset(tls_treatment_assignment_cache, 0,
+         sizeof(tls_treatment_assignment_cache));
   tls_session_cache_next = 0;
   tls_persistent_session_cache_next = 0;
+  tls_treatment_assignment_cache_next = 0;
   g_profile_conn_str[0] = '\0';
   g_profile_conn_configured = 0;
   g_global_conn_str[0] = '\0';
@@ -1548,6 +1595,10 @@ int db_apply_config_policy_rules(const char *profile_key) {
   }
 
   res = pq_exec_params_global_locked("COMMIT", 0, NULL, NULL, NULL, NULL, 0);
+  char store[512];
+  if (global_conninfo(store, sizeof store) == 0)
+    policy_index_reset(store);
+  response_cache_bump_generation(WAMBLE_RESPONSE_CACHE_NAMESPACE_COUNT);
   if (!res)
     return -1;
   int ok = (PQresultStatus(res) == PGRES_COMMAND_OK) ? 0 : -1;
@@ -1850,6 +1901,7 @@ int db_apply_config_treatment_rules(const char *profile_key) {
   }
 
   res = pq_exec_params_global_locked("COMMIT", 0, NULL, NULL, NULL, NULL, 0);
+  treatment_index_reset(NULL);
   if (!res)
     return -1;
   int ok = (PQresultStatus(res) == PGRES_COMMAND_OK) ? 0 : -1;
@@ -2033,13 +2085,58 @@ static void db_apply_policy_treatment_overrides(const uint8_t *token,
     out->permission_level = 0;
 }
 
+static void treatment_assignment_cache_invalidate(void) {
+  wamble_atomic_inc_u64(&g_treatment_assignment_generation);
+}
+
+static TreatmentAssignmentCacheEntry *
+treatment_assignment_cache_find(const uint8_t *token, const char *profile_key,
+                                uint64_t generation, uint64_t now_ms) {
+  for (int i = 0; i < TREATMENT_ASSIGNMENT_CACHE_CAP; i++) {
+    TreatmentAssignmentCacheEntry *e = &tls_treatment_assignment_cache[i];
+    if (!e->used || e->generation != generation || e->expires_ms < now_ms)
+      continue;
+    if (memcmp(e->token, token, TOKEN_LENGTH) == 0 &&
+        strcmp(e->profile_key, profile_key) == 0)
+      return e;
+  }
+  return NULL;
+}
+
+static void treatment_assignment_cache_store(
+    const uint8_t *token, const char *profile_key, DbStatus status,
+    const WambleTreatmentAssignment *assignment, uint64_t generation,
+    uint64_t now_ms) {
+  int idx = tls_treatment_assignment_cache_next;
+  tls_treatment_assignment_cache_next =
+      (idx + 1) % TREATMENT_ASSIGNMENT_CACHE_CAP;
+  TreatmentAssignmentCacheEntry *e = &tls_treatment_assignment_cache[idx];
+  memcpy(e->token, token, TOKEN_LENGTH);
+  snprintf(e->profile_key, sizeof(e->profile_key), "%s", profile_key);
+  e->status = status;
+  e->assignment = *assignment;
+  e->generation = generation;
+  e->expires_ms = now_ms + TOKEN_READ_CACHE_TTL_MS;
+  e->used = 1;
+}
+
 static DbStatus db_get_session_treatment_assignment_for_profile(
     const uint8_t *token, const char *profile, WambleTreatmentAssignment *out) {
   if (!token || !out)
     return DB_ERR_BAD_DATA;
+  const char *profile_key = db_treatment_profile_key(profile);
+  uint64_t generation =
+      wamble_atomic_load_u64(&g_treatment_assignment_generation);
+  uint64_t now_ms = wamble_now_mono_millis();
+  const TreatmentAssignmentCacheEntry *cached =
+      treatment_assignment_cache_find(token, profile_key, generation, now_ms);
+  if (cached) {
+    if (cached->status == DB_OK)
+      *out = cached->assignment;
+    return cached->status;
+  }
   char token_hex[33];
   bytes_to_hex(token, TOKEN_LENGTH, token_hex);
-  const char *profile_key = db_treatment_profile_key(profile);
   PGresult *res = pq_exec_params_locked(
       "SELECT COALESCE(sta.treatment_group_key, ''), "
       "       COALESCE(sta.treatment_rule_id, 0), "
@@ -2059,17 +2156,23 @@ static DbStatus db_get_session_treatment_assignment_for_profile(
     PQclear(res);
     return DB_ERR_EXEC;
   }
-  if (PQntuples(res) == 0) {
-    PQclear(res);
-    return DB_NOT_FOUND;
+  WambleTreatmentAssignment assignment;
+  memset(&assignment, 0, sizeof(assignment));
+  if (PQntuples(res) > 0) {
+    snprintf(assignment.group_key, sizeof(assignment.group_key), "%s",
+             PQgetvalue(res, 0, 0));
+    assignment.rule_id = strtoull(PQgetvalue(res, 0, 1), NULL, 10);
+    assignment.snapshot_revision_id =
+        strtoull(PQgetvalue(res, 0, 2), NULL, 10);
+    assignment.assigned_at = (time_t)strtoull(PQgetvalue(res, 0, 3), NULL, 10);
   }
-  memset(out, 0, sizeof(*out));
-  snprintf(out->group_key, sizeof(out->group_key), "%s", PQgetvalue(res, 0, 0));
-  out->rule_id = strtoull(PQgetvalue(res, 0, 1), NULL, 10);
-  out->snapshot_revision_id = strtoull(PQgetvalue(res, 0, 2), NULL, 10);
-  out->assigned_at = (time_t)strtoull(PQgetvalue(res, 0, 3), NULL, 10);
   PQclear(res);
-  return out->group_key[0] ? DB_OK : DB_NOT_FOUND;
+  DbStatus status = assignment.group_key[0] ? DB_OK : DB_NOT_FOUND;
+  treatment_assignment_cache_store(token, profile_key, status, &assignment,
+                                   generation, now_ms);
+  if (status == DB_OK)
+    *out = assignment;
+  return status;
 }
 
 DbStatus db_get_session_treatment_assignment(const uint8_t *token,
@@ -2248,6 +2351,7 @@ DbStatus db_assign_session_treatment(const uint8_t *token, const char *profile,
     return DB_ERR_EXEC;
   }
   PQclear(res);
+  treatment_assignment_cache_invalidate();
 
   res = pq_exec_params_global_locked(
       "INSERT INTO global_identity_tags(global_identity_id, tag) "
@@ -2271,6 +2375,161 @@ DbStatus db_assign_session_treatment(const uint8_t *token, const char *profile,
   return DB_OK;
 }
 
+static int db_treatment_index_store(const char *profile_key, char *out,
+                                    size_t out_size) {
+  char conn[512];
+  if (global_conninfo(conn, sizeof conn) != 0)
+    return -1;
+  int n = snprintf(out, out_size, "%s|%s", conn, profile_key);
+  return n >= 0 && (size_t)n < out_size ? 0 : -1;
+}
+
+static int db_treatment_index_seed(const char *store,
+                                   const char *profile_key) {
+  uint64_t seed = treatment_index_seed_begin(store);
+  if (!seed)
+    return -1;
+  char rule_source[PROFILE_NAME_MAX_LENGTH];
+  int source_status = db_treatment_rule_source_key(profile_key, rule_source,
+                                                   sizeof(rule_source));
+  if (source_status < 0) {
+    treatment_index_reset(store);
+    return -1;
+  }
+  if (source_status > 0)
+    return treatment_index_seed_end(store, seed, 0);
+  PGresult *res = pq_exec_params_global_locked(
+      "SELECT id, group_key, hook_name, output_kind, output_key, value_type, "
+      "       COALESCE(value_text, ''), COALESCE(value_num, 0), "
+      "       COALESCE(value_bool, FALSE), COALESCE(value_fact_ref, '') "
+      "FROM global_treatment_group_outputs WHERE source = md5($1)",
+      1, NULL, (const char *[]){rule_source}, NULL, NULL, 0);
+  if (!res || PQresultStatus(res) != PGRES_TUPLES_OK) {
+    if (res)
+      PQclear(res);
+    treatment_index_reset(store);
+    return -1;
+  }
+  int rows = PQntuples(res);
+  for (int i = 0; i < rows; i++) {
+    WambleTreatmentOutputRow row;
+    memset(&row, 0, sizeof(row));
+    row.id = strtoull(PQgetvalue(res, i, 0), NULL, 10);
+    snprintf(row.group_key, sizeof(row.group_key), "%s",
+             PQgetvalue(res, i, 1));
+    WambleTreatmentAction *a = &row.action;
+    snprintf(a->hook_name, sizeof(a->hook_name), "%s", PQgetvalue(res, i, 2));
+    snprintf(a->output_kind, sizeof(a->output_kind), "%s",
+             PQgetvalue(res, i, 3));
+    snprintf(a->output_key, sizeof(a->output_key), "%s",
+             PQgetvalue(res, i, 4));
+    a->value_type =
+        (WambleTreatmentValueType)strtol(PQgetvalue(res, i, 5), NULL, 10);
+    switch (a->value_type) {
+    case WAMBLE_TREATMENT_VALUE_STRING:
+      snprintf(a->string_value, sizeof(a->string_value), "%s",
+               PQgetvalue(res, i, 6));
+      break;
+    case WAMBLE_TREATMENT_VALUE_INT:
+      a->int_value = strtoll(PQgetvalue(res, i, 7), NULL, 10);
+      break;
+    case WAMBLE_TREATMENT_VALUE_DOUBLE:
+      a->double_value = strtod(PQgetvalue(res, i, 7), NULL);
+      break;
+    case WAMBLE_TREATMENT_VALUE_BOOL:
+      a->bool_value = (PQgetvalue(res, i, 8)[0] == 't' ||
+                       PQgetvalue(res, i, 8)[0] == '1');
+      break;
+    case WAMBLE_TREATMENT_VALUE_FACT_REF:
+      snprintf(row.fact_ref, sizeof(row.fact_ref), "%s",
+               PQgetvalue(res, i, 9));
+      break;
+    default:
+      break;
+    }
+    if (treatment_index_seed_output(store, seed, &row) != 0) {
+      PQclear(res);
+      treatment_index_reset(store);
+      return -1;
+    }
+  }
+  PQclear(res);
+  res = pq_exec_params_global_locked(
+      "SELECT source_group_key, target_group_key "
+      "FROM global_treatment_group_edges WHERE source = md5($1)",
+      1, NULL, (const char *[]){rule_source}, NULL, NULL, 0);
+  if (!res || PQresultStatus(res) != PGRES_TUPLES_OK) {
+    if (res)
+      PQclear(res);
+    treatment_index_reset(store);
+    return -1;
+  }
+  rows = PQntuples(res);
+  for (int i = 0; i < rows; i++) {
+    if (treatment_index_seed_edge(store, seed, PQgetvalue(res, i, 0),
+                                  PQgetvalue(res, i, 1)) != 0) {
+      PQclear(res);
+      treatment_index_reset(store);
+      return -1;
+    }
+  }
+  PQclear(res);
+  return treatment_index_seed_end(store, seed, 1);
+}
+
+static int db_treatment_index_ready_store(const char *profile_key, char *store,
+                                          size_t store_size) {
+  if (db_treatment_index_store(profile_key, store, store_size) != 0)
+    return -1;
+  if (treatment_index_has_rules(store) >= 0)
+    return 0;
+  return db_treatment_index_seed(store, profile_key);
+}
+
+void db_invalidate_treatment_index(void) {
+  treatment_index_reset(NULL);
+  treatment_assignment_cache_invalidate();
+}
+
+static int db_resolve_treatment_actions_indexed(
+    const uint8_t *token, const char *profile_key, const char *hook_name,
+    const char *opponent_group_key, const WambleFact *facts, int fact_count,
+    WambleTreatmentAction *out, int max_out, int *out_count,
+    DbStatus *out_status) {
+  char store[640];
+  if (db_treatment_index_ready_store(profile_key, store, sizeof store) != 0)
+    return -1;
+  int has_rules = treatment_index_has_rules(store);
+  if (has_rules < 0)
+    return -1;
+  if (!has_rules) {
+    *out_status = DB_NOT_FOUND;
+    return 0;
+  }
+  WambleTreatmentAssignment assignment = {0};
+  DbStatus st = db_get_session_treatment_assignment_for_profile(
+      token, profile_key, &assignment);
+  if (st != DB_OK) {
+    *out_status = st;
+    return 0;
+  }
+  if (opponent_group_key && opponent_group_key[0]) {
+    int allowed = treatment_index_edge_allows(store, assignment.group_key,
+                                              opponent_group_key);
+    if (allowed < 0)
+      return -1;
+    if (!allowed) {
+      *out_status = DB_NOT_FOUND;
+      return 0;
+    }
+  }
+  if (treatment_index_resolve(store, assignment.group_key, hook_name, facts,
+                              fact_count, out, max_out, out_count) != 0)
+    return -1;
+  *out_status = DB_OK;
+  return 0;
+}
+
 DbStatus db_resolve_treatment_actions(const uint8_t *token, const char *profile,
                                       const char *hook_name,
                                       const char *opponent_group_key,
@@ -2282,6 +2541,11 @@ DbStatus db_resolve_treatment_actions(const uint8_t *token, const char *profile,
   if (!token || !hook_name || !out || max_out <= 0)
     return DB_ERR_BAD_DATA;
   const char *profile_key = db_treatment_profile_key(profile);
+  DbStatus indexed_status = DB_OK;
+  if (db_resolve_treatment_actions_indexed(
+          token, profile_key, hook_name, opponent_group_key, facts, fact_count,
+          out, max_out, out_count, &indexed_status) == 0)
+    return indexed_status;
   char rule_source[PROFILE_NAME_MAX_LENGTH];
   int source_status = db_treatment_rule_source_key(profile_key, rule_source,
                                                    sizeof(rule_source));
@@ -2342,6 +2606,13 @@ int db_treatment_edge_allows(const char *profile, const char *source_group_key,
       !target_group_key[0])
     return 1;
   const char *profile_key = db_treatment_profile_key(profile);
+  char store[640];
+  if (db_treatment_index_ready_store(profile_key, store, sizeof store) == 0) {
+    int allowed =
+        treatment_index_edge_allows(store, source_group_key, target_group_key);
+    if (allowed >= 0)
+      return allowed;
+  }
   char rule_source[PROFILE_NAME_MAX_LENGTH];
   int source_status = db_treatment_rule_source_key(profile_key, rule_source,
                                                    sizeof(rule_source));
@@ -2391,6 +2662,106 @@ static int db_get_player_public_key_by_id(uint64_t player_id,
   return 0;
 }
 
+static int db_parse_epoch_bound(const char *text, int64_t unbounded,
+                                int64_t *out) {
+  if (!text || !text[0]) {
+    *out = unbounded;
+    return 0;
+  }
+  char *end = NULL;
+  long long v = strtoll(text, &end, 10);
+  if (!end || *end != '\0')
+    return -1;
+  *out = (int64_t)v;
+  return 0;
+}
+
+static int db_policy_index_seed(const char *store) {
+  uint64_t seed = policy_index_seed_begin(store);
+  if (!seed)
+    return -1;
+  PGresult *res = pq_exec_params_global_locked(
+      "SELECT id, global_identity_id, action, resource, scope, effect, "
+      "       permission_level, policy_version, COALESCE(reason, ''), "
+      "       COALESCE(snapshot_revision_id, 0), "
+      "       CASE WHEN context_key IS NULL THEN 0 ELSE 1 END, "
+      "       COALESCE(context_key, ''), COALESCE(context_value, ''), "
+      "       COALESCE(ceil(EXTRACT(EPOCH FROM not_before_at))::bigint::text, "
+      "                ''), "
+      "       COALESCE(floor(EXTRACT(EPOCH FROM not_after_at))::bigint::text, "
+      "                '') "
+      "FROM global_policy_rules",
+      0, NULL, NULL, NULL, NULL, 0);
+  if (!res || PQresultStatus(res) != PGRES_TUPLES_OK) {
+    if (res)
+      PQclear(res);
+    policy_index_reset(store);
+    return -1;
+  }
+  int rows = PQntuples(res);
+  for (int i = 0; i < rows; i++) {
+    WamblePolicyRuleRow row;
+    memset(&row, 0, sizeof(row));
+    row.id = strtoull(PQgetvalue(res, i, 0), NULL, 10);
+    row.global_identity_id = strtoull(PQgetvalue(res, i, 1), NULL, 10);
+    snprintf(row.action, sizeof(row.action), "%s", PQgetvalue(res, i, 2));
+    snprintf(row.resource, sizeof(row.resource), "%s", PQgetvalue(res, i, 3));
+    snprintf(row.scope, sizeof(row.scope), "%s", PQgetvalue(res, i, 4));
+    snprintf(row.effect, sizeof(row.effect), "%s", PQgetvalue(res, i, 5));
+    row.permission_level = (int)strtol(PQgetvalue(res, i, 6), NULL, 10);
+    snprintf(row.policy_version, sizeof(row.policy_version), "%s",
+             PQgetvalue(res, i, 7));
+    snprintf(row.reason, sizeof(row.reason), "%s", PQgetvalue(res, i, 8));
+    row.snapshot_revision_id = strtoull(PQgetvalue(res, i, 9), NULL, 10);
+    row.has_context = PQgetvalue(res, i, 10)[0] == '1';
+    snprintf(row.context_key, sizeof(row.context_key), "%s",
+             PQgetvalue(res, i, 11));
+    snprintf(row.context_value, sizeof(row.context_value), "%s",
+             PQgetvalue(res, i, 12));
+    if (db_parse_epoch_bound(PQgetvalue(res, i, 13), INT64_MIN,
+                             &row.not_before_at) != 0 ||
+        db_parse_epoch_bound(PQgetvalue(res, i, 14), INT64_MAX,
+                             &row.not_after_at) != 0 ||
+        policy_index_seed_row(store, seed, &row) != 0) {
+      PQclear(res);
+      policy_index_reset(store);
+      return -1;
+    }
+  }
+  PQclear(res);
+  return policy_index_seed_end(store, seed);
+}
+
+void db_invalidate_policy_index(void) { policy_index_reset(NULL); }
+
+static DbStatus db_policy_decision_finish(const uint8_t *token,
+                                          const char *profile_name,
+                                          const char *context_key,
+                                          const char *context_value,
+                                          WamblePolicyDecision *out) {
+  db_apply_policy_treatment_overrides(token, profile_name, out, context_key,
+                                      context_value);
+  if (!out->allowed)
+    out->permission_level = 0;
+  return DB_OK;
+}
+
+DbStatus db_policy_action_has_rules(const char *action, int scoped_only,
+                                    int *out_present) {
+  if (!action || !action[0] || !out_present)
+    return DB_ERR_BAD_DATA;
+  char store[512];
+  if (global_conninfo(store, sizeof store) != 0)
+    return DB_ERR_CONN;
+  if (!policy_index_ready(store) && db_policy_index_seed(store) != 0)
+    return DB_ERR_EXEC;
+  int present = policy_index_has_action(store, action, scoped_only);
+  if (present < 0)
+    return DB_ERR_EXEC;
+  *out_present = present;
+  return DB_OK;
+}
+
 DbStatus db_resolve_policy_decision(const uint8_t *token, const char *profile,
                                     const char *action, const char *resource,
                                     const char *context_key,
@@ -2421,6 +2792,34 @@ DbStatus db_resolve_policy_decision(const uint8_t *token, const char *profile,
   char scope_group[256];
   snprintf(scope_exact, sizeof(scope_exact), "profile:%s", profile_name);
   snprintf(scope_group, sizeof(scope_group), "profile_group:%s", group);
+  char store[512];
+  if (global_conninfo(store, sizeof store) == 0 &&
+      (policy_index_ready(store) || db_policy_index_seed(store) == 0)) {
+    WamblePolicyRuleRow rule;
+    int found = policy_index_resolve(
+        store, identity_id, action, resource, scope_exact, scope_group,
+        context_key, context_value, (int64_t)wamble_now_wall(), &rule);
+    if (found == 0) {
+      out->allowed = 0;
+      return db_policy_decision_finish(token, profile_name, context_key,
+                                       context_value, out);
+    }
+    if (found == 1) {
+      out->rule_id = rule.id;
+      out->snapshot_revision_id = rule.snapshot_revision_id;
+      out->permission_level = rule.permission_level;
+      snprintf(out->effect, sizeof(out->effect), "%s",
+               rule.effect[0] ? rule.effect : "deny");
+      snprintf(out->policy_version, sizeof(out->policy_version), "%s",
+               rule.policy_version);
+      snprintf(out->reason, sizeof(out->reason), "%s", rule.reason);
+      snprintf(out->scope, sizeof(out->scope), "%s", rule.scope);
+      out->allowed = (strcmp(out->effect, "allow") == 0) ? 1 : 0;
+      return db_policy_decision_finish(token, profile_name, context_key,
+                                       context_value, out);
+    }
+  }
+
   char identity_id_str[32];
   snprintf(identity_id_str, sizeof(identity_id_str), "%" PRIu64, identity_id);
 
@@ -2463,11 +2862,8 @@ DbStatus db_resolve_policy_decision(const uint8_t *token, const char *profile,
   if (PQntuples(res) == 0) {
     PQclear(res);
     out->allowed = 0;
-    db_apply_policy_treatment_overrides(token, profile_name, out, context_key,
-                                        context_value);
-    if (!out->allowed)
-      out->permission_level = 0;
-    return DB_OK;
+    return db_policy_decision_finish(token, profile_name, context_key,
+                                     context_value, out);
   }
 
   char *e = NULL;
@@ -2499,11 +2895,8 @@ DbStatus db_resolve_policy_decision(const uint8_t *token, const char *profile,
   snprintf(out->scope, sizeof(out->scope), "%s", PQgetvalue(res, 0, 5));
   out->allowed = (strcmp(out->effect, "allow") == 0) ? 1 : 0;
   PQclear(res);
-  db_apply_policy_treatment_overrides(token, profile_name, out, context_key,
-                                      context_value);
-  if (!out->allowed)
-    out->permission_level = 0;
-  return DB_OK;
+  return db_policy_decision_finish(token, profile_name, context_key,
+                                   context_value, out);
 }
 
 const WambleQueryService *wamble_get_db_query_service(void) {
@@ -2516,6 +2909,7 @@ const WambleQueryService *wamble_get_db_query_service(void) {
     svc.get_active_session_count = db_get_active_session_count;
     svc.get_max_board_id = db_get_max_board_id;
     svc.get_session_by_token = db_get_session_by_token;
+    svc.get_sessions_by_tokens = db_get_sessions_by_tokens;
     svc.has_profile_terms_acceptance = db_has_profile_terms_acceptance;
     svc.has_profile_terms_acceptance_for_config =
         db_has_profile_terms_acceptance_for_config;
@@ -2555,6 +2949,7 @@ const WambleQueryService *wamble_get_db_query_service(void) {
     svc.get_pending_predictions = db_get_pending_predictions;
     svc.get_session_treatment_assignment = db_get_session_treatment_assignment;
     svc.resolve_policy_decision = db_resolve_policy_decision;
+    svc.policy_action_has_rules = db_policy_action_has_rules;
     svc.resolve_treatment_actions = db_resolve_treatment_actions;
     svc.treatment_edge_allows = db_treatment_edge_allows;
     initialized = 1;
@@ -2672,6 +3067,25 @@ DbStatus wamble_query_get_session_by_token(const uint8_t *token,
   return qs->get_session_by_token(token, out_session);
 }
 
+DbStatus wamble_query_get_sessions_by_tokens(const uint8_t *tokens, int count,
+                                             uint64_t *out_sessions) {
+  if (!tokens || !out_sessions || count < 0)
+    return DB_ERR_BAD_DATA;
+  const WambleQueryService *qs = get_query_service();
+  if (qs && qs->get_sessions_by_tokens)
+    return qs->get_sessions_by_tokens(tokens, count, out_sessions);
+  if (!qs || !qs->get_session_by_token)
+    return DB_ERR_EXEC;
+  for (int i = 0; i < count; i++) {
+    out_sessions[i] = 0;
+    DbStatus st =
+        qs->get_session_by_token(&tokens[i * TOKEN_LENGTH], &out_sessions[i]);
+    if (st != DB_OK && st != DB_NOT_FOUND)
+      return st;
+  }
+  return DB_OK;
+}
+
 DbStatus wamble_query_has_profile_terms_acceptance(
     const uint8_t *token, const char *profile_name,
     const uint8_t tos_hash[WAMBLE_FRAGMENT_HASH_LENGTH], int *out_accepted) {
@@ -2957,6 +3371,15 @@ DbStatus wamble_query_resolve_policy_decision(
                                      context_key, context_value, out);
 }
 
+DbStatus wamble_query_policy_action_has_rules(const char *action,
+                                              int scoped_only,
+                                              int *out_present) {
+  const WambleQueryService *qs = get_query_service();
+  if (!qs || !qs->policy_action_has_rules)
+    return DB_ERR_EXEC;
+  return qs->policy_action_has_rules(action, scoped_only, out_present);
+}
+
 #define TREATMENT_ACTION_QUERY_CACHE_MAX 64
 #define TREATMENT_ACTION_QUERY_CACHE_TTL_MS 1000ULL
 
@@ -3188,6 +3611,8 @@ uint64_t db_create_session(const uint8_t *token, uint64_t player_id) {
                           player_id > 0 ? DB_OK : DB_NOT_FOUND,
                           player_id > 0 ? session_id : 0, now_ms);
   }
+  if (session_id > 0)
+    db_leaderboard_note_new_session(session_id, player_id);
   return session_id;
 }
 
@@ -3252,6 +3677,88 @@ static DbStatus db_get_session_by_token(const uint8_t *token,
   return DB_OK;
 }
 
+static DbStatus db_get_sessions_by_tokens(const uint8_t *tokens, int count,
+                                          uint64_t *out_sessions) {
+  if (!tokens || !out_sessions || count < 0)
+    return DB_ERR_BAD_DATA;
+  if (count == 0)
+    return DB_OK;
+  uint64_t now_ms = wamble_now_mono_millis();
+  int *misses = (int *)malloc(sizeof(int) * (size_t)count);
+  char *token_array =
+      (char *)malloc((size_t)count * (TOKEN_LENGTH * 2 + 1) + 3);
+  if (!misses || !token_array) {
+    free(misses);
+    free(token_array);
+    return DB_ERR_EXEC;
+  }
+  int miss_count = 0;
+  size_t len = 0;
+  token_array[len++] = '{';
+  for (int i = 0; i < count; i++) {
+    const uint8_t *token = &tokens[i * TOKEN_LENGTH];
+    DbStatus cached_status = DB_ERR_EXEC;
+    uint64_t cached_value = 0;
+    out_sessions[i] = 0;
+    if (token_cache_u64_lookup(tls_session_cache, TOKEN_READ_CACHE_CAP, token,
+                               now_ms, &cached_status, &cached_value) &&
+        (cached_status == DB_OK || cached_status == DB_NOT_FOUND)) {
+      if (cached_status == DB_OK)
+        out_sessions[i] = cached_value;
+      continue;
+    }
+    if (miss_count > 0)
+      token_array[len++] = ',';
+    bytes_to_hex(token, TOKEN_LENGTH, token_array + len);
+    len += TOKEN_LENGTH * 2;
+    misses[miss_count++] = i;
+  }
+  token_array[len++] = '}';
+  token_array[len] = '\0';
+  if (miss_count == 0) {
+    free(misses);
+    free(token_array);
+    return DB_OK;
+  }
+
+  const char *query =
+      "SELECT t.ord, s.id FROM unnest($1::text[]) WITH ORDINALITY AS "
+      "t(token_hex, ord) JOIN sessions s ON s.token = decode(t.token_hex, "
+      "'hex')";
+  const char *paramValues[] = {token_array};
+  PGresult *res =
+      pq_exec_params_locked(query, 1, NULL, paramValues, NULL, NULL, 0);
+  free(token_array);
+  if (!res) {
+    free(misses);
+    return DB_ERR_CONN;
+  }
+  if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+    PQclear(res);
+    free(misses);
+    return DB_ERR_EXEC;
+  }
+  int rows = PQntuples(res);
+  for (int r = 0; r < rows; r++) {
+    long ord = strtol(PQgetvalue(res, r, 0), NULL, 10);
+    uint64_t session_id = strtoull(PQgetvalue(res, r, 1), NULL, 10);
+    if (ord < 1 || ord > miss_count)
+      continue;
+    out_sessions[misses[ord - 1]] = session_id;
+  }
+  PQclear(res);
+  for (int m = 0; m < miss_count; m++) {
+    uint64_t session_id = out_sessions[misses[m]];
+    token_cache_u64_store(tls_session_cache, TOKEN_READ_CACHE_CAP,
+                          &tls_session_cache_next,
+                          &tokens[misses[m] * TOKEN_LENGTH],
+                          session_id > 0 ? DB_OK : DB_NOT_FOUND, session_id,
+                          now_ms);
+  }
+  free(misses);
+  return DB_OK;
+}
+
 DbStatus db_record_profile_terms_acceptance(
     const uint8_t *token, const char *profile_name,
     const uint8_t tos_hash[WAMBLE_FRAGMENT_HASH_LENGTH], const char *tos_text,
@@ -3864,8 +4371,13 @@ static DbBoardIdList db_list_boards_by_status(const char *status) {
 
 int db_apply_record_move(uint64_t board_id, uint64_t session_id,
                          const char *move_uci, int move_number) {
-  const char *query = "INSERT INTO moves (board_id, session_id, move_uci, "
-                      "move_number) VALUES ($1, $2, $3, $4)";
+  const char *query =
+      "WITH prior AS ("
+      "  SELECT 1 FROM moves WHERE board_id = $1 AND session_id = $2 LIMIT 1"
+      ") "
+      "INSERT INTO moves (board_id, session_id, move_uci, move_number) "
+      "VALUES ($1, $2, $3, $4) "
+      "RETURNING (SELECT COUNT(*) FROM prior)";
 
   char board_id_str[32];
   char session_id_str[32];
@@ -3883,12 +4395,16 @@ int db_apply_record_move(uint64_t board_id, uint64_t session_id,
 
   if (!res)
     return -1;
-  if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+  if (PQresultStatus(res) != PGRES_TUPLES_OK) {
     PQclear(res);
     return -1;
   }
 
+  int first_move =
+      PQntuples(res) > 0 && strcmp(PQgetvalue(res, 0, 0), "0") == 0;
   PQclear(res);
+  if (first_move)
+    db_leaderboard_note_first_move(session_id);
   return 0;
 }
 
@@ -4325,6 +4841,7 @@ int db_apply_record_payout_with_canonical(uint64_t board_id,
   }
 
   PQclear(res);
+  db_leaderboard_note_payout(session_id, strtod(points_awarded_str, NULL));
   return 0;
 }
 
@@ -4532,6 +5049,71 @@ int db_apply_update_player_rating(uint64_t session_id, double rating) {
     return -1;
   }
   PQclear(res);
+  db_leaderboard_note_rating(session_id, strtod(rating_str, NULL));
+  return 0;
+}
+
+int db_apply_update_player_ratings(const uint64_t *session_ids,
+                                   const double *ratings, int count) {
+  if (!session_ids || !ratings || count < 0)
+    return -1;
+  if (count == 0)
+    return 0;
+  if (count == 1)
+    return db_apply_update_player_rating(session_ids[0], ratings[0]);
+  const char *query =
+      "UPDATE players p SET rating = v.rating FROM (SELECT DISTINCT ON "
+      "(s.player_id) s.player_id, u.rating FROM unnest($1::bigint[], "
+      "$2::numeric[]) WITH ORDINALITY AS u(session_id, rating, ord) JOIN "
+      "sessions s ON s.id = u.session_id ORDER BY s.player_id, u.ord DESC) v "
+      "WHERE p.id = v.player_id";
+
+  size_t cap = (size_t)count * 32 + 3;
+  char *id_array = (char *)malloc(cap);
+  char *rating_array = (char *)malloc(cap);
+  if (!id_array || !rating_array) {
+    free(id_array);
+    free(rating_array);
+    return -1;
+  }
+  size_t id_len = 0;
+  size_t rating_len = 0;
+  id_array[id_len++] = '{';
+  rating_array[rating_len++] = '{';
+  for (int i = 0; i < count; i++) {
+    const char *sep = i > 0 ? "," : "";
+    id_len += (size_t)snprintf(id_array + id_len, cap - id_len, "%s%" PRIu64,
+                               sep, session_ids[i]);
+    rating_len += (size_t)snprintf(rating_array + rating_len,
+                                   cap - rating_len, "%s%.4f", sep,
+                                   ratings[i]);
+    if (id_len >= cap - 2 || rating_len >= cap - 2) {
+      free(id_array);
+      free(rating_array);
+      return -1;
+    }
+  }
+  id_array[id_len++] = '}';
+  id_array[id_len] = '\0';
+  rating_array[rating_len++] = '}';
+  rating_array[rating_len] = '\0';
+
+  const char *paramValues[] = {id_array, rating_array};
+  PGresult *res =
+      pq_exec_params_locked(query, 2, NULL, paramValues, NULL, NULL, 0);
+  free(id_array);
+  free(rating_array);
+  if (!res || PQresultStatus(res) != PGRES_COMMAND_OK) {
+    if (res)
+      PQclear(res);
+    return -1;
+  }
+  PQclear(res);
+  for (int i = 0; i < count; i++) {
+    char rating_str[32];
+    snprintf(rating_str, sizeof(rating_str), "%.4f", ratings[i]);
+    db_leaderboard_note_rating(session_ids[i], strtod(rating_str, NULL));
+  }
   return 0;
 }
 
@@ -5369,19 +5951,213 @@ db_get_persistent_player_stats(const uint8_t *public_key,
   return DB_OK;
 }
 
+#define LEADERBOARD_ROW_QUERY                                                  \
+  "SELECT s.id, COALESCE(s.player_id, 0), s.total_score, "                     \
+  "COALESCE(p.rating, 0), s.games_played, "                                    \
+  "CASE WHEN p.public_key IS NULL THEN '' ELSE ENCODE(p.public_key, "          \
+  "'hex') END, COALESCE(gh.handle, '') "                                       \
+  "FROM sessions s LEFT JOIN players p ON p.id = s.player_id "                 \
+  "LEFT JOIN global_identity_handles gh "                                      \
+  "ON gh.global_identity_id = s.global_identity_id"
+
+static const char *const leaderboard_session_query =
+    LEADERBOARD_ROW_QUERY " WHERE s.id = $1";
+static const char *const leaderboard_player_query =
+    LEADERBOARD_ROW_QUERY " WHERE s.player_id = "
+                          "(SELECT player_id FROM sessions WHERE id = $1)";
+
+static WAMBLE_THREAD_LOCAL DbLeaderboardEntry
+    tls_leaderboard_rows[WAMBLE_MAX_LEADERBOARD_ENTRIES];
+static WAMBLE_THREAD_LOCAL char *tls_leaderboard_self_handle;
+
+static void leaderboard_row_from_result(PGresult *res, int i,
+                                        WambleLeaderboardRow *row) {
+  memset(row, 0, sizeof(*row));
+  row->session_id = strtoull(PQgetvalue(res, i, 0), NULL, 10);
+  row->player_id = strtoull(PQgetvalue(res, i, 1), NULL, 10);
+  row->score = strtod(PQgetvalue(res, i, 2), NULL);
+  row->rating = strtod(PQgetvalue(res, i, 3), NULL);
+  row->games_played = (uint32_t)strtoul(PQgetvalue(res, i, 4), NULL, 10);
+  const char *pub_hex = PQgetvalue(res, i, 5);
+  if (pub_hex && pub_hex[0]) {
+    hex_to_bytes(pub_hex, row->public_key, WAMBLE_PUBLIC_KEY_LENGTH);
+    row->has_identity = 1;
+    snprintf(row->handle, sizeof(row->handle), "%s", PQgetvalue(res, i, 6));
+  }
+}
+
+static void leaderboard_entry_from_row(DbLeaderboardEntry *e,
+                                       const WambleLeaderboardRow *row,
+                                       uint32_t rank) {
+  memset(e, 0, sizeof(*e));
+  e->rank = rank;
+  e->session_id = row->session_id;
+  e->score = row->score;
+  e->rating = row->rating;
+  e->games_played = row->games_played;
+  e->has_identity = row->has_identity;
+  memcpy(e->public_key, row->public_key, WAMBLE_PUBLIC_KEY_LENGTH);
+  if (row->has_identity && row->handle[0])
+    e->handle = wamble_strdup(row->handle);
+}
+
+static int db_leaderboard_seed(const char *store) {
+  uint64_t seed = leaderboard_index_seed_begin(store);
+  if (seed == 0)
+    return -1;
+  PGresult *res = pq_exec_locked(LEADERBOARD_ROW_QUERY);
+  if (!res || PQresultStatus(res) != PGRES_TUPLES_OK) {
+    if (res)
+      PQclear(res);
+    leaderboard_index_reset(store);
+    return -1;
+  }
+  int n = PQntuples(res);
+  for (int i = 0; i < n; i++) {
+    WambleLeaderboardRow row;
+    leaderboard_row_from_result(res, i, &row);
+    if (leaderboard_index_seed_row(store, seed, &row) != 0)
+      break;
+  }
+  PQclear(res);
+  return leaderboard_index_seed_end(store, seed);
+}
+
+static void db_leaderboard_refresh(const char *store, const char *query,
+                                   uint64_t id) {
+  if (!leaderboard_index_ready(store))
+    return;
+  char id_str[32];
+  snprintf(id_str, sizeof(id_str), "%" PRIu64, id);
+  const char *params[] = {id_str};
+  PGresult *res = pq_exec_params_locked(query, 1, NULL, params, NULL, NULL, 0);
+  if (!res || PQresultStatus(res) != PGRES_TUPLES_OK) {
+    if (res)
+      PQclear(res);
+    leaderboard_index_reset(store);
+    return;
+  }
+  int n = PQntuples(res);
+  for (int i = 0; i < n; i++) {
+    WambleLeaderboardRow row;
+    leaderboard_row_from_result(res, i, &row);
+    if (leaderboard_index_put(store, &row) != 0)
+      break;
+  }
+  PQclear(res);
+}
+
+static void db_leaderboard_note_session(uint64_t session_id) {
+  char store[512];
+  if (profile_conninfo(store, sizeof store) == 0)
+    db_leaderboard_refresh(store, leaderboard_session_query, session_id);
+}
+
+static void db_leaderboard_note_new_session(uint64_t session_id,
+                                            uint64_t player_id) {
+  char store[512];
+  if (profile_conninfo(store, sizeof store) != 0)
+    return;
+  if (player_id > 0) {
+    db_leaderboard_refresh(store, leaderboard_session_query, session_id);
+    return;
+  }
+  WambleLeaderboardRow row;
+  memset(&row, 0, sizeof(row));
+  row.session_id = session_id;
+  (void)leaderboard_index_put(store, &row);
+}
+
+static void db_leaderboard_note_payout(uint64_t session_id, double points) {
+  char store[512];
+  if (profile_conninfo(store, sizeof store) != 0)
+    return;
+  if (leaderboard_index_add_score(store, session_id, points) != 0)
+    db_leaderboard_refresh(store, leaderboard_session_query, session_id);
+}
+
+static void db_leaderboard_note_first_move(uint64_t session_id) {
+  char store[512];
+  if (profile_conninfo(store, sizeof store) != 0)
+    return;
+  if (leaderboard_index_add_game(store, session_id) != 0)
+    db_leaderboard_refresh(store, leaderboard_session_query, session_id);
+}
+
+static void db_leaderboard_note_rating(uint64_t session_id, double rating) {
+  char store[512];
+  if (profile_conninfo(store, sizeof store) != 0)
+    return;
+  if (leaderboard_index_set_rating(store, session_id, rating) != 0)
+    db_leaderboard_refresh(store, leaderboard_player_query, session_id);
+}
+
+void db_warm_leaderboard_index(void) {
+  char store[512];
+  if (profile_conninfo(store, sizeof store) != 0 ||
+      leaderboard_index_ready(store))
+    return;
+  (void)db_leaderboard_seed(store);
+}
+
+void db_invalidate_leaderboard_index(void) { leaderboard_index_reset(NULL); }
+
+static int db_get_leaderboard_from_index(uint64_t requester_session_id,
+                                         uint8_t leaderboard_type, int limit,
+                                         int offset, DbLeaderboardResult *out) {
+  WambleLeaderboardRow rows[WAMBLE_MAX_LEADERBOARD_ENTRIES];
+  WambleLeaderboardRow self;
+  int count = 0;
+  uint32_t self_rank = 0;
+  uint32_t total = 0;
+  char store[512];
+  if (profile_conninfo(store, sizeof store) != 0)
+    return -1;
+  if (!leaderboard_index_ready(store) && db_leaderboard_seed(store) != 0)
+    return -1;
+  if (leaderboard_index_query(store, leaderboard_type, requester_session_id,
+                              limit, offset, rows, &count, &self, &self_rank,
+                              &total) != 0)
+    return -1;
+  if (requester_session_id > 0 && self_rank == 0) {
+    db_leaderboard_refresh(store, leaderboard_session_query,
+                           requester_session_id);
+    if (leaderboard_index_query(store, leaderboard_type, requester_session_id,
+                                limit, offset, rows, &count, &self,
+                                &self_rank, &total) != 0)
+      return -1;
+  }
+  for (int i = 0; i < count; i++) {
+    leaderboard_entry_from_row(&tls_leaderboard_rows[i], &rows[i],
+                               (uint32_t)(offset + i + 1));
+    if (requester_session_id > 0 &&
+        rows[i].session_id == requester_session_id && !out->self_in_rows) {
+      out->self_in_rows = 1;
+      out->self = tls_leaderboard_rows[i];
+    }
+  }
+  out->count = count;
+  out->total_count = total;
+  out->self_rank = self_rank;
+  if (!out->self_in_rows && self_rank > 0) {
+    leaderboard_entry_from_row(&out->self, &self, self_rank);
+    tls_leaderboard_self_handle = out->self.handle;
+  }
+  out->status = DB_OK;
+  return 0;
+}
+
 DbLeaderboardResult db_get_leaderboard(uint64_t requester_session_id,
                                        uint8_t leaderboard_type, int limit,
                                        int offset) {
-  static WAMBLE_THREAD_LOCAL DbLeaderboardEntry
-      rows[WAMBLE_MAX_LEADERBOARD_ENTRIES];
-  static WAMBLE_THREAD_LOCAL char *self_handle;
+  DbLeaderboardEntry *rows = tls_leaderboard_rows;
   DbLeaderboardResult out = {0};
   for (int i = 0; i < WAMBLE_MAX_LEADERBOARD_ENTRIES; i++) {
     free(rows[i].handle);
     rows[i].handle = NULL;
   }
-  free(self_handle);
-  self_handle = NULL;
+  free(tls_leaderboard_self_handle);
+  tls_leaderboard_self_handle = NULL;
   out.status = DB_ERR_EXEC;
   out.rows = rows;
   out.count = 0;
@@ -5399,6 +6175,10 @@ DbLeaderboardResult db_get_leaderboard(uint64_t requester_session_id,
   uint8_t effective_type = leaderboard_type;
   if (effective_type != WAMBLE_LEADERBOARD_RATING)
     effective_type = WAMBLE_LEADERBOARD_SCORE;
+  if (db_get_leaderboard_from_index(requester_session_id, effective_type,
+                                    effective_limit, effective_offset,
+                                    &out) == 0)
+    return out;
 
   char limit_str[16];
   char offset_str[16];
@@ -5577,8 +6357,9 @@ DbLeaderboardResult db_get_leaderboard(uint64_t requester_session_id,
         hex_to_bytes(pub_hex, e->public_key, WAMBLE_PUBLIC_KEY_LENGTH);
         e->has_identity = 1;
         if (PQgetvalue(self_res, 0, 5)[0])
-          self_handle = wamble_strdup(PQgetvalue(self_res, 0, 5));
-        e->handle = self_handle;
+          tls_leaderboard_self_handle =
+              wamble_strdup(PQgetvalue(self_res, 0, 5));
+        e->handle = tls_leaderboard_self_handle;
       }
     }
     PQclear(self_res);
@@ -5689,6 +6470,7 @@ int db_apply_link_session_to_pubkey(uint64_t session_id,
   PQclear(res);
   memset(tls_persistent_session_cache, 0, sizeof(tls_persistent_session_cache));
   tls_persistent_session_cache_next = 0;
+  db_leaderboard_note_session(session_id);
   return 0;
 }
 
@@ -5734,8 +6516,10 @@ int db_apply_unlink_session_identity(uint64_t session_id) {
     return -1;
   }
   PQclear(res);
+  treatment_assignment_cache_invalidate();
 
   memset(tls_persistent_session_cache, 0, sizeof(tls_persistent_session_cache));
   tls_persistent_session_cache_next = 0;
+  db_leaderboard_note_session(session_id);
   return 0;
 }
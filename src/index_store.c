@@ -0,0 +1,174 @@
+#include "../include/wamble/wamble.h"
+
+static void index_set_ensure_mutex(WambleIndexSet *set) {
+  if (!set->mutex_ready) {
+    wamble_mutex_init(&set->mutex);
+    set->mutex_ready = 1;
+  }
+}
+
+static WambleIndexStore *index_set_store_at(const WambleIndexSet *set, int i) {
+  return (WambleIndexStore *)((char *)set->stores +
+                              (size_t)i * set->store_size);
+}
+
+void index_set_lock(WambleIndexSet *set) {
+  index_set_ensure_mutex(set);
+  wamble_mutex_lock(&set->mutex);
+}
+
+void index_set_unlock(WambleIndexSet *set) { wamble_mutex_unlock(&set->mutex); }
+
+void *index_set_store_locked(WambleIndexSet *set, const char *key,
+                             int create) {
+  WambleIndexStore *free_store = NULL;
+  if (!key)
+    key = "";
+  for (int i = 0; i < set->max_stores; i++) {
+    WambleIndexStore *st = index_set_store_at(set, i);
+    if (st->used && strcmp(st->key, key) == 0)
+      return st;
+    if (!st->used && !free_store)
+      free_store = st;
+  }
+  if (!create || !free_store || strlen(key) >= sizeof(free_store->key))
+    return NULL;
+  snprintf(free_store->key, sizeof(free_store->key), "%s", key);
+  free_store->used = 1;
+  return free_store;
+}
+
+void *index_set_seeding_locked(WambleIndexSet *set, const char *key,
+                               uint64_t seed) {
+  WambleIndexStore *st = index_set_store_locked(set, key, 0);
+  return (st && st->seeding && st->seed == seed) ? st : NULL;
+}
+
+void index_set_clear_locked(WambleIndexSet *set, void *store) {
+  WambleIndexStore *st = (WambleIndexStore *)store;
+  st->ready = 0;
+  st->seeding = 0;
+  if (set->clear)
+    set->clear(store);
+}
+
+void index_set_reset(WambleIndexSet *set, const char *key) {
+  index_set_lock(set);
+  for (int i = 0; i < set->max_stores; i++) {
+    WambleIndexStore *st = index_set_store_at(set, i);
+    if (st->used && (!key || strcmp(st->key, key) == 0))
+      index_set_clear_locked(set, st);
+  }
+  index_set_unlock(set);
+}
+
+uint64_t index_set_seed_begin(WambleIndexSet *set, const char *key) {
+  uint64_t seed = 0;
+  index_set_lock(set);
+  WambleIndexStore *st = index_set_store_locked(set, key, 1);
+  if (st) {
+    index_set_clear_locked(set, st);
+    st->seeding = 1;
+    st->seed = ++set->last_seed;
+    seed = st->seed;
+  }
+  index_set_unlock(set);
+  return seed;
+}
+
+int index_set_seed_end(WambleIndexSet *set, const char *key, uint64_t seed,
+                       int (*finish)(void *store, void *arg), void *arg) {
+  int rc = -1;
+  index_set_lock(set);
+  WambleIndexStore *st = index_set_seeding_locked(set, key, seed);
+  if (st) {
+    if (!finish || finish(st, arg) == 0) {
+      st->seeding = 0;
+      st->ready = 1;
+      rc = 0;
+    } else {
+      index_set_clear_locked(set, st);
+    }
+  }
+  index_set_unlock(set);
+  return rc;
+}
+
+int index_set_ready(WambleIndexSet *set, const char *key) {
+  index_set_lock(set);
+  WambleIndexStore *st = index_set_store_locked(set, key, 0);
+  int ready = st && st->ready;
+  index_set_unlock(set);
+  return ready;
+}
+
+int index_rows_push(void **rows, int *count, int *capacity, size_t row_size,
+                    int initial_capacity, const void *row) {
+  if (*count == *capacity) {
+    int cap = *capacity ? *capacity * 2 : initial_capacity;
+    void *grown = realloc(*rows, row_size * (size_t)cap);
+    if (!grown)
+      return -1;
+    *rows = grown;
+    *capacity = cap;
+  }
+  memcpy((char *)*rows + (size_t)(*count)++ * row_size, row, row_size);
+  return 0;
+}
+
+int index_buckets_build(WambleIndexBuckets *out, int min_buckets,
+                        const void *rows, int count, size_t row_size,
+                        uint64_t (*hash)(const void *row),
+                        int (*same_group)(const void *a, const void *b)) {
+  int cap = min_buckets;
+  while (cap < count * 2)
+    cap <<= 1;
+  WambleIndexBucket *slots =
+      (WambleIndexBucket *)malloc(sizeof(*slots) * (size_t)cap);
+  if (!slots)
+    return -1;
+  for (int i = 0; i < cap; i++)
+    slots[i].start = -1;
+  const char *base = (const char *)rows;
+  for (int i = 0; i < count;) {
+    const void *head = base + (size_t)i * row_size;
+    int j = i + 1;
+    while (j < count && same_group(base + (size_t)j * row_size, head))
+      j++;
+    int slot = (int)(hash(head) & (uint64_t)(cap - 1));
+    while (slots[slot].start >= 0)
+      slot = (slot + 1) & (cap - 1);
+    slots[slot].start = i;
+    slots[slot].count = j - i;
+    i = j;
+  }
+  free(out->slots);
+  out->slots = slots;
+  out->cap = cap;
+  return 0;
+}
+
+void index_buckets_free(WambleIndexBuckets *buckets) {
+  free(buckets->slots);
+  buckets->slots = NULL;
+  buckets->cap = 0;
+}
+
+const WambleIndexBucket *
+index_buckets_find(const WambleIndexBuckets *buckets, uint64_t hash,
+                   const void *rows, size_t row_size,
+                   int (*matches)(const void *row, const void *probe),
+                   const void *probe) {
+  if (!buckets->slots || buckets->cap <= 0)
+    return NULL;
+  int slot = (int)(hash & (uint64_t)(buckets->cap - 1));
+  for (int n = 0; n < buckets->cap; n++) {
+    const WambleIndexBucket *b = &buckets->slots[slot];
+    if (b->start < 0)
+      return NULL;
+    if (matches((const char *)rows + (size_t)b->start * row_size, probe))
+      return b;
+    slot = (slot + 1) & (buckets->cap - 1);
+  }
+  return NULL;
+}
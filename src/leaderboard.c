@@ -0,0 +1,489 @@
+#include "../include/wamble/wamble.h"
+
+#define LEADERBOARD_MAX_STORES 16
+#define LEADERBOARD_FIXED_SCALE 10000.0
+
+enum { LB_ORDER_SCORE = 0, LB_ORDER_RATING = 1, LB_ORDER_COUNT = 2 };
+
+typedef struct LeaderboardNode {
+  WambleLeaderboardRow row;
+  int64_t score_key;
+  int64_t rating_key;
+  uint32_t priority;
+  int child[LB_ORDER_COUNT][2];
+  int size[LB_ORDER_COUNT];
+  int player_next;
+} LeaderboardNode;
+
+typedef struct LeaderboardStore {
+  WambleIndexStore base;
+  int dirty;
+  LeaderboardNode *nodes;
+  int count;
+  int capacity;
+  int root[LB_ORDER_COUNT];
+  int *session_slots;
+  uint64_t *player_keys;
+  int *player_heads;
+  int slot_cap;
+} LeaderboardStore;
+
+static void lb_store_clear(void *store) {
+  LeaderboardStore *st = (LeaderboardStore *)store;
+  st->dirty = 0;
+  st->count = 0;
+  st->root[LB_ORDER_SCORE] = -1;
+  st->root[LB_ORDER_RATING] = -1;
+  for (int i = 0; i < st->slot_cap; i++) {
+    st->session_slots[i] = -1;
+    st->player_keys[i] = 0;
+    st->player_heads[i] = -1;
+  }
+}
+
+static LeaderboardStore g_leaderboard_stores[LEADERBOARD_MAX_STORES];
+static WambleIndexSet g_leaderboard = {
+    .stores = g_leaderboard_stores,
+    .max_stores = LEADERBOARD_MAX_STORES,
+    .store_size = sizeof(LeaderboardStore),
+    .clear = lb_store_clear,
+};
+
+static int64_t lb_fixed(double value) {
+  return (int64_t)llround(value * LEADERBOARD_FIXED_SCALE);
+}
+
+static uint32_t lb_hash64(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return (uint32_t)x;
+}
+
+static int lb_before(const LeaderboardNode *a, const LeaderboardNode *b,
+                     int order) {
+  int64_t a_primary = order == LB_ORDER_RATING ? a->rating_key : a->score_key;
+  int64_t b_primary = order == LB_ORDER_RATING ? b->rating_key : b->score_key;
+  if (a_primary != b_primary)
+    return a_primary > b_primary;
+  int64_t a_secondary = order == LB_ORDER_RATING ? a->score_key : a->rating_key;
+  int64_t b_secondary = order == LB_ORDER_RATING ? b->score_key : b->rating_key;
+  if (a_secondary != b_secondary)
+    return a_secondary > b_secondary;
+  return a->row.session_id < b->row.session_id;
+}
+
+static int lb_size(const LeaderboardStore *st, int t, int order) {
+  return t < 0 ? 0 : st->nodes[t].size[order];
+}
+
+static void lb_pull(LeaderboardStore *st, int t, int order) {
+  LeaderboardNode *n = &st->nodes[t];
+  n->size[order] = 1 + lb_size(st, n->child[order][0], order) +
+                   lb_size(st, n->child[order][1], order);
+}
+
+static void lb_split(LeaderboardStore *st, int t, int key, int order, int *l,
+                     int *r) {
+  if (t < 0) {
+    *l = -1;
+    *r = -1;
+    return;
+  }
+  LeaderboardNode *n = &st->nodes[t];
+  if (lb_before(n, &st->nodes[key], order)) {
+    lb_split(st, n->child[order][1], key, order, &n->child[order][1], r);
+    *l = t;
+  } else {
+    lb_split(st, n->child[order][0], key, order, l, &n->child[order][0]);
+    *r = t;
+  }
+  lb_pull(st, t, order);
+}
+
+static int lb_merge(LeaderboardStore *st, int a, int b, int order) {
+  if (a < 0)
+    return b;
+  if (b < 0)
+    return a;
+  if (st->nodes[a].priority >= st->nodes[b].priority) {
+    st->nodes[a].child[order][1] =
+        lb_merge(st, st->nodes[a].child[order][1], b, order);
+    lb_pull(st, a, order);
+    return a;
+  }
+  st->nodes[b].child[order][0] =
+      lb_merge(st, a, st->nodes[b].child[order][0], order);
+  lb_pull(st, b, order);
+  return b;
+}
+
+static void lb_tree_insert(LeaderboardStore *st, int idx, int order) {
+  LeaderboardNode *n = &st->nodes[idx];
+  int l = -1;
+  int r = -1;
+  n->child[order][0] = -1;
+  n->child[order][1] = -1;
+  n->size[order] = 1;
+  lb_split(st, st->root[order], idx, order, &l, &r);
+  st->root[order] = lb_merge(st, lb_merge(st, l, idx, order), r, order);
+}
+
+static int lb_tree_erase(LeaderboardStore *st, int t, int idx, int order) {
+  if (t < 0)
+    return -1;
+  LeaderboardNode *n = &st->nodes[t];
+  if (t == idx)
+    return lb_merge(st, n->child[order][0], n->child[order][1], order);
+  if (lb_before(&st->nodes[idx], n, order))
+    n->child[order][0] = lb_tree_erase(st, n->child[order][0], idx, order);
+  else
+    n->child[order][1] = lb_tree_erase(st, n->child[order][1], idx, order);
+  lb_pull(st, t, order);
+  return t;
+}
+
+static uint32_t lb_rank(const LeaderboardStore *st, int idx, int order) {
+  uint32_t rank = 1;
+  int t = st->root[order];
+  while (t >= 0) {
+    const LeaderboardNode *n = &st->nodes[t];
+    int left_size = lb_size(st, n->child[order][0], order);
+    if (t == idx)
+      return rank + (uint32_t)left_size;
+    if (lb_before(&st->nodes[idx], n, order)) {
+      t = n->child[order][0];
+    } else {
+      rank += (uint32_t)left_size + 1u;
+      t = n->child[order][1];
+    }
+  }
+  return 0;
+}
+
+static void lb_collect(const LeaderboardStore *st, int t, int order, int *skip,
+                       WambleLeaderboardRow *rows, int limit, int *count) {
+  while (t >= 0 && *count < limit) {
+    const LeaderboardNode *n = &st->nodes[t];
+    int left_size = lb_size(st, n->child[order][0], order);
+    if (*skip >= left_size)
+      *skip -= left_size;
+    else
+      lb_collect(st, n->child[order][0], order, skip, rows, limit, count);
+    if (*count >= limit)
+      return;
+    if (*skip > 0)
+      (*skip)--;
+    else
+      rows[(*count)++] = n->row;
+    t = n->child[order][1];
+  }
+}
+
+static int lb_session_slot(const LeaderboardStore *st, uint64_t session_id) {
+  uint32_t mask = (uint32_t)st->slot_cap - 1u;
+  uint32_t i = lb_hash64(session_id) & mask;
+  while (st->session_slots[i] >= 0 &&
+         st->nodes[st->session_slots[i]].row.session_id != session_id)
+    i = (i + 1u) & mask;
+  return (int)i;
+}
+
+static int lb_player_slot(const LeaderboardStore *st, uint64_t player_id) {
+  uint32_t mask = (uint32_t)st->slot_cap - 1u;
+  uint32_t i = lb_hash64(player_id) & mask;
+  while (st->player_keys[i] != 0 && st->player_keys[i] != player_id)
+    i = (i + 1u) & mask;
+  return (int)i;
+}
+
+static int lb_find(const LeaderboardStore *st, uint64_t session_id) {
+  if (st->slot_cap <= 0 || session_id == 0)
+    return -1;
+  return st->session_slots[lb_session_slot(st, session_id)];
+}
+
+static int lb_reserve(LeaderboardStore *st, int needed) {
+  if (needed > st->capacity) {
+    int cap = st->capacity > 0 ? st->capacity * 2 : 256;
+    while (cap < needed)
+      cap *= 2;
+    LeaderboardNode *nodes = (LeaderboardNode *)realloc(
+        st->nodes, (size_t)cap * sizeof(*nodes));
+    if (!nodes)
+      return -1;
+    st->nodes = nodes;
+    st->capacity = cap;
+  }
+  if ((int64_t)needed * 2 <= st->slot_cap)
+    return 0;
+  int slot_cap = st->slot_cap > 0 ? st->slot_cap * 2 : 512;
+  while ((int64_t)needed * 2 > slot_cap)
+    slot_cap *= 2;
+  int *session_slots = (int *)malloc((size_t)slot_cap * sizeof(int));
+  uint64_t *player_keys =
+      (uint64_t *)calloc((size_t)slot_cap, sizeof(uint64_t));
+  int *player_heads = (int *)malloc((size_t)slot_cap * sizeof(int));
+  if (!session_slots || !player_keys || !player_heads) {
+    free(session_slots);
+    free(player_keys);
+    free(player_heads);
+    return -1;
+  }
+  uint64_t *old_keys = st->player_keys;
+  int *old_heads = st->player_heads;
+  int old_cap = st->slot_cap;
+  free(st->session_slots);
+  st->session_slots = session_slots;
+  st->player_keys = player_keys;
+  st->player_heads = player_heads;
+  st->slot_cap = slot_cap;
+  for (int i = 0; i < slot_cap; i++) {
+    session_slots[i] = -1;
+    player_heads[i] = -1;
+  }
+  for (int i = 0; i < st->count; i++)
+    session_slots[lb_session_slot(st, st->nodes[i].row.session_id)] = i;
+  for (int i = 0; i < old_cap; i++) {
+    if (old_keys[i] == 0)
+      continue;
+    int slot = lb_player_slot(st, old_keys[i]);
+    player_keys[slot] = old_keys[i];
+    player_heads[slot] = old_heads[i];
+  }
+  free(old_keys);
+  free(old_heads);
+  return 0;
+}
+
+static void lb_player_link(LeaderboardStore *st, int idx) {
+  LeaderboardNode *n = &st->nodes[idx];
+  n->player_next = -1;
+  if (n->row.player_id == 0)
+    return;
+  int slot = lb_player_slot(st, n->row.player_id);
+  st->player_keys[slot] = n->row.player_id;
+  n->player_next = st->player_heads[slot];
+  st->player_heads[slot] = idx;
+}
+
+static void lb_player_unlink(LeaderboardStore *st, int idx) {
+  LeaderboardNode *n = &st->nodes[idx];
+  if (n->row.player_id == 0)
+    return;
+  int *link = &st->player_heads[lb_player_slot(st, n->row.player_id)];
+  while (*link >= 0) {
+    if (*link == idx) {
+      *link = n->player_next;
+      break;
+    }
+    link = &st->nodes[*link].player_next;
+  }
+  n->player_next = -1;
+}
+
+static void lb_set_keys(LeaderboardNode *n, int64_t score_key,
+                        int64_t rating_key) {
+  n->score_key = score_key;
+  n->rating_key = rating_key;
+  n->row.score = (double)score_key / LEADERBOARD_FIXED_SCALE;
+  n->row.rating = (double)rating_key / LEADERBOARD_FIXED_SCALE;
+}
+
+static void lb_rekey_locked(LeaderboardStore *st, int idx, int64_t score_key,
+                            int64_t rating_key) {
+  LeaderboardNode *n = &st->nodes[idx];
+  if (n->score_key == score_key && n->rating_key == rating_key)
+    return;
+  for (int order = 0; order < LB_ORDER_COUNT; order++)
+    st->root[order] = lb_tree_erase(st, st->root[order], idx, order);
+  lb_set_keys(n, score_key, rating_key);
+  for (int order = 0; order < LB_ORDER_COUNT; order++)
+    lb_tree_insert(st, idx, order);
+}
+
+static void lb_copy_details(WambleLeaderboardRow *dst,
+                            const WambleLeaderboardRow *src) {
+  dst->games_played = src->games_played;
+  dst->has_identity = src->has_identity;
+  memcpy(dst->public_key, src->public_key, WAMBLE_PUBLIC_KEY_LENGTH);
+  snprintf(dst->handle, sizeof(dst->handle), "%s", src->handle);
+}
+
+static int lb_upsert_locked(LeaderboardStore *st,
+                            const WambleLeaderboardRow *row) {
+  int idx = lb_find(st, row->session_id);
+  if (idx >= 0) {
+    LeaderboardNode *n = &st->nodes[idx];
+    if (n->row.player_id != row->player_id) {
+      lb_player_unlink(st, idx);
+      n->row.player_id = row->player_id;
+      lb_player_link(st, idx);
+    }
+    lb_copy_details(&n->row, row);
+    lb_rekey_locked(st, idx, lb_fixed(row->score), lb_fixed(row->rating));
+    return 0;
+  }
+  if (row->session_id == 0 || lb_reserve(st, st->count + 1) != 0)
+    return -1;
+  idx = st->count++;
+  LeaderboardNode *n = &st->nodes[idx];
+  memset(n, 0, sizeof(*n));
+  n->row.session_id = row->session_id;
+  n->row.player_id = row->player_id;
+  lb_copy_details(&n->row, row);
+  lb_set_keys(n, lb_fixed(row->score), lb_fixed(row->rating));
+  n->priority = lb_hash64(row->session_id ^ 0x9e3779b97f4a7c15ULL);
+  st->session_slots[lb_session_slot(st, row->session_id)] = idx;
+  lb_player_link(st, idx);
+  for (int order = 0; order < LB_ORDER_COUNT; order++)
+    lb_tree_insert(st, idx, order);
+  return 0;
+}
+
+static LeaderboardStore *lb_live_store_locked(const char *store) {
+  LeaderboardStore *st = index_set_store_locked(&g_leaderboard, store, 0);
+  if (!st)
+    return NULL;
+  if (st->base.seeding) {
+    st->dirty = 1;
+    return NULL;
+  }
+  return st->base.ready ? st : NULL;
+}
+
+static int lb_seed_finish(void *store, void *arg) {
+  (void)arg;
+  return ((LeaderboardStore *)store)->dirty ? -1 : 0;
+}
+
+void leaderboard_index_reset(const char *store) {
+  index_set_reset(&g_leaderboard, store);
+}
+
+uint64_t leaderboard_index_seed_begin(const char *store) {
+  return index_set_seed_begin(&g_leaderboard, store);
+}
+
+int leaderboard_index_seed_row(const char *store, uint64_t seed,
+                               const WambleLeaderboardRow *row) {
+  int rc = -1;
+  if (!row)
+    return -1;
+  index_set_lock(&g_leaderboard);
+  LeaderboardStore *st = index_set_seeding_locked(&g_leaderboard, store, seed);
+  if (st) {
+    rc = lb_upsert_locked(st, row);
+    if (rc != 0)
+      st->dirty = 1;
+  }
+  index_set_unlock(&g_leaderboard);
+  return rc;
+}
+
+int leaderboard_index_seed_end(const char *store, uint64_t seed) {
+  return index_set_seed_end(&g_leaderboard, store, seed, lb_seed_finish, NULL);
+}
+
+int leaderboard_index_ready(const char *store) {
+  return index_set_ready(&g_leaderboard, store);
+}
+
+int leaderboard_index_put(const char *store, const WambleLeaderboardRow *row) {
+  int rc = -1;
+  if (!row)
+    return -1;
+  index_set_lock(&g_leaderboard);
+  LeaderboardStore *st = lb_live_store_locked(store);
+  if (st) {
+    rc = lb_upsert_locked(st, row);
+    if (rc != 0)
+      index_set_clear_locked(&g_leaderboard, st);
+  }
+  index_set_unlock(&g_leaderboard);
+  return rc;
+}
+
+int leaderboard_index_add_score(const char *store, uint64_t session_id,
+                                double points) {
+  int rc = -1;
+  index_set_lock(&g_leaderboard);
+  LeaderboardStore *st = lb_live_store_locked(store);
+  int idx = st ? lb_find(st, session_id) : -1;
+  if (idx >= 0) {
+    LeaderboardNode *n = &st->nodes[idx];
+    lb_rekey_locked(st, idx, n->score_key + lb_fixed(points), n->rating_key);
+    rc = 0;
+  }
+  index_set_unlock(&g_leaderboard);
+  return rc;
+}
+
+int leaderboard_index_add_game(const char *store, uint64_t session_id) {
+  int rc = -1;
+  index_set_lock(&g_leaderboard);
+  LeaderboardStore *st = lb_live_store_locked(store);
+  int idx = st ? lb_find(st, session_id) : -1;
+  if (idx >= 0) {
+    st->nodes[idx].row.games_played++;
+    rc = 0;
+  }
+  index_set_unlock(&g_leaderboard);
+  return rc;
+}
+
+int leaderboard_index_set_rating(const char *store, uint64_t session_id,
+                                 double rating) {
+  int rc = -1;
+  index_set_lock(&g_leaderboard);
+  LeaderboardStore *st = lb_live_store_locked(store);
+  int idx = st ? lb_find(st, session_id) : -1;
+  if (idx >= 0) {
+    uint64_t player_id = st->nodes[idx].row.player_id;
+    int64_t rating_key = lb_fixed(rating);
+    if (player_id != 0) {
+      int i = st->player_heads[lb_player_slot(st, player_id)];
+      while (i >= 0) {
+        lb_rekey_locked(st, i, st->nodes[i].score_key, rating_key);
+        i = st->nodes[i].player_next;
+      }
+    }
+    rc = 0;
+  }
+  index_set_unlock(&g_leaderboard);
+  return rc;
+}
+
+int leaderboard_index_query(const char *store, uint8_t leaderboard_type,
+                            uint64_t session_id, int limit, int offset,
+                            WambleLeaderboardRow *rows, int *out_count,
+                            WambleLeaderboardRow *out_self,
+                            uint32_t *out_self_rank, uint32_t *out_total) {
+  if (!rows || !out_count || !out_self || !out_self_rank || !out_total)
+    return -1;
+  int order = leaderboard_type == WAMBLE_LEADERBOARD_RATING ? LB_ORDER_RATING
+                                                            : LB_ORDER_SCORE;
+  index_set_lock(&g_leaderboard);
+  LeaderboardStore *st = index_set_store_locked(&g_leaderboard, store, 0);
+  if (!st || !st->base.ready) {
+    index_set_unlock(&g_leaderboard);
+    return -1;
+  }
+  int count = 0;
+  int skip = offset > 0 ? offset : 0;
+  if (limit > 0)
+    lb_collect(st, st->root[order], order, &skip, rows, limit, &count);
+  *out_count = count;
+  *out_total = (uint32_t)st->count;
+  *out_self_rank = 0;
+  memset(out_self, 0, sizeof(*out_self));
+  int idx = lb_find(st, session_id);
+  if (idx >= 0) {
+    *out_self_rank = lb_rank(st, idx, order);
+    *out_self = st->nodes[idx].row;
+  }
+  index_set_unlock(&g_leaderboard);
+  return 0;
+}
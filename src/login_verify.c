@@ -0,0 +1,297 @@
+#include "../include/wamble/wamble.h"
+
+int crypto_eddsa_check(const uint8_t signature[64],
+                       const uint8_t public_key[32], const uint8_t *message,
+                       size_t message_size);
+void network_wake_socket(wamble_socket_t sockfd);
+
+#define LOGIN_VERIFY_WORKERS 2
+#define LOGIN_VERIFY_MAX_QUEUED 1024
+#define LOGIN_VERIFY_BATCH 16
+#define LOGIN_VERIFY_MESSAGE_MAX 128
+
+typedef struct LoginVerifyJob {
+  uint64_t owner;
+  uint64_t ticket;
+  uint8_t signature[WAMBLE_LOGIN_SIGNATURE_LENGTH];
+  uint8_t public_key[WAMBLE_PUBLIC_KEY_LENGTH];
+  uint8_t message[LOGIN_VERIFY_MESSAGE_MAX];
+  size_t message_len;
+  wamble_socket_t wake_sockfd;
+  int verified;
+  struct LoginVerifyJob *next;
+} LoginVerifyJob;
+
+typedef struct LoginVerifyRetired {
+  uint64_t owner;
+  int pending;
+  struct LoginVerifyRetired *next;
+} LoginVerifyRetired;
+
+static wamble_mutex_t g_verify_mutex;
+static wamble_cond_t g_verify_cond;
+static int g_verify_initialized = 0;
+static int g_verify_stop = 0;
+static int g_verify_running = 0;
+static wamble_thread_t g_verify_threads[LOGIN_VERIFY_WORKERS];
+static LoginVerifyJob *g_verify_queue_head = NULL;
+static LoginVerifyJob *g_verify_queue_tail = NULL;
+static LoginVerifyJob *g_verify_done = NULL;
+static LoginVerifyRetired *g_verify_retired = NULL;
+static int g_verify_queued = 0;
+static uint64_t g_verify_next_owner = 1;
+static uint64_t g_verify_next_ticket = 1;
+
+static WAMBLE_THREAD_LOCAL uint64_t g_verify_owner = 0;
+static WAMBLE_THREAD_LOCAL int g_verify_outstanding = 0;
+
+static void ensure_verify_mutex_init(void) {
+  if (!g_verify_initialized) {
+    wamble_mutex_init(&g_verify_mutex);
+    wamble_cond_init(&g_verify_cond);
+    g_verify_initialized = 1;
+  }
+}
+
+static void login_verify_run(LoginVerifyJob *job) {
+  job->verified = crypto_eddsa_check(job->signature, job->public_key,
+                                     job->message, job->message_len) == 0;
+}
+
+static void login_verify_post_locked(LoginVerifyJob *job) {
+  for (LoginVerifyRetired **link = &g_verify_retired; *link;
+       link = &(*link)->next) {
+    LoginVerifyRetired *retired = *link;
+    if (retired->owner != job->owner)
+      continue;
+    if (--retired->pending <= 0) {
+      *link = retired->next;
+      free(retired);
+    }
+    free(job);
+    return;
+  }
+  job->next = g_verify_done;
+  g_verify_done = job;
+}
+
+static int login_verify_unlink_owner_locked(LoginVerifyJob **head,
+                                            LoginVerifyJob **tail,
+                                            uint64_t owner) {
+  int removed = 0;
+  LoginVerifyJob *last = NULL;
+  LoginVerifyJob **link = head;
+  while (*link) {
+    LoginVerifyJob *job = *link;
+    if (job->owner == owner) {
+      *link = job->next;
+      free(job);
+      removed++;
+      continue;
+    }
+    last = job;
+    link = &job->next;
+  }
+  if (tail)
+    *tail = last;
+  return removed;
+}
+
+static void *login_verify_worker(void *arg) {
+  (void)arg;
+  LoginVerifyJob *batch[LOGIN_VERIFY_BATCH];
+  wamble_socket_t wake[LOGIN_VERIFY_BATCH];
+  for (;;) {
+    wamble_mutex_lock(&g_verify_mutex);
+    while (!g_verify_stop && !g_verify_queue_head)
+      wamble_cond_wait(&g_verify_cond, &g_verify_mutex);
+    if (g_verify_stop) {
+      wamble_mutex_unlock(&g_verify_mutex);
+      return NULL;
+    }
+    int count = 0;
+    while (count < LOGIN_VERIFY_BATCH && g_verify_queue_head) {
+      batch[count++] = g_verify_queue_head;
+      g_verify_queue_head = g_verify_queue_head->next;
+      g_verify_queued--;
+    }
+    if (!g_verify_queue_head)
+      g_verify_queue_tail = NULL;
+    wamble_mutex_unlock(&g_verify_mutex);
+
+    for (int i = 0; i < count; i++)
+      login_verify_run(batch[i]);
+
+    int wake_count = 0;
+    wamble_mutex_lock(&g_verify_mutex);
+    for (int i = 0; i < count; i++) {
+      wamble_socket_t sockfd = batch[i]->wake_sockfd;
+      login_verify_post_locked(batch[i]);
+      if (sockfd == WAMBLE_INVALID_SOCKET)
+        continue;
+      int seen = 0;
+      for (int w = 0; w < wake_count && !seen; w++)
+        seen = wake[w] == sockfd;
+      if (!seen)
+        wake[wake_count++] = sockfd;
+    }
+    wamble_mutex_unlock(&g_verify_mutex);
+    for (int w = 0; w < wake_count; w++)
+      network_wake_socket(wake[w]);
+  }
+}
+
+static void login_verify_free_list(LoginVerifyJob *job) {
+  while (job) {
+    LoginVerifyJob *next = job->next;
+    free(job);
+    job = next;
+  }
+}
+
+int login_verify_pool_init(void) {
+  ensure_verify_mutex_init();
+  wamble_mutex_lock(&g_verify_mutex);
+  if (g_verify_running) {
+    wamble_mutex_unlock(&g_verify_mutex);
+    return 0;
+  }
+  g_verify_stop = 0;
+  wamble_mutex_unlock(&g_verify_mutex);
+  int started = 0;
+  while (started < LOGIN_VERIFY_WORKERS &&
+         wamble_thread_create(&g_verify_threads[started], login_verify_worker,
+                              NULL) == 0)
+    started++;
+  wamble_mutex_lock(&g_verify_mutex);
+  g_verify_running = started;
+  wamble_mutex_unlock(&g_verify_mutex);
+  return started > 0 ? 0 : -1;
+}
+
+void login_verify_pool_shutdown(void) {
+  if (!g_verify_initialized)
+    return;
+  wamble_mutex_lock(&g_verify_mutex);
+  int running = g_verify_running;
+  g_verify_stop = 1;
+  wamble_cond_broadcast(&g_verify_cond);
+  wamble_mutex_unlock(&g_verify_mutex);
+  for (int i = 0; i < running; i++)
+    wamble_thread_join(g_verify_threads[i], NULL);
+  wamble_mutex_lock(&g_verify_mutex);
+  g_verify_running = 0;
+  g_verify_stop = 0;
+  login_verify_free_list(g_verify_queue_head);
+  login_verify_free_list(g_verify_done);
+  while (g_verify_retired) {
+    LoginVerifyRetired *next = g_verify_retired->next;
+    free(g_verify_retired);
+    g_verify_retired = next;
+  }
+  g_verify_queue_head = NULL;
+  g_verify_queue_tail = NULL;
+  g_verify_done = NULL;
+  g_verify_queued = 0;
+  wamble_mutex_unlock(&g_verify_mutex);
+}
+
+uint64_t login_verify_submit(const uint8_t *signature,
+                             const uint8_t *public_key,
+                             const uint8_t *message, size_t message_len,
+                             wamble_socket_t wake_sockfd) {
+  if (!signature || !public_key || !message || message_len == 0 ||
+      message_len > LOGIN_VERIFY_MESSAGE_MAX)
+    return 0;
+  ensure_verify_mutex_init();
+  LoginVerifyJob *job = (LoginVerifyJob *)calloc(1, sizeof(*job));
+  if (!job)
+    return 0;
+  memcpy(job->signature, signature, WAMBLE_LOGIN_SIGNATURE_LENGTH);
+  memcpy(job->public_key, public_key, WAMBLE_PUBLIC_KEY_LENGTH);
+  memcpy(job->message, message, message_len);
+  job->message_len = message_len;
+  job->wake_sockfd = wake_sockfd;
+
+  wamble_mutex_lock(&g_verify_mutex);
+  if (g_verify_running && g_verify_queued >= LOGIN_VERIFY_MAX_QUEUED) {
+    wamble_mutex_unlock(&g_verify_mutex);
+    free(job);
+    return 0;
+  }
+  if (!g_verify_owner)
+    g_verify_owner = g_verify_next_owner++;
+  job->owner = g_verify_owner;
+  job->ticket = g_verify_next_ticket++;
+  if (job->ticket == 0)
+    job->ticket = g_verify_next_ticket++;
+  uint64_t ticket = job->ticket;
+  if (g_verify_running) {
+    if (g_verify_queue_tail)
+      g_verify_queue_tail->next = job;
+    else
+      g_verify_queue_head = job;
+    g_verify_queue_tail = job;
+    g_verify_queued++;
+    wamble_cond_signal(&g_verify_cond);
+    wamble_mutex_unlock(&g_verify_mutex);
+  } else {
+    wamble_mutex_unlock(&g_verify_mutex);
+    login_verify_run(job);
+    wamble_mutex_lock(&g_verify_mutex);
+    login_verify_post_locked(job);
+    wamble_mutex_unlock(&g_verify_mutex);
+  }
+  g_verify_outstanding++;
+  return ticket;
+}
+
+int login_verify_poll(uint64_t *ticket, int *verified) {
+  if (!ticket || !verified || g_verify_outstanding <= 0)
+    return 0;
+  LoginVerifyJob *found = NULL;
+  wamble_mutex_lock(&g_verify_mutex);
+  LoginVerifyJob **link = &g_verify_done;
+  while (*link) {
+    if ((*link)->owner == g_verify_owner) {
+      found = *link;
+      *link = found->next;
+      break;
+    }
+    link = &(*link)->next;
+  }
+  wamble_mutex_unlock(&g_verify_mutex);
+  if (!found)
+    return 0;
+  *ticket = found->ticket;
+  *verified = found->verified;
+  free(found);
+  g_verify_outstanding--;
+  return 1;
+}
+
+int login_verify_pending(void) { return g_verify_outstanding; }
+
+void login_verify_thread_discard(void) {
+  if (g_verify_initialized && g_verify_owner) {
+    wamble_mutex_lock(&g_verify_mutex);
+    int removed = login_verify_unlink_owner_locked(
+        &g_verify_queue_head, &g_verify_queue_tail, g_verify_owner);
+    g_verify_queued -= removed;
+    removed +=
+        login_verify_unlink_owner_locked(&g_verify_done, NULL, g_verify_owner);
+    int in_flight = g_verify_outstanding - removed;
+    LoginVerifyRetired *retired =
+        in_flight > 0 ? (LoginVerifyRetired *)calloc(1, sizeof(*retired))
+                      : NULL;
+    if (retired) {
+      retired->owner = g_verify_owner;
+      retired->pending = in_flight;
+      retired->next = g_verify_retired;
+      g_verify_retired = retired;
+    }
+    wamble_mutex_unlock(&g_verify_mutex);
+  }
+  g_verify_owner = 0;
+  g_verify_outstanding = 0;
+}
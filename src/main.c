@@ -18,6 +18,9 @@ typedef struct WambleIntentBuffer WambleIntentBuffer;
 WambleIntentBuffer *wamble_intents_create(void);
 void wamble_intents_destroy(WambleIntentBuffer *buf);
 void wamble_set_intent_buffer(WambleIntentBuffer *buf);
+int login_verify_pool_init(void);
+void login_verify_pool_shutdown(void);
+void server_protocol_thread_cleanup(void);
 
 static WambleIntentBuffer *g_intents_main;
 static volatile sig_atomic_t g_reload_requested = 0;
@@ -286,6 +289,9 @@ static void process_config_reload_request(
   int loaded_from_db_snapshot = 0;
 
   LOG_INFO("Config reload requested");
+  db_invalidate_policy_index();
+  db_invalidate_treatment_index();
+  response_cache_bump_generation(WAMBLE_RESPONSE_CACHE_NAMESPACE_COUNT);
   (void)read_text_file(config_file, &attempt_cfg_text);
 
   cfg_snapshot = config_create_snapshot();
@@ -768,6 +774,9 @@ static int initialize_services(void) {
     LOG_INFO("Spectator manager initialized");
   }
 
+  if (login_verify_pool_init() != 0)
+    LOG_WARN("Login verification workers unavailable; verifying inline");
+
   int started = 0;
   ProfileStartStatus pst = start_profile_listeners(&started);
   if (pst != PROFILE_START_OK || started <= 0) {
@@ -1055,6 +1064,8 @@ static void run_main_loop(const char *config_file, const char *profile,
 
 static void shutdown_services(void) {
   stop_profile_listeners();
+  login_verify_pool_shutdown();
+  server_protocol_thread_cleanup();
   spectator_manager_shutdown();
   wamble_set_intent_buffer(NULL);
   wamble_intents_destroy(g_intents_main);
@@ -1,13 +1,36 @@
 #include "../include/wamble/wamble.h"
 #include <limits.h>
+#if defined(__linux__)
+#include <netinet/udp.h>
+#include <sys/uio.h>
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#define WAMBLE_UDP_OFFLOAD
+#endif
 void crypto_blake2b(uint8_t *hash, size_t hash_size, const uint8_t *msg,
                     size_t msg_size);
 #define WAMBLE_TRANSPORT_INITIAL_CAP 64
 #define WAMBLE_TRANSPORT_INITIAL_RTO_MS 250u
+#define WAMBLE_TRANSPORT_INITIAL_CWND 1u
+#define WAMBLE_TRANSPORT_MAX_CWND ((uint32_t)WAMBLE_ACK_BITMAP_BITS)
+#define WAMBLE_TRANSPORT_MIN_SSTHRESH 2u
+#define WAMBLE_TRANSPORT_SACK_LOSS_DISTANCE 3u
+#define WAMBLE_TRANSPORT_PACE_BURST 2u
+#define WAMBLE_TRANSPORT_PACE_UNIT 1000u
+#define WAMBLE_TRANSPORT_COMPRESS_MIN 64u
 #define WAMBLE_INBOUND_PUMP_BATCH 64u
 #define WAMBLE_CLASSIFY_BATCH 64u
 #define WAMBLE_DISPATCH_BATCH 64u
+#define WAMBLE_TRANSPORT_PACKET_SLOTS 256u
+#define WAMBLE_UDP_OFFLOAD_MAX_SEGMENTS 64u
+#define WAMBLE_UDP_OFFLOAD_MAX_BYTES 65507u
+#define WAMBLE_UDP_GRO_BUFFER_SIZE 65535u
 #define TRANSPORT_LANE_NONE ((size_t)-1)
+#define TRANSPORT_PACKET_SLOT_NONE UINT32_MAX
 
 typedef enum {
   TRANSPORT_PACKET_SOURCE_UDP = 0,
@@ -61,22 +84,28 @@ typedef struct TransportEndpointState {
   uint32_t rttvar_ms;
   uint32_t rto_ms;
   uint64_t last_rtt_sample_ms;
+  uint8_t capabilities;
+  WambleAckState ack_state;
+  uint32_t cwnd;
+  uint32_t ssthresh;
+  uint32_t cwnd_acked;
+  uint32_t recovery_seq;
+  uint32_t pace_tokens;
+  uint64_t pace_refill_ms;
+  uint32_t outbound_queued;
+  uint32_t fragments_in_flight;
+  size_t next_unsent_bundle;
 } TransportEndpointState;
 
-typedef struct TransportInboundEntry {
+typedef struct TransportPacketSlot {
   TransportPacketSource source;
   TransportEndpointId endpoint_id;
   struct sockaddr_in addr;
   size_t packet_len;
+  uint32_t next_free;
+  WambleMsgView view;
   uint8_t packet[WAMBLE_MAX_PACKET_SIZE];
-} TransportInboundEntry;
-
-typedef struct TransportDispatchEntry {
-  TransportPacketSource source;
-  TransportEndpointId endpoint_id;
-  struct sockaddr_in addr;
-  struct WambleMsg msg;
-} TransportDispatchEntry;
+} TransportPacketSlot;
 
 typedef struct ReliableBundle {
   uint64_t bundle_id;
@@ -88,7 +117,9 @@ typedef struct ReliableBundle {
   size_t payload_len;
   uint16_t chunk_count;
   uint16_t next_fragment_index;
+  uint16_t acked_fragments;
   uint8_t hash_algo;
+  uint8_t codec;
   uint8_t hash[WAMBLE_FRAGMENT_HASH_LENGTH];
   uint32_t req_seq;
   uint32_t transfer_id;
@@ -100,6 +131,12 @@ typedef struct ReliableBundle {
   struct sockaddr_in addr;
 } ReliableBundle;
 
+typedef struct TransportSharedPayload {
+  uint32_t refs;
+  size_t len;
+  uint8_t data[];
+} TransportSharedPayload;
+
 typedef struct TransportOutboundEntry {
   TransportOutboundVariant variant;
   TransportOutboundLane lane;
@@ -108,6 +145,7 @@ typedef struct TransportOutboundEntry {
   uint8_t token[TOKEN_LENGTH];
   uint8_t *payload;
   size_t payload_len;
+  struct TransportSharedPayload *shared;
   union {
     struct {
       uint32_t seq;
@@ -138,6 +176,9 @@ typedef struct TransportOutboundEntry {
 ServerStatus handle_message(wamble_socket_t sockfd, const struct WambleMsg *msg,
                             const struct sockaddr_in *cliaddr, int trust_tier,
                             const char *profile_name);
+int server_protocol_drain_login_verifications(wamble_socket_t sockfd,
+                                              const char *profile_name);
+int wamble_socket_bound_port(wamble_socket_t sock);
 int ws_gateway_pop_packet(WambleWsGateway *gateway, uint8_t *packet,
                           size_t packet_cap, size_t *out_packet_len,
                           struct sockaddr_in *out_cliaddr);
@@ -148,6 +189,9 @@ void ws_gateway_flush_outbound(WambleWsGateway *gateway);
 int ws_gateway_flush_route(const struct sockaddr_in *cliaddr);
 int network_enqueue_ack_after(const struct WambleMsg *msg,
                               const struct sockaddr_in *cliaddr);
+int network_set_endpoint_capabilities(const struct sockaddr_in *cliaddr,
+                                      const uint8_t *token,
+                                      uint8_t capabilities);
 int network_enqueue_reliable(const struct WambleMsg *msg,
                              const struct sockaddr_in *cliaddr, int timeout_ms,
                              int max_retries);
@@ -156,32 +200,40 @@ int send_unreliable_packet(wamble_socket_t sockfd, const struct WambleMsg *msg,
 
 #define CLIENT_SESSION_TREATMENT_CACHE_TTL_MS 3000ULL
 
+#define WAMBLE_TERMINAL_CACHE_MAX_SLOTS 8u
+#define WAMBLE_TERMINAL_CACHE_MAX_BUNDLE_PACKETS 1024
+#define WAMBLE_TERMINAL_ARENA_NONE UINT32_MAX
+
 typedef struct WambleTerminalCachePacket {
   size_t len;
   uint32_t seq;
+  uint32_t next;
   uint8_t token[TOKEN_LENGTH];
-  uint8_t *data;
+  uint8_t data[WAMBLE_MAX_PACKET_SIZE];
 } WambleTerminalCachePacket;
 
 typedef struct WambleTerminalCacheSlot {
   uint32_t req_seq;
   uint64_t stored_mono_ms;
   int packet_count;
-  int packet_cap;
-  WambleTerminalCachePacket *packets;
+  uint32_t head;
+  uint32_t tail;
 } WambleTerminalCacheSlot;
 
 typedef struct WambleClientSession {
   struct sockaddr_in addr;
   uint8_t token[TOKEN_LENGTH];
   int token_next_index;
+  int active;
+  int free_next;
+  int idle_prev;
+  int idle_next;
   uint32_t last_seq_num;
   time_t last_seen;
   uint32_t next_seq_num;
   char treatment_group_key[128];
   uint64_t treatment_group_cached_at_ms;
-  WambleTerminalCacheSlot *terminal_cache;
-  int terminal_cache_count;
+  WambleTerminalCacheSlot terminal_cache[WAMBLE_TERMINAL_CACHE_MAX_SLOTS];
 } WambleClientSession;
 
 typedef struct WambleCurrentRequest {
@@ -191,14 +243,26 @@ typedef struct WambleCurrentRequest {
 
 static WAMBLE_THREAD_LOCAL WambleCurrentRequest g_current_request;
 
+static WAMBLE_THREAD_LOCAL WambleTerminalCachePacket *terminal_arena;
+static WAMBLE_THREAD_LOCAL uint32_t terminal_arena_capacity = 0;
+static WAMBLE_THREAD_LOCAL uint32_t terminal_arena_live = 0;
+static WAMBLE_THREAD_LOCAL uint32_t terminal_arena_free_head =
+    WAMBLE_TERMINAL_ARENA_NONE;
+
 static WAMBLE_THREAD_LOCAL WambleClientSession *client_sessions;
 static WAMBLE_THREAD_LOCAL int num_sessions = 0;
 static WAMBLE_THREAD_LOCAL int client_sessions_capacity = 0;
+static WAMBLE_THREAD_LOCAL int session_free_head = -1;
+static WAMBLE_THREAD_LOCAL int session_idle_head = -1;
+static WAMBLE_THREAD_LOCAL int session_idle_tail = -1;
 static WAMBLE_THREAD_LOCAL uint32_t global_seq_num = 1;
 static WAMBLE_THREAD_LOCAL uint32_t global_fragment_transfer_id = 1;
 
 static WAMBLE_THREAD_LOCAL int *session_index_map;
 static WAMBLE_THREAD_LOCAL int session_index_map_capacity = 0;
+static WAMBLE_THREAD_LOCAL int session_index_map_tombstones = 0;
+
+#define WAMBLE_SESSION_MAP_TOMBSTONE (-2)
 
 typedef struct TokenSessionMapEntry {
   int used;
@@ -208,6 +272,7 @@ typedef struct TokenSessionMapEntry {
 
 static WAMBLE_THREAD_LOCAL TokenSessionMapEntry *token_session_index_map;
 static WAMBLE_THREAD_LOCAL int token_session_index_map_capacity = 0;
+static WAMBLE_THREAD_LOCAL int token_session_index_map_tombstones = 0;
 
 static int token_has_any_byte(const uint8_t *token);
 static int ensure_client_session_capacity(int needed);
@@ -236,7 +301,13 @@ static int transport_endpoint_update_rto_by_index(size_t idx,
                                                   int retransmitted);
 static uint16_t
 transport_outbound_entry_retry_count(const TransportOutboundEntry *entry);
-static int transport_reliable_bundle_fragment_acked(uint64_t bundle_id);
+static int transport_reliable_bundle_fragment_acked(uint64_t bundle_id,
+                                                    int retransmitted);
+static void transport_endpoint_enter_recovery(TransportEndpointId endpoint_id,
+                                              uint32_t seq);
+static int transport_endpoint_fill_window(TransportEndpointId endpoint_id);
+static size_t transport_reliable_bundle_abort(uint64_t bundle_id,
+                                              size_t pivot);
 static uint16_t
 transport_outbound_entry_max_retries(const TransportOutboundEntry *entry);
 static void transport_outbound_entry_arm_retry(TransportOutboundEntry *entry,
@@ -247,8 +318,13 @@ static int transport_outbound_contains_reliable(uint32_t seq,
                                                 const struct sockaddr_in *addr);
 static int
 transport_outbound_match_and_remove_ack(TransportEndpointId endpoint_id,
-                                        uint32_t seq, const uint8_t *token,
-                                        const struct sockaddr_in *cliaddr);
+                                        const WambleAckState *ack,
+                                        const uint8_t *token);
+static NetworkStatus serialize_packet_with_payload(
+    uint8_t ctrl, uint8_t header_version, const uint8_t *token,
+    uint64_t board_id, uint32_t seq_num, uint8_t flags, const uint8_t *payload,
+    size_t payload_len, uint8_t *buffer, size_t buffer_capacity,
+    size_t *out_len);
 
 static inline uint64_t mix64_s(uint64_t x) {
   x ^= x >> 33;
@@ -291,6 +367,7 @@ static int map_capacity_for_session_capacity(int session_capacity) {
 
 static void session_map_init(void) {
   int cap = session_map_capacity();
+  session_index_map_tombstones = 0;
   if (!session_index_map || cap <= 0)
     return;
   for (int i = 0; i < cap; i++)
@@ -299,6 +376,7 @@ static void session_map_init(void) {
 
 static void token_session_map_init(void) {
   int cap = token_session_index_map_capacity;
+  token_session_index_map_tombstones = 0;
   if (!token_session_index_map || cap <= 0)
     return;
   memset(token_session_index_map, 0,
@@ -311,29 +389,56 @@ static void session_map_put(const struct sockaddr_in *addr, int index) {
     return;
   uint64_t h = addr_hash_key(addr);
   int i = (int)(h % (uint64_t)cap);
+  int reuse = -1;
   for (int probe = 0; probe < cap; probe++) {
-    if (session_index_map[i] == -1) {
+    int cur = session_index_map[i];
+    if (cur == -1)
+      break;
+    if (cur == WAMBLE_SESSION_MAP_TOMBSTONE) {
+      if (reuse < 0)
+        reuse = i;
+    } else if (cur >= 0 &&
+               sockaddr_in_equal(&client_sessions[cur].addr, addr)) {
       session_index_map[i] = index;
       return;
     }
-    int cur = session_index_map[i];
-    if (cur >= 0) {
-      const struct sockaddr_in *saddr = &client_sessions[cur].addr;
-      if (sockaddr_in_equal(saddr, addr)) {
-        session_index_map[i] = index;
-        return;
-      }
-    }
     i = session_map_next(i, cap);
   }
+  if (reuse >= 0) {
+    session_index_map[reuse] = index;
+    session_index_map_tombstones--;
+  } else if (session_index_map[i] == -1) {
+    session_index_map[i] = index;
+  }
 }
 
 static void session_map_rebuild(void) {
   session_map_init();
   if (!client_sessions)
     return;
-  for (int i = 0; i < num_sessions; i++)
-    session_map_put(&client_sessions[i].addr, i);
+  for (int i = 0; i < num_sessions; i++) {
+    if (client_sessions[i].active)
+      session_map_put(&client_sessions[i].addr, i);
+  }
+}
+
+static void session_map_remove(const struct sockaddr_in *addr, int index) {
+  int cap = session_map_capacity();
+  if (!addr || !session_index_map || cap <= 0)
+    return;
+  uint64_t h = addr_hash_key(addr);
+  int i = (int)(h % (uint64_t)cap);
+  for (int probe = 0; probe < cap; probe++) {
+    int cur = session_index_map[i];
+    if (cur == -1)
+      return;
+    if (cur == index) {
+      session_index_map[i] = WAMBLE_SESSION_MAP_TOMBSTONE;
+      session_index_map_tombstones++;
+      return;
+    }
+    i = session_map_next(i, cap);
+  }
 }
 
 static int session_map_get(const struct sockaddr_in *addr) {
@@ -362,21 +467,35 @@ static int token_session_map_slot(const uint8_t *token, int create) {
     return -1;
   uint32_t h = wamble_token_hash32(token);
   int i = (int)(h % (uint64_t)cap);
+  int reuse = -1;
+  int empty = -1;
   for (int probe = 0; probe < cap; probe++) {
     TokenSessionMapEntry *entry = &token_session_index_map[i];
     if (!entry->used) {
-      if (!create)
-        return -1;
-      entry->used = 1;
-      memcpy(entry->token, token, TOKEN_LENGTH);
-      entry->head_index = -1;
-      return i;
+      empty = i;
+      break;
+    }
+    if (entry->used == 1) {
+      if (memcmp(entry->token, token, TOKEN_LENGTH) == 0)
+        return i;
+    } else if (reuse < 0) {
+      reuse = i;
     }
-    if (memcmp(entry->token, token, TOKEN_LENGTH) == 0)
-      return i;
     i = session_map_next(i, cap);
   }
-  return -1;
+  if (!create)
+    return -1;
+  if (reuse >= 0) {
+    token_session_index_map_tombstones--;
+    empty = reuse;
+  }
+  if (empty < 0)
+    return -1;
+  TokenSessionMapEntry *entry = &token_session_index_map[empty];
+  entry->used = 1;
+  memcpy(entry->token, token, TOKEN_LENGTH);
+  entry->head_index = -1;
+  return empty;
 }
 
 static void token_session_map_put(const uint8_t *token, int index) {
@@ -404,10 +523,14 @@ static void token_session_map_remove(const uint8_t *token, int index) {
     if (*link == index) {
       *link = session->token_next_index;
       session->token_next_index = -1;
-      return;
+      break;
     }
     link = &session->token_next_index;
   }
+  if (entry->head_index >= 0)
+    return;
+  entry->used = 2;
+  token_session_index_map_tombstones++;
 }
 
 static int token_session_map_head(const uint8_t *token) {
@@ -424,26 +547,71 @@ static void token_session_map_rebuild(void) {
   for (int i = 0; i < num_sessions; i++)
     client_sessions[i].token_next_index = -1;
   for (int i = 0; i < num_sessions; i++) {
-    if (token_has_any_byte(client_sessions[i].token))
+    if (client_sessions[i].active &&
+        token_has_any_byte(client_sessions[i].token))
       token_session_map_put(client_sessions[i].token, i);
   }
 }
 
+static void session_idle_unlink(int index) {
+  WambleClientSession *session = &client_sessions[index];
+  if (session->idle_prev >= 0)
+    client_sessions[session->idle_prev].idle_next = session->idle_next;
+  else
+    session_idle_head = session->idle_next;
+  if (session->idle_next >= 0)
+    client_sessions[session->idle_next].idle_prev = session->idle_prev;
+  else
+    session_idle_tail = session->idle_prev;
+  session->idle_prev = -1;
+  session->idle_next = -1;
+}
+
+static void session_idle_append(int index) {
+  WambleClientSession *session = &client_sessions[index];
+  session->idle_prev = session_idle_tail;
+  session->idle_next = -1;
+  if (session_idle_tail >= 0)
+    client_sessions[session_idle_tail].idle_next = index;
+  else
+    session_idle_head = index;
+  session_idle_tail = index;
+}
+
+static void client_session_touch(WambleClientSession *session) {
+  session->last_seen = wamble_now_wall();
+  int index = (int)(session - client_sessions);
+  if (session_idle_tail == index)
+    return;
+  session_idle_unlink(index);
+  session_idle_append(index);
+}
+
+static void session_slots_reset(void) {
+  num_sessions = 0;
+  session_free_head = -1;
+  session_idle_head = -1;
+  session_idle_tail = -1;
+}
+
 static WAMBLE_THREAD_LOCAL TransportEndpointState *transport_endpoints = NULL;
 static WAMBLE_THREAD_LOCAL size_t transport_endpoint_size = 0;
 static WAMBLE_THREAD_LOCAL size_t transport_endpoint_capacity = 0;
 static WAMBLE_THREAD_LOCAL TransportEndpointId transport_next_endpoint_id = 1;
 static WAMBLE_THREAD_LOCAL int defer_reliable_ack_wait = 0;
-static WAMBLE_THREAD_LOCAL TransportInboundEntry *transport_inbound_entries =
-    NULL;
-static WAMBLE_THREAD_LOCAL size_t transport_inbound_capacity = 0;
+static WAMBLE_THREAD_LOCAL TransportPacketSlot *transport_packet_slots = NULL;
+static WAMBLE_THREAD_LOCAL uint32_t transport_packet_free_head =
+    TRANSPORT_PACKET_SLOT_NONE;
+static WAMBLE_THREAD_LOCAL size_t transport_packet_free_size = 0;
+static WAMBLE_THREAD_LOCAL uint32_t *transport_inbound_ring = NULL;
 static WAMBLE_THREAD_LOCAL size_t transport_inbound_head = 0;
 static WAMBLE_THREAD_LOCAL size_t transport_inbound_size = 0;
-static WAMBLE_THREAD_LOCAL TransportDispatchEntry *transport_dispatch_entries =
-    NULL;
-static WAMBLE_THREAD_LOCAL size_t transport_dispatch_capacity = 0;
+static WAMBLE_THREAD_LOCAL uint32_t *transport_dispatch_ring = NULL;
 static WAMBLE_THREAD_LOCAL size_t transport_dispatch_head = 0;
 static WAMBLE_THREAD_LOCAL size_t transport_dispatch_size = 0;
+static WAMBLE_THREAD_LOCAL struct WambleMsg *transport_request_msg = NULL;
+static WAMBLE_THREAD_LOCAL uint32_t transport_request_msg_slot =
+    TRANSPORT_PACKET_SLOT_NONE;
 static WAMBLE_THREAD_LOCAL TransportOutboundEntry *transport_outbound_entries =
     NULL;
 static WAMBLE_THREAD_LOCAL size_t transport_outbound_size = 0;
@@ -455,6 +623,316 @@ static WAMBLE_THREAD_LOCAL uint64_t transport_next_reliable_bundle_id = 1;
 static WAMBLE_THREAD_LOCAL uint64_t runtime_next_deadline_at_ms = 0;
 static WAMBLE_THREAD_LOCAL uint64_t runtime_retry_after_ms = 0;
 
+static int transport_udp_sendto(wamble_socket_t sockfd, const uint8_t *data,
+                                size_t len, const struct sockaddr_in *addr) {
+  ssize_t bytes_sent = sendto(sockfd, (const char *)data,
+#ifdef WAMBLE_PLATFORM_WINDOWS
+                              (int)len,
+#else
+                              len,
+#endif
+                              0, (const struct sockaddr *)addr,
+#ifdef WAMBLE_PLATFORM_WINDOWS
+                              (int)sizeof(*addr)
+#else
+                              (wamble_socklen_t)sizeof(*addr)
+#endif
+  );
+  return bytes_sent < 0 ? -1 : 0;
+}
+
+#ifdef WAMBLE_UDP_OFFLOAD
+typedef struct TransportUdpBatch {
+  wamble_socket_t sockfd;
+  struct sockaddr_in addr;
+  uint8_t *data;
+  size_t len;
+  size_t segment_size;
+  uint32_t segments;
+  uint32_t failed;
+} TransportUdpBatch;
+
+static WAMBLE_THREAD_LOCAL TransportUdpBatch transport_udp_batch;
+static WAMBLE_THREAD_LOCAL int transport_udp_gso_unsupported = 0;
+static WAMBLE_THREAD_LOCAL wamble_socket_t transport_udp_gro_sockfd =
+    WAMBLE_INVALID_SOCKET;
+static WAMBLE_THREAD_LOCAL int transport_udp_gro_enabled = 0;
+static WAMBLE_THREAD_LOCAL uint8_t *transport_udp_gro_buffer;
+
+static int transport_udp_send_segmented(TransportUdpBatch *batch) {
+  char control[CMSG_SPACE(sizeof(uint16_t))];
+  memset(control, 0, sizeof(control));
+  struct iovec iov;
+  iov.iov_base = batch->data;
+  iov.iov_len = batch->len;
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = &batch->addr;
+  msg.msg_namelen = (socklen_t)sizeof(batch->addr);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+  cm->cmsg_level = IPPROTO_UDP;
+  cm->cmsg_type = UDP_SEGMENT;
+  cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+  uint16_t segment_size = (uint16_t)batch->segment_size;
+  memcpy(CMSG_DATA(cm), &segment_size, sizeof(segment_size));
+  if (sendmsg(batch->sockfd, &msg, 0) >= 0)
+    return 0;
+  if (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT ||
+      errno == EOPNOTSUPP)
+    transport_udp_gso_unsupported = 1;
+  return -1;
+}
+
+static void transport_udp_batch_flush(void) {
+  TransportUdpBatch *batch = &transport_udp_batch;
+  if (batch->segments == 0)
+    return;
+  if (batch->segments == 1 || transport_udp_gso_unsupported ||
+      transport_udp_send_segmented(batch) != 0) {
+    for (size_t off = 0; off < batch->len; off += batch->segment_size) {
+      size_t len = batch->len - off;
+      if (len > batch->segment_size)
+        len = batch->segment_size;
+      if (transport_udp_sendto(batch->sockfd, batch->data + off, len,
+                               &batch->addr) != 0)
+        batch->failed++;
+    }
+  }
+  batch->len = 0;
+  batch->segments = 0;
+}
+
+static int transport_udp_batch_accepts(wamble_socket_t sockfd, size_t len,
+                                       const struct sockaddr_in *addr) {
+  const TransportUdpBatch *batch = &transport_udp_batch;
+  return batch->sockfd == sockfd && sockaddr_in_equal(&batch->addr, addr) &&
+         len <= batch->segment_size && batch->len % batch->segment_size == 0 &&
+         batch->segments < WAMBLE_UDP_OFFLOAD_MAX_SEGMENTS &&
+         batch->len + len <= WAMBLE_UDP_OFFLOAD_MAX_BYTES;
+}
+
+static int transport_udp_gro_active(wamble_socket_t sockfd) {
+  if (transport_udp_gro_sockfd != sockfd) {
+    int optval = 0;
+    socklen_t optlen = (socklen_t)sizeof(optval);
+    transport_udp_gro_enabled =
+        getsockopt(sockfd, IPPROTO_UDP, UDP_GRO, &optval, &optlen) == 0 &&
+        optval != 0;
+    transport_udp_gro_sockfd = sockfd;
+  }
+  if (transport_udp_gro_enabled && !transport_udp_gro_buffer)
+    transport_udp_gro_buffer = (uint8_t *)malloc(WAMBLE_UDP_GRO_BUFFER_SIZE);
+  return transport_udp_gro_enabled && transport_udp_gro_buffer;
+}
+#endif
+
+static int transport_udp_send(wamble_socket_t sockfd, const uint8_t *data,
+                              size_t len, const struct sockaddr_in *addr) {
+#ifdef WAMBLE_UDP_OFFLOAD
+  TransportUdpBatch *batch = &transport_udp_batch;
+  if (len > 0 && get_config()->udp_segment_offload &&
+      !transport_udp_gso_unsupported) {
+    if (batch->segments && !transport_udp_batch_accepts(sockfd, len, addr))
+      transport_udp_batch_flush();
+    if (!batch->data)
+      batch->data = (uint8_t *)malloc(WAMBLE_UDP_OFFLOAD_MAX_BYTES);
+    if (batch->data) {
+      if (batch->segments == 0) {
+        batch->sockfd = sockfd;
+        batch->addr = *addr;
+        batch->segment_size = len;
+      }
+      memcpy(batch->data + batch->len, data, len);
+      batch->len += len;
+      batch->segments++;
+      return 0;
+    }
+  }
+#endif
+  return transport_udp_sendto(sockfd, data, len, addr);
+}
+
+static uint32_t transport_udp_batch_finish(void) {
+#ifdef WAMBLE_UDP_OFFLOAD
+  transport_udp_batch_flush();
+  uint32_t failed = transport_udp_batch.failed;
+  transport_udp_batch.failed = 0;
+  return failed;
+#else
+  return 0;
+#endif
+}
+
+static void transport_udp_offload_release(void) {
+#ifdef WAMBLE_UDP_OFFLOAD
+  free(transport_udp_batch.data);
+  memset(&transport_udp_batch, 0, sizeof(transport_udp_batch));
+  free(transport_udp_gro_buffer);
+  transport_udp_gro_buffer = NULL;
+  transport_udp_gro_sockfd = WAMBLE_INVALID_SOCKET;
+  transport_udp_gro_enabled = 0;
+  transport_udp_gso_unsupported = 0;
+#endif
+}
+
+void network_configure_udp_offload(wamble_socket_t sockfd, int enabled) {
+#ifdef WAMBLE_UDP_OFFLOAD
+  int optval = enabled ? 1 : 0;
+  (void)setsockopt(sockfd, IPPROTO_UDP, UDP_GRO, (const char *)&optval,
+                   sizeof(optval));
+  transport_udp_gro_sockfd = WAMBLE_INVALID_SOCKET;
+#else
+  (void)sockfd;
+  (void)enabled;
+#endif
+}
+
+#define WAMBLE_RATE_BUCKET_MIN_CAPACITY 64u
+#define WAMBLE_RATE_BUCKET_PROBE 8u
+#define WAMBLE_RATE_BUCKET_UNIT 1000u
+#define WAMBLE_RATE_BUCKET_IDLE_MS 1000u
+
+typedef struct RateBucket {
+  int used;
+  uint8_t key[TOKEN_LENGTH];
+  uint64_t refill_ms;
+  uint64_t milli_tokens;
+} RateBucket;
+
+typedef struct RateBucketTable {
+  RateBucket *slots;
+  size_t capacity;
+  RateBucket overflow;
+} RateBucketTable;
+
+static WAMBLE_THREAD_LOCAL RateBucketTable rate_token_buckets;
+static WAMBLE_THREAD_LOCAL RateBucketTable rate_addr_buckets;
+
+static void rate_bucket_table_release(RateBucketTable *table) {
+  free(table->slots);
+  table->slots = NULL;
+  table->capacity = 0;
+  memset(&table->overflow, 0, sizeof(table->overflow));
+}
+
+static uint64_t rate_bucket_hash(const uint8_t key[TOKEN_LENGTH]) {
+  uint64_t lo = 0;
+  uint64_t hi = 0;
+  memcpy(&lo, key, sizeof(lo));
+  memcpy(&hi, key + sizeof(lo), sizeof(hi));
+  return mix64_s(lo ^ mix64_s(hi));
+}
+
+static int rate_bucket_idle(const RateBucket *bucket, uint64_t now) {
+  return !bucket->used ||
+         now >= bucket->refill_ms + WAMBLE_RATE_BUCKET_IDLE_MS;
+}
+
+static RateBucket *rate_bucket_probe(RateBucket *slots, size_t capacity,
+                                     const uint8_t key[TOKEN_LENGTH],
+                                     uint64_t now, int *found) {
+  RateBucket *reuse = NULL;
+  uint64_t h = rate_bucket_hash(key);
+  size_t window =
+      capacity < WAMBLE_RATE_BUCKET_PROBE ? capacity : WAMBLE_RATE_BUCKET_PROBE;
+  *found = 0;
+  for (size_t p = 0; p < window; p++) {
+    RateBucket *bucket = &slots[(h + p) & (capacity - 1u)];
+    if (bucket->used && memcmp(bucket->key, key, TOKEN_LENGTH) == 0) {
+      *found = 1;
+      return bucket;
+    }
+    if (!reuse && rate_bucket_idle(bucket, now))
+      reuse = bucket;
+  }
+  return reuse;
+}
+
+static size_t rate_bucket_max_capacity(void) {
+  int players = get_config()->max_players;
+  size_t limit = players > 0 ? (size_t)players * 2u : 1u;
+  size_t capacity = WAMBLE_RATE_BUCKET_MIN_CAPACITY;
+  while (capacity < limit)
+    capacity <<= 1;
+  return capacity;
+}
+
+static int rate_bucket_table_grow(RateBucketTable *table, uint64_t now) {
+  size_t next = table->capacity ? table->capacity * 2u
+                                : WAMBLE_RATE_BUCKET_MIN_CAPACITY;
+  if (next > rate_bucket_max_capacity())
+    return -1;
+  RateBucket *slots = calloc(next, sizeof(*slots));
+  if (!slots)
+    return -1;
+  for (size_t i = 0; i < table->capacity; i++) {
+    RateBucket *old = &table->slots[i];
+    if (rate_bucket_idle(old, now))
+      continue;
+    int found = 0;
+    RateBucket *dst = rate_bucket_probe(slots, next, old->key, now, &found);
+    if (dst)
+      *dst = *old;
+  }
+  free(table->slots);
+  table->slots = slots;
+  table->capacity = next;
+  return 0;
+}
+
+static int rate_bucket_take(RateBucket *bucket, int max_per_sec,
+                            uint64_t now) {
+  uint64_t burst = (uint64_t)max_per_sec * WAMBLE_RATE_BUCKET_UNIT;
+  if (now > bucket->refill_ms) {
+    uint64_t refill = (now - bucket->refill_ms) * (uint64_t)max_per_sec;
+    bucket->milli_tokens = bucket->milli_tokens + refill > burst
+                               ? burst
+                               : bucket->milli_tokens + refill;
+  }
+  bucket->refill_ms = now;
+  if (bucket->milli_tokens < WAMBLE_RATE_BUCKET_UNIT)
+    return 0;
+  bucket->milli_tokens -= WAMBLE_RATE_BUCKET_UNIT;
+  return 1;
+}
+
+static int rate_bucket_allow(RateBucketTable *table,
+                             const uint8_t key[TOKEN_LENGTH], int max_per_sec,
+                             uint64_t now) {
+  if (!key || max_per_sec <= 0)
+    return 1;
+  int found = 0;
+  RateBucket *bucket =
+      table->slots
+          ? rate_bucket_probe(table->slots, table->capacity, key, now, &found)
+          : NULL;
+  while (!bucket) {
+    if (rate_bucket_table_grow(table, now) != 0) {
+      if (!table->overflow.used) {
+        table->overflow.used = 1;
+        table->overflow.refill_ms = now;
+        table->overflow.milli_tokens =
+            (uint64_t)max_per_sec * WAMBLE_RATE_BUCKET_UNIT;
+      }
+      return rate_bucket_take(&table->overflow, max_per_sec, now);
+    }
+    bucket = rate_bucket_probe(table->slots, table->capacity, key, now, &found);
+  }
+  if (!found) {
+    bucket->used = 1;
+    memcpy(bucket->key, key, TOKEN_LENGTH);
+    bucket->refill_ms = now;
+    bucket->milli_tokens = table->capacity < rate_bucket_max_capacity()
+                               ? (uint64_t)max_per_sec * WAMBLE_RATE_BUCKET_UNIT
+                               : WAMBLE_RATE_BUCKET_UNIT;
+  }
+  return rate_bucket_take(bucket, max_per_sec, now);
+}
+
 static void network_runtime_reset_drive_schedule(void) {
   runtime_next_deadline_at_ms = 0;
   runtime_retry_after_ms = 0;
@@ -473,30 +951,60 @@ static void transport_endpoint_init(TransportEndpointState *endpoint,
     memcpy(endpoint->token, token, TOKEN_LENGTH);
   endpoint->next_reliable_seq = 1;
   endpoint->rto_ms = WAMBLE_TRANSPORT_INITIAL_RTO_MS;
+  endpoint->cwnd = WAMBLE_TRANSPORT_INITIAL_CWND;
+  endpoint->ssthresh = WAMBLE_TRANSPORT_MAX_CWND;
+  endpoint->pace_tokens = WAMBLE_TRANSPORT_PACE_BURST * WAMBLE_TRANSPORT_PACE_UNIT;
+}
+
+static void transport_shared_payload_release(TransportSharedPayload *shared) {
+  if (shared && --shared->refs == 0)
+    free(shared);
+}
+
+static void transport_outbound_entry_free(TransportOutboundEntry *entry) {
+  free(entry->payload);
+  transport_shared_payload_release(entry->shared);
+}
+
+static const uint8_t *
+transport_outbound_entry_bytes(const TransportOutboundEntry *entry,
+                               uint8_t *scratch) {
+  if (!entry->shared)
+    return entry->payload;
+  memcpy(scratch, entry->shared->data, entry->payload_len);
+  memcpy(scratch + 4, entry->token, TOKEN_LENGTH);
+  return scratch;
 }
 
 static void transport_runtime_release(void) {
   for (size_t i = 0; i < transport_outbound_size; i++)
-    free(transport_outbound_entries[i].payload);
+    transport_outbound_entry_free(&transport_outbound_entries[i]);
   for (size_t i = 0; i < transport_reliable_bundle_size; i++)
     free(transport_reliable_bundles[i].payload);
   free(transport_endpoints);
-  free(transport_inbound_entries);
-  free(transport_dispatch_entries);
+  free(transport_packet_slots);
+  free(transport_inbound_ring);
+  free(transport_dispatch_ring);
+  if (transport_request_msg)
+    wamble_msg_release_dynamic(transport_request_msg);
+  free(transport_request_msg);
   free(transport_outbound_entries);
   free(transport_reliable_bundles);
   transport_endpoints = NULL;
   transport_endpoint_size = 0;
   transport_endpoint_capacity = 0;
   transport_next_endpoint_id = 1;
-  transport_inbound_entries = NULL;
-  transport_inbound_capacity = 0;
+  transport_packet_slots = NULL;
+  transport_packet_free_head = TRANSPORT_PACKET_SLOT_NONE;
+  transport_packet_free_size = 0;
+  transport_inbound_ring = NULL;
   transport_inbound_head = 0;
   transport_inbound_size = 0;
-  transport_dispatch_entries = NULL;
-  transport_dispatch_capacity = 0;
+  transport_dispatch_ring = NULL;
   transport_dispatch_head = 0;
   transport_dispatch_size = 0;
+  transport_request_msg = NULL;
+  transport_request_msg_slot = TRANSPORT_PACKET_SLOT_NONE;
   transport_outbound_entries = NULL;
   transport_outbound_size = 0;
   transport_outbound_capacity = 0;
@@ -504,6 +1012,9 @@ static void transport_runtime_release(void) {
   transport_reliable_bundle_size = 0;
   transport_reliable_bundle_capacity = 0;
   transport_next_reliable_bundle_id = 1;
+  rate_bucket_table_release(&rate_token_buckets);
+  rate_bucket_table_release(&rate_addr_buckets);
+  transport_udp_offload_release();
   network_runtime_reset_drive_schedule();
 }
 
@@ -531,6 +1042,10 @@ static void transport_reliable_bundle_remove(size_t index) {
   for (size_t i = index + 1; i < transport_reliable_bundle_size; i++)
     transport_reliable_bundles[i - 1] = transport_reliable_bundles[i];
   transport_reliable_bundle_size--;
+  for (size_t e = 0; e < transport_endpoint_size; e++) {
+    if (transport_endpoints[e].next_unsent_bundle > index)
+      transport_endpoints[e].next_unsent_bundle--;
+  }
   if (transport_reliable_bundle_size == 0) {
     free(transport_reliable_bundles);
     transport_reliable_bundles = NULL;
@@ -559,109 +1074,135 @@ static int transport_size_ensure(void **items, size_t item_size,
   return 0;
 }
 
-static int transport_inbound_ensure_capacity(size_t need) {
-  if (transport_inbound_capacity >= need && transport_inbound_entries)
+static int transport_packet_slab_init(void) {
+  if (transport_packet_slots)
     return 0;
-  size_t old_cap = transport_inbound_capacity;
-  size_t new_cap = old_cap > 0 ? old_cap : (size_t)WAMBLE_TRANSPORT_INITIAL_CAP;
-  while (new_cap < need) {
-    if (new_cap > SIZE_MAX / 2)
-      return -1;
-    new_cap *= 2;
-  }
-  TransportInboundEntry *grown =
-      (TransportInboundEntry *)calloc(new_cap, sizeof(*grown));
-  if (!grown)
+  TransportPacketSlot *slots = (TransportPacketSlot *)malloc(
+      (size_t)WAMBLE_TRANSPORT_PACKET_SLOTS * sizeof(*slots));
+  uint32_t *inbound =
+      (uint32_t *)malloc((size_t)WAMBLE_TRANSPORT_PACKET_SLOTS *
+                         sizeof(*inbound));
+  uint32_t *dispatch =
+      (uint32_t *)malloc((size_t)WAMBLE_TRANSPORT_PACKET_SLOTS *
+                         sizeof(*dispatch));
+  struct WambleMsg *request_msg =
+      (struct WambleMsg *)calloc(1, sizeof(*request_msg));
+  if (!slots || !inbound || !dispatch || !request_msg) {
+    free(slots);
+    free(inbound);
+    free(dispatch);
+    free(request_msg);
     return -1;
-  for (size_t i = 0; i < transport_inbound_size; i++) {
-    size_t src = old_cap ? (transport_inbound_head + i) % old_cap : 0;
-    grown[i] = transport_inbound_entries[src];
   }
-  free(transport_inbound_entries);
-  transport_inbound_entries = grown;
-  transport_inbound_capacity = new_cap;
+  for (uint32_t i = 0; i < WAMBLE_TRANSPORT_PACKET_SLOTS; i++)
+    slots[i].next_free = (i + 1u < WAMBLE_TRANSPORT_PACKET_SLOTS)
+                             ? i + 1u
+                             : TRANSPORT_PACKET_SLOT_NONE;
+  transport_packet_slots = slots;
+  transport_packet_free_head = 0;
+  transport_packet_free_size = WAMBLE_TRANSPORT_PACKET_SLOTS;
+  transport_inbound_ring = inbound;
   transport_inbound_head = 0;
+  transport_inbound_size = 0;
+  transport_dispatch_ring = dispatch;
+  transport_dispatch_head = 0;
+  transport_dispatch_size = 0;
+  transport_request_msg = request_msg;
+  transport_request_msg_slot = TRANSPORT_PACKET_SLOT_NONE;
   return 0;
 }
 
-static int transport_dispatch_ensure_capacity(size_t need) {
-  if (transport_dispatch_capacity >= need && transport_dispatch_entries)
-    return 0;
-  size_t old_cap = transport_dispatch_capacity;
-  size_t new_cap = old_cap > 0 ? old_cap : (size_t)WAMBLE_TRANSPORT_INITIAL_CAP;
-  while (new_cap < need) {
-    if (new_cap > SIZE_MAX / 2)
-      return -1;
-    new_cap *= 2;
-  }
-  TransportDispatchEntry *grown =
-      (TransportDispatchEntry *)calloc(new_cap, sizeof(*grown));
-  if (!grown)
+int transport_packet_acquire(TransportPacketSource source,
+                             const struct sockaddr_in *addr,
+                             uint32_t *out_slot) {
+  if (!out_slot || transport_packet_slab_init() != 0 ||
+      transport_packet_free_head == TRANSPORT_PACKET_SLOT_NONE)
     return -1;
-  for (size_t i = 0; i < transport_dispatch_size; i++) {
-    size_t src = old_cap ? (transport_dispatch_head + i) % old_cap : 0;
-    grown[i] = transport_dispatch_entries[src];
-  }
-  free(transport_dispatch_entries);
-  transport_dispatch_entries = grown;
-  transport_dispatch_capacity = new_cap;
-  transport_dispatch_head = 0;
+  uint32_t slot = transport_packet_free_head;
+  TransportPacketSlot *packet = &transport_packet_slots[slot];
+  transport_packet_free_head = packet->next_free;
+  transport_packet_free_size--;
+  packet->next_free = TRANSPORT_PACKET_SLOT_NONE;
+  packet->source = source;
+  packet->endpoint_id = TRANSPORT_ENDPOINT_ID_INVALID;
+  if (addr)
+    packet->addr = *addr;
+  else
+    memset(&packet->addr, 0, sizeof(packet->addr));
+  packet->packet_len = 0;
+  *out_slot = slot;
   return 0;
 }
 
-int transport_inbound_push(const TransportInboundEntry *entry) {
-  if (!entry || entry->packet_len == 0 ||
-      entry->packet_len > WAMBLE_MAX_PACKET_SIZE)
-    return -1;
-  if (transport_inbound_ensure_capacity(transport_inbound_size + 1) != 0)
+TransportPacketSlot *transport_packet_get(uint32_t slot) {
+  if (!transport_packet_slots || slot >= WAMBLE_TRANSPORT_PACKET_SLOTS)
+    return NULL;
+  return &transport_packet_slots[slot];
+}
+
+void transport_packet_release(uint32_t slot) {
+  if (!transport_packet_slots || slot >= WAMBLE_TRANSPORT_PACKET_SLOTS)
+    return;
+  TransportPacketSlot *packet = &transport_packet_slots[slot];
+  packet->packet_len = 0;
+  packet->next_free = transport_packet_free_head;
+  transport_packet_free_head = slot;
+  transport_packet_free_size++;
+}
+
+size_t transport_packet_available(void) {
+  if (!transport_packet_slots)
+    return WAMBLE_TRANSPORT_PACKET_SLOTS;
+  return transport_packet_free_size;
+}
+
+static int transport_ring_push(uint32_t *ring, size_t head, size_t *size,
+                               uint32_t slot) {
+  if (!ring || *size >= WAMBLE_TRANSPORT_PACKET_SLOTS)
     return -1;
-  size_t slot = (transport_inbound_head + transport_inbound_size) %
-                transport_inbound_capacity;
-  transport_inbound_entries[slot] = *entry;
-  transport_inbound_size++;
+  ring[(head + *size) % WAMBLE_TRANSPORT_PACKET_SLOTS] = slot;
+  (*size)++;
   return 0;
 }
 
-int transport_inbound_pop(TransportInboundEntry *out) {
-  if (!out || transport_inbound_size == 0)
+static int transport_ring_pop(const uint32_t *ring, size_t *head, size_t *size,
+                              uint32_t *out_slot) {
+  if (!out_slot || *size == 0)
     return 0;
-  *out = transport_inbound_entries[transport_inbound_head];
-  memset(&transport_inbound_entries[transport_inbound_head], 0,
-         sizeof(transport_inbound_entries[transport_inbound_head]));
-  transport_inbound_head =
-      (transport_inbound_head + 1) % transport_inbound_capacity;
-  transport_inbound_size--;
-  if (transport_inbound_size == 0)
-    transport_inbound_head = 0;
+  *out_slot = ring[*head];
+  *head = (*head + 1u) % WAMBLE_TRANSPORT_PACKET_SLOTS;
+  (*size)--;
+  if (*size == 0)
+    *head = 0;
   return 1;
 }
 
+int transport_inbound_push(uint32_t slot) {
+  TransportPacketSlot *packet = transport_packet_get(slot);
+  if (!packet || packet->packet_len == 0 ||
+      packet->packet_len > WAMBLE_MAX_PACKET_SIZE)
+    return -1;
+  return transport_ring_push(transport_inbound_ring, transport_inbound_head,
+                             &transport_inbound_size, slot);
+}
+
+int transport_inbound_pop(uint32_t *out_slot) {
+  return transport_ring_pop(transport_inbound_ring, &transport_inbound_head,
+                            &transport_inbound_size, out_slot);
+}
+
 size_t transport_inbound_count(void) { return transport_inbound_size; }
 
-int transport_dispatch_push(const TransportDispatchEntry *entry) {
-  if (!entry)
+int transport_dispatch_push(uint32_t slot) {
+  if (!transport_packet_get(slot))
     return -1;
-  if (transport_dispatch_ensure_capacity(transport_dispatch_size + 1) != 0)
-    return -1;
-  size_t slot = (transport_dispatch_head + transport_dispatch_size) %
-                transport_dispatch_capacity;
-  transport_dispatch_entries[slot] = *entry;
-  transport_dispatch_size++;
-  return 0;
+  return transport_ring_push(transport_dispatch_ring, transport_dispatch_head,
+                             &transport_dispatch_size, slot);
 }
 
-int transport_dispatch_pop(TransportDispatchEntry *out) {
-  if (!out || transport_dispatch_size == 0)
-    return 0;
-  *out = transport_dispatch_entries[transport_dispatch_head];
-  memset(&transport_dispatch_entries[transport_dispatch_head], 0,
-         sizeof(transport_dispatch_entries[transport_dispatch_head]));
-  transport_dispatch_head =
-      (transport_dispatch_head + 1) % transport_dispatch_capacity;
-  transport_dispatch_size--;
-  if (transport_dispatch_size == 0)
-    transport_dispatch_head = 0;
-  return 1;
+int transport_dispatch_pop(uint32_t *out_slot) {
+  return transport_ring_pop(transport_dispatch_ring, &transport_dispatch_head,
+                            &transport_dispatch_size, out_slot);
 }
 
 size_t transport_dispatch_count(void) { return transport_dispatch_size; }
@@ -837,6 +1378,28 @@ uint32_t transport_endpoint_rto_ms_by_id(TransportEndpointId endpoint_id) {
   return transport_endpoints[idx].rto_ms;
 }
 
+uint32_t transport_endpoint_cwnd_by_id(TransportEndpointId endpoint_id) {
+  int idx = transport_endpoint_find_by_id(endpoint_id);
+  if (idx < 0)
+    return 0;
+  return transport_endpoints[idx].cwnd;
+}
+
+int network_rate_limit_allow(const uint8_t *token, int max_per_sec) {
+  return rate_bucket_allow(&rate_token_buckets, token, max_per_sec,
+                           wamble_now_mono_millis());
+}
+
+int network_addr_prefilter_allow(const struct sockaddr_in *addr,
+                                 int max_per_sec) {
+  if (!addr)
+    return 1;
+  uint8_t key[TOKEN_LENGTH] = {0};
+  memcpy(key, &addr->sin_addr.s_addr, sizeof(addr->sin_addr.s_addr));
+  return rate_bucket_allow(&rate_addr_buckets, key, max_per_sec,
+                           wamble_now_mono_millis());
+}
+
 int transport_endpoint_update_rto_by_id(TransportEndpointId endpoint_id,
                                         uint32_t sample_ms, int retransmitted) {
   int idx = transport_endpoint_find_by_id(endpoint_id);
@@ -891,7 +1454,7 @@ transport_lane_for_variant(TransportOutboundVariant variant) {
 int transport_outbound_push(const TransportOutboundEntry *entry) {
   if (!entry)
     return -1;
-  if (entry->payload_len > 0 && !entry->payload)
+  if (entry->payload_len > 0 && !entry->payload && !entry->shared)
     return -1;
   if (entry->payload_len > WAMBLE_MAX_PACKET_SIZE)
     return -1;
@@ -910,7 +1473,10 @@ int transport_outbound_push(const TransportOutboundEntry *entry) {
     copy.lane = transport_lane_for_variant(copy.variant);
   copy.payload = NULL;
   copy.payload_len = 0;
-  if (entry->payload_len > 0) {
+  if (entry->shared) {
+    entry->shared->refs++;
+    copy.payload_len = entry->shared->len;
+  } else if (entry->payload_len > 0) {
     copy.payload = (uint8_t *)malloc(entry->payload_len);
     if (!copy.payload)
       return -1;
@@ -919,13 +1485,24 @@ int transport_outbound_push(const TransportOutboundEntry *entry) {
   }
   size_t index = transport_outbound_size++;
   transport_outbound_entries[index] = copy;
+  transport_endpoints[endpoint].outbound_queued++;
+  if (copy.variant == TRANSPORT_OUTBOUND_RELIABLE_BUNDLE_FRAGMENT)
+    transport_endpoints[endpoint].fragments_in_flight++;
   return 0;
 }
 
 void transport_outbound_remove(size_t index) {
   if (!transport_outbound_entries || index >= transport_outbound_size)
     return;
-  free(transport_outbound_entries[index].payload);
+  TransportOutboundEntry *entry = &transport_outbound_entries[index];
+  int endpoint = transport_endpoint_find_by_id(entry->endpoint_id);
+  if (endpoint >= 0 && transport_endpoints[endpoint].outbound_queued > 0)
+    transport_endpoints[endpoint].outbound_queued--;
+  if (endpoint >= 0 &&
+      entry->variant == TRANSPORT_OUTBOUND_RELIABLE_BUNDLE_FRAGMENT &&
+      transport_endpoints[endpoint].fragments_in_flight > 0)
+    transport_endpoints[endpoint].fragments_in_flight--;
+  transport_outbound_entry_free(entry);
   for (size_t i = index + 1; i < transport_outbound_size; i++)
     transport_outbound_entries[i - 1] = transport_outbound_entries[i];
   transport_outbound_size--;
@@ -1298,25 +1875,30 @@ static WambleClientSession *find_client_session_by_token(const uint8_t *token) {
 
 static WambleClientSession *
 create_client_session(const struct sockaddr_in *addr, const uint8_t *token) {
-  if (ensure_client_session_capacity(num_sessions + 1) != 0)
+  int needed = session_free_head >= 0 ? num_sessions : num_sessions + 1;
+  if (ensure_client_session_capacity(needed) != 0)
     return NULL;
-  if (num_sessions >= client_sessions_capacity) {
+  if (needed > client_sessions_capacity)
     return NULL;
-  }
 
-  WambleClientSession *session = &client_sessions[num_sessions++];
+  int index = session_free_head;
+  if (index >= 0)
+    session_free_head = client_sessions[index].free_next;
+  else
+    index = num_sessions++;
+  WambleClientSession *session = &client_sessions[index];
+  memset(session, 0, sizeof(*session));
   session->addr = *addr;
   memcpy(session->token, token, TOKEN_LENGTH);
   session->token_next_index = -1;
-  session->last_seq_num = 0;
+  session->active = 1;
+  session->free_next = -1;
   session->last_seen = wamble_now_wall();
   session->next_seq_num = 1;
-  session->treatment_group_key[0] = '\0';
-  session->terminal_cache = NULL;
-  session->terminal_cache_count = 0;
-  session_map_put(addr, (int)(session - client_sessions));
+  session_idle_append(index);
+  session_map_put(addr, index);
   if (token_has_any_byte(token))
-    token_session_map_put(token, (int)(session - client_sessions));
+    token_session_map_put(token, index);
   return session;
 }
 
@@ -1386,81 +1968,124 @@ static int ensure_client_session_capacity(int needed) {
   return 0;
 }
 
-static void terminal_cache_slot_clear_packets(WambleTerminalCacheSlot *slot) {
-  if (!slot)
+static void terminal_arena_release(void) {
+  free(terminal_arena);
+  terminal_arena = NULL;
+  terminal_arena_capacity = 0;
+  terminal_arena_live = 0;
+  terminal_arena_free_head = WAMBLE_TERMINAL_ARENA_NONE;
+}
+
+static uint32_t terminal_arena_acquire(void) {
+  if (terminal_arena_free_head == WAMBLE_TERMINAL_ARENA_NONE) {
+    uint32_t old_capacity = terminal_arena_capacity;
+    uint32_t new_capacity = old_capacity ? old_capacity * 2u : 64u;
+    WambleTerminalCachePacket *grown = (WambleTerminalCachePacket *)realloc(
+        terminal_arena, (size_t)new_capacity * sizeof(*terminal_arena));
+    if (!grown)
+      return WAMBLE_TERMINAL_ARENA_NONE;
+    for (uint32_t i = old_capacity; i < new_capacity; i++)
+      grown[i].next = i + 1u < new_capacity ? i + 1u
+                                            : WAMBLE_TERMINAL_ARENA_NONE;
+    terminal_arena = grown;
+    terminal_arena_capacity = new_capacity;
+    terminal_arena_free_head = old_capacity;
+  }
+  uint32_t idx = terminal_arena_free_head;
+  terminal_arena_free_head = terminal_arena[idx].next;
+  terminal_arena[idx].next = WAMBLE_TERMINAL_ARENA_NONE;
+  terminal_arena_live++;
+  return idx;
+}
+
+static void terminal_arena_trim(void) {
+  uint32_t target = 64u;
+  if (terminal_arena_capacity <= target ||
+      terminal_arena_live > terminal_arena_capacity / 4u)
     return;
-  for (int i = 0; i < slot->packet_count; i++)
-    free(slot->packets[i].data);
-  slot->packet_count = 0;
+  while (target < terminal_arena_live * 2u)
+    target *= 2u;
+  WambleTerminalCachePacket *packed = (WambleTerminalCachePacket *)malloc(
+      (size_t)target * sizeof(*packed));
+  if (!packed)
+    return;
+  uint32_t used = 0;
+  for (int i = 0; i < num_sessions; i++) {
+    for (uint32_t s = 0; s < WAMBLE_TERMINAL_CACHE_MAX_SLOTS; s++) {
+      WambleTerminalCacheSlot *slot = &client_sessions[i].terminal_cache[s];
+      if (slot->packet_count == 0)
+        continue;
+      uint32_t src = slot->head;
+      slot->head = used;
+      while (src != WAMBLE_TERMINAL_ARENA_NONE) {
+        packed[used] = terminal_arena[src];
+        src = terminal_arena[src].next;
+        packed[used].next = used + 1u;
+        used++;
+      }
+      slot->tail = used - 1u;
+      packed[slot->tail].next = WAMBLE_TERMINAL_ARENA_NONE;
+    }
+  }
+  for (uint32_t i = used; i < target; i++)
+    packed[i].next = i + 1u < target ? i + 1u : WAMBLE_TERMINAL_ARENA_NONE;
+  free(terminal_arena);
+  terminal_arena = packed;
+  terminal_arena_capacity = target;
+  terminal_arena_free_head = used < target ? used : WAMBLE_TERMINAL_ARENA_NONE;
 }
 
-static void terminal_cache_slot_free(WambleTerminalCacheSlot *slot) {
-  if (!slot)
+static void terminal_cache_slot_clear_packets(WambleTerminalCacheSlot *slot) {
+  if (!slot || slot->packet_count == 0)
     return;
-  terminal_cache_slot_clear_packets(slot);
-  free(slot->packets);
-  slot->packets = NULL;
-  slot->packet_cap = 0;
+  terminal_arena[slot->tail].next = terminal_arena_free_head;
+  terminal_arena_free_head = slot->head;
+  uint32_t threshold = terminal_arena_capacity / 4u;
+  int crossed = terminal_arena_live > threshold;
+  terminal_arena_live -= (uint32_t)slot->packet_count;
+  slot->packet_count = 0;
+  slot->head = WAMBLE_TERMINAL_ARENA_NONE;
+  slot->tail = WAMBLE_TERMINAL_ARENA_NONE;
+  if (crossed && terminal_arena_live <= threshold)
+    terminal_arena_trim();
 }
 
 static void terminal_cache_free_all(WambleClientSession *session) {
-  if (!session || !session->terminal_cache)
+  if (!session)
     return;
-  for (int i = 0; i < session->terminal_cache_count; i++)
-    terminal_cache_slot_free(&session->terminal_cache[i]);
-  free(session->terminal_cache);
-  session->terminal_cache = NULL;
-  session->terminal_cache_count = 0;
+  for (uint32_t i = 0; i < WAMBLE_TERMINAL_CACHE_MAX_SLOTS; i++)
+    terminal_cache_slot_clear_packets(&session->terminal_cache[i]);
 }
 
-static void terminal_cache_remove(WambleClientSession *session,
-                                  uint32_t req_seq) {
-  if (!session || !session->terminal_cache)
-    return;
-  for (int i = 0; i < session->terminal_cache_count; i++) {
-    if (session->terminal_cache[i].req_seq != req_seq)
-      continue;
-    terminal_cache_slot_free(&session->terminal_cache[i]);
-    for (int j = i + 1; j < session->terminal_cache_count; j++)
-      session->terminal_cache[j - 1] = session->terminal_cache[j];
-    session->terminal_cache_count--;
-    if (session->terminal_cache_count == 0) {
-      free(session->terminal_cache);
-      session->terminal_cache = NULL;
-    }
-    return;
-  }
+static WambleTerminalCacheSlot *
+terminal_cache_slot_for(WambleClientSession *session, uint32_t req_seq) {
+  return &session->terminal_cache[req_seq % WAMBLE_TERMINAL_CACHE_MAX_SLOTS];
 }
 
-static void terminal_cache_expire(WambleClientSession *session,
-                                  uint64_t now_ms) {
-  if (!session || !session->terminal_cache)
-    return;
+static WambleTerminalCacheSlot *
+terminal_cache_lookup(WambleClientSession *session, uint32_t req_seq,
+                      uint64_t now_ms) {
+  if (!session)
+    return NULL;
+  WambleTerminalCacheSlot *slot = terminal_cache_slot_for(session, req_seq);
+  if (slot->packet_count == 0)
+    return NULL;
   int ttl = get_config()->terminal_cache_ttl_ms;
-  if (ttl <= 0) {
-    terminal_cache_free_all(session);
-    return;
-  }
-  int write = 0;
-  for (int i = 0; i < session->terminal_cache_count; i++) {
-    WambleTerminalCacheSlot *s = &session->terminal_cache[i];
-    if (now_ms - s->stored_mono_ms > (uint64_t)ttl) {
-      terminal_cache_slot_free(s);
-      continue;
-    }
-    if (write != i)
-      session->terminal_cache[write] = *s;
-    write++;
-  }
-  session->terminal_cache_count = write;
-  if (write == 0) {
-    free(session->terminal_cache);
-    session->terminal_cache = NULL;
+  if (ttl <= 0 || now_ms - slot->stored_mono_ms > (uint64_t)ttl) {
+    terminal_cache_slot_clear_packets(slot);
+    return NULL;
   }
+  return slot->req_seq == req_seq ? slot : NULL;
 }
 
-#define WAMBLE_TERMINAL_CACHE_MAX_SLOTS 8
-#define WAMBLE_TERMINAL_CACHE_MAX_BUNDLE_PACKETS 1024
+static void terminal_cache_remove(WambleClientSession *session,
+                                  uint32_t req_seq) {
+  if (!session)
+    return;
+  WambleTerminalCacheSlot *slot = terminal_cache_slot_for(session, req_seq);
+  if (slot->packet_count > 0 && slot->req_seq == req_seq)
+    terminal_cache_slot_clear_packets(slot);
+}
 
 static void terminal_cache_packet_set_meta(WambleTerminalCachePacket *packet,
                                            const uint8_t *data, size_t len) {
@@ -1471,152 +2096,87 @@ static void terminal_cache_packet_set_meta(WambleTerminalCachePacket *packet,
                 ((uint32_t)data[30] << 8) | (uint32_t)data[31];
 }
 
-static int terminal_cache_slot_append_take(WambleTerminalCacheSlot *slot,
-                                           uint8_t *data, size_t len);
-
 static int terminal_cache_slot_append(WambleTerminalCacheSlot *slot,
                                       const uint8_t *data, size_t len) {
-  uint8_t *buf = NULL;
-  if (!data)
-    return -1;
-  buf = (uint8_t *)malloc(len);
-  if (!buf)
-    return -1;
-  memcpy(buf, data, len);
-  if (terminal_cache_slot_append_take(slot, buf, len) != 0)
-    return -1;
-  return 0;
-}
-
-static int terminal_cache_slot_append_take(WambleTerminalCacheSlot *slot,
-                                           uint8_t *data, size_t len) {
-  if (!data)
+  if (!data || slot->packet_count >= WAMBLE_TERMINAL_CACHE_MAX_BUNDLE_PACKETS)
     return -1;
-  if (slot->packet_count >= WAMBLE_TERMINAL_CACHE_MAX_BUNDLE_PACKETS) {
-    free(data);
+  uint32_t idx = terminal_arena_acquire();
+  if (idx == WAMBLE_TERMINAL_ARENA_NONE)
     return -1;
-  }
-  if (slot->packet_count >= slot->packet_cap) {
-    int new_cap = slot->packet_cap ? slot->packet_cap * 2 : 4;
-    if (new_cap > WAMBLE_TERMINAL_CACHE_MAX_BUNDLE_PACKETS)
-      new_cap = WAMBLE_TERMINAL_CACHE_MAX_BUNDLE_PACKETS;
-    WambleTerminalCachePacket *grown = (WambleTerminalCachePacket *)realloc(
-        slot->packets, (size_t)new_cap * sizeof(*slot->packets));
-    if (!grown) {
-      free(data);
-      return -1;
-    }
-    slot->packets = grown;
-    slot->packet_cap = new_cap;
-  }
-  WambleTerminalCachePacket *packet = &slot->packets[slot->packet_count];
-  memset(packet, 0, sizeof(*packet));
-  packet->data = data;
+  WambleTerminalCachePacket *packet = &terminal_arena[idx];
+  memset(packet->token, 0, sizeof(packet->token));
+  packet->seq = 0;
+  memcpy(packet->data, data, len);
   packet->len = len;
   terminal_cache_packet_set_meta(packet, data, len);
+  if (slot->packet_count == 0)
+    slot->head = idx;
+  else
+    terminal_arena[slot->tail].next = idx;
+  slot->tail = idx;
   slot->packet_count++;
   return 0;
 }
 
 static int terminal_cache_store_impl(WambleClientSession *session,
-                                     uint32_t req_seq, uint8_t *owned_data,
-                                     const uint8_t *data, size_t len) {
-  if (!session || !data || len == 0 || len > WAMBLE_MAX_PACKET_SIZE) {
-    free(owned_data);
+                                     uint32_t req_seq, const uint8_t *data,
+                                     size_t len) {
+  if (!session || !data || len == 0 || len > WAMBLE_MAX_PACKET_SIZE)
     return -1;
-  }
-  int ttl = get_config()->terminal_cache_ttl_ms;
-  if (ttl <= 0) {
-    free(owned_data);
+  if (get_config()->terminal_cache_ttl_ms <= 0)
     return -1;
-  }
   uint64_t now_ms = wamble_now_mono_millis();
-  terminal_cache_expire(session, now_ms);
-  WambleTerminalCacheSlot *slot = NULL;
-  int oldest = 0;
-  for (int i = 0; i < session->terminal_cache_count; i++) {
-    if (session->terminal_cache[i].req_seq == req_seq) {
-      slot = &session->terminal_cache[i];
-      break;
-    }
-    if (session->terminal_cache[i].stored_mono_ms <
-        session->terminal_cache[oldest].stored_mono_ms)
-      oldest = i;
-  }
+  WambleTerminalCacheSlot *slot =
+      terminal_cache_lookup(session, req_seq, now_ms);
   if (!slot) {
-    if (session->terminal_cache_count >= WAMBLE_TERMINAL_CACHE_MAX_SLOTS) {
-      slot = &session->terminal_cache[oldest];
-      terminal_cache_slot_clear_packets(slot);
-    } else {
-      int new_count = session->terminal_cache_count + 1;
-      WambleTerminalCacheSlot *grown = (WambleTerminalCacheSlot *)realloc(
-          session->terminal_cache,
-          (size_t)new_count * sizeof(*session->terminal_cache));
-      if (!grown) {
-        free(owned_data);
-        return -1;
-      }
-      session->terminal_cache = grown;
-      slot = &session->terminal_cache[session->terminal_cache_count];
-      slot->packets = NULL;
-      slot->packet_cap = 0;
-      slot->packet_count = 0;
-      session->terminal_cache_count = new_count;
-    }
+    slot = terminal_cache_slot_for(session, req_seq);
+    terminal_cache_slot_clear_packets(slot);
     slot->req_seq = req_seq;
   }
-  if (owned_data) {
-    if (terminal_cache_slot_append_take(slot, owned_data, len) != 0) {
-      return -1;
-    }
-  } else if (terminal_cache_slot_append(slot, data, len) != 0) {
+  if (terminal_cache_slot_append(slot, data, len) != 0)
     return -1;
-  }
   slot->stored_mono_ms = now_ms;
   return 0;
 }
 
 static int terminal_cache_store(WambleClientSession *session, uint32_t req_seq,
                                 const uint8_t *data, size_t len) {
-  return terminal_cache_store_impl(session, req_seq, NULL, data, len);
+  return terminal_cache_store_impl(session, req_seq, data, len);
 }
 
 static int terminal_cache_enqueue_replay(WambleClientSession *session,
                                          uint32_t req_seq,
                                          const struct sockaddr_in *cliaddr) {
-  if (!session || !session->terminal_cache || !cliaddr)
+  if (!cliaddr)
     return 0;
-  terminal_cache_expire(session, wamble_now_mono_millis());
-  for (int i = 0; i < session->terminal_cache_count; i++) {
-    WambleTerminalCacheSlot *s = &session->terminal_cache[i];
-    if (s->req_seq != req_seq)
-      continue;
-    if (s->packet_count == 0)
-      return 0;
-    for (int p = 0; p < s->packet_count; p++) {
-      uint32_t seq = s->packets[p].seq;
-      uint8_t token[TOKEN_LENGTH];
-      memcpy(token, s->packets[p].token, TOKEN_LENGTH);
-      if (seq == 0 || !token_has_any_byte(token)) {
-        struct WambleMsg cached;
-        uint8_t flags = 0;
-        memset(&cached, 0, sizeof(cached));
-        if (wamble_packet_deserialize(s->packets[p].data, s->packets[p].len,
-                                      &cached, &flags) != NET_OK)
-          return -1;
-        seq = cached.seq_num;
-        memcpy(token, cached.token, TOKEN_LENGTH);
-      }
-      if (transport_outbound_contains_reliable(seq, token, cliaddr))
-        continue;
-      if (network_enqueue_serialized_reliable(
-              token, seq, s->packets[p].data, s->packets[p].len, cliaddr, 0,
-              get_config()->max_retries, 0) != 0)
+  WambleTerminalCacheSlot *s =
+      terminal_cache_lookup(session, req_seq, wamble_now_mono_millis());
+  if (!s)
+    return 0;
+  for (uint32_t idx = s->head; idx != WAMBLE_TERMINAL_ARENA_NONE;
+       idx = terminal_arena[idx].next) {
+    WambleTerminalCachePacket *packet = &terminal_arena[idx];
+    uint32_t seq = packet->seq;
+    uint8_t token[TOKEN_LENGTH];
+    memcpy(token, packet->token, TOKEN_LENGTH);
+    if (seq == 0 || !token_has_any_byte(token)) {
+      struct WambleMsg cached;
+      uint8_t flags = 0;
+      memset(&cached, 0, sizeof(cached));
+      if (wamble_packet_deserialize(packet->data, packet->len, &cached,
+                                    &flags) != NET_OK)
         return -1;
+      seq = cached.seq_num;
+      memcpy(token, cached.token, TOKEN_LENGTH);
     }
-    return 1;
+    if (transport_outbound_contains_reliable(seq, token, cliaddr))
+      continue;
+    if (network_enqueue_serialized_reliable(token, seq, packet->data,
+                                            packet->len, cliaddr, 0,
+                                            get_config()->max_retries, 0) != 0)
+      return -1;
   }
-  return 0;
+  return 1;
 }
 
 static int
@@ -1659,9 +2219,10 @@ void network_end_request(void) { g_current_request.session = NULL; }
 void network_runtime_reset_thread_state(void) {
   for (int i = 0; i < num_sessions; i++)
     terminal_cache_release(&client_sessions[i]);
+  terminal_arena_release();
   free(client_sessions);
   client_sessions = NULL;
-  num_sessions = 0;
+  session_slots_reset();
   client_sessions_capacity = 0;
   global_seq_num = 1;
   global_fragment_transfer_id = 1;
@@ -1712,7 +2273,7 @@ static void update_client_session(const struct sockaddr_in *addr,
   }
 
   session->last_seq_num = seq_num;
-  session->last_seen = wamble_now_wall();
+  client_session_touch(session);
   int token_changed = memcmp(session->token, token, TOKEN_LENGTH) != 0;
   if (token_changed) {
     int index = (int)(session - client_sessions);
@@ -1737,9 +2298,11 @@ static void rebind_client_session(WambleClientSession *session,
   if (!session || !addr || sockaddr_in_equal(&session->addr, addr))
     return;
   struct sockaddr_in old_addr = session->addr;
+  int index = (int)(session - client_sessions);
   session->addr = *addr;
+  session_map_remove(&old_addr, index);
   (void)transport_endpoint_rebind_by_addr(&old_addr, session->token, addr);
-  session_map_rebuild();
+  session_map_put(addr, index);
 }
 
 static int reliable_sequence_is_duplicate(const WambleClientSession *session,
@@ -1763,6 +2326,16 @@ find_endpoint_session(const struct sockaddr_in *cliaddr, const uint8_t *token) {
   return session;
 }
 
+void network_begin_request(const struct WambleMsg *msg,
+                           const struct sockaddr_in *cliaddr) {
+  g_current_request.session = NULL;
+  if (!msg || !cliaddr || !ctrl_is_client_request(msg->ctrl) ||
+      (msg->flags & WAMBLE_FLAG_UNRELIABLE) != 0)
+    return;
+  begin_reliable_request_scope(find_endpoint_session(cliaddr, msg->token),
+                               msg->seq_num);
+}
+
 static int
 replay_duplicate_reliable_request(WambleClientSession *session,
                                   const struct WambleMsg *msg,
@@ -1777,7 +2350,7 @@ replay_duplicate_reliable_request(WambleClientSession *session,
     return 0;
   if (session) {
     rebind_client_session(session, cliaddr);
-    session->last_seen = wamble_now_wall();
+    client_session_touch(session);
   }
   if (terminal_cache_enqueue_replay(session, msg->seq_num, cliaddr) < 0)
     return -1;
@@ -1810,7 +2383,8 @@ static void admit_client_packet(const struct sockaddr_in *cliaddr,
 void network_init_thread_state(void) {
   for (int i = 0; i < num_sessions; i++)
     terminal_cache_release(&client_sessions[i]);
-  num_sessions = 0;
+  terminal_arena_release();
+  session_slots_reset();
   g_current_request.session = NULL;
   transport_runtime_release();
   network_runtime_reset_drive_schedule();
@@ -1849,13 +2423,30 @@ int network_protocol_thread_terminal_cache_packet_count(void) {
   uint64_t now_ms = wamble_now_mono_millis();
   for (int i = 0; i < num_sessions; i++) {
     WambleClientSession *session = &client_sessions[i];
-    terminal_cache_expire(session, now_ms);
-    for (int s = 0; s < session->terminal_cache_count; s++)
-      total += session->terminal_cache[s].packet_count;
+    if (!session->active)
+      continue;
+    for (uint32_t s = 0; s < WAMBLE_TERMINAL_CACHE_MAX_SLOTS; s++) {
+      const WambleTerminalCacheSlot *slot =
+          terminal_cache_lookup(session, session->terminal_cache[s].req_seq,
+                                now_ms);
+      if (slot)
+        total += slot->packet_count;
+    }
   }
   return total;
 }
 
+int network_protocol_thread_terminal_arena_capacity(void) {
+  return (int)terminal_arena_capacity;
+}
+
+int network_protocol_thread_session_count(void) {
+  int total = 0;
+  for (int i = session_idle_head; i >= 0; i = client_sessions[i].idle_next)
+    total++;
+  return total;
+}
+
 int network_protocol_thread_pending_packet_count(void) {
   return (int)(transport_inbound_size + transport_dispatch_size);
 }
@@ -1939,6 +2530,7 @@ wamble_socket_t create_and_bind_socket(int port) {
                    sizeof(buffer_size));
   (void)setsockopt(sockfd, SOL_SOCKET, SO_SNDBUF, (const char *)&buffer_size,
                    sizeof(buffer_size));
+  network_configure_udp_offload(sockfd, get_config()->udp_segment_offload);
 
   memset(&servaddr, 0, sizeof(servaddr));
 
@@ -1966,12 +2558,12 @@ typedef enum NetworkInboundClassification {
 } NetworkInboundClassification;
 
 static int network_classify_packet_impl(
-    wamble_socket_t sockfd, const uint8_t *packet, size_t packet_len,
+    wamble_socket_t sockfd, const WambleMsgView *view, size_t packet_len,
     struct WambleMsg *msg, const struct sockaddr_in *cliaddr,
     TransportEndpointId inbound_endpoint_id,
     TransportEndpointId *out_endpoint_id,
     NetworkInboundClassification *out_kind, int begin_request_scope) {
-  if (!packet || !msg || !cliaddr || packet_len == 0 ||
+  if (!view || !msg || !cliaddr || packet_len == 0 ||
       packet_len > WAMBLE_MAX_PACKET_SIZE) {
     return -1;
   }
@@ -1979,30 +2571,24 @@ static int network_classify_packet_impl(
     *out_kind = NETWORK_INBOUND_INVALID;
   network_ensure_thread_state_initialized();
 
-  uint8_t flags = 0;
-  if (wamble_packet_deserialize(packet, packet_len, msg, &flags) != NET_OK)
+  if (!ctrl_is_supported(view->ctrl))
     return -1;
 
-  if (!ctrl_is_supported(msg->ctrl))
-    return -1;
-  if (msg->text.uci_len > MAX_UCI_LENGTH)
-    return -1;
-
-  int token_valid = token_has_any_byte(msg->token);
-  if (!token_valid && !ctrl_allows_anonymous_token(msg->ctrl))
+  int token_valid = token_has_any_byte(view->token);
+  if (!token_valid && !ctrl_allows_anonymous_token(view->ctrl))
     return -1;
 
   TransportEndpointId endpoint_id = inbound_endpoint_id;
-  if (msg->ctrl == WAMBLE_CTRL_ACK) {
+  if (view->ctrl == WAMBLE_CTRL_ACK) {
     if (endpoint_id == TRANSPORT_ENDPOINT_ID_INVALID &&
-        transport_endpoint_bind_addr_token(cliaddr, msg->token, &endpoint_id) !=
-            0)
+        transport_endpoint_bind_addr_token(cliaddr, view->token,
+                                           &endpoint_id) != 0)
       return -1;
     if (out_endpoint_id)
       *out_endpoint_id = endpoint_id;
 
     int ack_rc = transport_outbound_match_and_remove_ack(
-        endpoint_id, msg->seq_num, msg->token, cliaddr);
+        endpoint_id, &view->ack, view->token);
     if (ack_rc < 0)
       return -1;
     if (out_kind)
@@ -2010,6 +2596,11 @@ static int network_classify_packet_impl(
     return (int)packet_len;
   }
 
+  if (wamble_msg_view_decode(view, msg) != NET_OK)
+    return -1;
+  if (msg->text.uci_len > MAX_UCI_LENGTH)
+    return -1;
+
   if (ctrl_is_client_request(msg->ctrl)) {
     if (token_valid && transport_endpoint_count_by_token(msg->token) == 1) {
       int token_idx = transport_endpoint_find_by_token(msg->token);
@@ -2032,6 +2623,10 @@ static int network_classify_packet_impl(
   }
   if (out_endpoint_id)
     *out_endpoint_id = endpoint_id;
+  if (view->ack.highest_seq != 0 &&
+      transport_outbound_match_and_remove_ack(endpoint_id, &view->ack,
+                                              view->token) < 0)
+    return -1;
 
   WambleClientSession *session = find_endpoint_session(cliaddr, msg->token);
   (void)sockfd;
@@ -2056,7 +2651,18 @@ static int receive_message_from_packet_impl(wamble_socket_t sockfd,
                                             struct WambleMsg *msg,
                                             const struct sockaddr_in *cliaddr) {
   NetworkInboundClassification kind = NETWORK_INBOUND_INVALID;
-  int rc = network_classify_packet_impl(sockfd, packet, packet_len, msg,
+  WambleMsgView view;
+  if (!packet || !msg ||
+      wamble_msg_view_parse(packet, packet_len, &view) != NET_OK)
+    return -1;
+  memset(msg, 0, sizeof(*msg));
+  msg->ctrl = view.ctrl;
+  msg->flags = view.flags;
+  memcpy(msg->token, view.token, TOKEN_LENGTH);
+  msg->board_id = view.board_id;
+  msg->seq_num = view.seq_num;
+  msg->header_version = view.header_version;
+  int rc = network_classify_packet_impl(sockfd, &view, packet_len, msg,
                                         cliaddr, TRANSPORT_ENDPOINT_ID_INVALID,
                                         NULL, &kind, 1);
   if (rc <= 0)
@@ -2066,15 +2672,60 @@ static int receive_message_from_packet_impl(wamble_socket_t sockfd,
   return rc;
 }
 
+static int transport_outbound_complete_reliable(size_t index) {
+  TransportOutboundEntry *e = &transport_outbound_entries[index];
+  uint64_t sent_at_ms = 0;
+  uint64_t deadline_at_ms = 0;
+  uint32_t rto_ms = 0;
+  uint16_t retry_count = 0;
+  if (e->variant == TRANSPORT_OUTBOUND_RELIABLE_TERMINAL) {
+    sent_at_ms = e->as.reliable.sent_at_ms;
+    deadline_at_ms = e->as.reliable.deadline_at_ms;
+    rto_ms = e->as.reliable.rto_ms;
+    retry_count = e->as.reliable.retry_count;
+  } else {
+    sent_at_ms = e->as.reliable_fragment.sent_at_ms;
+    deadline_at_ms = e->as.reliable_fragment.deadline_at_ms;
+    rto_ms = e->as.reliable_fragment.rto_ms;
+    retry_count = e->as.reliable_fragment.retry_count;
+  }
+  if (sent_at_ms > 0 || deadline_at_ms > rto_ms) {
+    uint64_t now_ms = wamble_now_mono_millis();
+    if (sent_at_ms == 0)
+      sent_at_ms = deadline_at_ms - rto_ms;
+    if (sent_at_ms > 0 && now_ms >= sent_at_ms) {
+      uint64_t sample_ms = now_ms - sent_at_ms;
+      if (sample_ms > UINT32_MAX)
+        sample_ms = UINT32_MAX;
+      int retransmitted = retry_count > 1;
+      int endpoint_idx = transport_endpoint_find_by_id(e->endpoint_id);
+      if (endpoint_idx >= 0)
+        (void)transport_endpoint_update_rto_by_index(
+            (size_t)endpoint_idx, (uint32_t)sample_ms, retransmitted);
+    }
+  }
+  uint64_t bundle_id = e->variant == TRANSPORT_OUTBOUND_RELIABLE_BUNDLE_FRAGMENT
+                           ? e->as.reliable_fragment.bundle_id
+                           : 0;
+  transport_outbound_remove(index);
+  if (bundle_id != 0 && transport_reliable_bundle_fragment_acked(
+                            bundle_id, retry_count > 1) < 0)
+    return -1;
+  return 0;
+}
+
 static int
 transport_outbound_match_and_remove_ack(TransportEndpointId endpoint_id,
-                                        uint32_t seq, const uint8_t *token,
-                                        const struct sockaddr_in *cliaddr) {
-  (void)cliaddr;
-  if (!transport_outbound_entries ||
+                                        const WambleAckState *ack,
+                                        const uint8_t *token) {
+  if (!transport_outbound_entries || !ack ||
       endpoint_id == TRANSPORT_ENDPOINT_ID_INVALID)
     return 0;
-  for (size_t i = 0; i < transport_outbound_size; i++) {
+  int matched = 0;
+  int sack = ack->bitmap != 0 || ack->cumulative_seq != 0;
+  int lost = 0;
+  uint32_t lost_seq = 0;
+  for (size_t i = 0; i < transport_outbound_size;) {
     TransportOutboundEntry *e = &transport_outbound_entries[i];
     uint32_t entry_seq = 0;
     if (e->variant == TRANSPORT_OUTBOUND_RELIABLE_TERMINAL) {
@@ -2082,62 +2733,45 @@ transport_outbound_match_and_remove_ack(TransportEndpointId endpoint_id,
     } else if (e->variant == TRANSPORT_OUTBOUND_RELIABLE_BUNDLE_FRAGMENT) {
       entry_seq = e->as.reliable_fragment.seq;
     } else {
+      i++;
+      continue;
+    }
+    if (e->endpoint_id != endpoint_id) {
+      i++;
       continue;
     }
-    if (entry_seq != seq || e->endpoint_id != endpoint_id)
+    if (!wamble_ack_state_covers(ack, entry_seq)) {
+      uint32_t distance = ack->highest_seq - entry_seq;
+      if (sack && e->variant == TRANSPORT_OUTBOUND_RELIABLE_BUNDLE_FRAGMENT &&
+          e->as.reliable_fragment.retry_count > 0 &&
+          distance >= WAMBLE_TRANSPORT_SACK_LOSS_DISTANCE &&
+          distance < 0x80000000u &&
+          (!lost || (int32_t)(entry_seq - lost_seq) > 0)) {
+        lost = 1;
+        lost_seq = entry_seq;
+      }
+      i++;
       continue;
+    }
     if (token && token_has_any_byte(token) && token_has_any_byte(e->token) &&
-        memcmp(e->token, token, TOKEN_LENGTH) != 0)
+        memcmp(e->token, token, TOKEN_LENGTH) != 0) {
+      i++;
       continue;
-    if (e->variant == TRANSPORT_OUTBOUND_RELIABLE_TERMINAL ||
-        e->variant == TRANSPORT_OUTBOUND_RELIABLE_BUNDLE_FRAGMENT) {
-      uint64_t sent_at_ms = 0;
-      uint64_t deadline_at_ms = 0;
-      uint32_t rto_ms = 0;
-      uint16_t retry_count = 0;
-      if (e->variant == TRANSPORT_OUTBOUND_RELIABLE_TERMINAL) {
-        sent_at_ms = e->as.reliable.sent_at_ms;
-        deadline_at_ms = e->as.reliable.deadline_at_ms;
-        rto_ms = e->as.reliable.rto_ms;
-        retry_count = e->as.reliable.retry_count;
-      } else {
-        sent_at_ms = e->as.reliable_fragment.sent_at_ms;
-        deadline_at_ms = e->as.reliable_fragment.deadline_at_ms;
-        rto_ms = e->as.reliable_fragment.rto_ms;
-        retry_count = e->as.reliable_fragment.retry_count;
-      }
-      if (sent_at_ms > 0 || deadline_at_ms > rto_ms) {
-        uint64_t now_ms = wamble_now_mono_millis();
-        if (sent_at_ms == 0)
-          sent_at_ms = deadline_at_ms - rto_ms;
-        if (sent_at_ms > 0 && now_ms >= sent_at_ms) {
-          uint64_t sample_ms = now_ms - sent_at_ms;
-          if (sample_ms > UINT32_MAX)
-            sample_ms = UINT32_MAX;
-          int retransmitted = retry_count > 1;
-          int endpoint_idx = transport_endpoint_find_by_id(e->endpoint_id);
-          if (endpoint_idx >= 0)
-            (void)transport_endpoint_update_rto_by_index(
-                (size_t)endpoint_idx, (uint32_t)sample_ms, retransmitted);
-        }
-      }
     }
-    uint64_t bundle_id =
-        e->variant == TRANSPORT_OUTBOUND_RELIABLE_BUNDLE_FRAGMENT
-            ? e->as.reliable_fragment.bundle_id
-            : 0;
-    transport_outbound_remove(i);
-    if (bundle_id != 0 &&
-        transport_reliable_bundle_fragment_acked(bundle_id) < 0)
+    if (transport_outbound_complete_reliable(i) != 0)
       return -1;
-    return 1;
+    matched++;
   }
-  return 0;
+  if (lost)
+    transport_endpoint_enter_recovery(endpoint_id, lost_seq);
+  return matched;
 }
 
 int transport_outbound_match_ack(TransportEndpointId endpoint_id, uint32_t seq,
                                  const uint8_t token[TOKEN_LENGTH]) {
-  return transport_outbound_match_and_remove_ack(endpoint_id, seq, token, NULL);
+  WambleAckState ack = {seq, 0, 0};
+  int matched = transport_outbound_match_and_remove_ack(endpoint_id, &ack, token);
+  return matched > 0 ? 1 : matched;
 }
 
 int receive_message_packet(const uint8_t *packet, size_t packet_len,
@@ -2150,13 +2784,15 @@ int receive_message_packet(const uint8_t *packet, size_t packet_len,
 int receive_message(wamble_socket_t sockfd, struct WambleMsg *msg,
                     struct sockaddr_in *cliaddr) {
   network_ensure_thread_state_initialized();
-  TransportInboundEntry pending;
-  memset(&pending, 0, sizeof(pending));
-  if (transport_inbound_pop(&pending)) {
+  uint32_t pending_slot = TRANSPORT_PACKET_SLOT_NONE;
+  if (transport_inbound_pop(&pending_slot)) {
+    TransportPacketSlot *pending = transport_packet_get(pending_slot);
     if (cliaddr)
-      *cliaddr = pending.addr;
-    return receive_message_from_packet_impl(
-        sockfd, pending.packet, pending.packet_len, msg, &pending.addr);
+      *cliaddr = pending->addr;
+    int rc = receive_message_from_packet_impl(
+        sockfd, pending->packet, pending->packet_len, msg, &pending->addr);
+    transport_packet_release(pending_slot);
+    return rc;
   }
 
   wamble_socklen_t len = sizeof(*cliaddr);
@@ -2183,42 +2819,152 @@ int network_ack_received_message(wamble_socket_t sockfd,
   return drive.status == TRANSPORT_DRIVE_PROGRESS ? 0 : -1;
 }
 
-int network_enqueue_ack_after(const struct WambleMsg *msg,
-                              const struct sockaddr_in *cliaddr) {
-  if (!msg || !cliaddr)
+static void transport_endpoint_reset_delivery(int idx) {
+  TransportEndpointState *endpoint = &transport_endpoints[idx];
+  TransportEndpointId endpoint_id = endpoint->endpoint_id;
+  for (size_t i = 0; i < transport_outbound_size;) {
+    const TransportOutboundEntry *e = &transport_outbound_entries[i];
+    if (e->endpoint_id == endpoint_id &&
+        (e->variant == TRANSPORT_OUTBOUND_RELIABLE_TERMINAL ||
+         e->variant == TRANSPORT_OUTBOUND_RELIABLE_BUNDLE_FRAGMENT))
+      transport_outbound_remove(i);
+    else
+      i++;
+  }
+  for (size_t b = 0; b < transport_reliable_bundle_size;) {
+    if (transport_reliable_bundles[b].endpoint_id == endpoint_id)
+      transport_reliable_bundle_remove(b);
+    else
+      b++;
+  }
+  memset(&endpoint->ack_state, 0, sizeof(endpoint->ack_state));
+  endpoint->cwnd = WAMBLE_TRANSPORT_INITIAL_CWND;
+  endpoint->ssthresh = WAMBLE_TRANSPORT_MAX_CWND;
+  endpoint->cwnd_acked = 0;
+  endpoint->recovery_seq = 0;
+  endpoint->next_unsent_bundle = 0;
+  endpoint->pace_tokens =
+      WAMBLE_TRANSPORT_PACE_BURST * WAMBLE_TRANSPORT_PACE_UNIT;
+  endpoint->pace_refill_ms = 0;
+}
+
+int network_set_endpoint_capabilities(const struct sockaddr_in *cliaddr,
+                                      const uint8_t *token,
+                                      uint8_t capabilities) {
+  network_ensure_thread_state_initialized();
+  int idx = transport_endpoint_bind_index(cliaddr, token);
+  if (idx < 0)
+    return -1;
+  transport_endpoint_reset_delivery(idx);
+  transport_endpoints[idx].capabilities = capabilities;
+  if (g_current_request.session && g_current_request.seq_num != 0 &&
+      sockaddr_in_equal(&g_current_request.session->addr, cliaddr))
+    (void)wamble_ack_state_record(&transport_endpoints[idx].ack_state,
+                                  g_current_request.seq_num);
+  return 0;
+}
+
+int network_endpoint_delivery_state(const struct sockaddr_in *addr,
+                                    uint32_t *out_srtt_ms,
+                                    uint32_t *out_backlog) {
+  int idx = transport_endpoint_find_by_addr(addr);
+  if (idx < 0)
     return -1;
-  struct WambleMsg ack_msg;
-  memset(&ack_msg, 0, sizeof(ack_msg));
-  ack_msg.ctrl = WAMBLE_CTRL_ACK;
-  memcpy(ack_msg.token, msg->token, TOKEN_LENGTH);
-  ack_msg.board_id = msg->board_id;
-  ack_msg.seq_num = msg->seq_num;
+  if (out_srtt_ms)
+    *out_srtt_ms = transport_endpoints[idx].srtt_ms;
+  if (out_backlog)
+    *out_backlog = transport_endpoints[idx].outbound_queued;
+  return 0;
+}
 
-  uint8_t send_buffer[WAMBLE_MAX_PACKET_SIZE];
+static int transport_endpoint_selective_ack(TransportEndpointId endpoint_id) {
+  int idx = transport_endpoint_find_by_id(endpoint_id);
+  return idx >= 0 &&
+         (transport_endpoints[idx].capabilities & WAMBLE_CAP_SELECTIVE_ACK) != 0;
+}
+
+static ssize_t transport_outbound_find_ack(TransportEndpointId endpoint_id) {
+  for (size_t i = 0; i < transport_outbound_size; i++) {
+    if (transport_outbound_entries[i].variant ==
+            TRANSPORT_OUTBOUND_REQUEST_ACK &&
+        transport_outbound_entries[i].endpoint_id == endpoint_id)
+      return (ssize_t)i;
+  }
+  return -1;
+}
+
+static int transport_enqueue_selective_ack(int endpoint_idx,
+                                           const struct WambleMsg *msg,
+                                           const struct sockaddr_in *cliaddr) {
+  TransportEndpointState *endpoint = &transport_endpoints[endpoint_idx];
+  if (!wamble_ack_state_record(&endpoint->ack_state, msg->seq_num))
+    return 1;
+
+  uint8_t selective[WAMBLE_ACK_PAYLOAD_SIZE];
+  uint32_t cumulative_be = htonl(endpoint->ack_state.cumulative_seq);
+  uint32_t bitmap_be = htonl(endpoint->ack_state.bitmap);
+  memcpy(selective, &cumulative_be, 4);
+  memcpy(selective + 4, &bitmap_be, 4);
+  uint8_t send_buffer[WAMBLE_HEADER_WIRE_SIZE + WAMBLE_ACK_PAYLOAD_SIZE];
   size_t serialized_size = 0;
-  if (wamble_packet_serialize(&ack_msg, send_buffer, sizeof(send_buffer),
-                              &serialized_size, 0) != NET_OK)
+  if (serialize_packet_with_payload(
+          WAMBLE_CTRL_ACK, 0, msg->token, msg->board_id,
+          endpoint->ack_state.highest_seq, 0, selective, sizeof(selective),
+          send_buffer, sizeof(send_buffer), &serialized_size) != NET_OK)
     return -1;
 
-  uint8_t *owned_payload = (uint8_t *)malloc(serialized_size);
-  if (!owned_payload)
+  ssize_t pending = transport_outbound_find_ack(endpoint->endpoint_id);
+  if (pending >= 0 &&
+      transport_outbound_entries[pending].payload_len == serialized_size) {
+    TransportOutboundEntry *entry = &transport_outbound_entries[pending];
+    memcpy(entry->payload, send_buffer, serialized_size);
+    entry->as.ack.ack_seq = endpoint->ack_state.highest_seq;
+    return 0;
+  }
+
+  TransportOutboundEntry entry;
+  memset(&entry, 0, sizeof(entry));
+  entry.variant = TRANSPORT_OUTBOUND_REQUEST_ACK;
+  entry.endpoint_id = endpoint->endpoint_id;
+  entry.addr = *cliaddr;
+  memcpy(entry.token, msg->token, TOKEN_LENGTH);
+  entry.payload = send_buffer;
+  entry.payload_len = serialized_size;
+  entry.as.ack.ack_seq = endpoint->ack_state.highest_seq;
+  return transport_outbound_push(&entry);
+}
+
+int network_enqueue_ack_after(const struct WambleMsg *msg,
+                              const struct sockaddr_in *cliaddr) {
+  if (!msg || !cliaddr)
+    return -1;
+  if (msg->seq_num != 0) {
+    int endpoint_idx = transport_endpoint_find_by_addr(cliaddr);
+    if (endpoint_idx >= 0 && (transport_endpoints[endpoint_idx].capabilities &
+                              WAMBLE_CAP_SELECTIVE_ACK) != 0) {
+      int rc = transport_enqueue_selective_ack(endpoint_idx, msg, cliaddr);
+      if (rc <= 0)
+        return rc;
+    }
+  }
+  uint8_t send_buffer[WAMBLE_HEADER_WIRE_SIZE];
+  size_t serialized_size = 0;
+  if (serialize_packet_with_payload(WAMBLE_CTRL_ACK, 0, msg->token,
+                                    msg->board_id, msg->seq_num, 0, NULL, 0,
+                                    send_buffer, sizeof(send_buffer),
+                                    &serialized_size) != NET_OK)
     return -1;
-  memcpy(owned_payload, send_buffer, serialized_size);
 
   TransportOutboundEntry entry;
   memset(&entry, 0, sizeof(entry));
   entry.variant = TRANSPORT_OUTBOUND_REQUEST_ACK;
   entry.addr = *cliaddr;
   memcpy(entry.token, msg->token, TOKEN_LENGTH);
-  entry.payload = owned_payload;
+  entry.payload = send_buffer;
   entry.payload_len = serialized_size;
   entry.as.ack.ack_seq = msg->seq_num;
   entry.as.ack.deadline_at_ms = 0;
-  if (transport_outbound_push(&entry) != 0) {
-    free(owned_payload);
-    return -1;
-  }
-  return 0;
+  return transport_outbound_push(&entry);
 }
 
 static uint32_t
@@ -2309,6 +3055,7 @@ static int transport_serialize_bundle_fragment(
   fragment.seq_num = seq_num;
   fragment.fragment.fragment_version = WAMBLE_FRAGMENT_VERSION;
   fragment.fragment.fragment_hash_algo = bundle->hash_algo;
+  fragment.fragment.fragment_codec = bundle->codec;
   fragment.fragment.fragment_chunk_index = chunk_index;
   fragment.fragment.fragment_chunk_count = bundle->chunk_count;
   fragment.fragment.fragment_total_len = (uint32_t)bundle->payload_len;
@@ -2337,10 +3084,6 @@ static int transport_enqueue_bundle_fragment(ReliableBundle *bundle,
                                           send_buffer, sizeof(send_buffer),
                                           &serialized_size) != 0)
     return -1;
-  uint8_t *owned_payload = (uint8_t *)malloc(serialized_size);
-  if (!owned_payload)
-    return -1;
-  memcpy(owned_payload, send_buffer, serialized_size);
 
   TransportOutboundEntry entry;
   memset(&entry, 0, sizeof(entry));
@@ -2348,7 +3091,7 @@ static int transport_enqueue_bundle_fragment(ReliableBundle *bundle,
   entry.endpoint_id = bundle->endpoint_id;
   entry.addr = bundle->addr;
   memcpy(entry.token, bundle->token, TOKEN_LENGTH);
-  entry.payload = owned_payload;
+  entry.payload = send_buffer;
   entry.payload_len = serialized_size;
   entry.as.reliable_fragment.seq = seq_num;
   entry.as.reliable_fragment.fragment_index = chunk_index;
@@ -2357,11 +3100,7 @@ static int transport_enqueue_bundle_fragment(ReliableBundle *bundle,
   entry.as.reliable_fragment.rto_ms = transport_clamp_rto_ms(
       bundle->timeout_ms > 0 ? (uint32_t)bundle->timeout_ms : 0);
   entry.as.reliable_fragment.max_retries = bundle->max_retries;
-  if (transport_outbound_push(&entry) != 0) {
-    free(owned_payload);
-    return -1;
-  }
-  return 0;
+  return transport_outbound_push(&entry);
 }
 
 static int
@@ -2384,21 +3123,150 @@ transport_cache_replayable_bundle_packets(const ReliableBundle *bundle) {
   return 0;
 }
 
-static int transport_reliable_bundle_fragment_acked(uint64_t bundle_id) {
+static size_t transport_reliable_bundle_abort(uint64_t bundle_id,
+                                              size_t pivot) {
+  size_t removed_before = 0;
+  for (size_t i = 0; i < transport_outbound_size;) {
+    TransportOutboundEntry *e = &transport_outbound_entries[i];
+    if (e->variant == TRANSPORT_OUTBOUND_RELIABLE_BUNDLE_FRAGMENT &&
+        e->as.reliable_fragment.bundle_id == bundle_id) {
+      transport_outbound_remove(i);
+      if (i < pivot)
+        removed_before++;
+    } else {
+      i++;
+    }
+  }
   ssize_t idx = transport_reliable_bundle_find(bundle_id);
+  if (idx >= 0)
+    transport_reliable_bundle_remove((size_t)idx);
+  return removed_before;
+}
+
+static int transport_endpoint_fill_window(TransportEndpointId endpoint_id) {
+  int idx = transport_endpoint_find_by_id(endpoint_id);
+  if (idx < 0)
+    return -1;
+  TransportEndpointState *endpoint = &transport_endpoints[idx];
+  size_t b = endpoint->next_unsent_bundle;
+  for (; b < transport_reliable_bundle_size &&
+         endpoint->fragments_in_flight < endpoint->cwnd;) {
+    ReliableBundle *bundle = &transport_reliable_bundles[b];
+    if (bundle->endpoint_id != endpoint_id ||
+        bundle->next_fragment_index >= bundle->chunk_count) {
+      b++;
+      continue;
+    }
+    if (transport_enqueue_bundle_fragment(bundle,
+                                          bundle->next_fragment_index) != 0) {
+      (void)transport_reliable_bundle_abort(bundle->bundle_id, 0);
+      return -1;
+    }
+    bundle->next_fragment_index++;
+  }
+  endpoint->next_unsent_bundle = b;
+  return 0;
+}
+
+static void transport_endpoint_enter_recovery(TransportEndpointId endpoint_id,
+                                              uint32_t seq) {
+  int idx = transport_endpoint_find_by_id(endpoint_id);
+  if (idx < 0)
+    return;
+  TransportEndpointState *endpoint = &transport_endpoints[idx];
+  if ((int32_t)(seq - endpoint->recovery_seq) < 0)
+    return;
+  uint32_t half = endpoint->cwnd / 2u;
+  endpoint->ssthresh = half > WAMBLE_TRANSPORT_MIN_SSTHRESH
+                           ? half
+                           : WAMBLE_TRANSPORT_MIN_SSTHRESH;
+  endpoint->cwnd = half > 0 ? half : 1u;
+  endpoint->cwnd_acked = 0;
+  endpoint->recovery_seq = endpoint->next_reliable_seq;
+}
+
+static void transport_endpoint_ack_fragment(TransportEndpointId endpoint_id,
+                                            int retransmitted) {
+  int idx = transport_endpoint_find_by_id(endpoint_id);
+  if (idx < 0 || retransmitted)
+    return;
+  TransportEndpointState *endpoint = &transport_endpoints[idx];
+  if (endpoint->cwnd >= WAMBLE_TRANSPORT_MAX_CWND)
+    return;
+  if (endpoint->cwnd < endpoint->ssthresh) {
+    endpoint->cwnd++;
+  } else if (++endpoint->cwnd_acked >= endpoint->cwnd) {
+    endpoint->cwnd++;
+    endpoint->cwnd_acked = 0;
+  }
+}
+
+static uint64_t
+transport_endpoint_pace_fragment(const TransportOutboundEntry *entry,
+                                 uint64_t now) {
+  int idx = transport_endpoint_find_by_id(entry->endpoint_id);
   if (idx < 0)
     return 0;
-  ReliableBundle *bundle = &transport_reliable_bundles[idx];
-  if (bundle->next_fragment_index >= bundle->chunk_count) {
-    transport_reliable_bundle_remove((size_t)idx);
-    return 1;
+  TransportEndpointState *endpoint = &transport_endpoints[idx];
+  if (endpoint->srtt_ms == 0)
+    return 0;
+
+  uint64_t unit = WAMBLE_TRANSPORT_PACE_UNIT;
+  uint64_t burst = WAMBLE_TRANSPORT_PACE_BURST * unit;
+  uint64_t rate = (uint64_t)endpoint->cwnd * unit;
+  if (now > endpoint->pace_refill_ms) {
+    uint64_t elapsed = now - endpoint->pace_refill_ms;
+    uint64_t tokens = elapsed >= endpoint->srtt_ms
+                          ? burst
+                          : endpoint->pace_tokens +
+                                elapsed * rate / endpoint->srtt_ms;
+    endpoint->pace_tokens = (uint32_t)(tokens < burst ? tokens : burst);
+    endpoint->pace_refill_ms = now;
   }
-  uint16_t next = bundle->next_fragment_index++;
-  if (transport_enqueue_bundle_fragment(bundle, next) != 0) {
+  if (endpoint->pace_tokens < unit) {
+    uint64_t deficit = unit - endpoint->pace_tokens;
+    uint64_t wait = (deficit * endpoint->srtt_ms + rate - 1u) / rate;
+    return now + (wait ? wait : 1u);
+  }
+  endpoint->pace_tokens -= (uint32_t)unit;
+  return 0;
+}
+
+static int transport_reliable_bundle_fragment_acked(uint64_t bundle_id,
+                                                    int retransmitted) {
+  ssize_t idx = transport_reliable_bundle_find(bundle_id);
+  if (idx < 0)
+    return 0;
+  ReliableBundle *bundle = &transport_reliable_bundles[idx];
+  TransportEndpointId endpoint_id = bundle->endpoint_id;
+  transport_endpoint_ack_fragment(endpoint_id, retransmitted);
+  if (++bundle->acked_fragments >= bundle->chunk_count)
     transport_reliable_bundle_remove((size_t)idx);
-    return -1;
+  return transport_endpoint_fill_window(endpoint_id) == 0 ? 1 : -1;
+}
+
+static uint8_t *
+transport_endpoint_compress_payload(TransportEndpointId endpoint_id,
+                                    const uint8_t *payload, size_t payload_len,
+                                    size_t *out_len) {
+  int idx = transport_endpoint_find_by_id(endpoint_id);
+  if (idx < 0 ||
+      (transport_endpoints[idx].capabilities &
+       WAMBLE_CAP_PAYLOAD_COMPRESSION) == 0 ||
+      payload_len < WAMBLE_TRANSPORT_COMPRESS_MIN ||
+      payload_len > WAMBLE_FRAGMENT_REASSEMBLY_MAX)
+    return NULL;
+  size_t bound = wamble_lz_compress_bound(payload_len);
+  uint8_t *compressed = (uint8_t *)malloc(bound);
+  if (!compressed)
+    return NULL;
+  if (wamble_lz_compress(payload, payload_len, compressed, bound, out_len) !=
+          0 ||
+      *out_len >= payload_len) {
+    free(compressed);
+    return NULL;
   }
-  return 1;
+  return compressed;
 }
 
 static int transport_enqueue_reliable_bundle(
@@ -2412,40 +3280,51 @@ static int transport_enqueue_reliable_bundle(
       payload_len > (size_t)UINT32_MAX ||
       !ctrl_supports_fragment_payload(ctrl) || WAMBLE_FRAGMENT_DATA_MAX == 0)
     return -1;
+  TransportEndpointId endpoint_id = TRANSPORT_ENDPOINT_ID_INVALID;
+  if (transport_endpoint_bind_addr_token(cliaddr, effective_token,
+                                         &endpoint_id) != 0)
+    return -1;
+  size_t wire_len = 0;
+  uint8_t *compressed = transport_endpoint_compress_payload(
+      endpoint_id, payload, payload_len, &wire_len);
+  if (!compressed)
+    wire_len = payload_len;
   size_t chunk_size = (size_t)WAMBLE_FRAGMENT_DATA_MAX;
   size_t needed_chunks =
-      payload_len == 0 ? 1u : (payload_len + chunk_size - 1u) / chunk_size;
-  if (needed_chunks == 0 || needed_chunks > UINT16_MAX)
+      wire_len == 0 ? 1u : (wire_len + chunk_size - 1u) / chunk_size;
+  if (needed_chunks == 0 || needed_chunks > UINT16_MAX ||
+      transport_size_ensure((void **)&transport_reliable_bundles,
+                            sizeof(*transport_reliable_bundles),
+                            &transport_reliable_bundle_capacity,
+                            transport_reliable_bundle_size + 1) != 0) {
+    free(compressed);
     return -1;
+  }
   if (timeout_ms <= 0)
     timeout_ms = get_config()->timeout_ms;
   if (max_retries <= 0)
     max_retries = get_config()->max_retries;
-  if (transport_size_ensure((void **)&transport_reliable_bundles,
-                            sizeof(*transport_reliable_bundles),
-                            &transport_reliable_bundle_capacity,
-                            transport_reliable_bundle_size + 1) != 0)
-    return -1;
   ReliableBundle bundle;
   memset(&bundle, 0, sizeof(bundle));
   bundle.bundle_id = transport_allocate_bundle_id();
-  if (transport_endpoint_bind_addr_token(cliaddr, effective_token,
-                                         &bundle.endpoint_id) != 0)
-    return -1;
+  bundle.endpoint_id = endpoint_id;
   bundle.ctrl = ctrl;
   memcpy(bundle.token, effective_token, TOKEN_LENGTH);
   bundle.board_id = board_id;
-  bundle.payload = payload_len > 0 ? (uint8_t *)malloc(payload_len) : NULL;
-  if (payload_len > 0 && !bundle.payload)
-    return -1;
-  if (payload_len > 0)
+  if (compressed) {
+    bundle.payload = compressed;
+    bundle.codec = WAMBLE_FRAGMENT_CODEC_LZ;
+  } else if (payload_len > 0) {
+    bundle.payload = (uint8_t *)malloc(payload_len);
+    if (!bundle.payload)
+      return -1;
     memcpy(bundle.payload, payload, payload_len);
-  bundle.payload_len = payload_len;
+  }
+  bundle.payload_len = wire_len;
   bundle.chunk_count = (uint16_t)needed_chunks;
-  bundle.next_fragment_index = 1;
   bundle.hash_algo = WAMBLE_FRAGMENT_HASH_BLAKE2B_256;
-  crypto_blake2b(bundle.hash, WAMBLE_FRAGMENT_HASH_LENGTH, payload,
-                 payload_len);
+  crypto_blake2b(bundle.hash, WAMBLE_FRAGMENT_HASH_LENGTH,
+                 compressed ? compressed : payload, wire_len);
   bundle.req_seq = g_current_request.seq_num;
   bundle.transfer_id = next_fragment_transfer_id();
   bundle.replayable_terminal = replayable_terminal ? 1 : 0;
@@ -2457,25 +3336,16 @@ static int transport_enqueue_reliable_bundle(
   bundle.max_retries = (uint16_t)max_retries;
   bundle.timeout_ms = timeout_ms;
   bundle.addr = *cliaddr;
-  size_t idx = transport_reliable_bundle_size++;
-  transport_reliable_bundles[idx] = bundle;
-  if (transport_enqueue_bundle_fragment(&transport_reliable_bundles[idx], 0) !=
-      0) {
-    transport_reliable_bundle_remove(idx);
+  transport_reliable_bundles[transport_reliable_bundle_size++] = bundle;
+  if (transport_endpoint_fill_window(bundle.endpoint_id) != 0) {
+    (void)transport_reliable_bundle_abort(bundle.bundle_id, 0);
     return -1;
   }
-  if (transport_cache_replayable_bundle_packets(
-          &transport_reliable_bundles[idx]) != 0) {
+  ssize_t idx = transport_reliable_bundle_find(bundle.bundle_id);
+  if (idx >= 0 && transport_cache_replayable_bundle_packets(
+                      &transport_reliable_bundles[idx]) != 0) {
     terminal_cache_remove(g_current_request.session, g_current_request.seq_num);
-    for (size_t i = 0; i < transport_outbound_size;) {
-      TransportOutboundEntry *e = &transport_outbound_entries[i];
-      if (e->variant == TRANSPORT_OUTBOUND_RELIABLE_BUNDLE_FRAGMENT &&
-          e->as.reliable_fragment.bundle_id == bundle.bundle_id)
-        transport_outbound_remove(i);
-      else
-        i++;
-    }
-    transport_reliable_bundle_remove(idx);
+    (void)transport_reliable_bundle_abort(bundle.bundle_id, 0);
     return -1;
   }
   return 0;
@@ -2506,21 +3376,7 @@ static int send_serialized_packet_once(wamble_socket_t sockfd,
   }
   if (ws_rc < 0)
     return -1;
-
-  ssize_t bytes_sent = sendto(sockfd, (const char *)send_buffer,
-#ifdef WAMBLE_PLATFORM_WINDOWS
-                              (int)serialized_size,
-#else
-                              (size_t)serialized_size,
-#endif
-                              0, (const struct sockaddr *)cliaddr,
-#ifdef WAMBLE_PLATFORM_WINDOWS
-                              (int)sizeof(*cliaddr)
-#else
-                              (wamble_socklen_t)sizeof(*cliaddr)
-#endif
-  );
-  return bytes_sent < 0 ? -1 : 0;
+  return transport_udp_send(sockfd, send_buffer, serialized_size, cliaddr);
 }
 
 static int network_enqueue_serialized_reliable(
@@ -2560,10 +3416,10 @@ static int network_enqueue_serialized_reliable(
   entry.as.reliable.rto_ms = transport_clamp_rto_ms((uint32_t)timeout_ms);
   entry.as.reliable.retry_count = 0;
   entry.as.reliable.max_retries = (uint16_t)max_retries;
-  if (transport_outbound_push(&entry) != 0) {
-    free(owned_payload);
+  int pushed = transport_outbound_push(&entry);
+  free(owned_payload);
+  if (pushed != 0)
     return -1;
-  }
   if (replayable_terminal)
     terminal_cache_store_for_current_request(send_buffer, serialized_size);
   return 0;
@@ -2638,23 +3494,54 @@ int network_enqueue_unreliable(const struct WambleMsg *msg,
   if (wamble_packet_serialize(msg, buffer, sizeof(buffer), &serialized_size,
                               send_flags) != NET_OK)
     return -1;
-  uint8_t *owned_payload = (uint8_t *)malloc(serialized_size);
-  if (!owned_payload)
-    return -1;
-  memcpy(owned_payload, buffer, serialized_size);
 
   TransportOutboundEntry entry;
   memset(&entry, 0, sizeof(entry));
   entry.variant = TRANSPORT_OUTBOUND_UNRELIABLE;
   entry.addr = *cliaddr;
   memcpy(entry.token, msg->token, TOKEN_LENGTH);
-  entry.payload = owned_payload;
+  entry.payload = buffer;
   entry.payload_len = serialized_size;
-  if (transport_outbound_push(&entry) != 0) {
-    free(owned_payload);
+  return transport_outbound_push(&entry);
+}
+
+TransportSharedPayload *network_shared_payload_create(
+    const struct WambleMsg *msg) {
+  if (!msg)
+    return NULL;
+  uint8_t buffer[WAMBLE_MAX_PACKET_SIZE];
+  size_t serialized_size = 0;
+  uint8_t send_flags = (uint8_t)(msg->flags | WAMBLE_FLAG_UNRELIABLE);
+  if (wamble_packet_serialize(msg, buffer, sizeof(buffer), &serialized_size,
+                              send_flags) != NET_OK)
+    return NULL;
+  TransportSharedPayload *shared = (TransportSharedPayload *)malloc(
+      sizeof(*shared) + serialized_size);
+  if (!shared)
+    return NULL;
+  shared->refs = 1;
+  shared->len = serialized_size;
+  memcpy(shared->data, buffer, serialized_size);
+  return shared;
+}
+
+void network_shared_payload_release(TransportSharedPayload *shared) {
+  transport_shared_payload_release(shared);
+}
+
+int network_enqueue_unreliable_shared(TransportSharedPayload *shared,
+                                      const uint8_t *token,
+                                      const struct sockaddr_in *cliaddr) {
+  if (!shared || !token || !cliaddr)
     return -1;
-  }
-  return 0;
+  TransportOutboundEntry entry;
+  memset(&entry, 0, sizeof(entry));
+  entry.variant = TRANSPORT_OUTBOUND_UNRELIABLE;
+  entry.addr = *cliaddr;
+  memcpy(entry.token, token, TOKEN_LENGTH);
+  entry.shared = shared;
+  entry.payload_len = shared->len;
+  return transport_outbound_push(&entry);
 }
 
 int network_enqueue_unreliable_for_token(const struct WambleMsg *msg,
@@ -2858,6 +3745,27 @@ int send_unreliable_packet(wamble_socket_t sockfd, const struct WambleMsg *msg,
 #endif
 }
 
+void network_wake_socket(wamble_socket_t sockfd) {
+  if (sockfd == WAMBLE_INVALID_SOCKET)
+    return;
+  int port = wamble_socket_bound_port(sockfd);
+  if (port <= 0)
+    return;
+  struct sockaddr_in wake_addr;
+  memset(&wake_addr, 0, sizeof(wake_addr));
+  wake_addr.sin_family = AF_INET;
+  wake_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  wake_addr.sin_port = htons((uint16_t)port);
+  const uint8_t byte = 0;
+  (void)sendto(sockfd, (const char *)&byte,
+#ifdef WAMBLE_PLATFORM_WINDOWS
+               1,
+#else
+               sizeof(byte),
+#endif
+               0, (const struct sockaddr *)&wake_addr, sizeof(wake_addr));
+}
+
 static int network_is_manager_wake_packet(const uint8_t *packet,
                                           size_t packet_len,
                                           const struct sockaddr_in *addr) {
@@ -2867,6 +3775,86 @@ static int network_is_manager_wake_packet(const uint8_t *packet,
   return (ip >> 24) == 127u;
 }
 
+static int network_inbound_admit_udp(uint32_t slot,
+                                     uint32_t *progress_count) {
+  TransportPacketSlot *entry = &transport_packet_slots[slot];
+  if (network_is_manager_wake_packet(entry->packet, entry->packet_len,
+                                     &entry->addr) ||
+      !network_addr_prefilter_allow(
+          &entry->addr, get_config()->rate_limit_addr_packets_per_sec)) {
+    transport_packet_release(slot);
+    (*progress_count)++;
+    return 0;
+  }
+  (void)transport_endpoint_bind_addr_token(&entry->addr, NULL,
+                                           &entry->endpoint_id);
+  if (transport_inbound_push(slot) != 0) {
+    transport_packet_release(slot);
+    return -1;
+  }
+  (*progress_count)++;
+  return 0;
+}
+
+#ifdef WAMBLE_UDP_OFFLOAD
+static int network_inbound_recv_gro(wamble_socket_t sockfd,
+                                    uint32_t *progress_count,
+                                    uint32_t *error_count) {
+  if (transport_packet_available() < WAMBLE_UDP_OFFLOAD_MAX_SEGMENTS)
+    return 0;
+  struct sockaddr_in from;
+  char control[CMSG_SPACE(sizeof(int))];
+  struct iovec iov;
+  iov.iov_base = transport_udp_gro_buffer;
+  iov.iov_len = WAMBLE_UDP_GRO_BUFFER_SIZE;
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = &from;
+  msg.msg_namelen = (socklen_t)sizeof(from);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  ssize_t bytes_received = recvmsg(sockfd, &msg, 0);
+  if (bytes_received <= 0)
+    return 0;
+  size_t total = (size_t)bytes_received;
+  size_t segment_size = total;
+  for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm;
+       cm = CMSG_NXTHDR(&msg, cm)) {
+    if (cm->cmsg_level == IPPROTO_UDP && cm->cmsg_type == UDP_GRO) {
+      int gso_size = 0;
+      memcpy(&gso_size, CMSG_DATA(cm), sizeof(gso_size));
+      if (gso_size > 0)
+        segment_size = (size_t)gso_size;
+    }
+  }
+  for (size_t off = 0; off < total; off += segment_size) {
+    size_t len = total - off;
+    if (len > segment_size)
+      len = segment_size;
+    if (len > WAMBLE_MAX_PACKET_SIZE)
+      continue;
+    uint32_t slot = TRANSPORT_PACKET_SLOT_NONE;
+    if (transport_packet_acquire(TRANSPORT_PACKET_SOURCE_UDP, NULL, &slot) !=
+        0) {
+      *error_count += (uint32_t)((total - off + segment_size - 1u) /
+                                 segment_size);
+      return -1;
+    }
+    TransportPacketSlot *entry = &transport_packet_slots[slot];
+    memcpy(entry->packet, transport_udp_gro_buffer + off, len);
+    entry->packet_len = len;
+    entry->addr = from;
+    if (network_inbound_admit_udp(slot, progress_count) != 0) {
+      (*error_count)++;
+      return -1;
+    }
+  }
+  return 1;
+}
+#endif
+
 static TransportDriveResult network_inbound_pump(wamble_socket_t sockfd,
                                                  WambleWsGateway *ws_gateway,
                                                  long select_usec,
@@ -2875,21 +3863,25 @@ static TransportDriveResult network_inbound_pump(wamble_socket_t sockfd,
   uint32_t error_count = 0;
   if (ws_gateway) {
     for (size_t drained_ws = 0; drained_ws < budget; drained_ws++) {
-      TransportInboundEntry entry;
-      memset(&entry, 0, sizeof(entry));
-      entry.source = TRANSPORT_PACKET_SOURCE_WS;
+      uint32_t slot = TRANSPORT_PACKET_SLOT_NONE;
+      if (transport_packet_acquire(TRANSPORT_PACKET_SOURCE_WS, NULL, &slot) !=
+          0)
+        break;
+      TransportPacketSlot *entry = &transport_packet_slots[slot];
       size_t packet_len = 0;
-      struct sockaddr_in ws_cliaddr;
       int ws_rc =
-          ws_gateway_pop_packet(ws_gateway, entry.packet, sizeof(entry.packet),
-                                &packet_len, &ws_cliaddr);
-      if (ws_rc <= 0)
+          ws_gateway_pop_packet(ws_gateway, entry->packet,
+                                sizeof(entry->packet), &packet_len,
+                                &entry->addr);
+      if (ws_rc <= 0) {
+        transport_packet_release(slot);
         break;
-      entry.addr = ws_cliaddr;
-      (void)transport_endpoint_bind_addr_token(&entry.addr, NULL,
-                                               &entry.endpoint_id);
-      entry.packet_len = packet_len;
-      if (transport_inbound_push(&entry) != 0) {
+      }
+      (void)transport_endpoint_bind_addr_token(&entry->addr, NULL,
+                                               &entry->endpoint_id);
+      entry->packet_len = packet_len;
+      if (transport_inbound_push(slot) != 0) {
+        transport_packet_release(slot);
         error_count++;
         break;
       }
@@ -2897,7 +3889,7 @@ static TransportDriveResult network_inbound_pump(wamble_socket_t sockfd,
     }
   }
 
-  if (sockfd != WAMBLE_INVALID_SOCKET) {
+  if (sockfd != WAMBLE_INVALID_SOCKET && transport_packet_available() > 0) {
     int ready = 0;
     fd_set rfds;
     struct timeval tv;
@@ -2917,30 +3909,33 @@ static TransportDriveResult network_inbound_pump(wamble_socket_t sockfd,
 #endif
     if (ready > 0 && FD_ISSET(sockfd, &rfds)) {
       for (size_t drained = 0; drained < budget; drained++) {
-        TransportInboundEntry entry;
-        memset(&entry, 0, sizeof(entry));
-        entry.source = TRANSPORT_PACKET_SOURCE_UDP;
-        struct sockaddr_in cliaddr;
-        wamble_socklen_t len = sizeof(cliaddr);
+#ifdef WAMBLE_UDP_OFFLOAD
+        if (transport_udp_gro_active(sockfd)) {
+          int gro_rc =
+              network_inbound_recv_gro(sockfd, &progress_count, &error_count);
+          if (gro_rc <= 0)
+            break;
+          continue;
+        }
+#endif
+        uint32_t slot = TRANSPORT_PACKET_SLOT_NONE;
+        if (transport_packet_acquire(TRANSPORT_PACKET_SOURCE_UDP, NULL,
+                                     &slot) != 0)
+          break;
+        TransportPacketSlot *entry = &transport_packet_slots[slot];
+        wamble_socklen_t len = sizeof(entry->addr);
         ssize_t bytes_received =
-            recvfrom(sockfd, (char *)entry.packet, WAMBLE_MAX_PACKET_SIZE, 0,
-                     (struct sockaddr *)&cliaddr, &len);
-        if (bytes_received <= 0)
+            recvfrom(sockfd, (char *)entry->packet, WAMBLE_MAX_PACKET_SIZE, 0,
+                     (struct sockaddr *)&entry->addr, &len);
+        if (bytes_received <= 0) {
+          transport_packet_release(slot);
           break;
-        entry.addr = cliaddr;
-        entry.packet_len = (size_t)bytes_received;
-        if (network_is_manager_wake_packet(entry.packet, entry.packet_len,
-                                           &entry.addr)) {
-          progress_count++;
-          continue;
         }
-        (void)transport_endpoint_bind_addr_token(&entry.addr, NULL,
-                                                 &entry.endpoint_id);
-        if (transport_inbound_push(&entry) != 0) {
+        entry->packet_len = (size_t)bytes_received;
+        if (network_inbound_admit_udp(slot, &progress_count) != 0) {
           error_count++;
           break;
         }
-        progress_count++;
       }
     } else if (ready < 0) {
       error_count++;
@@ -2964,34 +3959,38 @@ static TransportDriveResult network_classify_inbound(wamble_socket_t sockfd,
   uint32_t error_count = 0;
   size_t processed = 0;
   while (processed < budget) {
-    TransportInboundEntry inbound;
-    memset(&inbound, 0, sizeof(inbound));
-    if (!transport_inbound_pop(&inbound))
+    uint32_t slot = TRANSPORT_PACKET_SLOT_NONE;
+    if (!transport_inbound_pop(&slot))
       break;
     processed++;
 
-    struct WambleMsg msg;
-    memset(&msg, 0, sizeof(msg));
+    TransportPacketSlot *inbound = &transport_packet_slots[slot];
     NetworkInboundClassification kind = NETWORK_INBOUND_INVALID;
-    TransportEndpointId classified_endpoint_id = inbound.endpoint_id;
-    int rc = network_classify_packet_impl(
-        sockfd, inbound.packet, inbound.packet_len, &msg, &inbound.addr,
-        inbound.endpoint_id, &classified_endpoint_id, &kind, 0);
+    TransportEndpointId classified_endpoint_id = inbound->endpoint_id;
+    int rc = -1;
+    transport_request_msg_slot = TRANSPORT_PACKET_SLOT_NONE;
+    if (wamble_msg_view_parse(inbound->packet, inbound->packet_len,
+                              &inbound->view) == NET_OK) {
+      rc = network_classify_packet_impl(
+          sockfd, &inbound->view, inbound->packet_len, transport_request_msg,
+          &inbound->addr, inbound->endpoint_id, &classified_endpoint_id, &kind,
+          0);
+    }
     if (rc <= 0) {
+      transport_packet_release(slot);
       error_count++;
       continue;
     }
     progress_count++;
-    if (kind != NETWORK_INBOUND_REQUEST)
+    if (kind != NETWORK_INBOUND_REQUEST) {
+      transport_packet_release(slot);
       continue;
+    }
 
-    TransportDispatchEntry dispatch;
-    memset(&dispatch, 0, sizeof(dispatch));
-    dispatch.source = inbound.source;
-    dispatch.endpoint_id = classified_endpoint_id;
-    dispatch.addr = inbound.addr;
-    dispatch.msg = msg;
-    if (transport_dispatch_push(&dispatch) != 0) {
+    inbound->endpoint_id = classified_endpoint_id;
+    transport_request_msg_slot = slot;
+    if (transport_dispatch_push(slot) != 0) {
+      transport_packet_release(slot);
       error_count++;
       break;
     }
@@ -3017,22 +4016,27 @@ static TransportDriveResult network_dispatch_requests(wamble_socket_t sockfd,
   uint32_t error_count = 0;
   size_t processed = 0;
   while (processed < budget) {
-    TransportDispatchEntry dispatch;
-    memset(&dispatch, 0, sizeof(dispatch));
-    if (!transport_dispatch_pop(&dispatch))
+    uint32_t slot = TRANSPORT_PACKET_SLOT_NONE;
+    if (!transport_dispatch_pop(&slot))
       break;
     processed++;
-    if (ctrl_is_client_request(dispatch.msg.ctrl) &&
-        (dispatch.msg.flags & WAMBLE_FLAG_UNRELIABLE) == 0) {
-      WambleClientSession *session =
-          find_endpoint_session(&dispatch.addr, dispatch.msg.token);
-      begin_reliable_request_scope(session, dispatch.msg.seq_num);
+    TransportPacketSlot *dispatch = &transport_packet_slots[slot];
+    struct WambleMsg *msg = transport_request_msg;
+    if (transport_request_msg_slot != slot &&
+        wamble_msg_view_decode(&dispatch->view, msg) != NET_OK) {
+      transport_request_msg_slot = TRANSPORT_PACKET_SLOT_NONE;
+      transport_packet_release(slot);
+      error_count++;
+      continue;
     }
+    transport_request_msg_slot = TRANSPORT_PACKET_SLOT_NONE;
+    network_begin_request(msg, &dispatch->addr);
     int previous_defer = network_set_deferred_reliable_ack_wait(1);
     ServerStatus status =
-        handle_message(sockfd, &dispatch.msg, &dispatch.addr, 0, profile_name);
+        handle_message(sockfd, msg, &dispatch->addr, 0, profile_name);
     (void)network_set_deferred_reliable_ack_wait(previous_defer);
     network_end_request();
+    transport_packet_release(slot);
     if (status == SERVER_ERR_SEND_FAILED)
       error_count++;
     progress_count++;
@@ -3051,6 +4055,48 @@ static TransportDriveResult network_dispatch_requests(wamble_socket_t sockfd,
       error_count ? (wamble_now_mono_millis() + 1u) : 0);
 }
 
+static int transport_outbound_has_due_data(TransportEndpointId endpoint_id,
+                                           uint64_t now) {
+  for (size_t i = 0; i < transport_outbound_size; i++) {
+    const TransportOutboundEntry *entry = &transport_outbound_entries[i];
+    if (entry->variant != TRANSPORT_OUTBOUND_REQUEST_ACK &&
+        entry->endpoint_id == endpoint_id &&
+        transport_outbound_entry_deadline(entry) <= now)
+      return 1;
+  }
+  return 0;
+}
+
+static int transport_send_with_ack_trailer(wamble_socket_t sockfd,
+                                           const TransportOutboundEntry *entry,
+                                           const uint8_t *bytes,
+                                           const struct sockaddr_in *addr) {
+  uint8_t packet[WAMBLE_MAX_PACKET_SIZE];
+  int idx = transport_endpoint_find_by_id(entry->endpoint_id);
+  if (idx < 0 || transport_endpoints[idx].ack_state.highest_seq == 0 ||
+      entry->payload_len < WAMBLE_HEADER_WIRE_SIZE ||
+      entry->payload_len + WAMBLE_ACK_TRAILER_SIZE > sizeof(packet) ||
+      (bytes[3] & WAMBLE_HEADER_OPT_ACK_TRAILER) != 0)
+    return 1;
+
+  const WambleAckState *ack = &transport_endpoints[idx].ack_state;
+  uint32_t trailer[3];
+  trailer[0] = htonl(ack->highest_seq);
+  trailer[1] = htonl(ack->cumulative_seq);
+  trailer[2] = htonl(ack->bitmap);
+  size_t packet_len = entry->payload_len + WAMBLE_ACK_TRAILER_SIZE;
+  size_t payload_len = packet_len - WAMBLE_HEADER_WIRE_SIZE;
+  memcpy(packet, bytes, entry->payload_len);
+  memcpy(packet + entry->payload_len, trailer, WAMBLE_ACK_TRAILER_SIZE);
+  packet[3] |= WAMBLE_HEADER_OPT_ACK_TRAILER;
+  packet[32] = (uint8_t)((payload_len >> 8) & 0xFFu);
+  packet[33] = (uint8_t)(payload_len & 0xFFu);
+  return send_serialized_packet_once(sockfd, packet, packet_len, addr, NULL) ==
+                 0
+             ? 0
+             : -1;
+}
+
 static TransportDriveResult network_outbound_pump(wamble_socket_t sockfd,
                                                   size_t budget) {
   uint32_t progress_count = 0;
@@ -3061,7 +4107,8 @@ static TransportDriveResult network_outbound_pump(wamble_socket_t sockfd,
   TransportOutboundLane lanes[] = {TRANSPORT_OUTBOUND_LANE_REQUEST_ACK,
                                    TRANSPORT_OUTBOUND_LANE_RELIABLE_TERMINAL,
                                    TRANSPORT_OUTBOUND_LANE_RELIABLE_BUNDLE,
-                                   TRANSPORT_OUTBOUND_LANE_UNRELIABLE};
+                                   TRANSPORT_OUTBOUND_LANE_UNRELIABLE,
+                                   TRANSPORT_OUTBOUND_LANE_REQUEST_ACK};
 
   for (size_t l = 0; l < sizeof(lanes) / sizeof(lanes[0]) &&
                      progress_count + error_count < budget;
@@ -3081,6 +4128,11 @@ static TransportDriveResult network_outbound_pump(wamble_socket_t sockfd,
         i++;
         continue;
       }
+      if (l == 0 && transport_endpoint_selective_ack(entry->endpoint_id) &&
+          transport_outbound_has_due_data(entry->endpoint_id, now)) {
+        i++;
+        continue;
+      }
 
       struct sockaddr_in delivery_addr = entry->addr;
       if (transport_endpoint_resolve_addr(entry->endpoint_id, &delivery_addr) ==
@@ -3113,20 +4165,44 @@ static TransportDriveResult network_outbound_pump(wamble_socket_t sockfd,
             entry->variant == TRANSPORT_OUTBOUND_RELIABLE_BUNDLE_FRAGMENT
                 ? entry->as.reliable_fragment.bundle_id
                 : 0;
+        TransportEndpointId dropped_endpoint_id = entry->endpoint_id;
         transport_outbound_remove(i);
         if (dropped_bundle_id != 0) {
-          ssize_t bundle_idx =
-              transport_reliable_bundle_find(dropped_bundle_id);
-          if (bundle_idx >= 0)
-            transport_reliable_bundle_remove((size_t)bundle_idx);
+          i -= transport_reliable_bundle_abort(dropped_bundle_id, i);
+          (void)transport_endpoint_fill_window(dropped_endpoint_id);
         }
         error_count++;
         continue;
       }
+      if (entry->variant == TRANSPORT_OUTBOUND_RELIABLE_BUNDLE_FRAGMENT) {
+        if (entry->as.reliable_fragment.retry_count > 0)
+          transport_endpoint_enter_recovery(entry->endpoint_id,
+                                            entry->as.reliable_fragment.seq);
+        uint64_t paced_until = transport_endpoint_pace_fragment(entry, now);
+        if (paced_until > now) {
+          next_deadline = transport_min_nonzero_u64(next_deadline, paced_until);
+          i++;
+          continue;
+        }
+      }
 
-      if (send_serialized_packet_once(sockfd, entry->payload,
-                                      entry->payload_len, &delivery_addr,
-                                      NULL) != 0) {
+      uint8_t scratch[WAMBLE_MAX_PACKET_SIZE];
+      const uint8_t *bytes = transport_outbound_entry_bytes(entry, scratch);
+      ssize_t piggyback_ack = -1;
+      int send_rc = 1;
+      if (entry->variant != TRANSPORT_OUTBOUND_REQUEST_ACK &&
+          transport_endpoint_selective_ack(entry->endpoint_id)) {
+        piggyback_ack = transport_outbound_find_ack(entry->endpoint_id);
+        if (piggyback_ack >= 0)
+          send_rc = transport_send_with_ack_trailer(sockfd, entry, bytes,
+                                                    &delivery_addr);
+        if (send_rc > 0)
+          piggyback_ack = -1;
+      }
+      if (send_rc > 0)
+        send_rc = send_serialized_packet_once(sockfd, bytes, entry->payload_len,
+                                              &delivery_addr, NULL);
+      if (send_rc != 0) {
         error_count++;
         retry_after = transport_min_nonzero_u64(retry_after, now + 1u);
         if (entry->variant == TRANSPORT_OUTBOUND_RELIABLE_TERMINAL ||
@@ -3145,6 +4221,12 @@ static TransportDriveResult network_outbound_pump(wamble_socket_t sockfd,
       }
 
       progress_count++;
+      if (piggyback_ack >= 0) {
+        transport_outbound_remove((size_t)piggyback_ack);
+        if ((size_t)piggyback_ack < i)
+          i--;
+        entry = &transport_outbound_entries[i];
+      }
       if (entry->variant == TRANSPORT_OUTBOUND_RELIABLE_TERMINAL ||
           entry->variant == TRANSPORT_OUTBOUND_RELIABLE_BUNDLE_FRAGMENT) {
         uint32_t rto = entry->variant == TRANSPORT_OUTBOUND_RELIABLE_TERMINAL
@@ -3167,6 +4249,12 @@ static TransportDriveResult network_outbound_pump(wamble_socket_t sockfd,
     }
   }
 
+  uint32_t batch_failures = transport_udp_batch_finish();
+  if (batch_failures) {
+    error_count += batch_failures;
+    retry_after = transport_min_nonzero_u64(retry_after, now + 1u);
+  }
+
   TransportDriveStatus status = TRANSPORT_DRIVE_IDLE;
   if (error_count)
     status = transport_outbound_size ? TRANSPORT_DRIVE_BACKOFF
@@ -3192,6 +4280,8 @@ TransportDriveResult network_runtime_drive_once_with_gateway(
       network_classify_inbound(sockfd, WAMBLE_CLASSIFY_BATCH);
   TransportDriveResult dispatched =
       network_dispatch_requests(sockfd, profile_name, WAMBLE_DISPATCH_BATCH);
+  dispatched.progress_count +=
+      (uint32_t)server_protocol_drain_login_verifications(sockfd, profile_name);
   TransportDriveResult outbound = network_outbound_pump(sockfd, 64u);
   TransportDriveResult result = transport_drive_result_merge(
       transport_drive_result_merge(
@@ -3227,6 +4317,9 @@ void network_runtime_drive_reload_drain(wamble_socket_t sockfd,
         network_classify_inbound(sockfd, WAMBLE_CLASSIFY_BATCH);
     TransportDriveResult dispatched =
         network_dispatch_requests(sockfd, profile_name, WAMBLE_DISPATCH_BATCH);
+    dispatched.progress_count +=
+        (uint32_t)server_protocol_drain_login_verifications(sockfd,
+                                                            profile_name);
     TransportDriveResult outbound = network_outbound_pump(sockfd, 64u);
     TransportDriveResult drive = transport_drive_result_merge(
         transport_drive_result_merge(
@@ -3300,28 +4393,33 @@ void network_runtime_drive_budget(wamble_socket_t sockfd,
     ws_gateway_flush_outbound(ws_gateway);
 }
 
+static void expire_client_session(int index) {
+  WambleClientSession *session = &client_sessions[index];
+  session->active = 0;
+  session_idle_unlink(index);
+  session_map_remove(&session->addr, index);
+  if (token_has_any_byte(session->token))
+    token_session_map_remove(session->token, index);
+  terminal_cache_release(session);
+  if (g_current_request.session == session)
+    g_current_request.session = NULL;
+  session->free_next = session_free_head;
+  session_free_head = index;
+}
+
 void cleanup_expired_sessions(void) {
+  if (!client_sessions)
+    return;
   time_t now = wamble_now_wall();
-  int write_idx = 0;
-
-  for (int read_idx = 0; read_idx < num_sessions; read_idx++) {
-    if (now - client_sessions[read_idx].last_seen <
-        get_config()->session_timeout) {
-      if (write_idx != read_idx) {
-        client_sessions[write_idx] = client_sessions[read_idx];
-      }
-      write_idx++;
-    } else {
-      terminal_cache_release(&client_sessions[read_idx]);
-    }
-  }
-
-  if (write_idx != num_sessions) {
-    num_sessions = write_idx;
-    g_current_request.session = NULL;
+  int timeout = get_config()->session_timeout;
+  while (session_idle_head >= 0 &&
+         now - client_sessions[session_idle_head].last_seen >= timeout)
+    expire_client_session(session_idle_head);
+  if (session_index_map_tombstones > session_index_map_capacity / 4)
     session_map_rebuild();
+  if (token_session_index_map_tombstones >
+      token_session_index_map_capacity / 4)
     token_session_map_rebuild();
-  }
 }
 
 int wamble_socket_bound_port(wamble_socket_t sock) {
@@ -91,6 +91,7 @@ typedef struct WamblePersistenceIntent {
     } record_payout;
     struct {
       uint8_t token[TOKEN_LENGTH];
+      uint64_t session_id;
       double rating;
     } update_player_rating;
     struct {
@@ -563,12 +564,14 @@ void wamble_emit_record_payout_with_canonical(uint64_t board_id,
   intents_push(it);
 }
 
-void wamble_emit_update_player_rating(const uint8_t *token, double rating) {
+void wamble_emit_update_player_rating(const uint8_t *token,
+                                      uint64_t session_id, double rating) {
   if (!token)
     return;
   struct WamblePersistenceIntent it = {0};
   it.type = WAMBLE_INTENT_UPDATE_PLAYER_RATING;
   memcpy(it.as.update_player_rating.token, token, TOKEN_LENGTH);
+  it.as.update_player_rating.session_id = session_id;
   it.as.update_player_rating.rating = rating;
   intents_push(it);
 }
@@ -797,10 +800,12 @@ static int apply_one_intent_db(const struct WamblePersistenceIntent *it,
         it->as.record_payout.canonical_points);
   }
   case WAMBLE_INTENT_UPDATE_PLAYER_RATING: {
-    uint64_t sid = 0;
-    DbStatus st = resolve_session_id_cached(
-        cache, it->as.update_player_rating.token, &sid);
-    if (st != DB_OK || sid == 0)
+    uint64_t sid = it->as.update_player_rating.session_id;
+    if (sid == 0 && resolve_session_id_cached(
+                        cache, it->as.update_player_rating.token, &sid) !=
+                        DB_OK)
+      return -1;
+    if (sid == 0)
       return -1;
     return db_apply_update_player_rating(sid,
                                          it->as.update_player_rating.rating);
@@ -890,6 +895,87 @@ static int apply_one_intent_db(const struct WamblePersistenceIntent *it,
   }
 }
 
+static int token_row_compare(const void *a, const void *b) {
+  return memcmp(a, b, TOKEN_LENGTH);
+}
+
+static void resolve_session_ids_batch(SessionResolveCache *cache,
+                                      const struct WamblePersistenceIntent *it,
+                                      int count) {
+  if (!cache || !cache->items || count <= 1)
+    return;
+  uint8_t *tokens = (uint8_t *)malloc((size_t)count * TOKEN_LENGTH);
+  uint8_t *known = (uint8_t *)malloc(
+      (size_t)(cache->count > 0 ? cache->count : 1) * TOKEN_LENGTH);
+  uint64_t *sids = (uint64_t *)calloc((size_t)count, sizeof(*sids));
+  int missing = 0;
+  if (tokens && known && sids) {
+    int unresolved = 0;
+    for (int i = 0; i < count; i++) {
+      if (it[i].as.update_player_rating.session_id == 0)
+        memcpy(&tokens[unresolved++ * TOKEN_LENGTH],
+               it[i].as.update_player_rating.token, TOKEN_LENGTH);
+    }
+    for (int c = 0; c < cache->count; c++)
+      memcpy(&known[c * TOKEN_LENGTH], cache->items[c].token, TOKEN_LENGTH);
+    qsort(tokens, (size_t)unresolved, TOKEN_LENGTH, token_row_compare);
+    qsort(known, (size_t)cache->count, TOKEN_LENGTH, token_row_compare);
+    int k = 0;
+    for (int i = 0; i < unresolved; i++) {
+      const uint8_t *token = &tokens[i * TOKEN_LENGTH];
+      if (missing > 0 && memcmp(&tokens[(missing - 1) * TOKEN_LENGTH], token,
+                                TOKEN_LENGTH) == 0)
+        continue;
+      while (k < cache->count &&
+             memcmp(&known[k * TOKEN_LENGTH], token, TOKEN_LENGTH) < 0)
+        k++;
+      if (k < cache->count &&
+          memcmp(&known[k * TOKEN_LENGTH], token, TOKEN_LENGTH) == 0)
+        continue;
+      memmove(&tokens[missing++ * TOKEN_LENGTH], token, TOKEN_LENGTH);
+    }
+  }
+  if (missing > 0 &&
+      wamble_query_get_sessions_by_tokens(tokens, missing, sids) == DB_OK) {
+    for (int i = 0; i < missing; i++)
+      cache_put_session(cache, &tokens[i * TOKEN_LENGTH],
+                        sids[i] > 0 ? DB_OK : DB_NOT_FOUND, sids[i]);
+  }
+  free(sids);
+  free(known);
+  free(tokens);
+}
+
+static int apply_rating_run_db(const struct WamblePersistenceIntent *it,
+                               int count, SessionResolveCache *cache) {
+  if (count > 1) {
+    resolve_session_ids_batch(cache, it, count);
+    uint64_t *sids = (uint64_t *)malloc(sizeof(*sids) * (size_t)count);
+    double *ratings = (double *)malloc(sizeof(*ratings) * (size_t)count);
+    int resolved = sids && ratings;
+    for (int i = 0; i < count && resolved; i++) {
+      sids[i] = it[i].as.update_player_rating.session_id;
+      if (sids[i] == 0 &&
+          resolve_session_id_cached(cache, it[i].as.update_player_rating.token,
+                                    &sids[i]) != DB_OK)
+        resolved = 0;
+      resolved = resolved && sids[i] > 0;
+      ratings[i] = it[i].as.update_player_rating.rating;
+    }
+    int rc = resolved ? db_apply_update_player_ratings(sids, ratings, count)
+                      : -1;
+    free(ratings);
+    free(sids);
+    if (rc == 0)
+      return count;
+  }
+  for (int i = 0; i < count; i++) {
+    if (apply_one_intent_db(&it[i], cache) < 0)
+      return i;
+  }
+  return count;
+}
+
 static int
 intent_payload_estimate_bytes(const struct WamblePersistenceIntent *it) {
   if (!it)
@@ -1001,16 +1087,27 @@ PersistenceStatus wamble_apply_intents_with_db_checked(
     }
   }
 
-  for (int i = 0; i < to_apply; i++) {
+  for (int i = 0; i < to_apply;) {
     struct WamblePersistenceIntent *it = &buf->items[i];
-    if (apply_one_intent_db(it, &session_cache) < 0) {
+    int run = 1;
+    int applied = 0;
+    if (it->type == WAMBLE_INTENT_UPDATE_PLAYER_RATING) {
+      while (i + run < to_apply &&
+             buf->items[i + run].type == WAMBLE_INTENT_UPDATE_PLAYER_RATING)
+        run++;
+      applied = apply_rating_run_db(it, run, &session_cache);
+    } else {
+      applied = apply_one_intent_db(it, &session_cache) < 0 ? 0 : 1;
+    }
+    if (applied < run) {
       failures = 1;
-      int pending = to_apply - i;
-      memmove(&buf->items[write_idx], it,
+      int pending = to_apply - (i + applied);
+      memmove(&buf->items[write_idx], &buf->items[i + applied],
               (size_t)pending * sizeof(*buf->items));
       write_idx += pending;
       break;
     }
+    i += run;
   }
   free(session_cache_items);
 
@@ -0,0 +1,223 @@
+#include "../include/wamble/wamble.h"
+
+#define POLICY_INDEX_MAX_STORES 8
+#define POLICY_INDEX_MIN_BUCKETS 64
+
+typedef struct PolicyIndexStore {
+  WambleIndexStore base;
+  WamblePolicyRuleRow *rules;
+  int count;
+  int capacity;
+  WambleIndexBuckets buckets;
+} PolicyIndexStore;
+
+typedef struct PolicyIndexProbe {
+  const char *action;
+  uint64_t identity_id;
+} PolicyIndexProbe;
+
+static void policy_store_clear(void *store) {
+  PolicyIndexStore *st = (PolicyIndexStore *)store;
+  st->count = 0;
+  index_buckets_free(&st->buckets);
+}
+
+static PolicyIndexStore g_policy_index_stores[POLICY_INDEX_MAX_STORES];
+static WambleIndexSet g_policy_index = {
+    .stores = g_policy_index_stores,
+    .max_stores = POLICY_INDEX_MAX_STORES,
+    .store_size = sizeof(PolicyIndexStore),
+    .clear = policy_store_clear,
+};
+
+static uint64_t policy_index_hash(const char *action, uint64_t identity_id) {
+  uint64_t h = 1469598103934665603ULL;
+  for (const unsigned char *p = (const unsigned char *)action; *p; p++) {
+    h ^= (uint64_t)*p;
+    h *= 1099511628211ULL;
+  }
+  h ^= identity_id + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+  return h;
+}
+
+static uint64_t policy_rule_hash(const void *row) {
+  const WamblePolicyRuleRow *r = (const WamblePolicyRuleRow *)row;
+  return policy_index_hash(r->action, r->global_identity_id);
+}
+
+static int policy_rule_same_group(const void *a, const void *b) {
+  const WamblePolicyRuleRow *ra = (const WamblePolicyRuleRow *)a;
+  const WamblePolicyRuleRow *rb = (const WamblePolicyRuleRow *)b;
+  return ra->global_identity_id == rb->global_identity_id &&
+         strcmp(ra->action, rb->action) == 0;
+}
+
+static int policy_rule_matches(const void *row, const void *probe) {
+  const WamblePolicyRuleRow *r = (const WamblePolicyRuleRow *)row;
+  const PolicyIndexProbe *p = (const PolicyIndexProbe *)probe;
+  return r->global_identity_id == p->identity_id &&
+         strcmp(r->action, p->action) == 0;
+}
+
+static int policy_rule_cmp(const void *a, const void *b) {
+  const WamblePolicyRuleRow *ra = (const WamblePolicyRuleRow *)a;
+  const WamblePolicyRuleRow *rb = (const WamblePolicyRuleRow *)b;
+  int c = strcmp(ra->action, rb->action);
+  if (c != 0)
+    return c;
+  if (ra->global_identity_id != rb->global_identity_id)
+    return ra->global_identity_id < rb->global_identity_id ? -1 : 1;
+  if (ra->id != rb->id)
+    return ra->id > rb->id ? -1 : 1;
+  return 0;
+}
+
+static int policy_store_build(void *store, void *arg) {
+  PolicyIndexStore *st = (PolicyIndexStore *)store;
+  (void)arg;
+  if (st->count > 1)
+    qsort(st->rules, (size_t)st->count, sizeof(*st->rules), policy_rule_cmp);
+  return index_buckets_build(&st->buckets, POLICY_INDEX_MIN_BUCKETS, st->rules,
+                             st->count, sizeof(*st->rules), policy_rule_hash,
+                             policy_rule_same_group);
+}
+
+static const WambleIndexBucket *
+policy_store_bucket(const PolicyIndexStore *st, const char *action,
+                    uint64_t identity_id) {
+  PolicyIndexProbe probe = {action, identity_id};
+  return index_buckets_find(&st->buckets,
+                            policy_index_hash(action, identity_id), st->rules,
+                            sizeof(*st->rules), policy_rule_matches, &probe);
+}
+
+static int policy_rule_rank(const WamblePolicyRuleRow *r, uint64_t identity_id,
+                            const char *resource, const char *scope_exact,
+                            const char *scope_group, const char *context_key,
+                            const char *context_value, int64_t now) {
+  if (r->not_before_at > now || r->not_after_at < now)
+    return -1;
+  int resource_rank = 0;
+  if (strcmp(r->resource, resource) != 0) {
+    if (strcmp(r->resource, "*") != 0)
+      return -1;
+    resource_rank = 1;
+  }
+  int scope_rank = 2;
+  if (strcmp(r->scope, scope_exact) == 0)
+    scope_rank = 0;
+  else if (strcmp(r->scope, scope_group) == 0)
+    scope_rank = 1;
+  else if (strcmp(r->scope, "*") != 0)
+    return -1;
+  int context_rank = 1;
+  if (r->has_context) {
+    if (!context_key || strcmp(r->context_key, context_key) != 0 ||
+        strcmp(r->context_value, context_value ? context_value : "") != 0)
+      return -1;
+    context_rank = 0;
+  }
+  int identity_rank = r->global_identity_id == identity_id ? 0 : 1;
+  int effect_rank = strcmp(r->effect, "deny") == 0 ? 0 : 1;
+  return (identity_rank << 5) | (scope_rank << 3) | (resource_rank << 2) |
+         (context_rank << 1) | effect_rank;
+}
+
+void policy_index_reset(const char *store) {
+  index_set_reset(&g_policy_index, store);
+}
+
+uint64_t policy_index_seed_begin(const char *store) {
+  return index_set_seed_begin(&g_policy_index, store);
+}
+
+int policy_index_seed_row(const char *store, uint64_t seed,
+                          const WamblePolicyRuleRow *row) {
+  int rc = -1;
+  if (!row)
+    return -1;
+  index_set_lock(&g_policy_index);
+  PolicyIndexStore *st = index_set_seeding_locked(&g_policy_index, store, seed);
+  if (st) {
+    rc = index_rows_push((void **)&st->rules, &st->count, &st->capacity,
+                         sizeof(*row), 64, row);
+    if (rc != 0)
+      index_set_clear_locked(&g_policy_index, st);
+  }
+  index_set_unlock(&g_policy_index);
+  return rc;
+}
+
+int policy_index_seed_end(const char *store, uint64_t seed) {
+  return index_set_seed_end(&g_policy_index, store, seed, policy_store_build,
+                            NULL);
+}
+
+int policy_index_ready(const char *store) {
+  return index_set_ready(&g_policy_index, store);
+}
+
+int policy_index_has_action(const char *store, const char *action,
+                            int scoped_only) {
+  if (!action)
+    return -1;
+  int rc = -1;
+  index_set_lock(&g_policy_index);
+  PolicyIndexStore *st = index_set_store_locked(&g_policy_index, store, 0);
+  if (st && st->base.ready) {
+    rc = 0;
+    for (int i = 0; i < st->count && !rc; i++) {
+      const WamblePolicyRuleRow *r = &st->rules[i];
+      if (strcmp(r->action, action) == 0 &&
+          (!scoped_only || strcmp(r->scope, "*") != 0))
+        rc = 1;
+    }
+  }
+  index_set_unlock(&g_policy_index);
+  return rc;
+}
+
+int policy_index_resolve(const char *store, uint64_t identity_id,
+                         const char *action, const char *resource,
+                         const char *scope_exact, const char *scope_group,
+                         const char *context_key, const char *context_value,
+                         int64_t now_epoch_seconds, WamblePolicyRuleRow *out) {
+  if (!action || !resource || !out)
+    return -1;
+  if (!scope_exact)
+    scope_exact = "";
+  if (!scope_group)
+    scope_group = "";
+  int rc = -1;
+  index_set_lock(&g_policy_index);
+  PolicyIndexStore *st = index_set_store_locked(&g_policy_index, store, 0);
+  if (st && st->base.ready) {
+    const WamblePolicyRuleRow *best = NULL;
+    int best_rank = 0;
+    uint64_t probes[2] = {identity_id, 0};
+    int probe_count = identity_id != 0 ? 2 : 1;
+    for (int p = 0; p < probe_count; p++) {
+      const WambleIndexBucket *b = policy_store_bucket(st, action, probes[p]);
+      for (int i = 0; b && i < b->count; i++) {
+        const WamblePolicyRuleRow *r = &st->rules[b->start + i];
+        int rank = policy_rule_rank(r, identity_id, resource, scope_exact,
+                                    scope_group, context_key, context_value,
+                                    now_epoch_seconds);
+        if (rank < 0)
+          continue;
+        if (!best || rank < best_rank ||
+            (rank == best_rank && r->id > best->id)) {
+          best = r;
+          best_rank = rank;
+        }
+      }
+    }
+    rc = 0;
+    if (best) {
+      *out = *best;
+      rc = 1;
+    }
+  }
+  index_set_unlock(&g_policy_index);
+  return rc;
+}
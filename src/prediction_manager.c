@@ -26,22 +26,72 @@ typedef struct {
   uint64_t board_id;
   uint8_t player_token[TOKEN_LENGTH];
   int correct_streak;
+  uint32_t stamp;
+  int board_prev;
+  int board_next;
 } PredictionStreak;
 
+#define PREDICTION_INDEX_BOARD (-1)
+#define PREDICTION_INDEX_ID (-2)
+
+typedef struct PredictionNode {
+  WamblePrediction pred;
+  int parent;
+  int first_child;
+  int last_child;
+  int next_sibling;
+  int ply_next;
+} PredictionNode;
+
+typedef struct PredictionArena {
+  uint64_t board_id;
+  PredictionNode *nodes;
+  int count;
+  int cap;
+  int first_root;
+  int last_root;
+  int pending;
+  int orphans;
+  int streak_head;
+  int next_free;
+} PredictionArena;
+
+typedef struct PredictionIndexBucket {
+  uint64_t key;
+  int ply;
+  int head;
+  int tail;
+} PredictionIndexBucket;
+
+typedef struct PredictionResolveJob {
+  WambleBoard board;
+  char actual_move_uci[MAX_UCI_LENGTH];
+  int expire_board;
+  struct PredictionResolveJob *next;
+} PredictionResolveJob;
+
 static void prediction_set_streak(uint64_t board_id, const uint8_t *token,
                                   int streak);
 static int prediction_resolve_session_id(const uint8_t *player_token,
                                          uint64_t *out_session_id);
-static void prediction_expire_invalid_descendants_locked(uint64_t board_id);
 static PredictionStatus prediction_write_allowed_for_player_depth(
     const WambleBoard *board, const uint8_t *player_token, int depth);
-
-static WAMBLE_THREAD_LOCAL WamblePrediction *g_predictions = NULL;
-static WAMBLE_THREAD_LOCAL int g_prediction_count = 0;
-static WAMBLE_THREAD_LOCAL int g_prediction_cap = 0;
+static void prediction_settle_board(uint64_t board_id);
+
+static WAMBLE_THREAD_LOCAL PredictionArena *g_prediction_arenas = NULL;
+static WAMBLE_THREAD_LOCAL int g_prediction_arena_count = 0;
+static WAMBLE_THREAD_LOCAL int g_prediction_arena_cap = 0;
+static WAMBLE_THREAD_LOCAL int g_prediction_arena_free = -1;
+static WAMBLE_THREAD_LOCAL int g_prediction_total = 0;
+static WAMBLE_THREAD_LOCAL PredictionIndexBucket *g_prediction_index = NULL;
+static WAMBLE_THREAD_LOCAL int g_prediction_index_cap = 0;
+static WAMBLE_THREAD_LOCAL int g_prediction_index_used = 0;
+static WAMBLE_THREAD_LOCAL PredictionResolveJob *g_resolve_head = NULL;
+static WAMBLE_THREAD_LOCAL PredictionResolveJob *g_resolve_tail = NULL;
 static WAMBLE_THREAD_LOCAL PredictionStreak *g_streaks = NULL;
-static WAMBLE_THREAD_LOCAL int g_streak_count = 0;
+static WAMBLE_THREAD_LOCAL int g_streak_used = 0;
 static WAMBLE_THREAD_LOCAL int g_streak_cap = 0;
+static WAMBLE_THREAD_LOCAL uint32_t g_streak_stamp = 0;
 static WAMBLE_THREAD_LOCAL wamble_mutex_t g_prediction_mutex;
 static WAMBLE_THREAD_LOCAL int g_prediction_mutex_ready = 0;
 static WAMBLE_THREAD_LOCAL int prediction_manager_mutex_held_depth = 0;
@@ -63,59 +113,295 @@ int wamble_architecture_prediction_lock_held(void) {
   return prediction_manager_mutex_held_depth > 0;
 }
 
-static int prediction_ensure_streak_capacity_locked(int need) {
-  if (need <= g_streak_cap)
+static uint64_t prediction_index_hash(uint64_t key, int ply) {
+  uint64_t h = (key ^ ((uint64_t)(uint32_t)ply << 40)) * 0x9E3779B97F4A7C15ULL;
+  return h ^ (h >> 29);
+}
+
+static int prediction_index_probe_locked(uint64_t key, int ply) {
+  int mask = g_prediction_index_cap - 1;
+  int i = (int)(prediction_index_hash(key, ply) & (uint64_t)mask);
+  while (g_prediction_index[i].key != 0 &&
+         (g_prediction_index[i].key != key || g_prediction_index[i].ply != ply))
+    i = (i + 1) & mask;
+  return i;
+}
+
+static PredictionIndexBucket *prediction_index_find_locked(uint64_t key,
+                                                           int ply) {
+  if (!g_prediction_index || key == 0)
+    return NULL;
+  PredictionIndexBucket *b =
+      &g_prediction_index[prediction_index_probe_locked(key, ply)];
+  return (b->key != 0 && b->head >= 0) ? b : NULL;
+}
+
+static int prediction_index_reserve_locked(int extra) {
+  if (g_prediction_index &&
+      (g_prediction_index_used + extra) * 2 <= g_prediction_index_cap)
     return 0;
-  int new_cap = g_streak_cap > 0 ? g_streak_cap : 16;
-  while (new_cap < need)
-    new_cap *= 2;
-  PredictionStreak *new_streaks = (PredictionStreak *)realloc(
-      g_streaks, (size_t)new_cap * sizeof(*g_streaks));
-  if (!new_streaks)
+  int live = 0;
+  for (int i = 0; i < g_prediction_index_cap; i++) {
+    if (g_prediction_index[i].key != 0 && g_prediction_index[i].head >= 0)
+      live++;
+  }
+  int cap = 64;
+  while ((live + extra) * 2 > cap)
+    cap *= 2;
+  PredictionIndexBucket *table =
+      (PredictionIndexBucket *)calloc((size_t)cap, sizeof(*table));
+  if (!table)
     return -1;
-  memset(new_streaks + g_streak_cap, 0,
-         (size_t)(new_cap - g_streak_cap) * sizeof(*new_streaks));
-  g_streaks = new_streaks;
-  g_streak_cap = new_cap;
+  PredictionIndexBucket *old = g_prediction_index;
+  int old_cap = g_prediction_index_cap;
+  g_prediction_index = table;
+  g_prediction_index_cap = cap;
+  g_prediction_index_used = 0;
+  for (int i = 0; i < old_cap; i++) {
+    if (old[i].key == 0 || old[i].head < 0)
+      continue;
+    table[prediction_index_probe_locked(old[i].key, old[i].ply)] = old[i];
+    g_prediction_index_used++;
+  }
+  free(old);
   return 0;
 }
 
-static int prediction_ensure_capacity_locked(int need) {
-  if (need <= g_prediction_cap)
-    return 0;
-  int new_cap = g_prediction_cap > 0 ? g_prediction_cap : 16;
-  while (new_cap < need)
-    new_cap *= 2;
-  WamblePrediction *new_predictions = (WamblePrediction *)realloc(
-      g_predictions, (size_t)new_cap * sizeof(*g_predictions));
-  if (!new_predictions)
+static PredictionIndexBucket *prediction_index_get_locked(uint64_t key,
+                                                          int ply) {
+  PredictionIndexBucket *b =
+      &g_prediction_index[prediction_index_probe_locked(key, ply)];
+  if (b->key == 0) {
+    b->key = key;
+    b->ply = ply;
+    b->head = -1;
+    b->tail = -1;
+    g_prediction_index_used++;
+  }
+  return b;
+}
+
+static PredictionArena *prediction_arena_find_locked(uint64_t board_id) {
+  PredictionIndexBucket *b =
+      prediction_index_find_locked(board_id, PREDICTION_INDEX_BOARD);
+  return b ? &g_prediction_arenas[b->head] : NULL;
+}
+
+static PredictionNode *prediction_node_by_id_locked(uint64_t prediction_id,
+                                                    PredictionArena **out) {
+  PredictionIndexBucket *b =
+      prediction_index_find_locked(prediction_id, PREDICTION_INDEX_ID);
+  if (!b)
+    return NULL;
+  PredictionArena *a = &g_prediction_arenas[b->head];
+  if (out)
+    *out = a;
+  return &a->nodes[b->tail];
+}
+
+static int prediction_ply_head_locked(const PredictionArena *a, int ply) {
+  PredictionIndexBucket *b =
+      a ? prediction_index_find_locked(a->board_id, ply) : NULL;
+  return b ? b->head : -1;
+}
+
+static int prediction_children_head_locked(const PredictionArena *a,
+                                           uint64_t parent_id) {
+  if (!a)
     return -1;
-  memset(new_predictions + g_prediction_cap, 0,
-         (size_t)(new_cap - g_prediction_cap) * sizeof(*new_predictions));
-  g_predictions = new_predictions;
-  g_prediction_cap = new_cap;
-  return prediction_ensure_streak_capacity_locked(new_cap);
+  if (parent_id == 0)
+    return a->first_root;
+  PredictionArena *owner = NULL;
+  PredictionNode *parent = prediction_node_by_id_locked(parent_id, &owner);
+  return (parent && owner == a) ? parent->first_child : -1;
+}
+
+static int prediction_preorder_next(const PredictionArena *a, int slot,
+                                    int stop, int descend) {
+  if (descend && a->nodes[slot].first_child >= 0)
+    return a->nodes[slot].first_child;
+  while (slot >= 0 && slot != stop) {
+    if (a->nodes[slot].next_sibling >= 0)
+      return a->nodes[slot].next_sibling;
+    slot = a->nodes[slot].parent;
+  }
+  return -1;
+}
+
+static void prediction_set_state_locked(PredictionArena *a, PredictionNode *n,
+                                        PredictionState state) {
+  if (n->pred.state == PREDICTION_STATE_PENDING)
+    a->pending--;
+  if (state == PREDICTION_STATE_PENDING)
+    a->pending++;
+  n->pred.state = state;
+}
+
+static int prediction_arena_get_locked(uint64_t board_id) {
+  PredictionIndexBucket *b =
+      prediction_index_find_locked(board_id, PREDICTION_INDEX_BOARD);
+  if (b)
+    return b->head;
+  int idx = g_prediction_arena_free;
+  if (idx < 0 && g_prediction_arena_count >= g_prediction_arena_cap) {
+    int new_cap = g_prediction_arena_cap > 0 ? g_prediction_arena_cap * 2 : 16;
+    PredictionArena *arenas = (PredictionArena *)realloc(
+        g_prediction_arenas, (size_t)new_cap * sizeof(*arenas));
+    if (!arenas)
+      return -1;
+    g_prediction_arenas = arenas;
+    g_prediction_arena_cap = new_cap;
+  }
+  if (idx >= 0)
+    g_prediction_arena_free = g_prediction_arenas[idx].next_free;
+  else
+    idx = g_prediction_arena_count++;
+  PredictionArena *a = &g_prediction_arenas[idx];
+  memset(a, 0, sizeof(*a));
+  a->board_id = board_id;
+  a->first_root = -1;
+  a->last_root = -1;
+  a->streak_head = -1;
+  a->next_free = -1;
+  prediction_index_get_locked(board_id, PREDICTION_INDEX_BOARD)->head = idx;
+  return idx;
+}
+
+static void prediction_link_node_locked(PredictionArena *a, int slot) {
+  PredictionNode *n = &a->nodes[slot];
+  PredictionArena *owner = NULL;
+  PredictionNode *parent =
+      n->pred.parent_id
+          ? prediction_node_by_id_locked(n->pred.parent_id, &owner)
+          : NULL;
+  if (parent && owner == a) {
+    n->parent = (int)(parent - a->nodes);
+    if (parent->last_child >= 0)
+      a->nodes[parent->last_child].next_sibling = slot;
+    else
+      parent->first_child = slot;
+    parent->last_child = slot;
+    return;
+  }
+  if (n->pred.parent_id)
+    a->orphans++;
+  if (a->last_root >= 0)
+    a->nodes[a->last_root].next_sibling = slot;
+  else
+    a->first_root = slot;
+  a->last_root = slot;
+}
+
+static int prediction_insert_locked(const WamblePrediction *src, int link) {
+  if (!src || src->id == 0 || src->board_id == 0)
+    return -1;
+  if (prediction_index_reserve_locked(3) != 0)
+    return -1;
+  int idx = prediction_arena_get_locked(src->board_id);
+  if (idx < 0)
+    return -1;
+  PredictionArena *a = &g_prediction_arenas[idx];
+  if (a->count >= a->cap) {
+    int new_cap = a->cap > 0 ? a->cap * 2 : 16;
+    PredictionNode *nodes =
+        (PredictionNode *)realloc(a->nodes, (size_t)new_cap * sizeof(*nodes));
+    if (!nodes)
+      return -1;
+    a->nodes = nodes;
+    a->cap = new_cap;
+  }
+  int slot = a->count++;
+  PredictionNode *n = &a->nodes[slot];
+  memset(n, 0, sizeof(*n));
+  n->pred = *src;
+  n->parent = -1;
+  n->first_child = -1;
+  n->last_child = -1;
+  n->next_sibling = -1;
+  if (n->pred.state == PREDICTION_STATE_PENDING)
+    a->pending++;
+  g_prediction_total++;
+
+  PredictionIndexBucket *p = prediction_index_get_locked(a->board_id,
+                                                         src->target_ply);
+  n->ply_next = p->head;
+  p->head = slot;
+  PredictionIndexBucket *id = prediction_index_get_locked(src->id,
+                                                          PREDICTION_INDEX_ID);
+  id->head = idx;
+  id->tail = slot;
+  if (link)
+    prediction_link_node_locked(a, slot);
+  return 0;
+}
+
+static void prediction_remove_board_locked(uint64_t board_id) {
+  PredictionIndexBucket *b =
+      prediction_index_find_locked(board_id, PREDICTION_INDEX_BOARD);
+  if (!b)
+    return;
+  int idx = b->head;
+  PredictionArena *a = &g_prediction_arenas[idx];
+  b->head = -1;
+  for (int i = 0; i < a->count; i++) {
+    const WamblePrediction *pred = &a->nodes[i].pred;
+    PredictionIndexBucket *p =
+        prediction_index_find_locked(board_id, pred->target_ply);
+    if (p)
+      p->head = -1;
+    PredictionIndexBucket *id =
+        prediction_index_find_locked(pred->id, PREDICTION_INDEX_ID);
+    if (id)
+      id->head = -1;
+  }
+  for (int i = a->streak_head; i >= 0; i = g_streaks[i].board_next)
+    g_streaks[i].correct_streak = 0;
+  g_prediction_total -= a->count;
+  free(a->nodes);
+  memset(a, 0, sizeof(*a));
+  a->next_free = g_prediction_arena_free;
+  g_prediction_arena_free = idx;
 }
 
 static void prediction_reset_locked(void) {
-  free(g_predictions);
+  while (g_resolve_head) {
+    PredictionResolveJob *next = g_resolve_head->next;
+    free(g_resolve_head);
+    g_resolve_head = next;
+  }
+  g_resolve_tail = NULL;
+  for (int i = 0; i < g_prediction_arena_count; i++)
+    free(g_prediction_arenas[i].nodes);
+  free(g_prediction_arenas);
+  free(g_prediction_index);
   free(g_streaks);
-  g_predictions = NULL;
-  g_prediction_count = 0;
-  g_prediction_cap = 0;
+  g_prediction_arenas = NULL;
+  g_prediction_arena_count = 0;
+  g_prediction_arena_cap = 0;
+  g_prediction_arena_free = -1;
+  g_prediction_total = 0;
+  g_prediction_index = NULL;
+  g_prediction_index_cap = 0;
+  g_prediction_index_used = 0;
   g_streaks = NULL;
-  g_streak_count = 0;
+  g_streak_used = 0;
   g_streak_cap = 0;
 }
 
 static void prediction_rebuild_streaks_locked(void) {
-  g_streak_count = 0;
-  for (int i = 0; i < g_prediction_count; i++) {
-    const WamblePrediction *pred = &g_predictions[i];
-    if (strcmp(pred->status, "PENDING") != 0)
-      continue;
-    prediction_set_streak(pred->board_id, pred->player_token,
-                          pred->correct_streak);
+  memset(g_streaks, 0, (size_t)g_streak_cap * sizeof(*g_streaks));
+  g_streak_used = 0;
+  for (int i = 0; i < g_prediction_arena_count; i++)
+    g_prediction_arenas[i].streak_head = -1;
+  for (int i = 0; i < g_prediction_arena_count; i++) {
+    const PredictionArena *a = &g_prediction_arenas[i];
+    for (int j = 0; j < a->count; j++) {
+      const WamblePrediction *pred = &a->nodes[j].pred;
+      if (pred->state != PREDICTION_STATE_PENDING)
+        continue;
+      prediction_set_streak(pred->board_id, pred->player_token,
+                            pred->correct_streak);
+    }
   }
 }
 
@@ -128,22 +414,27 @@ static PredictionManagerStatus prediction_load_active_locked(void) {
 
   for (int i = 0; i < rows.count; i++) {
     const DbPredictionRow *src = &rows.rows[i];
-    if (prediction_ensure_capacity_locked(g_prediction_count + 1) != 0)
-      return PREDICTION_MANAGER_ERR_ALLOC;
-    WamblePrediction *dst = &g_predictions[g_prediction_count++];
-    memset(dst, 0, sizeof(*dst));
-    dst->id = src->id;
-    dst->board_id = src->board_id;
-    dst->parent_id = src->parent_prediction_id;
-    memcpy(dst->player_token, src->player_token, TOKEN_LENGTH);
-    snprintf(dst->predicted_move_uci, sizeof(dst->predicted_move_uci), "%s",
+    WamblePrediction dst;
+    memset(&dst, 0, sizeof(dst));
+    dst.id = src->id;
+    dst.board_id = src->board_id;
+    dst.parent_id = src->parent_prediction_id;
+    memcpy(dst.player_token, src->player_token, TOKEN_LENGTH);
+    snprintf(dst.predicted_move_uci, sizeof(dst.predicted_move_uci), "%s",
              src->predicted_move_uci);
-    snprintf(dst->status, sizeof(dst->status), "%s", src->status);
-    dst->target_ply = src->move_number;
-    dst->depth = src->depth;
-    dst->correct_streak = src->correct_streak;
-    dst->points_awarded = src->points_awarded;
-    dst->created_at = src->created_at;
+    dst.state = prediction_state_from_str(src->status);
+    dst.target_ply = src->move_number;
+    dst.depth = src->depth;
+    dst.correct_streak = src->correct_streak;
+    dst.points_awarded = src->points_awarded;
+    dst.created_at = src->created_at;
+    if (prediction_insert_locked(&dst, 0) < 0)
+      return PREDICTION_MANAGER_ERR_ALLOC;
+  }
+  for (int i = 0; i < g_prediction_arena_count; i++) {
+    PredictionArena *a = &g_prediction_arenas[i];
+    for (int j = 0; j < a->count; j++)
+      prediction_link_node_locked(a, j);
   }
 
   prediction_rebuild_streaks_locked();
@@ -272,18 +563,16 @@ PredictionManagerStatus prediction_manager_init(void) {
   int max_pending = get_config()->prediction_max_pending;
   if (max_pending < 1)
     max_pending = 1;
-  g_prediction_cap =
+  int streak_need =
       max_pending *
       ((get_config()->max_boards > 0) ? get_config()->max_boards : 1);
-  if (g_prediction_cap < 16)
-    g_prediction_cap = 16;
-  g_streak_cap = g_prediction_cap;
+  g_streak_cap = 16;
+  while (g_streak_cap < streak_need)
+    g_streak_cap *= 2;
 
-  g_predictions = (WamblePrediction *)calloc((size_t)g_prediction_cap,
-                                             sizeof(*g_predictions));
   g_streaks =
       (PredictionStreak *)calloc((size_t)g_streak_cap, sizeof(*g_streaks));
-  if (!g_predictions || !g_streaks) {
+  if (!g_streaks) {
     prediction_reset_locked();
     return PREDICTION_MANAGER_ERR_ALLOC;
   }
@@ -447,11 +736,11 @@ static int prediction_treatment_feature_bool(const uint8_t *token,
 
 static int prediction_failed_count_for_locked(uint64_t board_id,
                                               const uint8_t *token) {
+  const PredictionArena *a = prediction_arena_find_locked(board_id);
   int count = 0;
-  for (int i = 0; i < g_prediction_count; i++) {
-    if (g_predictions[i].board_id == board_id &&
-        tokens_equal(g_predictions[i].player_token, token) &&
-        strcmp(g_predictions[i].status, "INCORRECT") == 0) {
+  for (int i = 0; a && i < a->count; i++) {
+    if (a->nodes[i].pred.state == PREDICTION_STATE_INCORRECT &&
+        tokens_equal(a->nodes[i].pred.player_token, token)) {
       count++;
     }
   }
@@ -600,6 +889,7 @@ int prediction_get_runtime_counts(uint64_t board_id, const uint8_t *token,
     return -1;
   if (!g_prediction_mutex_ready)
     return -1;
+  prediction_settle_board(board_id);
   prediction_manager_mutex_lock();
   int pending = prediction_pending_count_locked(board_id);
   int failed = prediction_failed_count_for_locked(board_id, token);
@@ -638,74 +928,127 @@ static int prediction_match_moves(const char *predicted, const char *actual) {
   return strcmp(predicted, actual) == 0;
 }
 
+static int prediction_streak_probe_locked(uint64_t board_id,
+                                          const uint8_t *token) {
+  int mask = g_streak_cap - 1;
+  uint64_t key = board_id ^ prediction_hash_token(token);
+  int i = (int)(prediction_index_hash(key, 0) & (uint64_t)mask);
+  while (g_streaks[i].board_id != 0 &&
+         (g_streaks[i].board_id != board_id ||
+          !tokens_equal(g_streaks[i].player_token, token)))
+    i = (i + 1) & mask;
+  return i;
+}
+
 static int prediction_find_streak(uint64_t board_id, const uint8_t *token) {
-  for (int i = 0; i < g_streak_count; i++) {
-    if (g_streaks[i].board_id == board_id &&
-        tokens_equal(g_streaks[i].player_token, token)) {
-      return i;
-    }
-  }
-  return -1;
+  if (!g_streaks || board_id == 0 || !token)
+    return -1;
+  int i = prediction_streak_probe_locked(board_id, token);
+  return (g_streaks[i].board_id != 0 && g_streaks[i].correct_streak > 0) ? i
+                                                                         : -1;
 }
 
-static int prediction_streak_for(uint64_t board_id, const uint8_t *token) {
-  int idx = prediction_find_streak(board_id, token);
-  return (idx >= 0) ? g_streaks[idx].correct_streak : 0;
+static void prediction_link_streak_locked(PredictionArena *a, int i) {
+  g_streaks[i].board_prev = -1;
+  g_streaks[i].board_next = a->streak_head;
+  if (a->streak_head >= 0)
+    g_streaks[a->streak_head].board_prev = i;
+  a->streak_head = i;
+}
+
+static void prediction_drop_streak_locked(PredictionArena *a, int i) {
+  PredictionStreak *st = &g_streaks[i];
+  if (st->board_prev >= 0)
+    g_streaks[st->board_prev].board_next = st->board_next;
+  else
+    a->streak_head = st->board_next;
+  if (st->board_next >= 0)
+    g_streaks[st->board_next].board_prev = st->board_prev;
+  st->correct_streak = 0;
 }
 
-static int prediction_participated_in_ply_locked(uint64_t board_id,
-                                                 int target_ply,
-                                                 const uint8_t *token) {
-  if (!token)
+static int prediction_streak_reserve_locked(int extra) {
+  if (g_streaks && (g_streak_used + extra) * 2 <= g_streak_cap)
     return 0;
-  for (int i = 0; i < g_prediction_count; i++) {
-    const WamblePrediction *pred = &g_predictions[i];
-    if (pred->board_id != board_id || pred->target_ply != target_ply)
+  int live = 0;
+  for (int i = 0; i < g_streak_cap; i++) {
+    if (g_streaks[i].board_id != 0 && g_streaks[i].correct_streak > 0)
+      live++;
+  }
+  int cap = 16;
+  while ((live + extra) * 2 > cap)
+    cap *= 2;
+  PredictionStreak *table =
+      (PredictionStreak *)calloc((size_t)cap, sizeof(*table));
+  if (!table)
+    return -1;
+  PredictionStreak *old = g_streaks;
+  int old_cap = g_streak_cap;
+  g_streaks = table;
+  g_streak_cap = cap;
+  g_streak_used = 0;
+  for (int i = 0; i < g_prediction_arena_count; i++)
+    g_prediction_arenas[i].streak_head = -1;
+  for (int i = 0; i < old_cap; i++) {
+    if (old[i].board_id == 0 || old[i].correct_streak <= 0)
       continue;
-    if (tokens_equal(pred->player_token, token))
-      return 1;
+    PredictionArena *a = prediction_arena_find_locked(old[i].board_id);
+    if (!a)
+      continue;
+    int slot = prediction_streak_probe_locked(old[i].board_id,
+                                              old[i].player_token);
+    table[slot] = old[i];
+    prediction_link_streak_locked(a, slot);
+    g_streak_used++;
   }
+  free(old);
   return 0;
 }
 
+static int prediction_streak_for(uint64_t board_id, const uint8_t *token) {
+  int idx = prediction_find_streak(board_id, token);
+  return (idx >= 0) ? g_streaks[idx].correct_streak : 0;
+}
+
 static void prediction_set_streak(uint64_t board_id, const uint8_t *token,
                                   int streak) {
   int idx = prediction_find_streak(board_id, token);
+  PredictionArena *a = prediction_arena_find_locked(board_id);
   if (streak <= 0) {
-    if (idx >= 0)
-      g_streaks[idx] = g_streaks[--g_streak_count];
+    if (idx >= 0 && a)
+      prediction_drop_streak_locked(a, idx);
     return;
   }
   if (idx >= 0) {
     g_streaks[idx].correct_streak = streak;
     return;
   }
-  if (!g_streaks || g_streak_count >= g_streak_cap)
+  if (!a || prediction_streak_reserve_locked(1) != 0)
     return;
-  PredictionStreak *slot = &g_streaks[g_streak_count++];
+  int i = prediction_streak_probe_locked(board_id, token);
+  PredictionStreak *slot = &g_streaks[i];
+  if (slot->board_id == 0)
+    g_streak_used++;
   memset(slot, 0, sizeof(*slot));
   slot->board_id = board_id;
   memcpy(slot->player_token, token, TOKEN_LENGTH);
   slot->correct_streak = streak;
+  prediction_link_streak_locked(a, i);
 }
 
 static int prediction_pending_count_locked(uint64_t board_id) {
-  int count = 0;
-  for (int i = 0; i < g_prediction_count; i++) {
-    if (g_predictions[i].board_id == board_id &&
-        strcmp(g_predictions[i].status, "PENDING") == 0) {
-      count++;
-    }
-  }
-  return count;
+  const PredictionArena *a = prediction_arena_find_locked(board_id);
+  return a ? a->pending : 0;
 }
 
 static int prediction_pending_count_scoped_locked(uint64_t board_id, int depth,
                                                   uint64_t parent_id) {
+  const PredictionArena *a = prediction_arena_find_locked(board_id);
   int count = 0;
-  for (int i = 0; i < g_prediction_count; i++) {
-    const WamblePrediction *p = &g_predictions[i];
-    if (p->board_id != board_id || strcmp(p->status, "PENDING") != 0)
+  for (int i = prediction_children_head_locked(a, parent_id); i >= 0;
+       i = a->nodes[i].next_sibling) {
+    const WamblePrediction *p = &a->nodes[i].pred;
+    if (p->state != PREDICTION_STATE_PENDING)
       continue;
     if (p->depth != depth || p->parent_id != parent_id)
       continue;
@@ -714,40 +1057,43 @@ static int prediction_pending_count_scoped_locked(uint64_t board_id, int depth,
   return count;
 }
 
-static int prediction_find_dup_locked(uint64_t board_id, const uint8_t *token,
-                                      const char *move_uci, uint64_t parent_id,
-                                      int check_move_dup, int max_per_parent,
-                                      int *out_kind) {
-  int self_idx = -1, move_idx = -1;
+static uint64_t prediction_find_dup_locked(uint64_t board_id,
+                                           const uint8_t *token,
+                                           const char *move_uci,
+                                           uint64_t parent_id,
+                                           int check_move_dup,
+                                           int max_per_parent, int *out_kind) {
+  const PredictionArena *a = prediction_arena_find_locked(board_id);
+  uint64_t self_id = 0, move_id = 0;
   int self_pending = 0;
-  for (int i = 0; i < g_prediction_count; i++) {
-    const WamblePrediction *p = &g_predictions[i];
-    if (p->board_id != board_id || p->parent_id != parent_id ||
-        strcmp(p->status, "PENDING") != 0)
+  for (int i = prediction_children_head_locked(a, parent_id); i >= 0;
+       i = a->nodes[i].next_sibling) {
+    const WamblePrediction *p = &a->nodes[i].pred;
+    if (p->parent_id != parent_id || p->state != PREDICTION_STATE_PENDING)
       continue;
     if (tokens_equal(p->player_token, token)) {
       self_pending++;
-      if (self_idx < 0)
-        self_idx = i;
+      if (self_id == 0)
+        self_id = p->id;
     }
-    if (move_idx < 0 && check_move_dup &&
+    if (move_id == 0 && check_move_dup &&
         strcmp(p->predicted_move_uci, move_uci) == 0)
-      move_idx = i;
+      move_id = p->id;
     if ((max_per_parent > 0 && self_pending >= max_per_parent) &&
-        (!check_move_dup || move_idx >= 0)) {
+        (!check_move_dup || move_id != 0)) {
       break;
     }
   }
-  if (max_per_parent > 0 && self_pending >= max_per_parent && self_idx >= 0) {
+  if (max_per_parent > 0 && self_pending >= max_per_parent && self_id != 0) {
     *out_kind = 1;
-    return self_idx;
+    return self_id;
   }
-  if (move_idx >= 0) {
+  if (move_id != 0) {
     *out_kind = 2;
-    return move_idx;
+    return move_id;
   }
   *out_kind = 0;
-  return -1;
+  return 0;
 }
 
 static void prediction_fill_view_locked(const WamblePrediction *pred,
@@ -759,45 +1105,44 @@ static void prediction_fill_view_locked(const WamblePrediction *pred,
   memcpy(dst->player_token, pred->player_token, TOKEN_LENGTH);
   snprintf(dst->predicted_move_uci, sizeof(dst->predicted_move_uci), "%s",
            pred->predicted_move_uci);
-  snprintf(dst->status, sizeof(dst->status), "%s", pred->status);
+  snprintf(dst->status, sizeof(dst->status), "%s",
+           prediction_state_to_str(pred->state));
   dst->target_ply = pred->target_ply;
   dst->depth = pred->depth;
   dst->points_awarded = pred->points_awarded;
   dst->created_at = pred->created_at;
 }
 
-static int prediction_find_by_id_locked(uint64_t prediction_id) {
-  if (prediction_id == 0)
-    return -1;
-  for (int i = 0; i < g_prediction_count; i++) {
-    if (g_predictions[i].id == prediction_id)
-      return i;
+static void prediction_expire_node_locked(PredictionArena *a,
+                                          PredictionNode *n) {
+  prediction_set_state_locked(a, n, PREDICTION_STATE_EXPIRED);
+  n->pred.points_awarded = 0.0;
+  wamble_emit_resolve_prediction(a->board_id, n->pred.player_token,
+                                 n->pred.target_ply,
+                                 prediction_state_to_str(n->pred.state), 0.0);
+}
+
+static void prediction_expire_subtree_locked(PredictionArena *a, int root) {
+  for (int i = a->nodes[root].first_child; i >= 0;
+       i = prediction_preorder_next(a, i, root, 1)) {
+    if (a->nodes[i].pred.state == PREDICTION_STATE_PENDING)
+      prediction_expire_node_locked(a, &a->nodes[i]);
   }
-  return -1;
 }
 
-static void prediction_expire_invalid_descendants_locked(uint64_t board_id) {
-  int changed = 0;
-  do {
-    changed = 0;
-    for (int i = 0; i < g_prediction_count; i++) {
-      WamblePrediction *pred = &g_predictions[i];
-      if (pred->board_id != board_id || pred->parent_id == 0 ||
-          strcmp(pred->status, "PENDING") != 0) {
-        continue;
-      }
-      int parent_idx = prediction_find_by_id_locked(pred->parent_id);
-      if (parent_idx < 0 || g_predictions[parent_idx].board_id != board_id ||
-          strcmp(g_predictions[parent_idx].status, "INCORRECT") == 0 ||
-          strcmp(g_predictions[parent_idx].status, "EXPIRED") == 0) {
-        pred->points_awarded = 0.0;
-        snprintf(pred->status, sizeof(pred->status), "EXPIRED");
-        wamble_emit_resolve_prediction(board_id, pred->player_token,
-                                       pred->target_ply, pred->status, 0.0);
-        changed = 1;
-      }
-    }
-  } while (changed);
+static void prediction_expire_orphans_locked(PredictionArena *a) {
+  if (a->orphans == 0)
+    return;
+  for (int i = a->first_root; i >= 0; i = a->nodes[i].next_sibling) {
+    PredictionNode *n = &a->nodes[i];
+    if (n->pred.parent_id == 0)
+      continue;
+    if (n->pred.state == PREDICTION_STATE_PENDING)
+      prediction_expire_node_locked(a, n);
+    if (n->pred.state != PREDICTION_STATE_CORRECT)
+      prediction_expire_subtree_locked(a, i);
+  }
+  a->orphans = 0;
 }
 
 static int prediction_policy_allowed(const uint8_t *token, const char *action,
@@ -954,6 +1299,24 @@ static double prediction_points_for_streak(int streak_before) {
          pow(get_config()->prediction_streak_multiplier, (double)exponent);
 }
 
+static PredictionStatus prediction_parent_locked(uint64_t board_id,
+                                                uint64_t parent_id,
+                                                int *out_depth,
+                                                int *out_target_ply) {
+  PredictionArena *a = NULL;
+  PredictionNode *parent = prediction_node_by_id_locked(parent_id, &a);
+  if (!parent || a->board_id != board_id)
+    return PREDICTION_ERR_NOT_FOUND;
+  if (parent->pred.state == PREDICTION_STATE_INCORRECT ||
+      parent->pred.state == PREDICTION_STATE_EXPIRED)
+    return PREDICTION_ERR_INVALID;
+  if (out_depth)
+    *out_depth = parent->pred.depth + 1;
+  if (out_target_ply)
+    *out_target_ply = parent->pred.target_ply + 1;
+  return PREDICTION_OK;
+}
+
 PredictionStatus prediction_submit(WambleBoard *board,
                                    const uint8_t *player_token,
                                    const char *predicted_move_uci,
@@ -969,13 +1332,15 @@ PredictionStatus prediction_submit_with_parent(WambleBoard *board,
                                                uint64_t parent_prediction_id,
                                                int flags,
                                                uint64_t *out_prediction_id) {
+  if (board && g_prediction_mutex_ready)
+    prediction_settle_board(board->id);
   PredictionStatus st =
       prediction_submit_allowed_for_player(board, player_token);
   if (st != PREDICTION_OK)
     return st;
   if (!prediction_valid_uci(predicted_move_uci))
     return PREDICTION_ERR_INVALID;
-  if (!g_prediction_mutex_ready || !g_predictions)
+  if (!g_prediction_mutex_ready || !g_streaks)
     return PREDICTION_ERR_INVALID;
 
   int check_move_dup = !(flags & WAMBLE_PREDICTION_SKIP_MOVE_DUP);
@@ -994,18 +1359,12 @@ PredictionStatus prediction_submit_with_parent(WambleBoard *board,
 
   prediction_manager_mutex_lock();
   if (parent_prediction_id > 0) {
-    int parent_idx = prediction_find_by_id_locked(parent_prediction_id);
-    if (parent_idx < 0 || g_predictions[parent_idx].board_id != board->id) {
+    PredictionStatus parent_st = prediction_parent_locked(
+        board->id, parent_prediction_id, &depth, &target_ply);
+    if (parent_st != PREDICTION_OK) {
       prediction_manager_mutex_unlock();
-      return PREDICTION_ERR_NOT_FOUND;
-    }
-    if (strcmp(g_predictions[parent_idx].status, "INCORRECT") == 0 ||
-        strcmp(g_predictions[parent_idx].status, "EXPIRED") == 0) {
-      prediction_manager_mutex_unlock();
-      return PREDICTION_ERR_INVALID;
+      return parent_st;
     }
-    depth = g_predictions[parent_idx].depth + 1;
-    target_ply = g_predictions[parent_idx].target_ply + 1;
   }
   pending_count = prediction_pending_count_locked(board->id);
   failed_count = prediction_failed_count_for_locked(board->id, player_token);
@@ -1026,18 +1385,12 @@ PredictionStatus prediction_submit_with_parent(WambleBoard *board,
 
   prediction_manager_mutex_lock();
   if (parent_prediction_id > 0) {
-    int parent_idx = prediction_find_by_id_locked(parent_prediction_id);
-    if (parent_idx < 0 || g_predictions[parent_idx].board_id != board->id) {
+    PredictionStatus parent_st = prediction_parent_locked(
+        board->id, parent_prediction_id, &depth, &target_ply);
+    if (parent_st != PREDICTION_OK) {
       prediction_manager_mutex_unlock();
-      return PREDICTION_ERR_NOT_FOUND;
+      return parent_st;
     }
-    if (strcmp(g_predictions[parent_idx].status, "INCORRECT") == 0 ||
-        strcmp(g_predictions[parent_idx].status, "EXPIRED") == 0) {
-      prediction_manager_mutex_unlock();
-      return PREDICTION_ERR_INVALID;
-    }
-    depth = g_predictions[parent_idx].depth + 1;
-    target_ply = g_predictions[parent_idx].target_ply + 1;
   }
   if (prediction_pending_count_scoped_locked(
           board->id, depth, parent_prediction_id) >= max_pending) {
@@ -1046,12 +1399,12 @@ PredictionStatus prediction_submit_with_parent(WambleBoard *board,
   }
   {
     int dup_kind = 0;
-    int dup_idx = prediction_find_dup_locked(
+    uint64_t dup_id = prediction_find_dup_locked(
         board->id, player_token, predicted_move_uci, parent_prediction_id,
         check_move_dup, max_per_parent, &dup_kind);
-    if (dup_idx >= 0) {
+    if (dup_id != 0) {
       if (out_prediction_id)
-        *out_prediction_id = g_predictions[dup_idx].id;
+        *out_prediction_id = dup_id;
       prediction_manager_mutex_unlock();
       return dup_kind == 1 ? PREDICTION_ERR_DUPLICATE
                            : PREDICTION_ERR_DUPLICATE_MOVE;
@@ -1074,56 +1427,55 @@ PredictionStatus prediction_submit_with_parent(WambleBoard *board,
 
   prediction_manager_mutex_lock();
   if (parent_prediction_id > 0) {
-    int parent_idx = prediction_find_by_id_locked(parent_prediction_id);
-    if (parent_idx < 0 || g_predictions[parent_idx].board_id != board->id ||
-        strcmp(g_predictions[parent_idx].status, "INCORRECT") == 0 ||
-        strcmp(g_predictions[parent_idx].status, "EXPIRED") == 0) {
+    if (prediction_parent_locked(board->id, parent_prediction_id, NULL,
+                                 NULL) != PREDICTION_OK) {
       prediction_manager_mutex_unlock();
       return PREDICTION_ERR_INVALID;
     }
   }
   {
     int dup_kind = 0;
-    int dup_idx = prediction_find_dup_locked(
+    uint64_t dup_id = prediction_find_dup_locked(
         board->id, player_token, predicted_move_uci, parent_prediction_id,
         check_move_dup, max_per_parent, &dup_kind);
-    if (dup_idx >= 0) {
+    if (dup_id != 0) {
       if (out_prediction_id)
-        *out_prediction_id = g_predictions[dup_idx].id;
+        *out_prediction_id = dup_id;
       prediction_manager_mutex_unlock();
       return dup_kind == 1 ? PREDICTION_ERR_DUPLICATE
                            : PREDICTION_ERR_DUPLICATE_MOVE;
     }
   }
-  if (prediction_ensure_capacity_locked(g_prediction_count + 1) != 0) {
+
+  WamblePrediction pred;
+  memset(&pred, 0, sizeof(pred));
+  pred.id = db_prediction_id;
+  pred.board_id = board->id;
+  pred.parent_id = parent_prediction_id;
+  memcpy(pred.player_token, player_token, TOKEN_LENGTH);
+  snprintf(pred.predicted_move_uci, sizeof(pred.predicted_move_uci), "%s",
+           predicted_move_uci);
+  pred.state = PREDICTION_STATE_PENDING;
+  pred.target_ply = target_ply;
+  pred.depth = depth;
+  pred.correct_streak = streak_before;
+  pred.points_awarded = 0.0;
+  pred.created_at = wamble_now_wall();
+  if (prediction_insert_locked(&pred, 1) < 0) {
     prediction_manager_mutex_unlock();
     return PREDICTION_ERR_LIMIT;
   }
-
-  WamblePrediction *slot = &g_predictions[g_prediction_count++];
-  memset(slot, 0, sizeof(*slot));
-  slot->id = db_prediction_id;
-  slot->board_id = board->id;
-  slot->parent_id = parent_prediction_id;
-  memcpy(slot->player_token, player_token, TOKEN_LENGTH);
-  snprintf(slot->predicted_move_uci, sizeof(slot->predicted_move_uci), "%s",
-           predicted_move_uci);
-  snprintf(slot->status, sizeof(slot->status), "PENDING");
-  slot->target_ply = target_ply;
-  slot->depth = depth;
-  slot->correct_streak = streak_before;
-  slot->points_awarded = 0.0;
-  slot->created_at = wamble_now_wall();
   if (out_prediction_id)
-    *out_prediction_id = slot->id;
+    *out_prediction_id = pred.id;
 
   prediction_manager_mutex_unlock();
   return PREDICTION_OK;
 }
 
-PredictionStatus prediction_resolve_move(WambleBoard *board,
-                                         const char *actual_move_uci) {
-  if (!board || !actual_move_uci || !g_prediction_mutex_ready || !g_predictions)
+static PredictionStatus
+prediction_resolve_move_now(const WambleBoard *board,
+                            const char *actual_move_uci) {
+  if (!board || !actual_move_uci || !g_prediction_mutex_ready || !g_streaks)
     return PREDICTION_ERR_INVALID;
 
   int resolved_ply = prediction_current_ply(board);
@@ -1131,12 +1483,12 @@ PredictionStatus prediction_resolve_move(WambleBoard *board,
 
   prediction_manager_mutex_lock();
 
-  for (int i = g_prediction_count - 1; i >= 0; i--) {
-    WamblePrediction *pred = &g_predictions[i];
-    if (pred->board_id != board->id || pred->target_ply != resolved_ply ||
-        strcmp(pred->status, "PENDING") != 0) {
+  PredictionArena *a = prediction_arena_find_locked(board->id);
+  for (int i = prediction_ply_head_locked(a, resolved_ply); i >= 0;
+       i = a->nodes[i].ply_next) {
+    WamblePrediction *pred = &a->nodes[i].pred;
+    if (pred->state != PREDICTION_STATE_PENDING)
       continue;
-    }
 
     resolved_any = 1;
     if (prediction_match_moves(pred->predicted_move_uci, actual_move_uci)) {
@@ -1147,37 +1499,52 @@ PredictionStatus prediction_resolve_move(WambleBoard *board,
       points = prediction_apply_resolution_adjustments_locked(
           pred->player_token, board, 1, points);
       pred->points_awarded = points;
-      snprintf(pred->status, sizeof(pred->status), "CORRECT");
+      prediction_set_state_locked(a, &a->nodes[i], PREDICTION_STATE_CORRECT);
       if (points != 0.0)
         (void)scoring_apply_prediction_points(pred->player_token, points);
       prediction_set_streak(board->id, pred->player_token,
                             pred->correct_streak + 1);
       wamble_emit_resolve_prediction(board->id, pred->player_token,
-                                     pred->target_ply, pred->status, points);
+                                     pred->target_ply,
+                                     prediction_state_to_str(pred->state),
+                                     points);
     } else {
       double penalty = -fabs(get_config()->prediction_penalty_incorrect);
       penalty = prediction_apply_resolution_adjustments_locked(
           pred->player_token, board, 0, penalty);
       pred->points_awarded = penalty;
-      snprintf(pred->status, sizeof(pred->status), "INCORRECT");
+      prediction_set_state_locked(a, &a->nodes[i], PREDICTION_STATE_INCORRECT);
       if (penalty != 0.0)
         (void)scoring_apply_prediction_points(pred->player_token, penalty);
       prediction_set_streak(board->id, pred->player_token, 0);
       wamble_emit_resolve_prediction(board->id, pred->player_token,
-                                     pred->target_ply, pred->status, penalty);
+                                     pred->target_ply,
+                                     prediction_state_to_str(pred->state),
+                                     penalty);
     }
   }
 
-  prediction_expire_invalid_descendants_locked(board->id);
-
-  if (get_config()->prediction_mode != PREDICTION_MODE_NEXT_SELF_MOVE) {
-    for (int i = g_streak_count - 1; i >= 0; i--) {
-      if (g_streaks[i].board_id != board->id)
-        continue;
-      int participated = prediction_participated_in_ply_locked(
-          board->id, resolved_ply, g_streaks[i].player_token);
-      if (!participated)
-        g_streaks[i] = g_streaks[--g_streak_count];
+  for (int i = prediction_ply_head_locked(a, resolved_ply); i >= 0;
+       i = a->nodes[i].ply_next) {
+    if (a->nodes[i].pred.state == PREDICTION_STATE_INCORRECT)
+      prediction_expire_subtree_locked(a, i);
+  }
+  if (a)
+    prediction_expire_orphans_locked(a);
+
+  if (a && get_config()->prediction_mode != PREDICTION_MODE_NEXT_SELF_MOVE) {
+    uint32_t stamp = ++g_streak_stamp;
+    for (int i = prediction_ply_head_locked(a, resolved_ply); i >= 0;
+         i = a->nodes[i].ply_next) {
+      int s = prediction_find_streak(board->id, a->nodes[i].pred.player_token);
+      if (s >= 0)
+        g_streaks[s].stamp = stamp;
+    }
+    for (int s = a->streak_head; s >= 0;) {
+      int next = g_streaks[s].board_next;
+      if (g_streaks[s].stamp != stamp)
+        prediction_drop_streak_locked(a, s);
+      s = next;
     }
   }
 
@@ -1215,13 +1582,16 @@ PredictionStatus prediction_collect_tree(uint64_t board_id,
   if (max_depth >= 0 && max_depth < allowed_depth)
     allowed_depth = max_depth;
 
+  if (g_prediction_mutex_ready)
+    prediction_settle_board(board_id);
   prediction_manager_mutex_lock();
+  const PredictionArena *a = prediction_arena_find_locked(board_id);
   int count = 0;
-  for (int i = 0; i < g_prediction_count && count < max_out; i++) {
-    const WamblePrediction *pred = &g_predictions[i];
-    if (pred->board_id != board_id || pred->depth > allowed_depth)
-      continue;
-    prediction_fill_view_locked(pred, &out[count++]);
+  for (int i = a ? a->first_root : -1; i >= 0 && count < max_out;) {
+    const WamblePrediction *pred = &a->nodes[i].pred;
+    if (pred->depth <= allowed_depth)
+      prediction_fill_view_locked(pred, &out[count++]);
+    i = prediction_preorder_next(a, i, -1, pred->depth < allowed_depth);
   }
   prediction_manager_mutex_unlock();
 
@@ -1236,13 +1606,21 @@ PredictionStatus prediction_get_view_by_id(uint64_t prediction_id,
     return PREDICTION_ERR_INVALID;
   if (!g_prediction_mutex_ready)
     return PREDICTION_ERR_INVALID;
+  if (g_resolve_head) {
+    PredictionArena *a = NULL;
+    prediction_manager_mutex_lock();
+    uint64_t board_id =
+        prediction_node_by_id_locked(prediction_id, &a) && a ? a->board_id : 0;
+    prediction_manager_mutex_unlock();
+    prediction_settle_board(board_id);
+  }
   prediction_manager_mutex_lock();
-  int idx = prediction_find_by_id_locked(prediction_id);
-  if (idx < 0) {
+  PredictionNode *n = prediction_node_by_id_locked(prediction_id, NULL);
+  if (!n) {
     prediction_manager_mutex_unlock();
     return PREDICTION_ERR_NOT_FOUND;
   }
-  prediction_fill_view_locked(&g_predictions[idx], out);
+  prediction_fill_view_locked(&n->pred, out);
   prediction_manager_mutex_unlock();
   return PREDICTION_OK;
 }
@@ -1265,32 +1643,130 @@ static void prediction_clear_board(uint64_t board_id) {
   if (!g_prediction_mutex_ready)
     return;
   prediction_manager_mutex_lock();
-  for (int i = g_prediction_count - 1; i >= 0; i--) {
-    if (g_predictions[i].board_id == board_id)
-      g_predictions[i] = g_predictions[--g_prediction_count];
-  }
-  for (int i = g_streak_count - 1; i >= 0; i--) {
-    if (g_streaks[i].board_id == board_id)
-      g_streaks[i] = g_streaks[--g_streak_count];
-  }
+  prediction_remove_board_locked(board_id);
   prediction_manager_mutex_unlock();
 }
 
-void prediction_expire_board(uint64_t board_id) {
+static void prediction_expire_board_now(uint64_t board_id) {
   if (!g_prediction_mutex_ready)
     return;
 
   prediction_manager_mutex_lock();
-  for (int i = 0; i < g_prediction_count; i++) {
-    WamblePrediction *pred = &g_predictions[i];
-    if (pred->board_id != board_id || strcmp(pred->status, "PENDING") != 0)
-      continue;
-    pred->points_awarded = 0.0;
-    snprintf(pred->status, sizeof(pred->status), "EXPIRED");
-    wamble_emit_resolve_prediction(board_id, pred->player_token,
-                                   pred->target_ply, pred->status, 0.0);
+  PredictionArena *a = prediction_arena_find_locked(board_id);
+  for (int i = 0; a && a->pending > 0 && i < a->count; i++) {
+    if (a->nodes[i].pred.state == PREDICTION_STATE_PENDING)
+      prediction_expire_node_locked(a, &a->nodes[i]);
   }
   prediction_manager_mutex_unlock();
 
   prediction_clear_board(board_id);
 }
+
+static int prediction_board_queued_locked(uint64_t board_id) {
+  for (PredictionResolveJob *job = g_resolve_head; job; job = job->next) {
+    if (job->board.id == board_id)
+      return 1;
+  }
+  return 0;
+}
+
+static PredictionResolveJob *prediction_take_job_locked(uint64_t board_id) {
+  PredictionResolveJob *prev = NULL;
+  for (PredictionResolveJob *job = g_resolve_head; job; job = job->next) {
+    if (board_id == 0 || job->board.id == board_id) {
+      if (prev)
+        prev->next = job->next;
+      else
+        g_resolve_head = job->next;
+      if (g_resolve_tail == job)
+        g_resolve_tail = prev;
+      job->next = NULL;
+      return job;
+    }
+    prev = job;
+  }
+  return NULL;
+}
+
+static int prediction_run_jobs(uint64_t board_id, int max_jobs) {
+  int ran = 0;
+  while (g_resolve_head && (max_jobs <= 0 || ran < max_jobs)) {
+    prediction_manager_mutex_lock();
+    PredictionResolveJob *job = prediction_take_job_locked(board_id);
+    prediction_manager_mutex_unlock();
+    if (!job)
+      break;
+    if (job->expire_board)
+      prediction_expire_board_now(job->board.id);
+    else
+      (void)prediction_resolve_move_now(&job->board, job->actual_move_uci);
+    free(job);
+    ran++;
+  }
+  return ran;
+}
+
+static void prediction_settle_board(uint64_t board_id) {
+  if (g_resolve_head && board_id != 0)
+    (void)prediction_run_jobs(board_id, 0);
+}
+
+static int prediction_enqueue_job(const WambleBoard *board,
+                                  uint64_t board_id,
+                                  const char *actual_move_uci) {
+  PredictionResolveJob *job = (PredictionResolveJob *)calloc(1, sizeof(*job));
+  if (!job)
+    return -1;
+  if (board) {
+    job->board = *board;
+    snprintf(job->actual_move_uci, sizeof(job->actual_move_uci), "%s",
+             actual_move_uci);
+  } else {
+    job->board.id = board_id;
+    job->expire_board = 1;
+  }
+  prediction_manager_mutex_lock();
+  if (g_resolve_tail)
+    g_resolve_tail->next = job;
+  else
+    g_resolve_head = job;
+  g_resolve_tail = job;
+  prediction_manager_mutex_unlock();
+  return 0;
+}
+
+PredictionStatus prediction_resolve_move(WambleBoard *board,
+                                         const char *actual_move_uci) {
+  if (board)
+    prediction_settle_board(board->id);
+  return prediction_resolve_move_now(board, actual_move_uci);
+}
+
+PredictionStatus prediction_resolve_move_deferred(const WambleBoard *board,
+                                                  const char *actual_move_uci) {
+  if (!board || !actual_move_uci || !g_prediction_mutex_ready || !g_streaks)
+    return PREDICTION_ERR_INVALID;
+  if (prediction_enqueue_job(board, board->id, actual_move_uci) != 0) {
+    prediction_settle_board(board->id);
+    return prediction_resolve_move_now(board, actual_move_uci);
+  }
+  return PREDICTION_OK;
+}
+
+int prediction_drain_deferred(int max_jobs) {
+  if (!g_prediction_mutex_ready)
+    return 0;
+  return prediction_run_jobs(0, max_jobs);
+}
+
+void prediction_expire_board(uint64_t board_id) {
+  if (!g_prediction_mutex_ready)
+    return;
+  prediction_manager_mutex_lock();
+  int queued = prediction_board_queued_locked(board_id);
+  prediction_manager_mutex_unlock();
+  if (queued && prediction_enqueue_job(NULL, board_id, NULL) == 0)
+    return;
+  prediction_settle_board(board_id);
+  prediction_expire_board_now(board_id);
+}
@@ -84,6 +84,8 @@ void cleanup_expired_sessions(void);
 void profile_runtime_manager_event_signal(void);
 wamble_socket_t create_and_bind_socket(int port);
 int wamble_socket_bound_port(wamble_socket_t sock);
+void network_wake_socket(wamble_socket_t sockfd);
+void network_configure_udp_offload(wamble_socket_t sockfd, int enabled);
 WambleWsGateway *ws_gateway_start(const char *profile_name, int ws_port,
                                   int udp_port, const char *ws_path,
                                   int *out_status);
@@ -110,6 +112,7 @@ int server_protocol_enqueue_spectator_batch(SpectatorUpdate *events, int count,
 int server_protocol_enqueue_session_expired_notice(
     const uint8_t *token, const struct sockaddr_in *cliaddr);
 int server_protocol_thread_pending_login_challenge_count(void);
+void server_protocol_thread_cleanup(void);
 int spectator_collect_updates(struct SpectatorUpdate *out, int max);
 int spectator_collect_notifications(struct SpectatorUpdate *out, int max);
 int spectator_manager_active_count_for_port(int owner_port);
@@ -177,27 +180,6 @@ void wamble_runtime_event_publish(WambleRuntimeStatus status,
   wamble_mutex_unlock(&g_mutex);
 }
 
-static void profile_runtime_wake_socket(wamble_socket_t sockfd) {
-  if (sockfd == WAMBLE_INVALID_SOCKET)
-    return;
-  int port = wamble_socket_bound_port(sockfd);
-  if (port <= 0)
-    return;
-  struct sockaddr_in wake_addr;
-  memset(&wake_addr, 0, sizeof(wake_addr));
-  wake_addr.sin_family = AF_INET;
-  wake_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
-  wake_addr.sin_port = htons((uint16_t)port);
-  const uint8_t byte = 0;
-  (void)sendto(sockfd, (const char *)&byte,
-#ifdef WAMBLE_PLATFORM_WINDOWS
-               1,
-#else
-               sizeof(byte),
-#endif
-               0, (const struct sockaddr *)&wake_addr, sizeof(wake_addr));
-}
-
 void profile_runtime_config_reload_begin(void) {
   ensure_mutex_init();
   wamble_mutex_lock(&g_mutex);
@@ -244,7 +226,7 @@ void profile_runtime_manager_event_signal(void) {
   }
   wamble_mutex_unlock(&g_mutex);
   for (int i = 0; i < wake_count; i++)
-    profile_runtime_wake_socket(wake_sockets[i]);
+    network_wake_socket(wake_sockets[i]);
   free(wake_sockets);
 }
 
@@ -296,6 +278,7 @@ enum {
   PERSIST_FLUSH_INTERVAL_MS = 200,
   PERSIST_FLUSH_EAGER_COUNT = 128,
   PERSIST_FLUSH_MAX_BATCHES_PER_CYCLE = 4,
+  PREDICTION_RESOLVE_JOBS_PER_STEP = 32,
 };
 
 static int profile_runtime_batch_limit_for_pending(int pending) {
@@ -686,6 +669,7 @@ static int adopt_profile_from_env(const char *name, const char *value,
                    (const char *)&buffer_size, sizeof(buffer_size));
   (void)setsockopt(rp->sockfd, SOL_SOCKET, SO_SNDBUF,
                    (const char *)&buffer_size, sizeof(buffer_size));
+  network_configure_udp_offload(rp->sockfd, rp->cfg.udp_segment_offload);
   (void)wamble_set_nonblocking(rp->sockfd);
 
   rp->run_inline = (ctx->capacity == 1) ? 1 : 0;
@@ -891,6 +875,7 @@ static wamble_socket_t create_prebound_socket(const WambleConfig *cfg,
                    sizeof(buffer_size));
   (void)setsockopt(sockfd, SOL_SOCKET, SO_SNDBUF, (const char *)&buffer_size,
                    sizeof(buffer_size));
+  network_configure_udp_offload(sockfd, cfg->udp_segment_offload);
 
   struct sockaddr_in servaddr;
   memset(&servaddr, 0, sizeof(servaddr));
@@ -1579,6 +1564,7 @@ static int profile_runtime_init(RunningProfile *rp) {
     if (st != PREDICTION_MANAGER_OK)
       publish_prediction_manager_status(st, rp->name);
   }
+  db_warm_leaderboard_index();
   rp->ws_retry_enabled = 1;
   rp->last_cleanup = wamble_now_wall();
   rp->last_tick = rp->last_cleanup;
@@ -1618,6 +1604,7 @@ static void profile_runtime_shutdown(RunningProfile *rp) {
     return;
   wamble_set_query_service(rp->qs);
   wamble_set_intent_buffer(rp->intents_buf);
+  (void)prediction_drain_deferred(0);
   for (int i = 0; i < 100 && rp->async_flush_mutex_ready; i++) {
     int busy = 0;
     wamble_mutex_lock(&rp->async_flush_mutex);
@@ -1661,6 +1648,8 @@ static void profile_runtime_shutdown(RunningProfile *rp) {
     rp->ws_gateway = NULL;
   }
   network_runtime_reset_thread_state();
+  server_protocol_thread_cleanup();
+  response_cache_clear();
   db_cleanup_thread();
   g_current_profile_runtime = NULL;
   rp->runtime_ready = 0;
@@ -1685,6 +1674,7 @@ static void profile_runtime_step(RunningProfile *rp) {
       rp->exec_ws_shutdown_requested = 1;
     }
     network_runtime_drive_reload_drain(rp->sockfd, rp->ws_gateway, rp->name, 4);
+    (void)prediction_drain_deferred(0);
     profile_runtime_flush_intents(rp, PERSIST_FLUSH_MAX_BATCHES_PER_CYCLE);
     profile_runtime_prepare_exec_snapshot(rp);
     return;
@@ -1740,6 +1730,7 @@ static void profile_runtime_step(RunningProfile *rp) {
   }
   profile_runtime_send_spectator_updates(rp);
   network_runtime_drive_budget(rp->sockfd, rp->ws_gateway, 0, rp->name, 1);
+  (void)prediction_drain_deferred(PREDICTION_RESOLVE_JOBS_PER_STEP);
 }
 
 static void profile_runtime_run(RunningProfile *rp) {
@@ -1924,7 +1915,9 @@ static int runtime_cfg_requires_restart(const WambleConfig *a,
                                         const WambleConfig *b) {
   if (!a || !b)
     return 1;
-  return a->buffer_size != b->buffer_size || a->max_boards != b->max_boards ||
+  return a->buffer_size != b->buffer_size ||
+         a->udp_segment_offload != b->udp_segment_offload ||
+         a->max_boards != b->max_boards ||
          a->min_boards != b->min_boards || a->max_players != b->max_players ||
          !cfg_str_eq(a->db_host, b->db_host) ||
          !cfg_str_eq(a->db_user, b->db_user) ||
@@ -1947,7 +1940,10 @@ static int runtime_cfg_equals(const WambleConfig *a, const WambleConfig *b) {
          a->rto_cap_ms == b->rto_cap_ms &&
          a->max_message_size == b->max_message_size &&
          a->buffer_size == b->buffer_size &&
+         a->udp_segment_offload == b->udp_segment_offload &&
          a->rate_limit_requests_per_sec == b->rate_limit_requests_per_sec &&
+         a->rate_limit_addr_packets_per_sec ==
+             b->rate_limit_addr_packets_per_sec &&
          a->session_timeout == b->session_timeout &&
          a->max_boards == b->max_boards && a->min_boards == b->min_boards &&
          a->cleanup_interval_sec == b->cleanup_interval_sec &&
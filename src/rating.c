@@ -1,7 +1,8 @@
 #include "wamble/wamble.h"
 #include <string.h>
 
-void wamble_emit_update_player_rating(const uint8_t *token, double rating);
+void wamble_emit_update_player_rating(const uint8_t *token,
+                                      uint64_t session_id, double rating);
 
 static int rating_seen_map_index(const uint8_t *map_tokens,
                                  const int *map_slots, int map_size,
@@ -146,6 +147,74 @@ static void rating_apply_treatment_adjustments(const WambleBoard *board,
   }
 }
 
+static int rating_update_player(WambleBoard *board, const uint8_t *token,
+                                double *out_rating) {
+  WamblePlayer *player = get_player_by_token(token);
+  if (!player)
+    return 0;
+  double delta = 0.0;
+  rating_apply_treatment_adjustments(board, player, &delta);
+  if (delta == 0.0)
+    return 0;
+  player->rating += delta;
+  *out_rating = player->rating;
+  return 1;
+}
+
+static void rating_update_players(WambleBoard *board, const uint8_t *tokens,
+                                  int count) {
+  if (count <= 0)
+    return;
+  uint8_t *changed = malloc((size_t)count * TOKEN_LENGTH);
+  double *ratings = malloc(sizeof(double) * (size_t)count);
+  uint64_t *session_ids = calloc((size_t)count, sizeof(uint64_t));
+  if (!changed || !ratings || !session_ids) {
+    free(changed);
+    free(ratings);
+    free(session_ids);
+    return;
+  }
+  int changed_count = 0;
+  for (int i = 0; i < count; i++) {
+    const uint8_t *token = &tokens[i * TOKEN_LENGTH];
+    if (!rating_update_player(board, token, &ratings[changed_count]))
+      continue;
+    memcpy(&changed[changed_count * TOKEN_LENGTH], token, TOKEN_LENGTH);
+    changed_count++;
+  }
+  if (changed_count > 0 &&
+      wamble_query_get_sessions_by_tokens(changed, changed_count,
+                                          session_ids) != DB_OK) {
+    for (int i = 0; i < changed_count; i++) {
+      if (wamble_query_get_session_by_token(&changed[i * TOKEN_LENGTH],
+                                            &session_ids[i]) != DB_OK)
+        session_ids[i] = 0;
+    }
+  }
+  for (int i = 0; i < changed_count; i++) {
+    if (session_ids[i] > 0)
+      wamble_emit_update_player_rating(&changed[i * TOKEN_LENGTH],
+                                       session_ids[i], ratings[i]);
+  }
+  free(session_ids);
+  free(ratings);
+  free(changed);
+}
+
+void update_player_ratings_for_contributors(
+    WambleBoard *board, const WambleContributor *contributors, int count) {
+  if (!board || !contributors || count <= 0)
+    return;
+  uint8_t *tokens = malloc((size_t)count * TOKEN_LENGTH);
+  if (!tokens)
+    return;
+  for (int i = 0; i < count; i++)
+    memcpy(&tokens[i * TOKEN_LENGTH], contributors[i].player_token,
+           TOKEN_LENGTH);
+  rating_update_players(board, tokens, count);
+  free(tokens);
+}
+
 void update_player_ratings(WambleBoard *board) {
   if (!board)
     return;
@@ -185,22 +254,7 @@ void update_player_ratings(WambleBoard *board) {
     seen_count++;
   }
 
-  for (int i = 0; i < seen_count; i++) {
-    const uint8_t *token = &seen[i * TOKEN_LENGTH];
-    WamblePlayer *player = get_player_by_token(token);
-    if (!player)
-      continue;
-    double delta = 0.0;
-    rating_apply_treatment_adjustments(board, player, &delta);
-    if (delta == 0.0)
-      continue;
-    player->rating += delta;
-    uint64_t session_id = 0;
-    if (wamble_query_get_session_by_token(token, &session_id) == DB_OK &&
-        session_id > 0) {
-      wamble_emit_update_player_rating(token, player->rating);
-    }
-  }
+  rating_update_players(board, seen, seen_count);
   free(seen_map_tokens);
   free(seen_slots);
   free(seen);
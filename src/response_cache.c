@@ -0,0 +1,361 @@
+#include "../include/wamble/wamble.h"
+
+#define RESPONSE_CACHE_MIN_BUCKETS 256
+#define RESPONSE_CACHE_ALIGN 16
+
+typedef struct ResponseCacheEntry {
+  struct ResponseCacheEntry *hash_next;
+  struct ResponseCacheEntry *tag_next;
+  struct ResponseCacheEntry *lru_prev;
+  struct ResponseCacheEntry *lru_next;
+  uint64_t hash;
+  uint64_t tag;
+  uint64_t generation;
+  uint64_t cached_at_ms;
+  size_t key_len;
+  size_t value_len;
+  size_t charge;
+  int ns;
+} ResponseCacheEntry;
+
+typedef struct ResponseCacheNamespace {
+  ResponseCacheEntry *lru_head;
+  ResponseCacheEntry *lru_tail;
+  size_t bytes;
+  int entries;
+  WambleResponseCacheStats stats;
+} ResponseCacheNamespace;
+
+typedef struct ResponseCacheShard {
+  ResponseCacheEntry **buckets;
+  ResponseCacheEntry **tag_buckets;
+  int bucket_cap;
+  int entry_count;
+  ResponseCacheNamespace ns[WAMBLE_RESPONSE_CACHE_NAMESPACE_COUNT];
+} ResponseCacheShard;
+
+typedef struct ResponseCacheSpec {
+  uint64_t ttl_ms;
+  int budget_percent;
+} ResponseCacheSpec;
+
+static const ResponseCacheSpec
+    g_response_cache_specs[WAMBLE_RESPONSE_CACHE_NAMESPACE_COUNT] = {
+        [WAMBLE_RESPONSE_CACHE_PROFILE_TERMS] = {5000ULL, 5},
+        [WAMBLE_RESPONSE_CACHE_PREDICTION_PROJECTION] = {3000ULL, 25},
+        [WAMBLE_RESPONSE_CACHE_TRUST_TIER] = {3000ULL, 5},
+        [WAMBLE_RESPONSE_CACHE_SESSION_CAPS] = {1000ULL, 15},
+        [WAMBLE_RESPONSE_CACHE_PROFILES_LIST] = {5000ULL, 10},
+        [WAMBLE_RESPONSE_CACHE_LEADERBOARD] = {5000ULL, 40},
+};
+
+static WAMBLE_THREAD_LOCAL ResponseCacheShard g_response_cache;
+
+static volatile uint64_t
+    g_response_cache_generations[WAMBLE_RESPONSE_CACHE_NAMESPACE_COUNT];
+
+static int response_cache_ns_valid(int ns) {
+  return ns >= 0 && ns < WAMBLE_RESPONSE_CACHE_NAMESPACE_COUNT;
+}
+
+uint64_t response_cache_generation(int ns) {
+  if (!response_cache_ns_valid(ns))
+    return 0;
+  return wamble_atomic_load_u64(&g_response_cache_generations[ns]);
+}
+
+static size_t response_cache_header_size(void) {
+  return (sizeof(ResponseCacheEntry) + RESPONSE_CACHE_ALIGN - 1u) &
+         ~(size_t)(RESPONSE_CACHE_ALIGN - 1u);
+}
+
+static unsigned char *response_cache_value(ResponseCacheEntry *e) {
+  return (unsigned char *)e + response_cache_header_size();
+}
+
+static unsigned char *response_cache_key(ResponseCacheEntry *e) {
+  return response_cache_value(e) + e->value_len;
+}
+
+static size_t response_cache_budget(int ns) {
+  const WambleConfig *cfg = get_config();
+  if (!cfg || cfg->response_cache_bytes <= 0)
+    return 0;
+  return (size_t)cfg->response_cache_bytes / 100u *
+         (size_t)g_response_cache_specs[ns].budget_percent;
+}
+
+uint64_t response_cache_hash(const void *data, size_t len) {
+  uint64_t h = 1469598103934665603ULL;
+  const unsigned char *p = (const unsigned char *)data;
+  for (size_t i = 0; p && i < len; i++) {
+    h ^= (uint64_t)p[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+static uint64_t response_cache_key_hash(int ns, const void *key,
+                                        size_t key_len) {
+  uint64_t salt = (uint64_t)ns + 1u;
+  return response_cache_hash(key, key_len) ^ (salt * 0x9e3779b97f4a7c15ULL);
+}
+
+static ResponseCacheEntry **response_cache_slot(uint64_t hash) {
+  uint64_t mask = (uint64_t)g_response_cache.bucket_cap - 1u;
+  return &g_response_cache.buckets[hash & mask];
+}
+
+static ResponseCacheEntry **response_cache_tag_slot(uint64_t tag) {
+  uint64_t mask = (uint64_t)g_response_cache.bucket_cap - 1u;
+  return &g_response_cache.tag_buckets[(tag ^ (tag >> 32)) & mask];
+}
+
+static ResponseCacheEntry *response_cache_find(int ns, uint64_t hash,
+                                               const void *key,
+                                               size_t key_len) {
+  if (!g_response_cache.buckets)
+    return NULL;
+  for (ResponseCacheEntry *e = *response_cache_slot(hash); e;
+       e = e->hash_next) {
+    if (e->hash == hash && e->ns == ns && e->key_len == key_len &&
+        memcmp(response_cache_key(e), key, key_len) == 0)
+      return e;
+  }
+  return NULL;
+}
+
+static void response_cache_lru_unlink(ResponseCacheEntry *e) {
+  ResponseCacheNamespace *n = &g_response_cache.ns[e->ns];
+  if (e->lru_prev)
+    e->lru_prev->lru_next = e->lru_next;
+  else
+    n->lru_head = e->lru_next;
+  if (e->lru_next)
+    e->lru_next->lru_prev = e->lru_prev;
+  else
+    n->lru_tail = e->lru_prev;
+  e->lru_prev = NULL;
+  e->lru_next = NULL;
+}
+
+static void response_cache_lru_push(ResponseCacheEntry *e) {
+  ResponseCacheNamespace *n = &g_response_cache.ns[e->ns];
+  e->lru_prev = NULL;
+  e->lru_next = n->lru_head;
+  if (n->lru_head)
+    n->lru_head->lru_prev = e;
+  n->lru_head = e;
+  if (!n->lru_tail)
+    n->lru_tail = e;
+}
+
+static void response_cache_remove(ResponseCacheEntry *e) {
+  ResponseCacheEntry **pp = response_cache_slot(e->hash);
+  while (*pp && *pp != e)
+    pp = &(*pp)->hash_next;
+  if (*pp)
+    *pp = e->hash_next;
+  pp = response_cache_tag_slot(e->tag);
+  while (*pp && *pp != e)
+    pp = &(*pp)->tag_next;
+  if (*pp)
+    *pp = e->tag_next;
+  response_cache_lru_unlink(e);
+  ResponseCacheNamespace *n = &g_response_cache.ns[e->ns];
+  n->bytes -= e->charge;
+  n->entries--;
+  g_response_cache.entry_count--;
+  free(e);
+}
+
+static int response_cache_grow(void) {
+  int cap = g_response_cache.bucket_cap ? g_response_cache.bucket_cap * 2
+                                        : RESPONSE_CACHE_MIN_BUCKETS;
+  ResponseCacheEntry **buckets =
+      (ResponseCacheEntry **)calloc((size_t)cap, sizeof(*buckets));
+  ResponseCacheEntry **tag_buckets =
+      (ResponseCacheEntry **)calloc((size_t)cap, sizeof(*tag_buckets));
+  if (!buckets || !tag_buckets) {
+    free(buckets);
+    free(tag_buckets);
+    return -1;
+  }
+  for (int i = 0; i < g_response_cache.bucket_cap; i++) {
+    ResponseCacheEntry *e = g_response_cache.buckets[i];
+    while (e) {
+      ResponseCacheEntry *next = e->hash_next;
+      ResponseCacheEntry **slot = &buckets[e->hash & (uint64_t)(cap - 1)];
+      e->hash_next = *slot;
+      *slot = e;
+      slot = &tag_buckets[(e->tag ^ (e->tag >> 32)) & (uint64_t)(cap - 1)];
+      e->tag_next = *slot;
+      *slot = e;
+      e = next;
+    }
+  }
+  free(g_response_cache.buckets);
+  free(g_response_cache.tag_buckets);
+  g_response_cache.buckets = buckets;
+  g_response_cache.tag_buckets = tag_buckets;
+  g_response_cache.bucket_cap = cap;
+  return 0;
+}
+
+void *response_cache_lookup(int ns, const void *key, size_t key_len,
+                            size_t *out_len) {
+  if (out_len)
+    *out_len = 0;
+  if (!response_cache_ns_valid(ns) || !key)
+    return NULL;
+  ResponseCacheNamespace *n = &g_response_cache.ns[ns];
+  uint64_t hash = response_cache_key_hash(ns, key, key_len);
+  ResponseCacheEntry *e = response_cache_find(ns, hash, key, key_len);
+  if (!e) {
+    n->stats.misses++;
+    return NULL;
+  }
+  if (e->generation != response_cache_generation(ns)) {
+    response_cache_remove(e);
+    n->stats.invalidations++;
+    n->stats.misses++;
+    return NULL;
+  }
+  if (wamble_now_mono_millis() - e->cached_at_ms >
+      g_response_cache_specs[ns].ttl_ms) {
+    response_cache_remove(e);
+    n->stats.expirations++;
+    n->stats.misses++;
+    return NULL;
+  }
+  response_cache_lru_unlink(e);
+  response_cache_lru_push(e);
+  n->stats.hits++;
+  if (out_len)
+    *out_len = e->value_len;
+  return response_cache_value(e);
+}
+
+void *response_cache_store(int ns, const void *key, size_t key_len,
+                           uint64_t tag, const void *value, size_t value_len) {
+  if (!response_cache_ns_valid(ns) || !key || (value_len > 0 && !value))
+    return NULL;
+  ResponseCacheNamespace *n = &g_response_cache.ns[ns];
+  uint64_t hash = response_cache_key_hash(ns, key, key_len);
+  ResponseCacheEntry *old = response_cache_find(ns, hash, key, key_len);
+  if (old)
+    response_cache_remove(old);
+  size_t charge = response_cache_header_size() + value_len + key_len;
+  size_t budget = response_cache_budget(ns);
+  if (charge > budget)
+    return NULL;
+  while (n->lru_tail && n->bytes + charge > budget) {
+    response_cache_remove(n->lru_tail);
+    n->stats.evictions++;
+  }
+  if (g_response_cache.entry_count >= g_response_cache.bucket_cap &&
+      response_cache_grow() != 0 && !g_response_cache.buckets)
+    return NULL;
+  ResponseCacheEntry *e = (ResponseCacheEntry *)malloc(charge);
+  if (!e)
+    return NULL;
+  memset(e, 0, sizeof(*e));
+  e->hash = hash;
+  e->tag = tag;
+  e->generation = response_cache_generation(ns);
+  e->cached_at_ms = wamble_now_mono_millis();
+  e->key_len = key_len;
+  e->value_len = value_len;
+  e->charge = charge;
+  e->ns = ns;
+  if (value_len > 0)
+    memcpy(response_cache_value(e), value, value_len);
+  memcpy(response_cache_key(e), key, key_len);
+  ResponseCacheEntry **slot = response_cache_slot(hash);
+  e->hash_next = *slot;
+  *slot = e;
+  slot = response_cache_tag_slot(tag);
+  e->tag_next = *slot;
+  *slot = e;
+  response_cache_lru_push(e);
+  n->bytes += charge;
+  n->entries++;
+  n->stats.stores++;
+  g_response_cache.entry_count++;
+  return response_cache_value(e);
+}
+
+void response_cache_invalidate(int ns, const void *key, size_t key_len) {
+  if (!response_cache_ns_valid(ns) || !key)
+    return;
+  uint64_t hash = response_cache_key_hash(ns, key, key_len);
+  ResponseCacheEntry *e = response_cache_find(ns, hash, key, key_len);
+  if (!e)
+    return;
+  response_cache_remove(e);
+  g_response_cache.ns[ns].stats.invalidations++;
+}
+
+void response_cache_invalidate_tag_prefix(int ns, uint64_t tag,
+                                         const void *prefix,
+                                         size_t prefix_len) {
+  if (!g_response_cache.tag_buckets || (prefix_len > 0 && !prefix))
+    return;
+  ResponseCacheEntry *e = *response_cache_tag_slot(tag);
+  while (e) {
+    ResponseCacheEntry *next = e->tag_next;
+    if (e->tag == tag && (!response_cache_ns_valid(ns) || e->ns == ns) &&
+        e->key_len >= prefix_len &&
+        (prefix_len == 0 ||
+         memcmp(response_cache_key(e), prefix, prefix_len) == 0)) {
+      g_response_cache.ns[e->ns].stats.invalidations++;
+      response_cache_remove(e);
+    }
+    e = next;
+  }
+}
+
+void response_cache_invalidate_tag(int ns, uint64_t tag) {
+  response_cache_invalidate_tag_prefix(ns, tag, NULL, 0);
+}
+
+void response_cache_bump_generation(int ns) {
+  for (int i = 0; i < WAMBLE_RESPONSE_CACHE_NAMESPACE_COUNT; i++) {
+    if (!response_cache_ns_valid(ns) || i == ns)
+      wamble_atomic_inc_u64(&g_response_cache_generations[i]);
+  }
+}
+
+void response_cache_clear(void) {
+  for (int i = 0; i < WAMBLE_RESPONSE_CACHE_NAMESPACE_COUNT; i++) {
+    while (g_response_cache.ns[i].lru_head)
+      response_cache_remove(g_response_cache.ns[i].lru_head);
+    memset(&g_response_cache.ns[i].stats, 0,
+           sizeof(g_response_cache.ns[i].stats));
+  }
+  free(g_response_cache.buckets);
+  free(g_response_cache.tag_buckets);
+  g_response_cache.buckets = NULL;
+  g_response_cache.tag_buckets = NULL;
+  g_response_cache.bucket_cap = 0;
+  g_response_cache.entry_count = 0;
+}
+
+void response_cache_stats(int ns, WambleResponseCacheStats *out) {
+  if (!out)
+    return;
+  memset(out, 0, sizeof(*out));
+  for (int i = 0; i < WAMBLE_RESPONSE_CACHE_NAMESPACE_COUNT; i++) {
+    if (response_cache_ns_valid(ns) && i != ns)
+      continue;
+    const ResponseCacheNamespace *n = &g_response_cache.ns[i];
+    out->hits += n->stats.hits;
+    out->misses += n->stats.misses;
+    out->stores += n->stats.stores;
+    out->evictions += n->stats.evictions;
+    out->expirations += n->stats.expirations;
+    out->invalidations += n->stats.invalidations;
+    out->bytes += n->bytes;
+    out->entries += n->entries;
+  }
+}
@@ -6,12 +6,6 @@ void wamble_emit_record_payout_with_canonical(uint64_t board_id,
                                               double points,
                                               double canonical_points);
 
-typedef struct {
-  uint8_t player_token[TOKEN_LENGTH];
-  int white_moves;
-  int black_moves;
-} PlayerContribution;
-
 static int scoring_map_find(const uint8_t *map_tokens, const int *map_values,
                             int map_size, const uint8_t *token) {
   if (!map_tokens || !map_values || map_size <= 0 || !token)
@@ -171,68 +165,27 @@ static void scoring_apply_treatment_adjustments(const WambleBoard *board,
     *score = 0.0;
 }
 
-static ScoringStatus calculate_and_distribute_pot_for_moves_internal(
-    uint64_t board_id, WambleBoard *board, const WambleMove *moves,
-    int num_moves) {
+static ScoringStatus scoring_distribute_contributions(
+    uint64_t board_id, WambleBoard *board,
+    const WambleContributor *contributions, int num_contributors) {
   const WambleConfig *cfg = get_config();
   if (!board)
     return SCORING_ERR_INVALID;
-  if (!moves || num_moves <= 0)
+  if (!contributions || num_contributors <= 0)
     return SCORING_NONE;
   if (!cfg || cfg->max_contributors <= 0)
     return SCORING_NONE;
+  if (num_contributors > cfg->max_contributors)
+    num_contributors = cfg->max_contributors;
 
-  int max_contributors = cfg->max_contributors;
-  int map_size = (max_contributors * 2) + 1;
-  PlayerContribution *contributions =
-      malloc(sizeof(PlayerContribution) * (size_t)max_contributors);
-  int *contrib_map_values = NULL;
-  uint8_t *contrib_map_tokens = NULL;
-  if (!contributions) {
-    return SCORING_ERR_DB;
-  }
-  if (map_size > 0) {
-    contrib_map_values = malloc(sizeof(int) * (size_t)map_size);
-    contrib_map_tokens = calloc((size_t)map_size, TOKEN_LENGTH);
-  }
-  if (!contrib_map_values || !contrib_map_tokens) {
-    free(contrib_map_tokens);
-    free(contrib_map_values);
-    free(contributions);
-    return SCORING_ERR_DB;
-  }
-  for (int i = 0; i < map_size; i++)
-    contrib_map_values[i] = -1;
-
-  int num_contributors = 0;
   int total_white_moves = 0;
   int total_black_moves = 0;
-
-  for (int i = 0; i < num_moves; i++) {
-    const WambleMove *move = &moves[i];
-    int contributor_index = scoring_map_find(
-        contrib_map_tokens, contrib_map_values, map_size, move->player_token);
-
-    if (contributor_index == -1 && num_contributors < max_contributors) {
-      contributor_index = num_contributors++;
-      memcpy(contributions[contributor_index].player_token, move->player_token,
-             TOKEN_LENGTH);
-      contributions[contributor_index].white_moves = 0;
-      contributions[contributor_index].black_moves = 0;
-      (void)scoring_map_insert(contrib_map_tokens, contrib_map_values, map_size,
-                               move->player_token, contributor_index);
-    }
-
-    if (contributor_index != -1) {
-      if (move->is_white_move) {
-        contributions[contributor_index].white_moves++;
-        total_white_moves++;
-      } else {
-        contributions[contributor_index].black_moves++;
-        total_black_moves++;
-      }
-    }
+  for (int i = 0; i < num_contributors; i++) {
+    total_white_moves += contributions[i].white_moves;
+    total_black_moves += contributions[i].black_moves;
   }
+  if (total_white_moves + total_black_moves <= 0)
+    return SCORING_NONE;
 
   double white_pot = 0.0;
   double black_pot = 0.0;
@@ -247,7 +200,7 @@ static ScoringStatus calculate_and_distribute_pot_for_moves_internal(
   }
 
   for (int i = 0; i < num_contributors; i++) {
-    PlayerContribution *contrib = &contributions[i];
+    const WambleContributor *contrib = &contributions[i];
     double score = 0.0;
     double canonical_score = 0.0;
 
@@ -281,11 +234,74 @@ static ScoringStatus calculate_and_distribute_pot_for_moves_internal(
       player->score += score;
     }
   }
+  return SCORING_OK;
+}
 
+static ScoringStatus calculate_and_distribute_pot_for_moves_internal(
+    uint64_t board_id, WambleBoard *board, const WambleMove *moves,
+    int num_moves) {
+  const WambleConfig *cfg = get_config();
+  if (!board)
+    return SCORING_ERR_INVALID;
+  if (!moves || num_moves <= 0)
+    return SCORING_NONE;
+  if (!cfg || cfg->max_contributors <= 0)
+    return SCORING_NONE;
+
+  int max_contributors = cfg->max_contributors;
+  int map_size = (max_contributors * 2) + 1;
+  WambleContributor *contributions =
+      malloc(sizeof(WambleContributor) * (size_t)max_contributors);
+  int *contrib_map_values = NULL;
+  uint8_t *contrib_map_tokens = NULL;
+  if (!contributions) {
+    return SCORING_ERR_DB;
+  }
+  if (map_size > 0) {
+    contrib_map_values = malloc(sizeof(int) * (size_t)map_size);
+    contrib_map_tokens = calloc((size_t)map_size, TOKEN_LENGTH);
+  }
+  if (!contrib_map_values || !contrib_map_tokens) {
+    free(contrib_map_tokens);
+    free(contrib_map_values);
+    free(contributions);
+    return SCORING_ERR_DB;
+  }
+  for (int i = 0; i < map_size; i++)
+    contrib_map_values[i] = -1;
+
+  int num_contributors = 0;
+
+  for (int i = 0; i < num_moves; i++) {
+    const WambleMove *move = &moves[i];
+    int contributor_index = scoring_map_find(
+        contrib_map_tokens, contrib_map_values, map_size, move->player_token);
+
+    if (contributor_index == -1 && num_contributors < max_contributors) {
+      contributor_index = num_contributors++;
+      memcpy(contributions[contributor_index].player_token, move->player_token,
+             TOKEN_LENGTH);
+      contributions[contributor_index].white_moves = 0;
+      contributions[contributor_index].black_moves = 0;
+      (void)scoring_map_insert(contrib_map_tokens, contrib_map_values, map_size,
+                               move->player_token, contributor_index);
+    }
+
+    if (contributor_index != -1) {
+      if (move->is_white_move) {
+        contributions[contributor_index].white_moves++;
+      } else {
+        contributions[contributor_index].black_moves++;
+      }
+    }
+  }
+
+  ScoringStatus status = scoring_distribute_contributions(
+      board_id, board, contributions, num_contributors);
   free(contrib_map_tokens);
   free(contrib_map_values);
   free(contributions);
-  return SCORING_OK;
+  return status;
 }
 
 ScoringStatus calculate_and_distribute_pot_for_moves(WambleBoard *board,
@@ -323,6 +339,16 @@ ScoringStatus calculate_and_distribute_pot(uint64_t board_id) {
                                                          mres.rows, mres.count);
 }
 
+ScoringStatus calculate_and_distribute_pot_for_contributors(
+    WambleBoard *board, const WambleContributor *contributors, int count) {
+  if (!board)
+    return SCORING_ERR_INVALID;
+  if (board->result == GAME_RESULT_IN_PROGRESS)
+    return SCORING_NONE;
+  return scoring_distribute_contributions(board->id, board, contributors,
+                                          count);
+}
+
 ScoringStatus
 calculate_and_distribute_pot_for_completed_board(uint64_t board_id,
                                                  GameResult result) {
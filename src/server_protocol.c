@@ -50,11 +50,27 @@ static int server_protocol_flush_intents_now(void (*emit_fn)(void *),
 
 void crypto_blake2b(uint8_t *hash, size_t hash_size, const uint8_t *msg,
                     size_t msg_size);
-int crypto_eddsa_check(const uint8_t signature[64],
-                       const uint8_t public_key[32], const uint8_t *message,
-                       size_t message_size);
+uint64_t login_verify_submit(const uint8_t *signature,
+                             const uint8_t *public_key,
+                             const uint8_t *message, size_t message_len,
+                             wamble_socket_t wake_sockfd);
+int login_verify_poll(uint64_t *ticket, int *verified);
+void login_verify_thread_discard(void);
+void network_begin_request(const struct WambleMsg *msg,
+                           const struct sockaddr_in *cliaddr);
+typedef struct TransportSharedPayload TransportSharedPayload;
+TransportSharedPayload *network_shared_payload_create(
+    const struct WambleMsg *msg);
+void network_shared_payload_release(TransportSharedPayload *shared);
+int network_enqueue_unreliable_shared(TransportSharedPayload *shared,
+                                      const uint8_t *token,
+                                      const struct sockaddr_in *cliaddr);
+void network_end_request(void);
 int network_enqueue_ack_after(const struct WambleMsg *msg,
                               const struct sockaddr_in *cliaddr);
+int network_set_endpoint_capabilities(const struct sockaddr_in *cliaddr,
+                                      const uint8_t *token,
+                                      uint8_t capabilities);
 int network_enqueue_replayable_terminal(const struct WambleMsg *msg,
                                         const struct sockaddr_in *cliaddr);
 int network_enqueue_replayable_terminal_for_token(const struct WambleMsg *msg,
@@ -75,16 +91,7 @@ int network_enqueue_unreliable_for_token(const struct WambleMsg *msg,
                                          const uint8_t *token);
 int spectator_collect_state_snapshot(const uint8_t *token,
                                      struct SpectatorUpdate *out, int max);
-
-typedef struct {
-  int used;
-  uint8_t token[TOKEN_LENGTH];
-  uint64_t window_start_ms;
-  int count;
-} RequestRateLimitEntry;
-
-static WAMBLE_THREAD_LOCAL RequestRateLimitEntry *g_rate_limit_entries = NULL;
-static WAMBLE_THREAD_LOCAL int g_rate_limit_capacity = 0;
+int network_rate_limit_allow(const uint8_t *token, int max_per_sec);
 
 #define LOGIN_CHALLENGE_TTL_MS 30000ULL
 
@@ -100,121 +107,96 @@ static WAMBLE_THREAD_LOCAL LoginChallengeEntry *g_login_challenge_entries =
     NULL;
 static WAMBLE_THREAD_LOCAL int g_login_challenge_capacity = 0;
 
-#define LEADERBOARD_CACHE_TTL_MS 5000ULL
+typedef struct {
+  uint64_t ticket;
+  struct sockaddr_in cliaddr;
+  uint8_t token[TOKEN_LENGTH];
+  uint8_t public_key[WAMBLE_PUBLIC_KEY_LENGTH];
+  uint64_t board_id;
+  uint32_t seq_num;
+  uint8_t flags;
+} PendingLoginEntry;
+
+static WAMBLE_THREAD_LOCAL PendingLoginEntry *g_pending_logins = NULL;
+static WAMBLE_THREAD_LOCAL int g_pending_login_count = 0;
+static WAMBLE_THREAD_LOCAL int g_pending_login_capacity = 0;
+
+#define RESPONSE_CACHE_KEY_MAX 320
 #define LEADERBOARD_CACHE_HANDLE_MAX 64
 
 typedef struct {
-  int valid;
-  uint64_t requester_session_id;
-  uint8_t type;
-  int limit;
-  int offset;
-  uint64_t cached_at_ms;
+  unsigned char bytes[RESPONSE_CACHE_KEY_MAX];
+  size_t len;
+  int overflow;
+} ResponseCacheKey;
+
+typedef struct {
   DbLeaderboardEntry rows[WAMBLE_MAX_LEADERBOARD_ENTRIES];
   char row_handles[WAMBLE_MAX_LEADERBOARD_ENTRIES]
                   [LEADERBOARD_CACHE_HANDLE_MAX];
+  uint8_t row_has_handle[WAMBLE_MAX_LEADERBOARD_ENTRIES];
   DbLeaderboardEntry self;
   char self_handle[LEADERBOARD_CACHE_HANDLE_MAX];
+  uint8_t self_has_handle;
   int count;
   uint32_t self_rank;
   int self_in_rows;
   uint32_t total_count;
-} LeaderboardCacheEntry;
-
-#define PROFILE_TERMS_CACHE_TTL_MS 5000ULL
-#define PROFILE_TERMS_CACHE_MAX 64
-#define PROFILE_TERMS_CACHE_NAME_MAX 64
+} LeaderboardCacheValue;
 
 typedef struct {
-  int valid;
-  uint8_t token[TOKEN_LENGTH];
-  char profile_name[PROFILE_TERMS_CACHE_NAME_MAX];
-  uint8_t tos_hash[WAMBLE_FRAGMENT_HASH_LENGTH];
-  int accepted;
-  uint64_t cached_at_ms;
-} ProfileTermsCacheEntry;
-
-#define PREDICTION_MOVE_PROJECTION_CACHE_TTL_MS 3000ULL
-#define PREDICTION_MOVE_PROJECTION_CACHE_MAX 16
+  uint32_t caps;
+  int max_pending;
+  char prediction_source[16];
+} SessionCapsCacheValue;
 
 typedef struct {
-  int valid;
-  uint64_t board_id;
-  time_t board_last_move_time;
-  int max_out;
-  WamblePredictionView rows[WAMBLE_MAX_PREDICTION_ENTRIES];
   int count;
-  uint64_t cached_at_ms;
-} PredictionMoveProjectionCacheEntry;
+  WamblePredictionView rows[WAMBLE_MAX_PREDICTION_ENTRIES];
+} PredictionMoveProjectionCacheValue;
 
-#define TRUST_TIER_CACHE_TTL_MS 3000ULL
-#define TRUST_TIER_CACHE_MAX 64
+static void response_cache_key_bytes(ResponseCacheKey *k, const void *data,
+                                     size_t len) {
+  if (k->overflow || len > sizeof(k->bytes) - k->len) {
+    k->overflow = 1;
+    return;
+  }
+  memcpy(k->bytes + k->len, data, len);
+  k->len += len;
+}
 
-typedef struct {
-  int valid;
-  uint8_t token[TOKEN_LENGTH];
-  char profile_name[PROFILE_TERMS_CACHE_NAME_MAX];
-  int trust_tier;
-  uint64_t cached_at_ms;
-} TrustTierCacheEntry;
+static void response_cache_key_str(ResponseCacheKey *k, const char *s) {
+  if (!s)
+    s = "";
+  response_cache_key_bytes(k, s, strlen(s) + 1u);
+}
 
-#define SESSION_CAPS_CACHE_TTL_MS 1000ULL
-#define SESSION_CAPS_CACHE_MAX 64
+static uint64_t response_cache_token_tag(const uint8_t *token) {
+  return response_cache_hash(token, TOKEN_LENGTH);
+}
 
-typedef struct {
-  int valid;
-  uint8_t token[TOKEN_LENGTH];
-  char profile_name[PROFILE_TERMS_CACHE_NAME_MAX];
-  uint64_t board_id;
-  time_t board_last_move_time;
-  time_t reservation_time;
-  uint32_t caps;
-  int max_pending;
-  char prediction_source[16];
-  uint64_t cached_at_ms;
-} SessionCapsCacheEntry;
+static void *response_cache_key_lookup(int ns, const ResponseCacheKey *k,
+                                       size_t *out_len) {
+  if (k->overflow)
+    return NULL;
+  return response_cache_lookup(ns, k->bytes, k->len, out_len);
+}
 
-#define PROFILE_INFO_CACHE_TTL_MS 5000ULL
-#define PROFILE_INFO_CACHE_MAX 64
+static void response_cache_key_store(int ns, const ResponseCacheKey *k,
+                                     uint64_t tag, const void *value,
+                                     size_t value_len) {
+  if (!k->overflow)
+    (void)response_cache_store(ns, k->bytes, k->len, tag, value, value_len);
+}
 
-typedef struct {
-  int valid;
-  uint8_t token[TOKEN_LENGTH];
-  uintptr_t config_identity;
-  int effective_trust_tier;
-  char *payload;
-  size_t payload_len;
-  uint64_t cached_at_ms;
-} ProfilesListCacheEntry;
+static void server_protocol_cache_forget_token(const uint8_t *token) {
+  if (token)
+    response_cache_invalidate_tag(WAMBLE_RESPONSE_CACHE_NAMESPACE_COUNT,
+                                  response_cache_token_tag(token));
+}
 
-typedef struct {
-  int valid;
-  uint8_t token[TOKEN_LENGTH];
-  char profile_name[PROFILE_TERMS_CACHE_NAME_MAX];
-  char bound_profile_name[PROFILE_TERMS_CACHE_NAME_MAX];
-  int effective_trust_tier;
-  struct WambleMsg response;
-  uint64_t cached_at_ms;
-} ProfileInfoCacheEntry;
-
-typedef struct ServerProtocolCaches {
-  LeaderboardCacheEntry leaderboard;
-  ProfileTermsCacheEntry profile_terms[PROFILE_TERMS_CACHE_MAX];
-  int profile_terms_next;
-  PredictionMoveProjectionCacheEntry
-      prediction_move_projection[PREDICTION_MOVE_PROJECTION_CACHE_MAX];
-  int prediction_move_projection_next;
-  TrustTierCacheEntry trust_tiers[TRUST_TIER_CACHE_MAX];
-  int trust_tiers_next;
-  SessionCapsCacheEntry session_caps[SESSION_CAPS_CACHE_MAX];
-  int session_caps_next;
-  ProfilesListCacheEntry profiles_list[PROFILE_INFO_CACHE_MAX];
-  int profiles_list_next;
-  ProfileInfoCacheEntry profile_info[PROFILE_INFO_CACHE_MAX];
-  int profile_info_next;
-} ServerProtocolCaches;
-
-static WAMBLE_THREAD_LOCAL ServerProtocolCaches g_server_protocol_caches;
+#define PROFILES_LIST_CACHE_BASELINE 0
+#define PROFILES_LIST_CACHE_CUSTOM 1
 
 static int profiles_list_cache_lookup(const uint8_t *token,
                                       uintptr_t config_identity,
@@ -223,25 +205,19 @@ static int profiles_list_cache_lookup(const uint8_t *token,
                                       size_t *payload_len_out) {
   if (!token || !payload_out || !payload_len_out)
     return 0;
-  uint64_t now_ms = wamble_now_mono_millis();
-  for (int i = 0; i < PROFILE_INFO_CACHE_MAX; i++) {
-    ProfilesListCacheEntry *e = &g_server_protocol_caches.profiles_list[i];
-    if (!e->valid)
-      continue;
-    if (now_ms - e->cached_at_ms > PROFILE_INFO_CACHE_TTL_MS) {
-      free(e->payload);
-      memset(e, 0, sizeof(*e));
-      continue;
-    }
-    if (e->config_identity == config_identity &&
-        e->effective_trust_tier == effective_trust_tier &&
-        memcmp(e->token, token, TOKEN_LENGTH) == 0) {
-      *payload_out = (const uint8_t *)e->payload;
-      *payload_len_out = e->payload_len;
-      return 1;
-    }
-  }
-  return 0;
+  ResponseCacheKey k = {0};
+  response_cache_key_bytes(&k, token, TOKEN_LENGTH);
+  response_cache_key_bytes(&k, &config_identity, sizeof(config_identity));
+  response_cache_key_bytes(&k, &effective_trust_tier,
+                           sizeof(effective_trust_tier));
+  size_t len = 0;
+  const uint8_t *payload = (const uint8_t *)response_cache_key_lookup(
+      WAMBLE_RESPONSE_CACHE_PROFILES_LIST, &k, &len);
+  if (!payload)
+    return 0;
+  *payload_out = payload;
+  *payload_len_out = len;
+  return 1;
 }
 
 static void profiles_list_cache_store(const uint8_t *token,
@@ -251,86 +227,26 @@ static void profiles_list_cache_store(const uint8_t *token,
                                       size_t payload_len) {
   if (!token || (payload_len > 0 && !payload))
     return;
-  char *copy = NULL;
-  if (payload_len > 0) {
-    copy = (char *)malloc(payload_len + 1u);
-    if (!copy)
-      return;
-    memcpy(copy, payload, payload_len);
-    copy[payload_len] = '\0';
-  }
-  int slot =
-      g_server_protocol_caches.profiles_list_next++ % PROFILE_INFO_CACHE_MAX;
-  ProfilesListCacheEntry *e = &g_server_protocol_caches.profiles_list[slot];
-  free(e->payload);
-  memset(e, 0, sizeof(*e));
-  e->valid = 1;
-  memcpy(e->token, token, TOKEN_LENGTH);
-  e->config_identity = config_identity;
-  e->effective_trust_tier = effective_trust_tier;
-  e->payload = copy;
-  e->payload_len = payload_len;
-  e->cached_at_ms = wamble_now_mono_millis();
-}
-
-static int profile_info_cache_lookup(const uint8_t *token, const char *name,
-                                     const char *bound_profile_name,
-                                     int effective_trust_tier,
-                                     struct WambleMsg *out) {
-  if (!token || !name || !out)
-    return 0;
-  uint64_t now_ms = wamble_now_mono_millis();
-  const char *bound = bound_profile_name ? bound_profile_name : "";
-  for (int i = 0; i < PROFILE_INFO_CACHE_MAX; i++) {
-    ProfileInfoCacheEntry *e = &g_server_protocol_caches.profile_info[i];
-    if (!e->valid)
-      continue;
-    if (now_ms - e->cached_at_ms > PROFILE_INFO_CACHE_TTL_MS) {
-      e->valid = 0;
-      continue;
-    }
-    if (e->effective_trust_tier == effective_trust_tier &&
-        memcmp(e->token, token, TOKEN_LENGTH) == 0 &&
-        strcmp(e->profile_name, name) == 0 &&
-        strcmp(e->bound_profile_name, bound) == 0) {
-      *out = e->response;
-      return 1;
-    }
-  }
-  return 0;
+  ResponseCacheKey k = {0};
+  response_cache_key_bytes(&k, token, TOKEN_LENGTH);
+  response_cache_key_bytes(&k, &config_identity, sizeof(config_identity));
+  response_cache_key_bytes(&k, &effective_trust_tier,
+                           sizeof(effective_trust_tier));
+  response_cache_key_store(WAMBLE_RESPONSE_CACHE_PROFILES_LIST, &k,
+                           response_cache_token_tag(token), payload,
+                           payload_len);
 }
 
-static void profile_info_cache_store(const uint8_t *token, const char *name,
-                                     const char *bound_profile_name,
-                                     int effective_trust_tier,
-                                     const struct WambleMsg *resp) {
-  if (!token || !name || !resp)
-    return;
-  int slot =
-      g_server_protocol_caches.profile_info_next++ % PROFILE_INFO_CACHE_MAX;
-  ProfileInfoCacheEntry *e = &g_server_protocol_caches.profile_info[slot];
-  memset(e, 0, sizeof(*e));
-  e->valid = 1;
-  memcpy(e->token, token, TOKEN_LENGTH);
-  snprintf(e->profile_name, sizeof(e->profile_name), "%s", name);
-  snprintf(e->bound_profile_name, sizeof(e->bound_profile_name), "%s",
-           bound_profile_name ? bound_profile_name : "");
-  e->effective_trust_tier = effective_trust_tier;
-  e->response = *resp;
-  e->cached_at_ms = wamble_now_mono_millis();
-}
-
-static void profile_info_cache_invalidate(const uint8_t *token,
-                                          const char *name) {
-  if (!token || !name)
-    return;
-  for (int i = 0; i < PROFILE_INFO_CACHE_MAX; i++) {
-    ProfileInfoCacheEntry *e = &g_server_protocol_caches.profile_info[i];
-    if (e->valid && memcmp(e->token, token, TOKEN_LENGTH) == 0 &&
-        strcmp(e->profile_name, name) == 0) {
-      e->valid = 0;
-    }
-  }
+static void session_caps_cache_key(ResponseCacheKey *k, const uint8_t *token,
+                                   const char *profile_name,
+                                   const WambleBoard *board) {
+  response_cache_key_bytes(k, token, TOKEN_LENGTH);
+  response_cache_key_str(k, profile_name);
+  response_cache_key_bytes(k, &board->id, sizeof(board->id));
+  response_cache_key_bytes(k, &board->last_move_time,
+                           sizeof(board->last_move_time));
+  response_cache_key_bytes(k, &board->reservation_time,
+                           sizeof(board->reservation_time));
 }
 
 static int session_caps_cache_lookup(const uint8_t *token,
@@ -341,28 +257,18 @@ static int session_caps_cache_lookup(const uint8_t *token,
                                      int *out_max_pending) {
   if (!token || !profile_name || !board || !out_caps || !out_max_pending)
     return 0;
-  uint64_t now_ms = wamble_now_mono_millis();
-  for (int i = 0; i < SESSION_CAPS_CACHE_MAX; i++) {
-    SessionCapsCacheEntry *e = &g_server_protocol_caches.session_caps[i];
-    if (!e->valid)
-      continue;
-    if (now_ms - e->cached_at_ms > SESSION_CAPS_CACHE_TTL_MS) {
-      e->valid = 0;
-      continue;
-    }
-    if (memcmp(e->token, token, TOKEN_LENGTH) == 0 &&
-        strcmp(e->profile_name, profile_name) == 0 &&
-        e->board_id == board->id &&
-        e->board_last_move_time == board->last_move_time &&
-        e->reservation_time == board->reservation_time) {
-      *out_caps = e->caps;
-      *out_max_pending = e->max_pending;
-      if (out_prediction_source)
-        *out_prediction_source = e->prediction_source;
-      return 1;
-    }
-  }
-  return 0;
+  ResponseCacheKey k = {0};
+  session_caps_cache_key(&k, token, profile_name, board);
+  const SessionCapsCacheValue *v =
+      (const SessionCapsCacheValue *)response_cache_key_lookup(
+          WAMBLE_RESPONSE_CACHE_SESSION_CAPS, &k, NULL);
+  if (!v)
+    return 0;
+  *out_caps = v->caps;
+  *out_max_pending = v->max_pending;
+  if (out_prediction_source)
+    *out_prediction_source = v->prediction_source;
+  return 1;
 }
 
 static void session_caps_cache_store(const uint8_t *token,
@@ -372,34 +278,32 @@ static void session_caps_cache_store(const uint8_t *token,
                                      int max_pending) {
   if (!token || !profile_name || !board)
     return;
-  int slot =
-      g_server_protocol_caches.session_caps_next++ % SESSION_CAPS_CACHE_MAX;
-  SessionCapsCacheEntry *e = &g_server_protocol_caches.session_caps[slot];
-  memset(e, 0, sizeof(*e));
-  e->valid = 1;
-  memcpy(e->token, token, TOKEN_LENGTH);
-  snprintf(e->profile_name, sizeof(e->profile_name), "%s", profile_name);
-  e->board_id = board->id;
-  e->board_last_move_time = board->last_move_time;
-  e->reservation_time = board->reservation_time;
-  e->caps = caps;
-  e->max_pending = max_pending;
-  snprintf(e->prediction_source, sizeof(e->prediction_source), "%s",
+  ResponseCacheKey k = {0};
+  session_caps_cache_key(&k, token, profile_name, board);
+  SessionCapsCacheValue v;
+  memset(&v, 0, sizeof(v));
+  v.caps = caps;
+  v.max_pending = max_pending;
+  snprintf(v.prediction_source, sizeof(v.prediction_source), "%s",
            prediction_source ? prediction_source : "tree");
-  e->cached_at_ms = wamble_now_mono_millis();
+  response_cache_key_store(WAMBLE_RESPONSE_CACHE_SESSION_CAPS, &k,
+                           response_cache_token_tag(token), &v, sizeof(v));
 }
 
 static void session_caps_cache_invalidate(const uint8_t *token,
                                           const char *profile_name) {
   if (!token || !profile_name)
     return;
-  for (int i = 0; i < SESSION_CAPS_CACHE_MAX; i++) {
-    SessionCapsCacheEntry *e = &g_server_protocol_caches.session_caps[i];
-    if (e->valid && memcmp(e->token, token, TOKEN_LENGTH) == 0 &&
-        strcmp(e->profile_name, profile_name) == 0) {
-      e->valid = 0;
-    }
-  }
+  ResponseCacheKey k = {0};
+  response_cache_key_bytes(&k, token, TOKEN_LENGTH);
+  response_cache_key_str(&k, profile_name);
+  if (k.overflow)
+    response_cache_invalidate_tag(WAMBLE_RESPONSE_CACHE_SESSION_CAPS,
+                                  response_cache_token_tag(token));
+  else
+    response_cache_invalidate_tag_prefix(WAMBLE_RESPONSE_CACHE_SESSION_CAPS,
+                                         response_cache_token_tag(token),
+                                         k.bytes, k.len);
 }
 
 static int trust_tier_cache_lookup(const uint8_t *token,
@@ -407,37 +311,27 @@ static int trust_tier_cache_lookup(const uint8_t *token,
                                    int *out_trust_tier) {
   if (!token || !profile_name || !out_trust_tier)
     return 0;
-  uint64_t now_ms = wamble_now_mono_millis();
-  for (int i = 0; i < TRUST_TIER_CACHE_MAX; i++) {
-    TrustTierCacheEntry *e = &g_server_protocol_caches.trust_tiers[i];
-    if (!e->valid)
-      continue;
-    if (now_ms - e->cached_at_ms > TRUST_TIER_CACHE_TTL_MS) {
-      e->valid = 0;
-      continue;
-    }
-    if (memcmp(e->token, token, TOKEN_LENGTH) == 0 &&
-        strcmp(e->profile_name, profile_name ? profile_name : "") == 0) {
-      *out_trust_tier = e->trust_tier;
-      return 1;
-    }
-  }
-  return 0;
+  ResponseCacheKey k = {0};
+  response_cache_key_bytes(&k, token, TOKEN_LENGTH);
+  response_cache_key_str(&k, profile_name);
+  const int *tier = (const int *)response_cache_key_lookup(
+      WAMBLE_RESPONSE_CACHE_TRUST_TIER, &k, NULL);
+  if (!tier)
+    return 0;
+  *out_trust_tier = *tier;
+  return 1;
 }
 
 static void trust_tier_cache_store(const uint8_t *token,
                                    const char *profile_name, int trust_tier) {
   if (!token || !profile_name)
     return;
-  int slot = g_server_protocol_caches.trust_tiers_next++ % TRUST_TIER_CACHE_MAX;
-  TrustTierCacheEntry *e = &g_server_protocol_caches.trust_tiers[slot];
-  memset(e, 0, sizeof(*e));
-  e->valid = 1;
-  memcpy(e->token, token, TOKEN_LENGTH);
-  snprintf(e->profile_name, sizeof(e->profile_name), "%s",
-           profile_name ? profile_name : "");
-  e->trust_tier = trust_tier;
-  e->cached_at_ms = wamble_now_mono_millis();
+  ResponseCacheKey k = {0};
+  response_cache_key_bytes(&k, token, TOKEN_LENGTH);
+  response_cache_key_str(&k, profile_name);
+  response_cache_key_store(WAMBLE_RESPONSE_CACHE_TRUST_TIER, &k,
+                           response_cache_token_tag(token), &trust_tier,
+                           sizeof(trust_tier));
 }
 
 static int prediction_move_projection_cache_lookup(uint64_t board_id,
@@ -447,28 +341,22 @@ static int prediction_move_projection_cache_lookup(uint64_t board_id,
                                                    int *out_count) {
   if (!out || max_out <= 0 || !out_count)
     return 0;
-  uint64_t now_ms = wamble_now_mono_millis();
-  for (int i = 0; i < PREDICTION_MOVE_PROJECTION_CACHE_MAX; i++) {
-    PredictionMoveProjectionCacheEntry *e =
-        &g_server_protocol_caches.prediction_move_projection[i];
-    if (!e->valid)
-      continue;
-    if (now_ms - e->cached_at_ms > PREDICTION_MOVE_PROJECTION_CACHE_TTL_MS) {
-      e->valid = 0;
-      continue;
-    }
-    if (e->board_id == board_id &&
-        e->board_last_move_time == board_last_move_time &&
-        e->max_out == max_out) {
-      int count = e->count;
-      if (count > max_out)
-        count = max_out;
-      memcpy(out, e->rows, sizeof(WamblePredictionView) * (size_t)count);
-      *out_count = count;
-      return 1;
-    }
-  }
-  return 0;
+  ResponseCacheKey k = {0};
+  response_cache_key_bytes(&k, &board_id, sizeof(board_id));
+  response_cache_key_bytes(&k, &board_last_move_time,
+                           sizeof(board_last_move_time));
+  response_cache_key_bytes(&k, &max_out, sizeof(max_out));
+  const PredictionMoveProjectionCacheValue *v =
+      (const PredictionMoveProjectionCacheValue *)response_cache_key_lookup(
+          WAMBLE_RESPONSE_CACHE_PREDICTION_PROJECTION, &k, NULL);
+  if (!v)
+    return 0;
+  int count = v->count;
+  if (count > max_out)
+    count = max_out;
+  memcpy(out, v->rows, sizeof(WamblePredictionView) * (size_t)count);
+  *out_count = count;
+  return 1;
 }
 
 static void prediction_move_projection_cache_store(
@@ -478,18 +366,27 @@ static void prediction_move_projection_cache_store(
     return;
   if (count > WAMBLE_MAX_PREDICTION_ENTRIES)
     count = WAMBLE_MAX_PREDICTION_ENTRIES;
-  int slot = g_server_protocol_caches.prediction_move_projection_next++ %
-             PREDICTION_MOVE_PROJECTION_CACHE_MAX;
-  PredictionMoveProjectionCacheEntry *e =
-      &g_server_protocol_caches.prediction_move_projection[slot];
-  memset(e, 0, sizeof(*e));
-  e->valid = 1;
-  e->board_id = board_id;
-  e->board_last_move_time = board_last_move_time;
-  e->max_out = max_out;
-  e->count = count;
-  memcpy(e->rows, rows, sizeof(WamblePredictionView) * (size_t)count);
-  e->cached_at_ms = wamble_now_mono_millis();
+  ResponseCacheKey k = {0};
+  response_cache_key_bytes(&k, &board_id, sizeof(board_id));
+  response_cache_key_bytes(&k, &board_last_move_time,
+                           sizeof(board_last_move_time));
+  response_cache_key_bytes(&k, &max_out, sizeof(max_out));
+  PredictionMoveProjectionCacheValue v;
+  memset(&v, 0, sizeof(v));
+  v.count = count;
+  memcpy(v.rows, rows, sizeof(WamblePredictionView) * (size_t)count);
+  response_cache_key_store(WAMBLE_RESPONSE_CACHE_PREDICTION_PROJECTION, &k, 0,
+                           &v,
+                           offsetof(PredictionMoveProjectionCacheValue, rows) +
+                               sizeof(WamblePredictionView) * (size_t)count);
+}
+
+static void profile_terms_cache_key(ResponseCacheKey *k, const uint8_t *token,
+                                    const char *profile_name,
+                                    const uint8_t *tos_hash) {
+  response_cache_key_bytes(k, token, TOKEN_LENGTH);
+  response_cache_key_str(k, profile_name);
+  response_cache_key_bytes(k, tos_hash, WAMBLE_FRAGMENT_HASH_LENGTH);
 }
 
 static int profile_terms_cache_lookup(const uint8_t *token,
@@ -498,23 +395,14 @@ static int profile_terms_cache_lookup(const uint8_t *token,
                                       int *out_accepted) {
   if (!token || !profile_name || !tos_hash || !out_accepted)
     return 0;
-  uint64_t now_ms = wamble_now_mono_millis();
-  for (int i = 0; i < PROFILE_TERMS_CACHE_MAX; i++) {
-    ProfileTermsCacheEntry *e = &g_server_protocol_caches.profile_terms[i];
-    if (!e->valid)
-      continue;
-    if (now_ms - e->cached_at_ms > PROFILE_TERMS_CACHE_TTL_MS) {
-      e->valid = 0;
-      continue;
-    }
-    if (memcmp(e->token, token, TOKEN_LENGTH) == 0 &&
-        strcmp(e->profile_name, profile_name) == 0 &&
-        memcmp(e->tos_hash, tos_hash, WAMBLE_FRAGMENT_HASH_LENGTH) == 0) {
-      *out_accepted = e->accepted;
-      return 1;
-    }
-  }
-  return 0;
+  ResponseCacheKey k = {0};
+  profile_terms_cache_key(&k, token, profile_name, tos_hash);
+  const int *accepted = (const int *)response_cache_key_lookup(
+      WAMBLE_RESPONSE_CACHE_PROFILE_TERMS, &k, NULL);
+  if (!accepted)
+    return 0;
+  *out_accepted = *accepted;
+  return 1;
 }
 
 static void profile_terms_cache_store(const uint8_t *token,
@@ -522,16 +410,12 @@ static void profile_terms_cache_store(const uint8_t *token,
                                       const uint8_t *tos_hash, int accepted) {
   if (!token || !profile_name || !tos_hash)
     return;
-  int slot =
-      g_server_protocol_caches.profile_terms_next++ % PROFILE_TERMS_CACHE_MAX;
-  ProfileTermsCacheEntry *e = &g_server_protocol_caches.profile_terms[slot];
-  memset(e, 0, sizeof(*e));
-  e->valid = 1;
-  memcpy(e->token, token, TOKEN_LENGTH);
-  snprintf(e->profile_name, sizeof(e->profile_name), "%s", profile_name);
-  memcpy(e->tos_hash, tos_hash, WAMBLE_FRAGMENT_HASH_LENGTH);
-  e->accepted = accepted ? 1 : 0;
-  e->cached_at_ms = wamble_now_mono_millis();
+  ResponseCacheKey k = {0};
+  profile_terms_cache_key(&k, token, profile_name, tos_hash);
+  int value = accepted ? 1 : 0;
+  response_cache_key_store(WAMBLE_RESPONSE_CACHE_PROFILE_TERMS, &k,
+                           response_cache_token_tag(token), &value,
+                           sizeof(value));
 }
 
 static void profile_terms_cache_invalidate(const uint8_t *token,
@@ -539,14 +423,21 @@ static void profile_terms_cache_invalidate(const uint8_t *token,
                                            const uint8_t *tos_hash) {
   if (!token || !profile_name || !tos_hash)
     return;
-  for (int i = 0; i < PROFILE_TERMS_CACHE_MAX; i++) {
-    ProfileTermsCacheEntry *e = &g_server_protocol_caches.profile_terms[i];
-    if (e->valid && memcmp(e->token, token, TOKEN_LENGTH) == 0 &&
-        strcmp(e->profile_name, profile_name) == 0 &&
-        memcmp(e->tos_hash, tos_hash, WAMBLE_FRAGMENT_HASH_LENGTH) == 0) {
-      e->valid = 0;
-    }
-  }
+  ResponseCacheKey k = {0};
+  profile_terms_cache_key(&k, token, profile_name, tos_hash);
+  if (!k.overflow)
+    response_cache_invalidate(WAMBLE_RESPONSE_CACHE_PROFILE_TERMS, k.bytes,
+                              k.len);
+}
+
+static void leaderboard_cache_key(ResponseCacheKey *k,
+                                  uint64_t requester_session_id, uint8_t type,
+                                  int limit, int offset) {
+  response_cache_key_bytes(k, &requester_session_id,
+                           sizeof(requester_session_id));
+  response_cache_key_bytes(k, &type, sizeof(type));
+  response_cache_key_bytes(k, &limit, sizeof(limit));
+  response_cache_key_bytes(k, &offset, sizeof(offset));
 }
 
 static void leaderboard_cache_store(uint64_t requester_session_id, uint8_t type,
@@ -554,67 +445,62 @@ static void leaderboard_cache_store(uint64_t requester_session_id, uint8_t type,
                                     const DbLeaderboardResult *src) {
   if (!src || src->status != DB_OK)
     return;
-  memset(&g_server_protocol_caches.leaderboard, 0,
-         sizeof(g_server_protocol_caches.leaderboard));
-  g_server_protocol_caches.leaderboard.valid = 1;
-  g_server_protocol_caches.leaderboard.requester_session_id =
-      requester_session_id;
-  g_server_protocol_caches.leaderboard.type = type;
-  g_server_protocol_caches.leaderboard.limit = limit;
-  g_server_protocol_caches.leaderboard.offset = offset;
-  g_server_protocol_caches.leaderboard.cached_at_ms = wamble_now_mono_millis();
-  g_server_protocol_caches.leaderboard.count = src->count;
-  if (g_server_protocol_caches.leaderboard.count < 0)
-    g_server_protocol_caches.leaderboard.count = 0;
-  if (g_server_protocol_caches.leaderboard.count >
-      WAMBLE_MAX_LEADERBOARD_ENTRIES)
-    g_server_protocol_caches.leaderboard.count = WAMBLE_MAX_LEADERBOARD_ENTRIES;
-  for (int i = 0; i < g_server_protocol_caches.leaderboard.count; i++) {
-    g_server_protocol_caches.leaderboard.rows[i] = src->rows[i];
+  LeaderboardCacheValue *v =
+      (LeaderboardCacheValue *)calloc(1, sizeof(LeaderboardCacheValue));
+  if (!v)
+    return;
+  v->count = src->count;
+  if (v->count < 0)
+    v->count = 0;
+  if (v->count > WAMBLE_MAX_LEADERBOARD_ENTRIES)
+    v->count = WAMBLE_MAX_LEADERBOARD_ENTRIES;
+  for (int i = 0; i < v->count; i++) {
+    v->rows[i] = src->rows[i];
+    v->rows[i].handle = NULL;
     if (src->rows[i].handle) {
-      snprintf(g_server_protocol_caches.leaderboard.row_handles[i],
-               sizeof(g_server_protocol_caches.leaderboard.row_handles[i]),
-               "%s", src->rows[i].handle);
-      g_server_protocol_caches.leaderboard.rows[i].handle =
-          g_server_protocol_caches.leaderboard.row_handles[i];
+      snprintf(v->row_handles[i], sizeof(v->row_handles[i]), "%s",
+               src->rows[i].handle);
+      v->row_has_handle[i] = 1;
     }
   }
-  g_server_protocol_caches.leaderboard.self_rank = src->self_rank;
-  g_server_protocol_caches.leaderboard.self_in_rows = src->self_in_rows;
-  g_server_protocol_caches.leaderboard.total_count = src->total_count;
-  g_server_protocol_caches.leaderboard.self = src->self;
+  v->self_rank = src->self_rank;
+  v->self_in_rows = src->self_in_rows;
+  v->total_count = src->total_count;
+  v->self = src->self;
+  v->self.handle = NULL;
   if (src->self.handle) {
-    snprintf(g_server_protocol_caches.leaderboard.self_handle,
-             sizeof(g_server_protocol_caches.leaderboard.self_handle), "%s",
-             src->self.handle);
-    g_server_protocol_caches.leaderboard.self.handle =
-        g_server_protocol_caches.leaderboard.self_handle;
-  }
+    snprintf(v->self_handle, sizeof(v->self_handle), "%s", src->self.handle);
+    v->self_has_handle = 1;
+  }
+  ResponseCacheKey k = {0};
+  leaderboard_cache_key(&k, requester_session_id, type, limit, offset);
+  response_cache_key_store(WAMBLE_RESPONSE_CACHE_LEADERBOARD, &k, 0, v,
+                           sizeof(*v));
+  free(v);
 }
 
 static int leaderboard_cache_lookup(uint64_t requester_session_id, uint8_t type,
                                     int limit, int offset,
                                     DbLeaderboardResult *out) {
-  if (!out || !g_server_protocol_caches.leaderboard.valid)
-    return 0;
-  uint64_t now_ms = wamble_now_mono_millis();
-  if (now_ms - g_server_protocol_caches.leaderboard.cached_at_ms >
-      LEADERBOARD_CACHE_TTL_MS)
+  if (!out)
     return 0;
-  if (g_server_protocol_caches.leaderboard.requester_session_id !=
-          requester_session_id ||
-      g_server_protocol_caches.leaderboard.type != type ||
-      g_server_protocol_caches.leaderboard.limit != limit ||
-      g_server_protocol_caches.leaderboard.offset != offset)
+  ResponseCacheKey k = {0};
+  leaderboard_cache_key(&k, requester_session_id, type, limit, offset);
+  LeaderboardCacheValue *v = (LeaderboardCacheValue *)response_cache_key_lookup(
+      WAMBLE_RESPONSE_CACHE_LEADERBOARD, &k, NULL);
+  if (!v)
     return 0;
+  for (int i = 0; i < v->count; i++)
+    v->rows[i].handle = v->row_has_handle[i] ? v->row_handles[i] : NULL;
+  v->self.handle = v->self_has_handle ? v->self_handle : NULL;
   memset(out, 0, sizeof(*out));
   out->status = DB_OK;
-  out->rows = g_server_protocol_caches.leaderboard.rows;
-  out->count = g_server_protocol_caches.leaderboard.count;
-  out->self_rank = g_server_protocol_caches.leaderboard.self_rank;
-  out->self_in_rows = g_server_protocol_caches.leaderboard.self_in_rows;
-  out->self = g_server_protocol_caches.leaderboard.self;
-  out->total_count = g_server_protocol_caches.leaderboard.total_count;
+  out->rows = v->rows;
+  out->count = v->count;
+  out->self_rank = v->self_rank;
+  out->self_in_rows = v->self_in_rows;
+  out->self = v->self;
+  out->total_count = v->total_count;
   return 1;
 }
 
@@ -682,40 +568,6 @@ static int is_valid_stats_handle(const char *handle) {
   return 1;
 }
 
-static int ensure_rate_limit_entries(void) {
-  if (g_rate_limit_entries && g_rate_limit_capacity > 0)
-    return 0;
-  RequestRateLimitEntry *next = calloc(1, sizeof(*next));
-  if (!next)
-    return -1;
-  g_rate_limit_entries = next;
-  g_rate_limit_capacity = 1;
-  return 0;
-}
-
-static RequestRateLimitEntry *grow_rate_limit_entries(void) {
-  int max_capacity = get_config()->max_players;
-  if (max_capacity < 1)
-    max_capacity = 1;
-  int old_capacity = g_rate_limit_capacity;
-  if (old_capacity >= max_capacity)
-    return NULL;
-  int new_capacity = old_capacity > 0 ? old_capacity * 2 : 1;
-  if (new_capacity > max_capacity)
-    new_capacity = max_capacity;
-  if (new_capacity <= old_capacity)
-    return NULL;
-  RequestRateLimitEntry *next = (RequestRateLimitEntry *)realloc(
-      g_rate_limit_entries, (size_t)new_capacity * sizeof(*next));
-  if (!next)
-    return NULL;
-  memset(&next[old_capacity], 0,
-         (size_t)(new_capacity - old_capacity) * sizeof(*next));
-  g_rate_limit_entries = next;
-  g_rate_limit_capacity = new_capacity;
-  return &g_rate_limit_entries[old_capacity];
-}
-
 static LoginChallengeEntry *grow_login_challenge_entries(void) {
   int old_capacity = g_login_challenge_capacity;
   int new_capacity = old_capacity > 0 ? old_capacity * 2 : 1;
@@ -824,6 +676,17 @@ void server_protocol_test_clear_login_challenges(void) {
            sizeof(g_login_challenge_entries[i]));
 }
 
+void server_protocol_thread_cleanup(void) {
+  free(g_login_challenge_entries);
+  g_login_challenge_entries = NULL;
+  g_login_challenge_capacity = 0;
+  free(g_pending_logins);
+  g_pending_logins = NULL;
+  g_pending_login_count = 0;
+  g_pending_login_capacity = 0;
+  login_verify_thread_discard();
+}
+
 int server_protocol_thread_pending_login_challenge_count(void) {
   if (!g_login_challenge_entries || g_login_challenge_capacity <= 0)
     return 0;
@@ -836,35 +699,59 @@ int server_protocol_thread_pending_login_challenge_count(void) {
   return count;
 }
 
-static int verify_login_proof(const struct WambleMsg *msg) {
-  if (!msg)
+static int prepare_login_proof(const struct WambleMsg *msg,
+                               uint8_t *sign_message, size_t sign_message_cap,
+                               size_t *sign_message_len) {
+  if (!msg || !sign_message_len)
     return -1;
   LoginChallengeEntry *entry = find_login_challenge_entry(msg->token, NULL);
   if (!entry || !entry->used)
     return -1;
-  int verified = 0;
+  *sign_message_len = 0;
   if (memcmp(entry->public_key, msg->login.public_key,
-             WAMBLE_PUBLIC_KEY_LENGTH) != 0) {
-    goto done;
+             WAMBLE_PUBLIC_KEY_LENGTH) == 0 &&
+      login_challenge_is_fresh(entry->issued_at_ms)) {
+    *sign_message_len = wamble_build_login_signature_message(
+        sign_message, sign_message_cap, msg->token, msg->login.public_key,
+        entry->challenge);
   }
-  if (!login_challenge_is_fresh(entry->issued_at_ms))
-    goto done;
+  memset(entry, 0, sizeof(*entry));
+  return *sign_message_len ? 0 : -1;
+}
 
-  uint8_t sign_message[128];
-  size_t sign_message_len = wamble_build_login_signature_message(
-      sign_message, sizeof(sign_message), msg->token, msg->login.public_key,
-      entry->challenge);
-  if (sign_message_len == 0)
-    goto done;
-
-  verified = (crypto_eddsa_check(msg->login.signature, msg->login.public_key,
-                                 sign_message, sign_message_len) == 0)
-                 ? 1
-                 : 0;
-
-done:
+static int track_pending_login(uint64_t ticket, const struct WambleMsg *msg,
+                               const struct sockaddr_in *cliaddr) {
+  if (g_pending_login_count >= g_pending_login_capacity) {
+    int next_capacity =
+        g_pending_login_capacity > 0 ? g_pending_login_capacity * 2 : 8;
+    PendingLoginEntry *next = (PendingLoginEntry *)realloc(
+        g_pending_logins, (size_t)next_capacity * sizeof(*next));
+    if (!next)
+      return -1;
+    g_pending_logins = next;
+    g_pending_login_capacity = next_capacity;
+  }
+  PendingLoginEntry *entry = &g_pending_logins[g_pending_login_count++];
   memset(entry, 0, sizeof(*entry));
-  return verified ? 0 : -1;
+  entry->ticket = ticket;
+  entry->cliaddr = *cliaddr;
+  memcpy(entry->token, msg->token, TOKEN_LENGTH);
+  memcpy(entry->public_key, msg->login.public_key, WAMBLE_PUBLIC_KEY_LENGTH);
+  entry->board_id = msg->board_id;
+  entry->seq_num = msg->seq_num;
+  entry->flags = msg->flags;
+  return 0;
+}
+
+static int take_pending_login(uint64_t ticket, PendingLoginEntry *out) {
+  for (int i = 0; i < g_pending_login_count; i++) {
+    if (g_pending_logins[i].ticket != ticket)
+      continue;
+    *out = g_pending_logins[i];
+    g_pending_logins[i] = g_pending_logins[--g_pending_login_count];
+    return 0;
+  }
+  return -1;
 }
 
 static ServerStatus complete_request_after_terminal_response(
@@ -1043,37 +930,105 @@ int server_protocol_enqueue_reliable_spectate_state_sync(
       token, cliaddr, state);
 }
 
+static void spectator_batch_build_message(const SpectatorUpdate *event,
+                                          uint8_t ctrl,
+                                          struct WambleMsg *out) {
+  memset(out, 0, sizeof(*out));
+  out->ctrl = ctrl;
+  memcpy(out->token, event->token, TOKEN_LENGTH);
+  out->board_id = event->board_id;
+  out->seq_num = 0;
+  out->flags = (uint8_t)(event->flags | WAMBLE_FLAG_UNRELIABLE);
+  out->session.notification_type = event->notification_type;
+  {
+    size_t len = strnlen(event->fen, FEN_MAX_LENGTH - 1);
+    memcpy(out->view.fen, event->fen, len);
+    out->view.fen[len] = '\0';
+  }
+  if (ctrl == WAMBLE_CTRL_SPECTATE_UPDATE && event->summary_generation > 0) {
+    out->extensions.count = 1;
+    snprintf(out->extensions.fields[0].key,
+             sizeof(out->extensions.fields[0].key), "%s",
+             "spectate.summary_generation");
+    out->extensions.fields[0].value_type = WAMBLE_TREATMENT_VALUE_INT;
+    out->extensions.fields[0].int_value = (int64_t)event->summary_generation;
+  }
+  if (ctrl == WAMBLE_CTRL_SPECTATE_UPDATE &&
+      event->summary_base_generation > 0) {
+    uint8_t idx = out->extensions.count++;
+    snprintf(out->extensions.fields[idx].key,
+             sizeof(out->extensions.fields[idx].key), "%s",
+             "spectate.summary_base");
+    out->extensions.fields[idx].value_type = WAMBLE_TREATMENT_VALUE_INT;
+    out->extensions.fields[idx].int_value =
+        (int64_t)event->summary_base_generation;
+  }
+}
+
+static uint64_t spectator_batch_payload_hash(const SpectatorUpdate *event) {
+  uint64_t h = 1469598103934665603ULL;
+  h = (h ^ event->board_id) * 1099511628211ULL;
+  h = (h ^ event->summary_generation) * 1099511628211ULL;
+  h = (h ^ event->summary_base_generation) * 1099511628211ULL;
+  h = (h ^ event->flags) * 1099511628211ULL;
+  h = (h ^ event->notification_type) * 1099511628211ULL;
+  for (size_t i = 0; i < FEN_MAX_LENGTH && event->fen[i]; i++)
+    h = (h ^ (uint8_t)event->fen[i]) * 1099511628211ULL;
+  return h;
+}
+
+static int spectator_batch_same_payload(const SpectatorUpdate *a,
+                                        const SpectatorUpdate *b) {
+  return a->board_id == b->board_id && a->flags == b->flags &&
+         a->notification_type == b->notification_type &&
+         a->summary_generation == b->summary_generation &&
+         a->summary_base_generation == b->summary_base_generation &&
+         strncmp(a->fen, b->fen, FEN_MAX_LENGTH) == 0;
+}
+
+typedef struct SpectatorBatchSlot {
+  int event_index;
+  TransportSharedPayload *shared;
+} SpectatorBatchSlot;
+
 int server_protocol_enqueue_spectator_batch(SpectatorUpdate *events, int count,
                                             uint8_t ctrl) {
   int rc = 0;
   if (!events || count <= 0)
     return 0;
+  size_t cap = 16;
+  while (cap < (size_t)count * 2u)
+    cap <<= 1;
+  SpectatorBatchSlot *slots =
+      (SpectatorBatchSlot *)malloc(cap * sizeof(*slots));
+  if (!slots)
+    return -1;
+  for (size_t s = 0; s < cap; s++)
+    slots[s].event_index = -1;
+
   for (int i = 0; i < count; i++) {
-    struct WambleMsg out = {0};
-    out.ctrl = ctrl;
-    memcpy(out.token, events[i].token, TOKEN_LENGTH);
-    out.board_id = events[i].board_id;
-    out.seq_num = 0;
-    out.flags = (uint8_t)(events[i].flags | WAMBLE_FLAG_UNRELIABLE);
-    out.session.notification_type = events[i].notification_type;
-    {
-      size_t len = strnlen(events[i].fen, FEN_MAX_LENGTH - 1);
-      memcpy(out.view.fen, events[i].fen, len);
-      out.view.fen[len] = '\0';
-    }
-    if (ctrl == WAMBLE_CTRL_SPECTATE_UPDATE &&
-        events[i].summary_generation > 0) {
-      out.extensions.count = 1;
-      snprintf(out.extensions.fields[0].key,
-               sizeof(out.extensions.fields[0].key), "%s",
-               "spectate.summary_generation");
-      out.extensions.fields[0].value_type = WAMBLE_TREATMENT_VALUE_INT;
-      out.extensions.fields[0].int_value =
-          (int64_t)events[i].summary_generation;
+    size_t s = (size_t)spectator_batch_payload_hash(&events[i]) & (cap - 1);
+    while (slots[s].event_index >= 0 &&
+           !spectator_batch_same_payload(&events[slots[s].event_index],
+                                         &events[i]))
+      s = (s + 1) & (cap - 1);
+    if (slots[s].event_index < 0) {
+      struct WambleMsg out;
+      spectator_batch_build_message(&events[i], ctrl, &out);
+      slots[s].event_index = i;
+      slots[s].shared = network_shared_payload_create(&out);
     }
-    if (network_enqueue_unreliable(&out, &events[i].addr) != 0)
+    if (!slots[s].shared ||
+        network_enqueue_unreliable_shared(slots[s].shared, events[i].token,
+                                          &events[i].addr) != 0)
       rc = -1;
   }
+
+  for (size_t s = 0; s < cap; s++) {
+    if (slots[s].event_index >= 0)
+      network_shared_payload_release(slots[s].shared);
+  }
+  free(slots);
   return rc;
 }
 
@@ -1378,53 +1333,6 @@ static DiscoverPolicyDecision resolve_discovery_policy_for_action(
   return DISCOVER_POLICY_NO_RULE;
 }
 
-static int rate_limit_allowed(const uint8_t *token, int max_per_sec) {
-  if (!token || max_per_sec <= 0)
-    return 1;
-  if (ensure_rate_limit_entries() != 0)
-    return 0;
-  uint64_t now = wamble_now_mono_millis();
-  int match_idx = -1;
-  int free_idx = -1;
-  for (int i = 0; i < g_rate_limit_capacity; i++) {
-    RequestRateLimitEntry *e = &g_rate_limit_entries[i];
-    if (e->used && now >= e->window_start_ms + 1000) {
-      memset(e, 0, sizeof(*e));
-    }
-    if (!e->used) {
-      if (free_idx < 0)
-        free_idx = i;
-      continue;
-    }
-    if (tokens_equal(e->token, token)) {
-      match_idx = i;
-      break;
-    }
-  }
-
-  RequestRateLimitEntry *entry = NULL;
-  if (match_idx >= 0) {
-    entry = &g_rate_limit_entries[match_idx];
-    if (now >= entry->window_start_ms + 1000) {
-      entry->window_start_ms = now;
-      entry->count = 0;
-    }
-  } else {
-    entry = free_idx >= 0 ? &g_rate_limit_entries[free_idx]
-                          : grow_rate_limit_entries();
-    if (!entry)
-      return 0;
-    entry->used = 1;
-    memcpy(entry->token, token, TOKEN_LENGTH);
-    entry->window_start_ms = now;
-    entry->count = 0;
-  }
-  if (entry->count >= max_per_sec)
-    return 0;
-  entry->count++;
-  return 1;
-}
-
 static const uint8_t *
 rate_limit_key_for_message(const struct WambleMsg *msg,
                            const struct sockaddr_in *cliaddr,
@@ -1795,63 +1703,238 @@ static int profile_terms_currently_accepted(const uint8_t *token,
                                             const char *profile_name);
 static uint32_t compute_profile_ui_caps(const uint8_t *token,
                                         const WambleProfile *p);
+static int profile_terms_required_for_profile(const WambleProfile *profile);
+static int set_ext_int_if_present(struct WambleMsg *msg, const char *key,
+                                  int64_t value);
 static uint32_t append_session_capability_extensions(struct WambleMsg *msg,
                                                      const uint8_t *token,
                                                      const char *profile_name,
                                                      const WambleBoard *board);
 
+typedef struct {
+  const char *name;
+  const WambleProfile *profile;
+  size_t name_len;
+  struct WambleMsg info;
+} ProfileCatalogEntry;
+
+typedef struct {
+  int ready;
+  uintptr_t config_identity;
+  uint64_t generation;
+  ProfileCatalogEntry *entries;
+  int count;
+  int *tiers;
+  char **tier_payloads;
+  size_t *tier_payload_lens;
+  int tier_count;
+  int discovery_uniform;
+} ProfileCatalog;
+
+static WAMBLE_THREAD_LOCAL ProfileCatalog g_profile_catalog;
+
+static int compare_catalog_entries(const void *a, const void *b) {
+  const ProfileCatalogEntry *lhs = (const ProfileCatalogEntry *)a;
+  const ProfileCatalogEntry *rhs = (const ProfileCatalogEntry *)b;
+  return compare_cstr_ptrs(&lhs->name, &rhs->name);
+}
+
+static void profile_catalog_free(ProfileCatalog *c) {
+  for (int i = 0; i < c->tier_count; i++)
+    free(c->tier_payloads[i]);
+  free(c->tier_payloads);
+  free(c->tier_payload_lens);
+  free(c->tiers);
+  free(c->entries);
+  memset(c, 0, sizeof(*c));
+}
+
+static int profile_catalog_baseline_visible(const ProfileCatalogEntry *e,
+                                            int trust_tier) {
+  return e->profile->advertise && trust_tier >= e->profile->visibility;
+}
+
+static void profile_catalog_fill_info(ProfileCatalogEntry *e) {
+  const WambleProfile *p = e->profile;
+  struct WambleMsg *info = &e->info;
+  const char *ws_path = effective_profile_websocket_path(p);
+  int wrote = snprintf(info->text.profile_info, FEN_MAX_LENGTH, "%s;%d;%d;%d",
+                       e->name, p->config.port, p->advertise, p->visibility);
+  if (wrote < 0)
+    wrote = 0;
+  if (wrote >= FEN_MAX_LENGTH)
+    wrote = FEN_MAX_LENGTH - 1;
+  info->ctrl = WAMBLE_CTRL_PROFILE_INFO;
+  info->text.profile_info_len = (uint16_t)wrote;
+  (void)append_ext_int(info, "profile.caps", 0);
+  (void)append_ext_int(info, "profile.tos_available",
+                       (int64_t)profile_terms_required_for_profile(p));
+  (void)append_ext_int(info, "profile.tos_accepted", 0);
+  (void)append_ext_int(info, "profile.websocket_port",
+                       (int64_t)effective_profile_websocket_port(p));
+  if (ws_path)
+    (void)append_ext_string(info, "profile.websocket_path", ws_path);
+  (void)append_ext_int(info, "profile.reservation_timeout",
+                       (int64_t)p->config.reservation_timeout);
+}
+
+static int profile_catalog_build_tiers(ProfileCatalog *c) {
+  if (c->count == 0)
+    return 0;
+  c->tiers = (int *)malloc(sizeof(*c->tiers) * (size_t)c->count);
+  c->tier_payloads = (char **)calloc((size_t)c->count, sizeof(char *));
+  c->tier_payload_lens = (size_t *)calloc((size_t)c->count, sizeof(size_t));
+  if (!c->tiers || !c->tier_payloads || !c->tier_payload_lens)
+    return -1;
+  for (int i = 0; i < c->count; i++) {
+    const WambleProfile *p = c->entries[i].profile;
+    if (!p->advertise)
+      continue;
+    int k = 0;
+    while (k < c->tier_count && c->tiers[k] < p->visibility)
+      k++;
+    if (k < c->tier_count && c->tiers[k] == p->visibility)
+      continue;
+    memmove(&c->tiers[k + 1], &c->tiers[k],
+            sizeof(*c->tiers) * (size_t)(c->tier_count - k));
+    c->tiers[k] = p->visibility;
+    c->tier_count++;
+  }
+  for (int k = 0; k < c->tier_count; k++) {
+    size_t len = 0;
+    for (int i = 0; i < c->count; i++) {
+      if (profile_catalog_baseline_visible(&c->entries[i], c->tiers[k]))
+        len += c->entries[i].name_len + (len ? 1u : 0u);
+    }
+    char *payload = (char *)malloc(len + 1u);
+    if (!payload)
+      return -1;
+    size_t written = 0;
+    for (int i = 0; i < c->count; i++) {
+      const ProfileCatalogEntry *e = &c->entries[i];
+      if (!profile_catalog_baseline_visible(e, c->tiers[k]))
+        continue;
+      if (written > 0)
+        payload[written++] = ',';
+      memcpy(payload + written, e->name, e->name_len);
+      written += e->name_len;
+    }
+    payload[written] = '\0';
+    c->tier_payloads[k] = payload;
+    c->tier_payload_lens[k] = written;
+  }
+  return 0;
+}
+
+static int profile_catalog_discovery_uniform(void) {
+  int overrides = 1;
+  int scoped_trust = 1;
+  if (wamble_query_policy_action_has_rules("profile.discover.override", 0,
+                                           &overrides) != DB_OK ||
+      wamble_query_policy_action_has_rules("trust.tier", 1, &scoped_trust) !=
+          DB_OK)
+    return 0;
+  return !overrides && !scoped_trust;
+}
+
+static const ProfileCatalog *profile_catalog_current(void) {
+  ProfileCatalog *c = &g_profile_catalog;
+  uintptr_t config_identity = (uintptr_t)get_config();
+  uint64_t generation =
+      response_cache_generation(WAMBLE_RESPONSE_CACHE_PROFILES_LIST);
+  if (c->ready && c->config_identity == config_identity &&
+      c->generation == generation)
+    return c;
+  profile_catalog_free(c);
+  int count = config_profile_count();
+  if (count > 0) {
+    c->entries = (ProfileCatalogEntry *)calloc((size_t)count,
+                                               sizeof(*c->entries));
+    if (!c->entries)
+      return NULL;
+  }
+  for (int i = 0; i < count; i++) {
+    const WambleProfile *p = config_get_profile(i);
+    if (!p || p->abstract)
+      continue;
+    ProfileCatalogEntry *e = &c->entries[c->count++];
+    e->profile = p;
+    e->name = p->name ? p->name : "";
+    e->name_len = strlen(e->name);
+  }
+  if (c->count > 1)
+    qsort(c->entries, (size_t)c->count, sizeof(*c->entries),
+          compare_catalog_entries);
+  for (int i = 0; i < c->count; i++)
+    profile_catalog_fill_info(&c->entries[i]);
+  if (profile_catalog_build_tiers(c) != 0) {
+    profile_catalog_free(c);
+    return NULL;
+  }
+  c->discovery_uniform = profile_catalog_discovery_uniform();
+  c->config_identity = config_identity;
+  c->generation = generation;
+  c->ready = 1;
+  return c;
+}
+
+static const ProfileCatalogEntry *
+profile_catalog_find(const ProfileCatalog *c, const char *name) {
+  if (!c || !name || c->count == 0)
+    return NULL;
+  ProfileCatalogEntry probe;
+  probe.name = name;
+  return (const ProfileCatalogEntry *)bsearch(&probe, c->entries,
+                                              (size_t)c->count,
+                                              sizeof(*c->entries),
+                                              compare_catalog_entries);
+}
+
+static const char *profile_catalog_tier_payload(const ProfileCatalog *c,
+                                                int trust_tier,
+                                                size_t *out_len) {
+  int k = -1;
+  while (k + 1 < c->tier_count && c->tiers[k + 1] <= trust_tier)
+    k++;
+  *out_len = k >= 0 ? c->tier_payload_lens[k] : 0;
+  return k >= 0 ? c->tier_payloads[k] : "";
+}
+
 static void fill_profile_info_response(struct WambleMsg *resp,
                                        const uint8_t *token, const char *name,
                                        const char *bound_profile_name,
                                        int effective_trust_tier) {
+  const ProfileCatalogEntry *entry = NULL;
   const WambleProfile *p = NULL;
   int wrote = 0;
   if (!resp || !token || !name)
     return;
-  if (profile_info_cache_lookup(token, name, bound_profile_name,
-                                effective_trust_tier, resp))
-    return;
-  resp->ctrl = WAMBLE_CTRL_PROFILE_INFO;
-  memcpy(resp->token, token, TOKEN_LENGTH);
-  p = config_find_profile(name);
-  if (p && profile_terms_route_allowed(token, p, name, bound_profile_name,
-                                       effective_trust_tier)) {
-    int ws_port = effective_profile_websocket_port(p);
-    const char *ws_path = effective_profile_websocket_path(p);
-    wrote = snprintf(resp->text.profile_info, FEN_MAX_LENGTH, "%s;%d;%d;%d",
-                     p->name, p->config.port, p->advertise, p->visibility);
-    if (wrote < 0)
-      wrote = 0;
-    if (wrote >= FEN_MAX_LENGTH)
-      wrote = FEN_MAX_LENGTH - 1;
-    resp->text.profile_info_len = (uint16_t)wrote;
-    (void)append_ext_int(resp, "profile.caps",
-                         (int64_t)compute_profile_ui_caps(token, p));
-    (void)append_ext_int(resp, "profile.tos_available",
-                         (int64_t)((p->tos_text && p->tos_text[0]) ? 1 : 0));
-    (void)append_ext_int(
+  entry = profile_catalog_find(profile_catalog_current(), name);
+  p = entry ? entry->profile : config_find_profile(name);
+  if (entry && profile_terms_route_allowed(token, p, name, bound_profile_name,
+                                           effective_trust_tier)) {
+    *resp = entry->info;
+    memcpy(resp->token, token, TOKEN_LENGTH);
+    (void)set_ext_int_if_present(resp, "profile.caps",
+                                 (int64_t)compute_profile_ui_caps(token, p));
+    (void)set_ext_int_if_present(
         resp, "profile.tos_accepted",
         (int64_t)profile_terms_currently_accepted(token, p->name));
-    (void)append_ext_int(resp, "profile.websocket_port", (int64_t)ws_port);
-    if (ws_path)
-      (void)append_ext_string(resp, "profile.websocket_path", ws_path);
-    (void)append_ext_int(resp, "profile.reservation_timeout",
-                         (int64_t)p->config.reservation_timeout);
-  } else {
-    publish_server_protocol_status(
-        p ? SERVER_PROTOCOL_STATUS_PROFILE_INFO_HIDDEN
-          : SERVER_PROTOCOL_STATUS_PROFILE_INFO_NOT_FOUND,
-        name);
-    wrote = snprintf(resp->text.profile_info, FEN_MAX_LENGTH, "NOTFOUND;%.80s",
-                     name);
-    if (wrote < 0)
-      wrote = 0;
-    if (wrote >= FEN_MAX_LENGTH)
-      wrote = FEN_MAX_LENGTH - 1;
-    resp->text.profile_info_len = (uint16_t)wrote;
+    return;
   }
-  profile_info_cache_store(token, name, bound_profile_name,
-                           effective_trust_tier, resp);
+  resp->ctrl = WAMBLE_CTRL_PROFILE_INFO;
+  memcpy(resp->token, token, TOKEN_LENGTH);
+  publish_server_protocol_status(
+      p ? SERVER_PROTOCOL_STATUS_PROFILE_INFO_HIDDEN
+        : SERVER_PROTOCOL_STATUS_PROFILE_INFO_NOT_FOUND,
+      name);
+  wrote =
+      snprintf(resp->text.profile_info, FEN_MAX_LENGTH, "NOTFOUND;%.80s", name);
+  if (wrote < 0)
+    wrote = 0;
+  if (wrote >= FEN_MAX_LENGTH)
+    wrote = FEN_MAX_LENGTH - 1;
+  resp->text.profile_info_len = (uint16_t)wrote;
 }
 
 static int set_ext_int_if_present(struct WambleMsg *msg, const char *key,
@@ -2452,12 +2535,15 @@ static ServerStatus handle_client_hello(wamble_socket_t sockfd,
     return SERVER_ERR_UNSUPPORTED_VERSION;
   }
 
-  const uint8_t supported_caps =
+  const uint8_t default_caps =
       (uint8_t)(WAMBLE_CAP_HOT_RELOAD | WAMBLE_CAP_PROFILE_STATE);
+  const uint8_t supported_caps =
+      (uint8_t)(default_caps | WAMBLE_CAP_SELECTIVE_ACK |
+                WAMBLE_CAP_PAYLOAD_COMPRESSION);
   uint8_t requested_caps = (uint8_t)(msg->flags & WAMBLE_CAPABILITY_MASK);
   uint8_t negotiated_caps = requested_caps
                                 ? (uint8_t)(requested_caps & supported_caps)
-                                : supported_caps;
+                                : default_caps;
 
   WamblePlayer *player = NULL;
   if (token_has_any_byte(msg->token))
@@ -2488,6 +2574,10 @@ static ServerStatus handle_client_hello(wamble_socket_t sockfd,
                                "could not persist player session", NULL, 0);
   }
 
+  if (network_set_endpoint_capabilities(cliaddr, player->token,
+                                        negotiated_caps) != 0)
+    return SERVER_ERR_SEND_FAILED;
+
   struct WambleMsg response = {0};
   response.flags = negotiated_caps;
   response.header_version = WAMBLE_PROTO_VERSION;
@@ -2528,6 +2618,7 @@ static ServerStatus handle_logout(const struct WambleMsg *msg,
   clear_login_challenge(msg->token);
   if (detach_persistent_identity(msg->token) != 0)
     return SERVER_ERR_INTERNAL;
+  server_protocol_cache_forget_token(msg->token);
   spectator_discard_by_token(msg->token);
   discard_player_by_token(msg->token);
   return SERVER_OK;
@@ -2580,7 +2671,7 @@ static ServerStatus handle_player_move(wamble_socket_t sockfd,
 
   wamble_emit_record_move(board->id, player->token, uci_move,
                           board->board.fullmove_number);
-  (void)prediction_resolve_move(board, uci_move);
+  (void)prediction_resolve_move_deferred(board, uci_move);
 
   board_move_played(board->id, player->token, uci_move);
   board_release_reservation(board->id);
@@ -2707,77 +2798,96 @@ static ServerStatus handle_list_profiles(wamble_socket_t sockfd,
       SERVER_PROTOCOL_STATUS_PROFILES_LIST_SERVED, wamble_runtime_profile_key(),
       detail);
 
-  const uint8_t *cached_payload = NULL;
-  size_t cached_payload_len = 0;
+  const ProfileCatalog *catalog = profile_catalog_current();
+  if (!catalog)
+    return SERVER_ERR_SEND_FAILED;
+  const uint8_t *cached = NULL;
+  size_t cached_len = 0;
   uintptr_t config_identity = (uintptr_t)cfg;
-  if (profiles_list_cache_lookup(msg->token, config_identity,
-                                 effective_trust_tier, &cached_payload,
-                                 &cached_payload_len)) {
-    (void)sockfd;
-    if (network_enqueue_reliable_payload_bytes(
-            WAMBLE_CTRL_PROFILES_LIST, msg->token, 0, cached_payload,
-            cached_payload_len, cliaddr, cfg->timeout_ms, cfg->max_retries,
-            cached_payload_len > (size_t)(FEN_MAX_LENGTH - 1)) != 0) {
-      return SERVER_ERR_SEND_FAILED;
+  const char *payload = NULL;
+  char *custom = NULL;
+  size_t written = 0;
+  if (catalog->discovery_uniform) {
+    payload =
+        profile_catalog_tier_payload(catalog, effective_trust_tier, &written);
+  } else if (profiles_list_cache_lookup(msg->token, config_identity,
+                                        effective_trust_tier, &cached,
+                                        &cached_len) &&
+             cached_len > 0) {
+    if (cached[0] == PROFILES_LIST_CACHE_BASELINE) {
+      payload =
+          profile_catalog_tier_payload(catalog, effective_trust_tier, &written);
+    } else {
+      payload = (const char *)cached + 1;
+      written = cached_len - 1u;
     }
-    return SERVER_OK;
   }
 
-  int count = config_profile_count();
-  const char **names =
-      count > 0 ? (const char **)calloc((size_t)count, sizeof(*names)) : NULL;
-  int name_count = 0;
-  size_t payload_len = 0;
-  if (count > 0 && !names)
-    return SERVER_ERR_SEND_FAILED;
-  for (int i = 0; i < count; i++) {
-    const WambleProfile *p = config_get_profile(i);
-    if (!p)
-      continue;
-    if (!profile_discovery_allowed(msg->token, p, effective_trust_tier))
-      continue;
-    const char *name = p->name ? p->name : "";
-    names[name_count++] = name;
-    payload_len += strlen(name) + (payload_len ? 1u : 0u);
-  }
-  if (name_count > 1)
-    qsort(names, (size_t)name_count, sizeof(*names), compare_cstr_ptrs);
-
-  char *payload = payload_len > 0 ? (char *)malloc(payload_len + 1) : NULL;
-  size_t written = 0;
-  if (payload_len > 0 && !payload) {
-    free(names);
-    return SERVER_ERR_SEND_FAILED;
-  }
+  if (!payload) {
+    uint8_t allowed_stack[64];
+    uint8_t *allowed = allowed_stack;
+    if (catalog->count > (int)sizeof(allowed_stack)) {
+      allowed = (uint8_t *)malloc((size_t)catalog->count);
+      if (!allowed)
+        return SERVER_ERR_SEND_FAILED;
+    }
+    int baseline = 1;
+    size_t payload_len = 0;
+    for (int i = 0; i < catalog->count; i++) {
+      const ProfileCatalogEntry *e = &catalog->entries[i];
+      allowed[i] = (uint8_t)profile_discovery_allowed(msg->token, e->profile,
+                                                      effective_trust_tier);
+      if (allowed[i] !=
+          profile_catalog_baseline_visible(e, effective_trust_tier))
+        baseline = 0;
+      if (allowed[i])
+        payload_len += e->name_len + (payload_len ? 1u : 0u);
+    }
 
-  for (int i = 0; i < name_count; i++) {
-    const char *name = names[i];
-    size_t name_len = strlen(name);
-    if (written > 0)
-      payload[written++] = ',';
-    if (name_len > 0) {
-      memcpy(payload + written, name, name_len);
-      written += name_len;
+    if (baseline) {
+      static const uint8_t marker = PROFILES_LIST_CACHE_BASELINE;
+      payload =
+          profile_catalog_tier_payload(catalog, effective_trust_tier, &written);
+      profiles_list_cache_store(msg->token, config_identity,
+                                effective_trust_tier, &marker, 1);
+    } else {
+      custom = (char *)malloc(payload_len + 2u);
+      if (!custom) {
+        if (allowed != allowed_stack)
+          free(allowed);
+        return SERVER_ERR_SEND_FAILED;
+      }
+      custom[0] = (char)PROFILES_LIST_CACHE_CUSTOM;
+      char *names = custom + 1;
+      for (int i = 0; i < catalog->count; i++) {
+        const ProfileCatalogEntry *e = &catalog->entries[i];
+        if (!allowed[i])
+          continue;
+        if (written > 0)
+          names[written++] = ',';
+        memcpy(names + written, e->name, e->name_len);
+        written += e->name_len;
+      }
+      names[written] = '\0';
+      payload = names;
+      profiles_list_cache_store(msg->token, config_identity,
+                                effective_trust_tier, (const uint8_t *)custom,
+                                written + 1u);
     }
+    if (allowed != allowed_stack)
+      free(allowed);
   }
-  if (payload)
-    payload[written] = '\0';
-
-  profiles_list_cache_store(msg->token, config_identity, effective_trust_tier,
-                            (const uint8_t *)payload, written);
 
   (void)sockfd;
+  ServerStatus status = SERVER_OK;
   if (network_enqueue_reliable_payload_bytes(
           WAMBLE_CTRL_PROFILES_LIST, msg->token, 0, (const uint8_t *)payload,
           written, cliaddr, cfg->timeout_ms, cfg->max_retries,
           written > (size_t)(FEN_MAX_LENGTH - 1)) != 0) {
-    free(payload);
-    free(names);
-    return SERVER_ERR_SEND_FAILED;
+    status = SERVER_ERR_SEND_FAILED;
   }
-  free(payload);
-  free(names);
-  return SERVER_OK;
+  free(custom);
+  return status;
 }
 
 static ServerStatus handle_get_profile_info(wamble_socket_t sockfd,
@@ -3318,7 +3428,6 @@ static ServerStatus handle_accept_profile_tos(wamble_socket_t sockfd,
   }
 
   profile_terms_cache_invalidate(msg->token, name, tos_hash);
-  profile_info_cache_invalidate(msg->token, name);
   session_caps_cache_invalidate(msg->token, name);
   {
     char detail[160];
@@ -3351,38 +3460,67 @@ static int login_has_pubkey(const struct WambleMsg *msg) {
   return 0;
 }
 
+static ServerStatus login_failed_response(const struct sockaddr_in *cliaddr,
+                                          const uint8_t *token,
+                                          const char *profile_name) {
+  struct WambleMsg response = {0};
+  memcpy(response.token, token, TOKEN_LENGTH);
+  publish_server_protocol_status(SERVER_PROTOCOL_STATUS_LOGIN_FAILED,
+                                 profile_name);
+  response.ctrl = WAMBLE_CTRL_LOGIN_FAILED;
+  response.view.error_code = WAMBLE_ERR_ACCESS_DENIED;
+  if (network_enqueue_replayable_terminal(&response, cliaddr) != 0)
+    return SERVER_ERR_SEND_FAILED;
+  return SERVER_ERR_LOGIN_FAILED;
+}
+
+static ServerStatus finish_login_request(const struct sockaddr_in *cliaddr,
+                                         const uint8_t *token,
+                                         const uint8_t *public_key,
+                                         const char *profile_name) {
+  struct WambleMsg response = {0};
+  memcpy(response.token, token, TOKEN_LENGTH);
+  WamblePlayer *player = attach_persistent_identity(token, public_key);
+  if (!player)
+    return login_failed_response(cliaddr, token, profile_name);
+  server_protocol_cache_forget_token(token);
+  server_protocol_cache_forget_token(player->token);
+  publish_server_protocol_status(SERVER_PROTOCOL_STATUS_LOGIN_SUCCESS,
+                                 profile_name);
+  response.ctrl = WAMBLE_CTRL_LOGIN_SUCCESS;
+  memcpy(response.token, player->token, TOKEN_LENGTH);
+  append_profile_session_snapshot(&response, player->token, profile_name);
+  {
+    WambleBoard *board = find_board_for_player(player);
+    if (board) {
+      append_last_move_extensions(&response, player->token, profile_name,
+                                  board);
+    }
+  }
+  if (network_enqueue_replayable_terminal(&response, cliaddr) != 0) {
+    return SERVER_ERR_SEND_FAILED;
+  }
+  return SERVER_OK;
+}
+
 static ServerStatus handle_login_request(wamble_socket_t sockfd,
                                          const struct sockaddr_in *cliaddr,
                                          const struct WambleMsg *msg,
-                                         const char *profile_name) {
-  (void)sockfd;
+                                         const char *profile_name,
+                                         int *deferred) {
   struct WambleMsg response = {0};
   memcpy(response.token, msg->token, TOKEN_LENGTH);
 
   WamblePlayer *existing = get_player_by_token(msg->token);
   int has_key = login_has_pubkey(msg);
-  if (!existing || !has_key) {
-    publish_server_protocol_status(SERVER_PROTOCOL_STATUS_LOGIN_FAILED,
-                                   profile_name);
-    response.ctrl = WAMBLE_CTRL_LOGIN_FAILED;
-    response.view.error_code = WAMBLE_ERR_ACCESS_DENIED;
-    if (network_enqueue_replayable_terminal(&response, cliaddr) != 0)
-      return SERVER_ERR_SEND_FAILED;
-    return SERVER_ERR_LOGIN_FAILED;
-  }
+  if (!existing || !has_key)
+    return login_failed_response(cliaddr, msg->token, profile_name);
 
   if (!msg->login.has_signature) {
     response.ctrl = WAMBLE_CTRL_LOGIN_CHALLENGE;
     if (issue_login_challenge(msg->token, msg->login.public_key,
-                              response.login.challenge) != 0) {
-      publish_server_protocol_status(SERVER_PROTOCOL_STATUS_LOGIN_FAILED,
-                                     profile_name);
-      response.ctrl = WAMBLE_CTRL_LOGIN_FAILED;
-      response.view.error_code = WAMBLE_ERR_ACCESS_DENIED;
-      if (network_enqueue_replayable_terminal(&response, cliaddr) != 0)
-        return SERVER_ERR_SEND_FAILED;
-      return SERVER_ERR_LOGIN_FAILED;
-    }
+                              response.login.challenge) != 0)
+      return login_failed_response(cliaddr, msg->token, profile_name);
     publish_server_protocol_status(
         SERVER_PROTOCOL_STATUS_LOGIN_CHALLENGE_ISSUED, profile_name);
     if (network_enqueue_replayable_terminal(&response, cliaddr) != 0)
@@ -3390,41 +3528,47 @@ static ServerStatus handle_login_request(wamble_socket_t sockfd,
     return SERVER_OK;
   }
 
-  if (verify_login_proof(msg) != 0) {
-    publish_server_protocol_status(SERVER_PROTOCOL_STATUS_LOGIN_FAILED,
-                                   profile_name);
-    response.ctrl = WAMBLE_CTRL_LOGIN_FAILED;
-    response.view.error_code = WAMBLE_ERR_ACCESS_DENIED;
-    if (network_enqueue_replayable_terminal(&response, cliaddr) != 0)
-      return SERVER_ERR_SEND_FAILED;
-    return SERVER_ERR_LOGIN_FAILED;
-  }
+  uint8_t sign_message[128];
+  size_t sign_message_len = 0;
+  if (prepare_login_proof(msg, sign_message, sizeof(sign_message),
+                          &sign_message_len) != 0)
+    return login_failed_response(cliaddr, msg->token, profile_name);
+  uint64_t ticket =
+      login_verify_submit(msg->login.signature, msg->login.public_key,
+                          sign_message, sign_message_len, sockfd);
+  if (ticket == 0 || track_pending_login(ticket, msg, cliaddr) != 0)
+    return login_failed_response(cliaddr, msg->token, profile_name);
+  *deferred = 1;
+  return SERVER_OK;
+}
 
-  WamblePlayer *player =
-      attach_persistent_identity(msg->token, msg->login.public_key);
-  if (player) {
-    publish_server_protocol_status(SERVER_PROTOCOL_STATUS_LOGIN_SUCCESS,
-                                   profile_name);
-    response.ctrl = WAMBLE_CTRL_LOGIN_SUCCESS;
-    memcpy(response.token, player->token, TOKEN_LENGTH);
-    append_profile_session_snapshot(&response, player->token, profile_name);
-    {
-      WambleBoard *board = find_board_for_player(player);
-      if (board) {
-        append_last_move_extensions(&response, player->token, profile_name,
-                                    board);
-      }
-    }
-  } else {
-    publish_server_protocol_status(SERVER_PROTOCOL_STATUS_LOGIN_FAILED,
-                                   profile_name);
-    response.ctrl = WAMBLE_CTRL_LOGIN_FAILED;
-    response.view.error_code = WAMBLE_ERR_ACCESS_DENIED;
-  }
-  if (network_enqueue_replayable_terminal(&response, cliaddr) != 0) {
-    return SERVER_ERR_SEND_FAILED;
-  }
-  return player ? SERVER_OK : SERVER_ERR_LOGIN_FAILED;
+int server_protocol_drain_login_verifications(wamble_socket_t sockfd,
+                                              const char *profile_name) {
+  int drained = 0;
+  uint64_t ticket = 0;
+  int verified = 0;
+  while (login_verify_poll(&ticket, &verified) == 1) {
+    PendingLoginEntry pending;
+    if (take_pending_login(ticket, &pending) != 0)
+      continue;
+    struct WambleMsg request = {0};
+    request.ctrl = WAMBLE_CTRL_LOGIN_REQUEST;
+    memcpy(request.token, pending.token, TOKEN_LENGTH);
+    request.board_id = pending.board_id;
+    request.seq_num = pending.seq_num;
+    request.flags = pending.flags;
+    network_begin_request(&request, &pending.cliaddr);
+    ServerStatus status =
+        verified ? finish_login_request(&pending.cliaddr, pending.token,
+                                        pending.public_key, profile_name)
+                 : login_failed_response(&pending.cliaddr, pending.token,
+                                         profile_name);
+    (void)complete_request_after_terminal_response(sockfd, &request,
+                                                   &pending.cliaddr, status);
+    network_end_request();
+    drained++;
+  }
+  return drained;
 }
 
 static ServerStatus enforce_message_access_policies(
@@ -3442,7 +3586,7 @@ static ServerStatus enforce_message_access_policies(
     uint8_t rate_key[TOKEN_LENGTH];
     const uint8_t *limit_token =
         rate_limit_key_for_message(msg, cliaddr, rate_key);
-    if (!bypass_rate_limit && !rate_limit_allowed(limit_token, max_per_sec)) {
+    if (!bypass_rate_limit && !network_rate_limit_allow(limit_token, max_per_sec)) {
       publish_server_protocol_status(SERVER_PROTOCOL_STATUS_RATE_LIMIT_DENIED,
                                      profile_name);
       struct WambleMsg out = {0};
@@ -3527,10 +3671,15 @@ static ServerStatus handle_message_impl(wamble_socket_t sockfd,
     return complete_request_after_terminal_response(
         sockfd, msg, cliaddr,
         handle_get_active_reservations(sockfd, cliaddr, msg, profile_name));
-  case WAMBLE_CTRL_LOGIN_REQUEST:
-    return complete_request_after_terminal_response(
-        sockfd, msg, cliaddr,
-        handle_login_request(sockfd, cliaddr, msg, profile_name));
+  case WAMBLE_CTRL_LOGIN_REQUEST: {
+    int deferred = 0;
+    ServerStatus login_status =
+        handle_login_request(sockfd, cliaddr, msg, profile_name, &deferred);
+    if (deferred)
+      return login_status;
+    return complete_request_after_terminal_response(sockfd, msg, cliaddr,
+                                                    login_status);
+  }
   case WAMBLE_CTRL_LOGOUT:
     return complete_request_after_terminal_response(
         sockfd, msg, cliaddr, handle_logout(msg, profile_name));
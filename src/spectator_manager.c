@@ -5,8 +5,15 @@
 void profile_runtime_manager_event_signal(void);
 int server_protocol_resolve_profile_trust_tier(const uint8_t *token,
                                                const char *profile_name);
+int network_endpoint_delivery_state(const struct sockaddr_in *addr,
+                                    uint32_t *out_srtt_ms,
+                                    uint32_t *out_backlog);
 
 #define WAMBLE_SPECTATOR_STATE_RECORD_SIZE 44u
+#define WAMBLE_SPECTATOR_BACKLOG_STEP 8u
+#define WAMBLE_SPECTATOR_MAX_SLOWDOWN 8.0
+#define WAMBLE_SPECTATOR_SUMMARY_KEYFRAME 10
+#define WAMBLE_SPECTATOR_SUMMARY_TOMBSTONES 256
 
 typedef struct WambleSpectatorSnapshot {
   uint8_t token[TOKEN_LENGTH];
@@ -37,11 +44,25 @@ typedef struct SpectatorEntry {
   int game_mode_visible;
   int owner_port;
   unsigned int game_mode_filter;
+  int focus_linked;
+  int focus_prev;
+  int focus_next;
+  int focus_dirty;
+  uint64_t summary_base;
+  int summary_frames_since_key;
 } SpectatorEntry;
 
+typedef struct SpectatorFocusBucket {
+  uint64_t board_id;
+  int head;
+} SpectatorFocusBucket;
+
 static SpectatorEntry *spectators;
 static int spectators_count;
 static int spectators_capacity;
+static SpectatorFocusBucket *focus_index;
+static int focus_index_capacity;
+static int focus_index_used;
 static wamble_mutex_t spectators_mutex;
 static WAMBLE_THREAD_LOCAL int spectator_manager_mutex_held_depth = 0;
 
@@ -64,19 +85,50 @@ int wamble_architecture_spectator_lock_held(void) {
 static int rr_index = 0;
 static uint64_t summary_generation_counter = 0;
 
-static WambleBoard **summary_cache = NULL;
-static int summary_cache_count = 0;
-static int summary_cache_capacity = 0;
-static time_t summary_cache_built_wall = 0;
+typedef struct SpectatorSummaryRank {
+  uint64_t board_id;
+  time_t last_move_time;
+  double score;
+  int owner_port;
+  GameMode game_mode;
+  uint64_t changed_generation;
+} SpectatorSummaryRank;
+
+typedef struct SpectatorSummaryTombstone {
+  uint64_t board_id;
+  int owner_port;
+  uint64_t changed_generation;
+} SpectatorSummaryTombstone;
+
+typedef struct SpectatorSummaryRankKey {
+  uint64_t board_id;
+  int owner_port;
+  time_t last_move_time;
+  double score;
+} SpectatorSummaryRankKey;
+
+static SpectatorSummaryRank *summary_rank = NULL;
+static int summary_rank_count = 0;
+static int summary_rank_capacity = 0;
+static SpectatorSummaryRankKey *summary_rank_keys = NULL;
+static int summary_rank_keys_capacity = 0;
+static uint64_t summary_rank_epoch = 1;
+static WAMBLE_THREAD_LOCAL uint64_t summary_rank_seeded_epoch = 0;
+static WAMBLE_THREAD_LOCAL int summary_rank_seeded_port = 0;
+static SpectatorSummaryTombstone
+    summary_tombstones[WAMBLE_SPECTATOR_SUMMARY_TOMBSTONES];
+static int summary_tombstone_head = 0;
+static int summary_tombstone_count = 0;
+static uint64_t summary_tombstone_floor = 0;
 
 static int is_board_eligible(const WambleBoard *b);
-static int cmp_boards(const void *a, const void *b);
+static double board_attractiveness(const WambleBoard *b);
 static int spectator_current_port(void);
 static int spectator_active_count_for_port_locked(int owner_port);
 static int fill_focus_now(SpectatorEntry *e, SpectatorUpdate *out, int out_cap,
                           int *out_count);
 static int fill_summary_now(SpectatorEntry *e, SpectatorUpdate *out,
-                            int out_cap, int *out_count);
+                            int out_cap, int *out_count, int allow_delta);
 static void spectator_fill_visible_fens_for_updates(SpectatorUpdate *out,
                                                     int count);
 
@@ -94,56 +146,372 @@ static int token_has_any_byte(const uint8_t *token) {
   return 0;
 }
 
-static void rebuild_summary_cache_locked(int max_to_scan) {
-  if (max_to_scan <= 0) {
-    summary_cache_count = 0;
-    summary_cache_built_wall = wamble_now_wall();
+static SpectatorFocusBucket *focus_index_bucket_locked(uint64_t board_id,
+                                                       int create) {
+  if (!focus_index || focus_index_capacity <= 0 || board_id == 0)
+    return NULL;
+  uint32_t mask = (uint32_t)focus_index_capacity - 1u;
+  uint32_t i = (uint32_t)(board_id * 11400714819323198485ull >> 32) & mask;
+  for (int probe = 0; probe < focus_index_capacity; probe++) {
+    SpectatorFocusBucket *b = &focus_index[i];
+    if (b->board_id == board_id)
+      return b;
+    if (b->board_id == 0) {
+      if (!create)
+        return NULL;
+      b->board_id = board_id;
+      b->head = -1;
+      focus_index_used++;
+      return b;
+    }
+    i = (i + 1u) & mask;
+  }
+  return NULL;
+}
+
+static void focus_index_link_locked(int idx) {
+  SpectatorEntry *e = &spectators[idx];
+  SpectatorFocusBucket *b = focus_index_bucket_locked(e->focus_board_id, 1);
+  if (!b)
     return;
+  e->focus_prev = -1;
+  e->focus_next = b->head;
+  if (b->head >= 0)
+    spectators[b->head].focus_prev = idx;
+  b->head = idx;
+  e->focus_linked = 1;
+}
+
+static void focus_index_rebuild_locked(void) {
+  int focused = 0;
+  for (int i = 0; i < spectators_count; i++) {
+    spectators[i].focus_linked = 0;
+    if (spectators[i].state == SPECTATOR_STATE_FOCUS &&
+        spectators[i].focus_board_id != 0)
+      focused++;
   }
-  if (summary_cache_capacity < max_to_scan) {
-    WambleBoard **newbuf = (WambleBoard **)realloc(
-        summary_cache, sizeof(WambleBoard *) * (size_t)max_to_scan);
-    if (newbuf) {
-      summary_cache = newbuf;
-      summary_cache_capacity = max_to_scan;
+  int cap = 16;
+  while (cap < focused * 2 + 16)
+    cap *= 2;
+  if (cap != focus_index_capacity) {
+    SpectatorFocusBucket *next = (SpectatorFocusBucket *)realloc(
+        focus_index, (size_t)cap * sizeof(*next));
+    if (!next) {
+      free(focus_index);
+      focus_index = NULL;
+      focus_index_capacity = 0;
+      focus_index_used = 0;
+      return;
     }
+    focus_index = next;
+    focus_index_capacity = cap;
   }
-  if (!summary_cache || summary_cache_capacity <= 0) {
-    summary_cache_count = 0;
-    summary_cache_built_wall = wamble_now_wall();
+  memset(focus_index, 0, (size_t)focus_index_capacity * sizeof(*focus_index));
+  focus_index_used = 0;
+  for (int i = 0; i < spectators_count; i++) {
+    if (spectators[i].state == SPECTATOR_STATE_FOCUS &&
+        spectators[i].focus_board_id != 0)
+      focus_index_link_locked(i);
+  }
+}
+
+static void focus_index_unlink_locked(int idx) {
+  SpectatorEntry *e = &spectators[idx];
+  if (!e->focus_linked)
+    return;
+  e->focus_linked = 0;
+  if (e->focus_next >= 0)
+    spectators[e->focus_next].focus_prev = e->focus_prev;
+  if (e->focus_prev >= 0) {
+    spectators[e->focus_prev].focus_next = e->focus_next;
     return;
   }
+  SpectatorFocusBucket *b = focus_index_bucket_locked(e->focus_board_id, 0);
+  if (b && b->head == idx)
+    b->head = e->focus_next;
+}
 
-  WambleBoard *exported =
-      (WambleBoard *)calloc((size_t)max_to_scan, sizeof(*exported));
-  if (!exported) {
-    summary_cache_count = 0;
-    summary_cache_built_wall = wamble_now_wall();
+static void focus_index_set_locked(SpectatorEntry *e) {
+  int idx = (int)(e - spectators);
+  focus_index_unlink_locked(idx);
+  if (e->state != SPECTATOR_STATE_FOCUS || e->focus_board_id == 0)
     return;
+  if (focus_index_used + 1 > focus_index_capacity / 2) {
+    focus_index_rebuild_locked();
+    if (e->focus_linked)
+      return;
   }
+  focus_index_link_locked(idx);
+}
 
-  int exported_count = 0;
-  if (board_manager_export(exported, max_to_scan, &exported_count, NULL) != 0) {
-    free(exported);
-    summary_cache_count = 0;
-    summary_cache_built_wall = wamble_now_wall();
+static void spectator_focus_fallback_locked(SpectatorEntry *e,
+                                            const char *reason,
+                                            ProfileAdminStatus admin_status) {
+  if (!e->has_pending_notice && e->focus_board_id) {
+    e->has_pending_notice = 1;
+    e->pending_notice_flags = WAMBLE_FLAG_SPECTATE_NOTICE_SUMMARY_FALLBACK;
+    e->pending_notice_type = WAMBLE_NOTIFICATION_TYPE_SPECTATE_ENDED;
+    e->pending_notice_board_id = e->focus_board_id;
+    snprintf(e->pending_notice, sizeof(e->pending_notice),
+             "%s; switched to summary mode (board %" PRIu64 ")", reason,
+             e->focus_board_id);
+    WambleRuntimeStatus runtime_status = {WAMBLE_RUNTIME_STATUS_PROFILE_ADMIN,
+                                          admin_status};
+    wamble_runtime_event_publish(runtime_status, wamble_runtime_profile_key(),
+                                 NULL);
+    profile_runtime_manager_event_signal();
+  }
+  e->state = SPECTATOR_STATE_SUMMARY;
+  e->focus_board_id = 0;
+  e->last_focus_sent = 0.0;
+  e->focus_dirty = 0;
+  e->summary_base = 0;
+  e->capacity_bypass = 0;
+}
+
+static int summary_rank_before(const SpectatorSummaryRank *a,
+                               const SpectatorSummaryRank *b) {
+  if (a->last_move_time != b->last_move_time)
+    return a->last_move_time > b->last_move_time;
+  if (a->score != b->score)
+    return a->score > b->score;
+  return a->board_id < b->board_id;
+}
+
+static uint32_t summary_rank_key_slot(uint64_t board_id, int owner_port) {
+  uint64_t h = (board_id ^ ((uint64_t)(uint32_t)owner_port << 40)) *
+               11400714819323198485ull;
+  return (uint32_t)(h >> 32) & ((uint32_t)summary_rank_keys_capacity - 1u);
+}
+
+static int summary_rank_key_find_locked(uint64_t board_id, int owner_port) {
+  if (!summary_rank_keys || board_id == 0)
+    return -1;
+  uint32_t mask = (uint32_t)summary_rank_keys_capacity - 1u;
+  uint32_t i = summary_rank_key_slot(board_id, owner_port);
+  for (int probe = 0; probe < summary_rank_keys_capacity; probe++) {
+    const SpectatorSummaryRankKey *k = &summary_rank_keys[i];
+    if (k->board_id == 0)
+      return -1;
+    if (k->board_id == board_id && k->owner_port == owner_port)
+      return (int)i;
+    i = (i + 1u) & mask;
+  }
+  return -1;
+}
+
+static void summary_rank_key_put_locked(const SpectatorSummaryRank *r) {
+  if (!summary_rank_keys || r->board_id == 0)
     return;
+  uint32_t mask = (uint32_t)summary_rank_keys_capacity - 1u;
+  uint32_t i = summary_rank_key_slot(r->board_id, r->owner_port);
+  for (int probe = 0; probe < summary_rank_keys_capacity; probe++) {
+    SpectatorSummaryRankKey *k = &summary_rank_keys[i];
+    if (k->board_id == 0 ||
+        (k->board_id == r->board_id && k->owner_port == r->owner_port)) {
+      k->board_id = r->board_id;
+      k->owner_port = r->owner_port;
+      k->last_move_time = r->last_move_time;
+      k->score = r->score;
+      return;
+    }
+    i = (i + 1u) & mask;
   }
+}
 
-  int count = 0;
-  for (int i = 0; i < exported_count && count < summary_cache_capacity; i++) {
-    WambleBoard *b = get_board_by_id(exported[i].id);
-    if (!b || !is_board_eligible(b))
-      continue;
-    summary_cache[count++] = b;
+static void summary_rank_key_delete_locked(int slot) {
+  uint32_t mask = (uint32_t)summary_rank_keys_capacity - 1u;
+  uint32_t hole = (uint32_t)slot;
+  uint32_t i = (hole + 1u) & mask;
+  summary_rank_keys[hole].board_id = 0;
+  while (summary_rank_keys[i].board_id != 0) {
+    uint32_t home = summary_rank_key_slot(summary_rank_keys[i].board_id,
+                                          summary_rank_keys[i].owner_port);
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      summary_rank_keys[hole] = summary_rank_keys[i];
+      summary_rank_keys[i].board_id = 0;
+      hole = i;
+    }
+    i = (i + 1u) & mask;
   }
-  free(exported);
+}
+
+static void summary_rank_keys_rebuild_locked(int min_capacity) {
+  int cap = 64;
+  while (cap < min_capacity * 2)
+    cap <<= 1;
+  if (cap != summary_rank_keys_capacity) {
+    SpectatorSummaryRankKey *next = (SpectatorSummaryRankKey *)realloc(
+        summary_rank_keys, (size_t)cap * sizeof(*next));
+    if (!next) {
+      free(summary_rank_keys);
+      summary_rank_keys = NULL;
+      summary_rank_keys_capacity = 0;
+      return;
+    }
+    summary_rank_keys = next;
+    summary_rank_keys_capacity = cap;
+  }
+  memset(summary_rank_keys, 0, (size_t)cap * sizeof(*summary_rank_keys));
+  for (int i = 0; i < summary_rank_count; i++)
+    summary_rank_key_put_locked(&summary_rank[i]);
+}
+
+static void summary_rank_keys_free_locked(void) {
+  free(summary_rank_keys);
+  summary_rank_keys = NULL;
+  summary_rank_keys_capacity = 0;
+}
+
+static int summary_rank_remove_at_locked(int i) {
+  memmove(&summary_rank[i], &summary_rank[i + 1],
+          (size_t)(summary_rank_count - i - 1) * sizeof(*summary_rank));
+  summary_rank_count--;
+  return 1;
+}
+
+static int summary_rank_remove_locked(uint64_t board_id, int owner_port) {
+  if (!summary_rank_keys) {
+    for (int i = 0; i < summary_rank_count; i++) {
+      if (summary_rank[i].board_id == board_id &&
+          summary_rank[i].owner_port == owner_port)
+        return summary_rank_remove_at_locked(i);
+    }
+    return 0;
+  }
+  int slot = summary_rank_key_find_locked(board_id, owner_port);
+  if (slot < 0)
+    return 0;
+  SpectatorSummaryRank key;
+  memset(&key, 0, sizeof(key));
+  key.board_id = board_id;
+  key.last_move_time = summary_rank_keys[slot].last_move_time;
+  key.score = summary_rank_keys[slot].score;
+  summary_rank_key_delete_locked(slot);
+  int lo = 0;
+  int hi = summary_rank_count;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (summary_rank_before(&summary_rank[mid], &key))
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  for (int i = lo; i < summary_rank_count &&
+                   !summary_rank_before(&key, &summary_rank[i]);
+       i++) {
+    if (summary_rank[i].board_id == board_id &&
+        summary_rank[i].owner_port == owner_port)
+      return summary_rank_remove_at_locked(i);
+  }
+  return 0;
+}
+
+static void summary_tombstone_push_locked(uint64_t board_id, int owner_port) {
+  int slot;
+  if (summary_tombstone_count < WAMBLE_SPECTATOR_SUMMARY_TOMBSTONES) {
+    slot = (summary_tombstone_head + summary_tombstone_count++) %
+           WAMBLE_SPECTATOR_SUMMARY_TOMBSTONES;
+  } else {
+    slot = summary_tombstone_head;
+    summary_tombstone_floor = summary_tombstones[slot].changed_generation;
+    summary_tombstone_head =
+        (summary_tombstone_head + 1) % WAMBLE_SPECTATOR_SUMMARY_TOMBSTONES;
+  }
+  summary_tombstones[slot].board_id = board_id;
+  summary_tombstones[slot].owner_port = owner_port;
+  summary_tombstones[slot].changed_generation = summary_generation_counter;
+}
+
+static void summary_tombstone_drop_locked(uint64_t board_id, int owner_port) {
+  for (int i = 0; i < summary_tombstone_count; i++) {
+    SpectatorSummaryTombstone *t =
+        &summary_tombstones[(summary_tombstone_head + i) %
+                            WAMBLE_SPECTATOR_SUMMARY_TOMBSTONES];
+    if (t->board_id == board_id && t->owner_port == owner_port)
+      t->board_id = 0;
+  }
+}
+
+static void summary_rank_insert_locked(const WambleBoard *b, int owner_port) {
+  if (summary_rank_count >= summary_rank_capacity) {
+    int new_cap = summary_rank_capacity > 0 ? summary_rank_capacity * 2 : 64;
+    SpectatorSummaryRank *next = (SpectatorSummaryRank *)realloc(
+        summary_rank, (size_t)new_cap * sizeof(*next));
+    if (!next)
+      return;
+    summary_rank = next;
+    summary_rank_capacity = new_cap;
+  }
+  if ((summary_rank_count + 1) * 2 > summary_rank_keys_capacity)
+    summary_rank_keys_rebuild_locked(summary_rank_count + 1);
+  SpectatorSummaryRank r;
+  r.board_id = b->id;
+  r.last_move_time = b->last_move_time;
+  r.score = board_attractiveness(b);
+  r.owner_port = owner_port;
+  r.game_mode = b->board.game_mode;
+  r.changed_generation = summary_generation_counter;
+  int lo = 0;
+  int hi = summary_rank_count;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (summary_rank_before(&summary_rank[mid], &r))
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  memmove(&summary_rank[lo + 1], &summary_rank[lo],
+          (size_t)(summary_rank_count - lo) * sizeof(*summary_rank));
+  summary_rank[lo] = r;
+  summary_rank_count++;
+  summary_rank_key_put_locked(&r);
+}
 
-  if (count > 1) {
-    qsort(summary_cache, (size_t)count, sizeof(summary_cache[0]), cmp_boards);
+static void summary_rank_update_locked(uint64_t board_id, const WambleBoard *b,
+                                       int owner_port) {
+  int removed = summary_rank_remove_locked(board_id, owner_port);
+  if (b && is_board_eligible(b)) {
+    summary_rank_insert_locked(b, owner_port);
+    summary_tombstone_drop_locked(board_id, owner_port);
+  } else if (removed)
+    summary_tombstone_push_locked(board_id, owner_port);
+}
+
+static int summary_rank_seeded(void) {
+  return summary_rank_seeded_epoch == summary_rank_epoch &&
+         summary_rank_seeded_port == spectator_current_port();
+}
+
+static void summary_rank_seed_locked(int max_to_scan) {
+  int port = spectator_current_port();
+  WambleBoard *exported = NULL;
+  if (max_to_scan > 0) {
+    exported = (WambleBoard *)calloc((size_t)max_to_scan, sizeof(*exported));
+    if (!exported)
+      return;
+  }
+  summary_rank_seeded_epoch = summary_rank_epoch;
+  summary_rank_seeded_port = port;
+  summary_tombstone_floor = summary_generation_counter;
+  int write_idx = 0;
+  for (int i = 0; i < summary_rank_count; i++) {
+    if (summary_rank[i].owner_port != port)
+      summary_rank[write_idx++] = summary_rank[i];
+  }
+  summary_rank_count = write_idx;
+  summary_rank_keys_rebuild_locked(summary_rank_count);
+  if (!exported)
+    return;
+
+  int exported_count = 0;
+  if (board_manager_export(exported, max_to_scan, &exported_count, NULL) == 0) {
+    for (int i = 0; i < exported_count; i++) {
+      WambleBoard *b = get_board_by_id(exported[i].id);
+      summary_rank_update_locked(exported[i].id, b, port);
+    }
   }
-  summary_cache_count = count;
-  summary_cache_built_wall = wamble_now_wall();
+  free(exported);
 }
 
 static double monotonic_seconds(void) {
@@ -248,28 +616,6 @@ static double board_attractiveness(const WambleBoard *b) {
   return score;
 }
 
-static int cmp_boards(const void *a, const void *b) {
-  const WambleBoard *ba = *(const WambleBoard *const *)a;
-  const WambleBoard *bb = *(const WambleBoard *const *)b;
-  if (!ba && !bb)
-    return 0;
-  if (!ba)
-    return 1;
-  if (!bb)
-    return -1;
-
-  if (ba->last_move_time != bb->last_move_time) {
-    return (bb->last_move_time > ba->last_move_time) -
-           (bb->last_move_time < ba->last_move_time);
-  }
-
-  double sa = board_attractiveness(ba);
-  double sb = board_attractiveness(bb);
-  if (sa == sb)
-    return 0;
-  return (sb > sa) - (sb < sa);
-}
-
 static int spectator_current_port(void) {
   return get_config() ? get_config()->port : 0;
 }
@@ -350,23 +696,19 @@ SpectatorInitStatus spectator_manager_init(void) {
   spectators_count = 0;
 
   spectators_capacity = 0;
-
-  if (summary_cache) {
-    free(summary_cache);
-    summary_cache = NULL;
-  }
-  summary_cache_capacity = 0;
-  summary_cache_count = 0;
-  summary_cache_built_wall = 0;
-  int cap = get_config()->max_boards;
-  if (cap < 0)
-    cap = 0;
-  if (cap > 0) {
-    summary_cache = (WambleBoard **)calloc((size_t)cap, sizeof(WambleBoard *));
-    if (summary_cache) {
-      summary_cache_capacity = cap;
-    }
-  }
+  free(focus_index);
+  focus_index = NULL;
+  focus_index_capacity = 0;
+  focus_index_used = 0;
+
+  free(summary_rank);
+  summary_rank = NULL;
+  summary_rank_capacity = 0;
+  summary_rank_count = 0;
+  summary_rank_keys_free_locked();
+  summary_rank_epoch++;
+  summary_tombstone_head = 0;
+  summary_tombstone_count = 0;
   spectator_manager_mutex_unlock();
   return SPECTATOR_INIT_OK;
 }
@@ -377,10 +719,16 @@ void spectator_manager_shutdown(void) {
     free(spectators);
     spectators = NULL;
   }
-  if (summary_cache) {
-    free(summary_cache);
-    summary_cache = NULL;
-  }
+  free(summary_rank);
+  summary_rank = NULL;
+  summary_rank_capacity = 0;
+  summary_rank_count = 0;
+  summary_rank_keys_free_locked();
+  summary_rank_epoch++;
+  free(focus_index);
+  focus_index = NULL;
+  focus_index_capacity = 0;
+  focus_index_used = 0;
   spectators_count = 0;
   spectators_capacity = 0;
   spectator_manager_mutex_unlock();
@@ -394,15 +742,14 @@ void spectator_manager_tick(void) {
 
   spectator_manager_mutex_lock();
 
-  int max_to_scan = cfg->max_boards;
-  if (max_to_scan <= 0)
-    max_to_scan = 0;
-  rebuild_summary_cache_locked(max_to_scan);
+  if (!summary_rank_seeded())
+    summary_rank_seed_locked(cfg->max_boards);
   double now = monotonic_seconds();
   int max_focus = cfg->max_spectators;
   double inactivity =
       (cfg->session_timeout > 0) ? (double)cfg->session_timeout : 300.0;
   int port = spectator_current_port();
+  int focus_changed = 0;
 
   int write_idx = 0;
   for (int read_idx = 0; read_idx < spectators_count; read_idx++) {
@@ -427,54 +774,12 @@ void spectator_manager_tick(void) {
       continue;
     }
 
-    if (e->state == SPECTATOR_STATE_FOCUS) {
-      if (cfg->spectator_max_focus_per_session <= 0) {
-        if (!e->has_pending_notice && e->focus_board_id) {
-          e->has_pending_notice = 1;
-          e->pending_notice_flags =
-              WAMBLE_FLAG_SPECTATE_NOTICE_SUMMARY_FALLBACK;
-          e->pending_notice_type = WAMBLE_NOTIFICATION_TYPE_SPECTATE_ENDED;
-          e->pending_notice_board_id = e->focus_board_id;
-          snprintf(e->pending_notice, sizeof(e->pending_notice),
-                   "focus ended; switched to summary mode (board %" PRIu64 ")",
-                   e->focus_board_id);
-          WambleRuntimeStatus runtime_status = {
-              WAMBLE_RUNTIME_STATUS_PROFILE_ADMIN,
-              PROFILE_ADMIN_STATUS_SPECTATOR_FOCUS_DISABLED_FALLBACK};
-          wamble_runtime_event_publish(runtime_status,
-                                       wamble_runtime_profile_key(), NULL);
-          profile_runtime_manager_event_signal();
-        }
-        e->state = SPECTATOR_STATE_SUMMARY;
-        e->focus_board_id = 0;
-        e->last_focus_sent = 0.0;
-        e->capacity_bypass = 0;
-      } else {
-        WambleBoard *b = get_board_by_id(e->focus_board_id);
-        if (!b || !is_board_eligible(b)) {
-          if (!e->has_pending_notice && e->focus_board_id) {
-            e->has_pending_notice = 1;
-            e->pending_notice_flags =
-                WAMBLE_FLAG_SPECTATE_NOTICE_SUMMARY_FALLBACK;
-            e->pending_notice_type = WAMBLE_NOTIFICATION_TYPE_SPECTATE_ENDED;
-            e->pending_notice_board_id = e->focus_board_id;
-            snprintf(e->pending_notice, sizeof(e->pending_notice),
-                     "focused game finished; switched to summary mode "
-                     "(board %" PRIu64 ")",
-                     e->focus_board_id);
-            WambleRuntimeStatus runtime_status = {
-                WAMBLE_RUNTIME_STATUS_PROFILE_ADMIN,
-                PROFILE_ADMIN_STATUS_SPECTATOR_BOARD_FINISHED_FALLBACK};
-            wamble_runtime_event_publish(runtime_status,
-                                         wamble_runtime_profile_key(), NULL);
-            profile_runtime_manager_event_signal();
-          }
-          e->state = SPECTATOR_STATE_SUMMARY;
-          e->focus_board_id = 0;
-          e->last_focus_sent = 0.0;
-          e->capacity_bypass = 0;
-        }
-      }
+    if (e->state == SPECTATOR_STATE_FOCUS &&
+        cfg->spectator_max_focus_per_session <= 0) {
+      spectator_focus_fallback_locked(
+          e, "focus ended",
+          PROFILE_ADMIN_STATUS_SPECTATOR_FOCUS_DISABLED_FALLBACK);
+      focus_changed = 1;
     }
 
     if (e->state == SPECTATOR_STATE_SUMMARY && cfg->spectator_summary_hz <= 0) {
@@ -505,6 +810,7 @@ void spectator_manager_tick(void) {
       e->focus_board_id = 0;
       e->last_focus_sent = 0.0;
       e->capacity_bypass = 0;
+      focus_changed = 1;
     }
 
     if (write_idx != read_idx) {
@@ -515,6 +821,39 @@ void spectator_manager_tick(void) {
 
   if (write_idx != spectators_count) {
     spectators_count = write_idx;
+    focus_changed = 1;
+  }
+  if (focus_changed)
+    focus_index_rebuild_locked();
+  spectator_manager_mutex_unlock();
+}
+
+void spectator_board_changed(uint64_t board_id) {
+  int ranked = summary_rank_seeded();
+  if (board_id == 0 || (!spectators && !ranked))
+    return;
+  WambleBoard *b = get_board_by_id(board_id);
+  int eligible = b && is_board_eligible(b);
+  int port = spectator_current_port();
+  spectator_manager_mutex_lock();
+  if (ranked)
+    summary_rank_update_locked(board_id, b, port);
+  SpectatorFocusBucket *bucket = focus_index_bucket_locked(board_id, 0);
+  int idx = bucket ? bucket->head : -1;
+  while (idx >= 0) {
+    SpectatorEntry *e = &spectators[idx];
+    int next = e->focus_next;
+    if (e->owner_port == port) {
+      if (eligible) {
+        e->focus_dirty = 1;
+      } else {
+        focus_index_unlink_locked(idx);
+        spectator_focus_fallback_locked(
+            e, "focused game finished",
+            PROFILE_ADMIN_STATUS_SPECTATOR_BOARD_FINISHED_FALLBACK);
+      }
+    }
+    idx = next;
   }
   spectator_manager_mutex_unlock();
 }
@@ -578,6 +917,7 @@ SpectatorRequestStatus spectator_handle_request(
       }
       e->addr = *cliaddr;
       e->trust = trust_tier;
+      focus_index_unlink_locked(i);
       e->state = SPECTATOR_STATE_IDLE;
       e->focus_board_id = 0;
       e->last_focus_sent = 0.0;
@@ -628,9 +968,11 @@ SpectatorRequestStatus spectator_handle_request(
     }
 
     if (msg->board_id == 0) {
+      focus_index_unlink_locked((int)(e - spectators));
       e->state = SPECTATOR_STATE_SUMMARY;
       e->focus_board_id = 0;
       e->last_summary_sent = 0.0;
+      e->summary_base = 0;
       e->capacity_bypass = 0;
       e->game_mode_filter = 0;
       if (e->game_mode_visible) {
@@ -678,10 +1020,13 @@ SpectatorRequestStatus spectator_handle_request(
         spectator_manager_mutex_unlock();
         return SPECTATOR_ERR_FULL;
       }
+      focus_index_unlink_locked((int)(e - spectators));
       e->state = SPECTATOR_STATE_FOCUS;
       e->focus_board_id = requested_board_id;
       e->last_focus_sent = 0.0;
+      e->focus_dirty = 0;
       e->capacity_bypass = capacity_bypass ? 1 : 0;
+      focus_index_set_locked(e);
       if (out_state)
         *out_state = e->state;
       if (out_focus_board_id)
@@ -954,6 +1299,7 @@ int spectator_manager_import(const WambleSpectatorSnapshot *in, int count) {
       imported--;
   }
   spectators_count = imported;
+  focus_index_rebuild_locked();
   spectator_manager_mutex_unlock();
   return 0;
 }
@@ -990,9 +1336,8 @@ int spectator_collect_state_snapshot(const uint8_t *token, SpectatorUpdate *out,
     return 0;
 
   spectator_manager_mutex_lock();
-  if (summary_cache_built_wall == 0) {
-    rebuild_summary_cache_locked(cfg->max_boards);
-  }
+  if (!summary_rank_seeded())
+    summary_rank_seed_locked(cfg->max_boards);
 
   int port = spectator_current_port();
   double now = monotonic_seconds();
@@ -1005,7 +1350,7 @@ int spectator_collect_state_snapshot(const uint8_t *token, SpectatorUpdate *out,
     if (!spectator_has_delivery_route(e))
       break;
     if (e->state == SPECTATOR_STATE_SUMMARY) {
-      if (fill_summary_now(e, out, max, &out_count) >= 0)
+      if (fill_summary_now(e, out, max, &out_count, 0) >= 0)
         e->last_summary_sent = now;
     } else if (e->state == SPECTATOR_STATE_FOCUS) {
       if (fill_focus_now(e, out, max, &out_count) >= 0)
@@ -1027,8 +1372,13 @@ static int fill_focus_now(SpectatorEntry *e, SpectatorUpdate *out, int out_cap,
   if (*out_count >= out_cap)
     return -1;
   WambleBoard *b = get_board_by_id(e->focus_board_id);
-  if (!b || !is_board_eligible(b))
+  if (!b || !is_board_eligible(b)) {
+    focus_index_unlink_locked((int)(e - spectators));
+    spectator_focus_fallback_locked(
+        e, "focused game finished",
+        PROFILE_ADMIN_STATUS_SPECTATOR_BOARD_FINISHED_FALLBACK);
     return 0;
+  }
 
   SpectatorUpdate *u = &out[*out_count];
   memset(u, 0, sizeof(*u));
@@ -1056,12 +1406,45 @@ void spectator_discard_by_token(const uint8_t *token) {
       spectators[write_idx] = spectators[read_idx];
     write_idx++;
   }
-  spectators_count = write_idx;
+  if (write_idx != spectators_count) {
+    spectators_count = write_idx;
+    focus_index_rebuild_locked();
+  }
   spectator_manager_mutex_unlock();
 }
 
+static int summary_mode_changes(void) {
+  const char *mode = get_config() ? get_config()->spectator_summary_mode : NULL;
+  return !mode || strcmp(mode, "full") != 0;
+}
+
+static int summary_rank_visible(const SpectatorEntry *e,
+                                const SpectatorSummaryRank *r) {
+  if (r->owner_port != e->owner_port)
+    return 0;
+  return e->game_mode_filter == 0 ||
+         (e->game_mode_filter & (1u << r->game_mode)) != 0;
+}
+
+static SpectatorUpdate *summary_frame_push(SpectatorEntry *e,
+                                           SpectatorUpdate *out, int out_cap,
+                                           int *out_count, uint64_t board_id,
+                                           uint64_t generation) {
+  if (*out_count >= out_cap)
+    return NULL;
+  SpectatorUpdate *u = &out[*out_count];
+  memset(u, 0, sizeof(*u));
+  memcpy(u->token, e->token, TOKEN_LENGTH);
+  u->board_id = board_id;
+  u->addr = e->addr;
+  u->flags = WAMBLE_FLAG_UNRELIABLE;
+  u->summary_generation = generation;
+  (*out_count)++;
+  return u;
+}
+
 static int fill_summary_now(SpectatorEntry *e, SpectatorUpdate *out,
-                            int out_cap, int *out_count) {
+                            int out_cap, int *out_count, int allow_delta) {
   if (!e || !out || !out_count || out_cap <= 0)
     return -1;
   if (!spectator_has_delivery_route(e))
@@ -1070,36 +1453,72 @@ static int fill_summary_now(SpectatorEntry *e, SpectatorUpdate *out,
   if (out_cap - *out_count < 1)
     return -1;
 
+  uint64_t base = e->summary_base;
+  int delta = allow_delta && base > summary_tombstone_floor &&
+              e->summary_frames_since_key < WAMBLE_SPECTATOR_SUMMARY_KEYFRAME &&
+              summary_mode_changes();
+  if (delta) {
+    int changed = 0;
+    for (int i = 0; i < summary_tombstone_count && !changed; i++) {
+      const SpectatorSummaryTombstone *t =
+          &summary_tombstones[(summary_tombstone_head + i) %
+                              WAMBLE_SPECTATOR_SUMMARY_TOMBSTONES];
+      changed = t->board_id != 0 && t->owner_port == e->owner_port &&
+                t->changed_generation >= base;
+    }
+    for (int i = 0; i < summary_rank_count && !changed; i++) {
+      changed = summary_rank_visible(e, &summary_rank[i]) &&
+                summary_rank[i].changed_generation >= base;
+    }
+    if (!changed) {
+      e->summary_frames_since_key++;
+      return 1;
+    }
+  }
+
   uint64_t generation = ++summary_generation_counter;
-  SpectatorUpdate *reset = &out[*out_count];
-  memset(reset, 0, sizeof(*reset));
-  memcpy(reset->token, e->token, TOKEN_LENGTH);
-  reset->addr = e->addr;
-  reset->flags = WAMBLE_FLAG_UNRELIABLE;
-  reset->summary_generation = generation;
-  (*out_count)++;
+  SpectatorUpdate *reset =
+      summary_frame_push(e, out, out_cap, out_count, 0, generation);
+  if (delta)
+    reset->summary_base_generation = base;
+
+  if (delta) {
+    for (int i = 0; i < summary_tombstone_count; i++) {
+      const SpectatorSummaryTombstone *t =
+          &summary_tombstones[(summary_tombstone_head + i) %
+                              WAMBLE_SPECTATOR_SUMMARY_TOMBSTONES];
+      if (t->board_id == 0 || t->owner_port != e->owner_port ||
+          t->changed_generation < base)
+        continue;
+      SpectatorUpdate *u = summary_frame_push(e, out, out_cap, out_count,
+                                              t->board_id, generation);
+      if (!u) {
+        *out_count = start_count;
+        return -1;
+      }
+      u->summary_base_generation = base;
+    }
+  }
 
-  for (int i = 0; i < summary_cache_count; i++) {
-    WambleBoard *b = summary_cache[i];
-    GameMode board_game_mode = b->board.game_mode;
-    if (e->game_mode_filter != 0 &&
-        !(e->game_mode_filter & (1u << board_game_mode)))
+  for (int i = 0; i < summary_rank_count; i++) {
+    const SpectatorSummaryRank *r = &summary_rank[i];
+    if (!summary_rank_visible(e, r))
+      continue;
+    if (delta && r->changed_generation < base)
       continue;
-    if (*out_count >= out_cap) {
+    SpectatorUpdate *u =
+        summary_frame_push(e, out, out_cap, out_count, r->board_id, generation);
+    if (!u) {
       *out_count = start_count;
       return -1;
     }
-    SpectatorUpdate *u = &out[*out_count];
-    memset(u, 0, sizeof(*u));
-    memcpy(u->token, e->token, TOKEN_LENGTH);
-    u->board_id = b->id;
-    u->addr = e->addr;
-    u->flags = WAMBLE_FLAG_UNRELIABLE;
-    u->summary_generation = generation;
-    if (e->game_mode_visible && board_game_mode == GAME_MODE_CHESS960)
+    if (delta)
+      u->summary_base_generation = base;
+    if (e->game_mode_visible && r->game_mode == GAME_MODE_CHESS960)
       u->flags |= WAMBLE_FLAG_BOARD_IS_960;
-    (*out_count)++;
   }
+  e->summary_base = generation;
+  e->summary_frames_since_key = delta ? e->summary_frames_since_key + 1 : 0;
   return 1;
 }
 
@@ -1118,6 +1537,23 @@ static void spectator_fill_visible_fens_for_updates(SpectatorUpdate *out,
   }
 }
 
+static double spectator_adaptive_interval(const SpectatorEntry *e,
+                                          double base) {
+  uint32_t srtt_ms = 0;
+  uint32_t backlog = 0;
+  if (base <= 0.0 ||
+      network_endpoint_delivery_state(&e->addr, &srtt_ms, &backlog) != 0)
+    return base;
+  double interval =
+      base * (1.0 + (double)(backlog / WAMBLE_SPECTATOR_BACKLOG_STEP));
+  double rtt = (double)srtt_ms / 1000.0;
+  if (interval < rtt)
+    interval = rtt;
+  if (interval > base * WAMBLE_SPECTATOR_MAX_SLOWDOWN)
+    interval = base * WAMBLE_SPECTATOR_MAX_SLOWDOWN;
+  return interval;
+}
+
 int spectator_collect_updates(struct SpectatorUpdate *out, int max) {
   if (!out || max <= 0)
     return 0;
@@ -1131,9 +1567,8 @@ int spectator_collect_updates(struct SpectatorUpdate *out, int max) {
     foc_interval = 1.0 / (double)cfg->spectator_focus_hz;
 
   spectator_manager_mutex_lock();
-  if (summary_cache_built_wall == 0) {
-    rebuild_summary_cache_locked(cfg->max_boards);
-  }
+  if (!summary_rank_seeded())
+    summary_rank_seed_locked(cfg->max_boards);
   int out_count = 0;
   int port = cfg ? cfg->port : 0;
   int start = rr_index;
@@ -1149,24 +1584,28 @@ int spectator_collect_updates(struct SpectatorUpdate *out, int max) {
     }
     int retry = 0;
     if (e->state == SPECTATOR_STATE_SUMMARY) {
-      int due =
-          (e->last_summary_sent == 0.0) ||
-          (sum_interval > 0.0 && (now - e->last_summary_sent) >= sum_interval);
+      double interval = spectator_adaptive_interval(e, sum_interval);
+      int due = (e->last_summary_sent == 0.0) ||
+                (interval > 0.0 && (now - e->last_summary_sent) >= interval);
       if (due) {
-        if (fill_summary_now(e, out, max, &out_count) > 0)
+        if (fill_summary_now(e, out, max, &out_count, 1) > 0)
           e->last_summary_sent = now;
         else
           retry = 1;
       }
     } else if (e->state == SPECTATOR_STATE_FOCUS) {
-      int due =
-          (e->last_focus_sent == 0.0) ||
-          (foc_interval > 0.0 && (now - e->last_focus_sent) >= foc_interval);
+      double interval = spectator_adaptive_interval(e, foc_interval);
+      int due = (e->last_focus_sent == 0.0) ||
+                (e->focus_dirty && interval > 0.0 &&
+                 (now - e->last_focus_sent) >= interval);
       if (due) {
-        if (fill_focus_now(e, out, max, &out_count) > 0)
+        int filled = fill_focus_now(e, out, max, &out_count);
+        if (filled > 0) {
           e->last_focus_sent = now;
-        else
+          e->focus_dirty = 0;
+        } else if (filled < 0 || e->state == SPECTATOR_STATE_FOCUS) {
           retry = 1;
+        }
       }
     }
     if (retry)
@@ -5,10 +5,11 @@
 #endif
 
 #define WAMBLE_STATE_MAGIC "WMBLST01"
-#define WAMBLE_STATE_FORMAT_REVISION 3u
+#define WAMBLE_STATE_FORMAT_REVISION 4u
 #define WAMBLE_STATE_MIN_LOADABLE_REVISION 1u
 #define WAMBLE_STATE_SPECTATOR_REVISION 2u
 #define WAMBLE_STATE_FIXED_SPECTATOR_REVISION 3u
+#define WAMBLE_STATE_LEDGER_REVISION 4u
 
 static int state_revision_loadable(uint32_t revision) {
   return revision >= WAMBLE_STATE_MIN_LOADABLE_REVISION &&
@@ -21,7 +22,7 @@ typedef struct StateHeader {
   uint32_t count;
   uint64_t next_id;
   uint32_t spectator_count;
-  uint32_t reserved;
+  uint32_t ledger_count;
 } StateHeader;
 
 int wamble_runtime_state_path(char *out, size_t out_size, const char *name) {
@@ -79,6 +80,11 @@ int spectator_manager_import_state_records(const uint8_t *in,
 int spectator_manager_import_legacy_state_records(const uint8_t *in,
                                                   size_t record_size,
                                                   int count);
+size_t board_manager_ledger_record_size(void);
+int board_manager_export_ledger_records(uint8_t *out, size_t record_size,
+                                        int max, int *out_count);
+int board_manager_import_ledger_records(const uint8_t *in, size_t record_size,
+                                        int count);
 
 int state_save_to_file(const char *path) {
   if (!path)
@@ -134,6 +140,29 @@ int state_save_to_file(const char *path) {
     }
   }
 
+  int ledger_count = 0;
+  uint8_t *ledgers = NULL;
+  size_t ledger_record_size = board_manager_ledger_record_size();
+  if (board_manager_export_ledger_records(NULL, ledger_record_size, 0,
+                                          &ledger_count) != 0) {
+    free(spectators);
+    free(tmp);
+    fclose(f);
+    return -1;
+  }
+  if (ledger_count > 0) {
+    ledgers = (uint8_t *)calloc((size_t)ledger_count, ledger_record_size);
+    if (!ledgers ||
+        board_manager_export_ledger_records(ledgers, ledger_record_size,
+                                            ledger_count, &ledger_count) != 0) {
+      free(ledgers);
+      free(spectators);
+      free(tmp);
+      fclose(f);
+      return -1;
+    }
+  }
+
   StateHeader hdr;
   memset(&hdr, 0, sizeof(hdr));
   memcpy(hdr.magic, WAMBLE_STATE_MAGIC, sizeof(hdr.magic));
@@ -141,8 +170,10 @@ int state_save_to_file(const char *path) {
   hdr.count = (uint32_t)((count < 0) ? 0 : count);
   hdr.next_id = next_id;
   hdr.spectator_count = (uint32_t)((spectator_count < 0) ? 0 : spectator_count);
+  hdr.ledger_count = (uint32_t)((ledger_count < 0) ? 0 : ledger_count);
 
   if (state_write_all(f, &hdr, sizeof(hdr)) != 0) {
+    free(ledgers);
     free(spectators);
     free(tmp);
     fclose(f);
@@ -151,6 +182,7 @@ int state_save_to_file(const char *path) {
   if (count > 0) {
     size_t need = sizeof(WambleBoard) * (size_t)count;
     if (state_write_all(f, tmp, need) != 0) {
+      free(ledgers);
       free(spectators);
       free(tmp);
       fclose(f);
@@ -160,12 +192,24 @@ int state_save_to_file(const char *path) {
   if (spectator_count > 0) {
     size_t need = spectator_record_size * (size_t)spectator_count;
     if (state_write_all(f, spectators, need) != 0) {
+      free(ledgers);
       free(spectators);
       free(tmp);
       fclose(f);
       return -1;
     }
   }
+  if (ledger_count > 0) {
+    size_t need = ledger_record_size * (size_t)ledger_count;
+    if (state_write_all(f, ledgers, need) != 0) {
+      free(ledgers);
+      free(spectators);
+      free(tmp);
+      fclose(f);
+      return -1;
+    }
+  }
+  free(ledgers);
   free(spectators);
   free(tmp);
   fclose(f);
@@ -192,7 +236,7 @@ int state_load_from_file(const char *path) {
   if (hdr.version >= WAMBLE_STATE_SPECTATOR_REVISION) {
     if (state_read_all(f, &hdr.spectator_count, sizeof(hdr.spectator_count)) !=
             0 ||
-        state_read_all(f, &hdr.reserved, sizeof(hdr.reserved)) != 0)
+        state_read_all(f, &hdr.ledger_count, sizeof(hdr.ledger_count)) != 0)
       return fclose(f), -1;
   }
   int count = (int)hdr.count;
@@ -240,7 +284,28 @@ int state_load_from_file(const char *path) {
       }
     }
   }
+  uint8_t *ledgers = NULL;
+  int ledger_count = 0;
+  size_t ledger_record_size = board_manager_ledger_record_size();
+  if (hdr.version >= WAMBLE_STATE_LEDGER_REVISION && hdr.ledger_count > 0) {
+    ledger_count = (int)hdr.ledger_count;
+    if (ledger_count < 0)
+      ledger_count = 0;
+    ledgers = (uint8_t *)malloc(ledger_record_size * (size_t)ledger_count);
+    if (!ledgers ||
+        state_read_all(f, ledgers, ledger_record_size * (size_t)ledger_count) !=
+            0) {
+      free(ledgers);
+      free(spectators);
+      free(tmp);
+      fclose(f);
+      return -1;
+    }
+  }
   int rc = board_manager_import(tmp, count, hdr.next_id);
+  if (rc == 0)
+    rc = board_manager_import_ledger_records(ledgers, ledger_record_size,
+                                             ledger_count);
   if (rc == 0 && hdr.version >= WAMBLE_STATE_SPECTATOR_REVISION) {
     if (hdr.version >= WAMBLE_STATE_FIXED_SPECTATOR_REVISION) {
       rc = spectator_manager_import_state_records(
@@ -251,6 +316,7 @@ int state_load_from_file(const char *path) {
           spectator_count);
     }
   }
+  free(ledgers);
   free(spectators);
   free(tmp);
   fclose(f);
@@ -0,0 +1,283 @@
+#include "../include/wamble/wamble.h"
+
+#define TREATMENT_INDEX_MAX_STORES 16
+#define TREATMENT_INDEX_MIN_BUCKETS 32
+
+typedef struct TreatmentIndexEdge {
+  char source_group_key[128];
+  char target_group_key[128];
+} TreatmentIndexEdge;
+
+typedef struct TreatmentIndexStore {
+  WambleIndexStore base;
+  int has_rules;
+  WambleTreatmentOutputRow *outputs;
+  int output_count;
+  int output_capacity;
+  TreatmentIndexEdge *edges;
+  int edge_count;
+  int edge_capacity;
+  WambleIndexBuckets buckets;
+} TreatmentIndexStore;
+
+typedef struct TreatmentIndexProbe {
+  const char *group_key;
+  const char *hook_name;
+} TreatmentIndexProbe;
+
+static void treatment_store_clear(void *store) {
+  TreatmentIndexStore *st = (TreatmentIndexStore *)store;
+  st->has_rules = 0;
+  st->output_count = 0;
+  st->edge_count = 0;
+  index_buckets_free(&st->buckets);
+}
+
+static TreatmentIndexStore g_treatment_index_stores[TREATMENT_INDEX_MAX_STORES];
+static WambleIndexSet g_treatment_index = {
+    .stores = g_treatment_index_stores,
+    .max_stores = TREATMENT_INDEX_MAX_STORES,
+    .store_size = sizeof(TreatmentIndexStore),
+    .clear = treatment_store_clear,
+};
+
+static uint64_t treatment_index_hash(const char *group_key,
+                                     const char *hook_name) {
+  uint64_t h = 1469598103934665603ULL;
+  for (const unsigned char *p = (const unsigned char *)group_key; *p; p++) {
+    h ^= (uint64_t)*p;
+    h *= 1099511628211ULL;
+  }
+  h ^= 0xffu;
+  h *= 1099511628211ULL;
+  for (const unsigned char *p = (const unsigned char *)hook_name; *p; p++) {
+    h ^= (uint64_t)*p;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+static uint64_t treatment_output_hash(const void *row) {
+  const WambleTreatmentOutputRow *r = (const WambleTreatmentOutputRow *)row;
+  return treatment_index_hash(r->group_key, r->action.hook_name);
+}
+
+static int treatment_output_same_group(const void *a, const void *b) {
+  const WambleTreatmentOutputRow *ra = (const WambleTreatmentOutputRow *)a;
+  const WambleTreatmentOutputRow *rb = (const WambleTreatmentOutputRow *)b;
+  return strcmp(ra->group_key, rb->group_key) == 0 &&
+         strcmp(ra->action.hook_name, rb->action.hook_name) == 0;
+}
+
+static int treatment_output_matches(const void *row, const void *probe) {
+  const WambleTreatmentOutputRow *r = (const WambleTreatmentOutputRow *)row;
+  const TreatmentIndexProbe *p = (const TreatmentIndexProbe *)probe;
+  return strcmp(r->group_key, p->group_key) == 0 &&
+         strcmp(r->action.hook_name, p->hook_name) == 0;
+}
+
+static int treatment_output_cmp(const void *a, const void *b) {
+  const WambleTreatmentOutputRow *ra = (const WambleTreatmentOutputRow *)a;
+  const WambleTreatmentOutputRow *rb = (const WambleTreatmentOutputRow *)b;
+  int c = strcmp(ra->group_key, rb->group_key);
+  if (c != 0)
+    return c;
+  c = strcmp(ra->action.hook_name, rb->action.hook_name);
+  if (c != 0)
+    return c;
+  if (ra->id != rb->id)
+    return ra->id < rb->id ? -1 : 1;
+  return 0;
+}
+
+static int treatment_edge_cmp(const void *a, const void *b) {
+  const TreatmentIndexEdge *ea = (const TreatmentIndexEdge *)a;
+  const TreatmentIndexEdge *eb = (const TreatmentIndexEdge *)b;
+  int c = strcmp(ea->source_group_key, eb->source_group_key);
+  if (c != 0)
+    return c;
+  return strcmp(ea->target_group_key, eb->target_group_key);
+}
+
+static int treatment_store_build(void *store, void *arg) {
+  TreatmentIndexStore *st = (TreatmentIndexStore *)store;
+  if (st->output_count > 1)
+    qsort(st->outputs, (size_t)st->output_count, sizeof(*st->outputs),
+          treatment_output_cmp);
+  if (st->edge_count > 1)
+    qsort(st->edges, (size_t)st->edge_count, sizeof(*st->edges),
+          treatment_edge_cmp);
+  if (index_buckets_build(&st->buckets, TREATMENT_INDEX_MIN_BUCKETS,
+                          st->outputs, st->output_count, sizeof(*st->outputs),
+                          treatment_output_hash,
+                          treatment_output_same_group) != 0)
+    return -1;
+  st->has_rules = *(const int *)arg ? 1 : 0;
+  return 0;
+}
+
+static const WambleIndexBucket *
+treatment_store_bucket(const TreatmentIndexStore *st, const char *group_key,
+                       const char *hook_name) {
+  TreatmentIndexProbe probe = {group_key, hook_name};
+  return index_buckets_find(
+      &st->buckets, treatment_index_hash(group_key, hook_name), st->outputs,
+      sizeof(*st->outputs), treatment_output_matches, &probe);
+}
+
+static int treatment_store_has_edge(const TreatmentIndexStore *st,
+                                    const char *source_group_key,
+                                    const char *target_group_key) {
+  TreatmentIndexEdge probe;
+  snprintf(probe.source_group_key, sizeof(probe.source_group_key), "%s",
+           source_group_key);
+  snprintf(probe.target_group_key, sizeof(probe.target_group_key), "%s",
+           target_group_key);
+  return st->edge_count > 0 &&
+         bsearch(&probe, st->edges, (size_t)st->edge_count, sizeof(probe),
+                 treatment_edge_cmp) != NULL;
+}
+
+static int treatment_materialize(const WambleTreatmentOutputRow *row,
+                                 const WambleFact *facts, int fact_count,
+                                 WambleTreatmentAction *out) {
+  *out = row->action;
+  if (out->value_type != WAMBLE_TREATMENT_VALUE_FACT_REF)
+    return 0;
+  for (int i = 0; facts && i < fact_count; i++) {
+    const WambleFact *fact = &facts[i];
+    if (strcmp(fact->key, row->fact_ref) != 0)
+      continue;
+    out->value_type = fact->value_type;
+    if (fact->value_type == WAMBLE_TREATMENT_VALUE_STRING) {
+      snprintf(out->string_value, sizeof(out->string_value), "%s",
+               fact->string_value);
+    } else if (fact->value_type == WAMBLE_TREATMENT_VALUE_INT) {
+      out->int_value = fact->int_value;
+    } else if (fact->value_type == WAMBLE_TREATMENT_VALUE_DOUBLE) {
+      out->double_value = fact->double_value;
+    } else if (fact->value_type == WAMBLE_TREATMENT_VALUE_BOOL) {
+      out->bool_value = fact->bool_value;
+    }
+    return 0;
+  }
+  return -1;
+}
+
+void treatment_index_reset(const char *store) {
+  index_set_reset(&g_treatment_index, store);
+}
+
+uint64_t treatment_index_seed_begin(const char *store) {
+  return index_set_seed_begin(&g_treatment_index, store);
+}
+
+int treatment_index_seed_output(const char *store, uint64_t seed,
+                                const WambleTreatmentOutputRow *row) {
+  int rc = -1;
+  if (!row)
+    return -1;
+  index_set_lock(&g_treatment_index);
+  TreatmentIndexStore *st =
+      index_set_seeding_locked(&g_treatment_index, store, seed);
+  if (st) {
+    rc = index_rows_push((void **)&st->outputs, &st->output_count,
+                         &st->output_capacity, sizeof(*row), 32, row);
+    if (rc != 0)
+      index_set_clear_locked(&g_treatment_index, st);
+  }
+  index_set_unlock(&g_treatment_index);
+  return rc;
+}
+
+int treatment_index_seed_edge(const char *store, uint64_t seed,
+                              const char *source_group_key,
+                              const char *target_group_key) {
+  int rc = -1;
+  if (!source_group_key || !target_group_key)
+    return -1;
+  TreatmentIndexEdge edge;
+  snprintf(edge.source_group_key, sizeof(edge.source_group_key), "%s",
+           source_group_key);
+  snprintf(edge.target_group_key, sizeof(edge.target_group_key), "%s",
+           target_group_key);
+  index_set_lock(&g_treatment_index);
+  TreatmentIndexStore *st =
+      index_set_seeding_locked(&g_treatment_index, store, seed);
+  if (st) {
+    rc = index_rows_push((void **)&st->edges, &st->edge_count,
+                         &st->edge_capacity, sizeof(edge), 16, &edge);
+    if (rc != 0)
+      index_set_clear_locked(&g_treatment_index, st);
+  }
+  index_set_unlock(&g_treatment_index);
+  return rc;
+}
+
+int treatment_index_seed_end(const char *store, uint64_t seed, int has_rules) {
+  return index_set_seed_end(&g_treatment_index, store, seed,
+                            treatment_store_build, &has_rules);
+}
+
+int treatment_index_has_rules(const char *store) {
+  int rc = -1;
+  index_set_lock(&g_treatment_index);
+  TreatmentIndexStore *st =
+      index_set_store_locked(&g_treatment_index, store, 0);
+  if (st && st->base.ready)
+    rc = st->has_rules;
+  index_set_unlock(&g_treatment_index);
+  return rc;
+}
+
+int treatment_index_edge_allows(const char *store, const char *source_group_key,
+                                const char *target_group_key) {
+  if (!source_group_key || !source_group_key[0] || !target_group_key ||
+      !target_group_key[0])
+    return 1;
+  int rc = -1;
+  index_set_lock(&g_treatment_index);
+  TreatmentIndexStore *st =
+      index_set_store_locked(&g_treatment_index, store, 0);
+  if (st && st->base.ready) {
+    rc = !st->has_rules ||
+         treatment_store_has_edge(st, source_group_key, target_group_key) ||
+         treatment_store_has_edge(st, source_group_key, "*");
+  }
+  index_set_unlock(&g_treatment_index);
+  return rc;
+}
+
+int treatment_index_resolve(const char *store, const char *group_key,
+                            const char *hook_name, const WambleFact *facts,
+                            int fact_count, WambleTreatmentAction *out,
+                            int max_out, int *out_count) {
+  if (out_count)
+    *out_count = 0;
+  if (!group_key || !hook_name || !out || max_out <= 0)
+    return -1;
+  int rc = -1;
+  index_set_lock(&g_treatment_index);
+  TreatmentIndexStore *st =
+      index_set_store_locked(&g_treatment_index, store, 0);
+  if (st && st->base.ready) {
+    const char *hooks[2] = {hook_name, "*"};
+    int hook_count = strcmp(hook_name, "*") == 0 ? 1 : 2;
+    int n = 0;
+    for (int h = 0; h < hook_count && n < max_out; h++) {
+      const WambleIndexBucket *b =
+          treatment_store_bucket(st, group_key, hooks[h]);
+      for (int i = 0; b && i < b->count && n < max_out; i++) {
+        if (treatment_materialize(&st->outputs[b->start + i], facts,
+                                  fact_count, &out[n]) != 0)
+          memset(&out[n], 0, sizeof(out[n]));
+        n++;
+      }
+    }
+    if (out_count)
+      *out_count = n;
+    rc = 0;
+  }
+  index_set_unlock(&g_treatment_index);
+  return rc;
+}
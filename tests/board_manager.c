@@ -393,6 +393,137 @@ WAMBLE_TEST(board_pairing_uses_persistent_treatment_without_live_network) {
   return 0;
 }
 
+static void board_test_play_move(uint64_t board_id, const uint8_t *token,
+                                 const char *uci, const char *fen_after) {
+  WambleBoard *board = get_board_by_id(board_id);
+  if (!board)
+    return;
+  snprintf(board->fen, sizeof(board->fen), "%s", fen_after);
+  parse_fen_to_bitboard(board->fen, &board->board);
+  board_move_played(board_id, token, uci);
+}
+
+WAMBLE_TEST(board_contributor_ledger_tracks_moves_across_state_reload) {
+  char msg[128];
+  T_ASSERT_STATUS(config_load(NULL, NULL, msg, sizeof(msg)),
+                  CONFIG_LOAD_DEFAULTS);
+  player_manager_init();
+  board_manager_init();
+
+  WambleBoard boards[2];
+  memset(boards, 0, sizeof(boards));
+  boards[0].id = 300;
+  snprintf(boards[0].fen, sizeof(boards[0].fen), "%s",
+           "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  parse_fen_to_bitboard(boards[0].fen, &boards[0].board);
+  boards[0].state = BOARD_STATE_ACTIVE;
+  boards[0].result = GAME_RESULT_IN_PROGRESS;
+  boards[1] = boards[0];
+  boards[1].id = 301;
+  snprintf(boards[1].fen, sizeof(boards[1].fen), "%s",
+           "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2");
+  parse_fen_to_bitboard(boards[1].fen, &boards[1].board);
+  T_ASSERT_EQ_INT(board_manager_import(boards, 2, 302), 0);
+
+  uint8_t alice[TOKEN_LENGTH];
+  uint8_t bob[TOKEN_LENGTH];
+  memset(alice, 0xA1, sizeof(alice));
+  memset(bob, 0xB0, sizeof(bob));
+  board_test_play_move(
+      300, alice, "e2e4",
+      "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1");
+  board_test_play_move(
+      300, bob, "e7e5",
+      "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2");
+  board_test_play_move(
+      300, alice, "g1f3",
+      "rnbqkbnr/pppp1ppp/8/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 1 2");
+  board_test_play_move(
+      301, alice, "g1f3",
+      "rnbqkbnr/pppp1ppp/8/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 1 2");
+
+  WambleContributor rows[4];
+  int count = 0;
+  T_ASSERT_EQ_INT(board_manager_contributors(301, rows, 4, &count), -1);
+  T_ASSERT_EQ_INT(board_manager_contributors(300, rows, 4, &count), 0);
+  T_ASSERT_EQ_INT(count, 2);
+  T_ASSERT(tokens_equal(rows[0].player_token, alice));
+  T_ASSERT_EQ_INT(rows[0].white_moves, 2);
+  T_ASSERT_EQ_INT(rows[0].black_moves, 0);
+  T_ASSERT(tokens_equal(rows[1].player_token, bob));
+  T_ASSERT_EQ_INT(rows[1].white_moves, 0);
+  T_ASSERT_EQ_INT(rows[1].black_moves, 1);
+
+  char path[256];
+  T_ASSERT_EQ_INT(
+      wamble_test_path(path, sizeof(path), "board_manager", "ledger.bin"), 0);
+  T_ASSERT_EQ_INT(state_save_to_file(path), 0);
+  board_manager_init();
+  T_ASSERT_EQ_INT(board_manager_contributors(300, rows, 4, &count), -1);
+  T_ASSERT_EQ_INT(state_load_from_file(path), 0);
+  wamble_unlink(path);
+
+  memset(rows, 0, sizeof(rows));
+  T_ASSERT_EQ_INT(board_manager_contributors(300, rows, 4, &count), 0);
+  T_ASSERT_EQ_INT(count, 2);
+  T_ASSERT(tokens_equal(rows[0].player_token, alice));
+  T_ASSERT_EQ_INT(rows[0].white_moves, 2);
+  T_ASSERT_EQ_INT(rows[1].black_moves, 1);
+  T_ASSERT_EQ_INT(board_manager_contributors(301, rows, 4, &count), -1);
+  return 0;
+}
+
+WAMBLE_TEST(board_cache_eviction_does_not_leak_contributor_ledger) {
+  if (board_manager_db_prepare() != 0)
+    T_FAIL_SIMPLE("board_manager_db_prepare failed");
+  const char *cfg_path = "build/test_board_cache_eviction_ledger.conf";
+  const char *cfg = "(def max-boards 2)\n"
+                    "(def min-boards 0)\n";
+  T_ASSERT_EQ_INT(wamble_test_write_optional_db_config_file(cfg_path, cfg), 0);
+  T_ASSERT_STATUS(config_load(cfg_path, NULL, NULL, 0), CONFIG_LOAD_OK);
+  player_manager_init();
+  board_manager_init();
+
+  WambleBoard boards[2];
+  memset(boards, 0, sizeof(boards));
+  boards[0].id = 500;
+  snprintf(boards[0].fen, sizeof(boards[0].fen), "%s",
+           "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  parse_fen_to_bitboard(boards[0].fen, &boards[0].board);
+  boards[0].state = BOARD_STATE_ACTIVE;
+  boards[0].result = GAME_RESULT_IN_PROGRESS;
+  boards[1] = boards[0];
+  boards[1].id = 501;
+  T_ASSERT_EQ_INT(board_manager_import(boards, 2, 502), 0);
+
+  uint8_t alice[TOKEN_LENGTH];
+  memset(alice, 0xA1, sizeof(alice));
+  board_test_play_move(
+      501, alice, "e2e4",
+      "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1");
+
+  T_ASSERT_EQ_INT(
+      db_insert_board(777,
+                      "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w "
+                      "KQkq - 0 2",
+                      "ACTIVE"),
+      0);
+  WambleBoard *loaded = get_board_by_id(777);
+  T_ASSERT(loaded != NULL);
+  T_ASSERT_EQ_INT((int)loaded->id, 777);
+
+  WambleContributor rows[2];
+  int count = 0;
+  T_ASSERT_EQ_INT(board_manager_contributors(777, rows, 2, &count), -1);
+  T_ASSERT_EQ_INT(board_manager_contributors(501, rows, 2, &count), 0);
+  T_ASSERT_EQ_INT(count, 1);
+  T_ASSERT(tokens_equal(rows[0].player_token, alice));
+  WambleBoard *kept = get_board_by_id(501);
+  T_ASSERT(kept != NULL);
+  T_ASSERT_EQ_INT((int)kept->id, 501);
+  return 0;
+}
+
 WAMBLE_TESTS_BEGIN_NAMED(board_manager_tests) {
   WAMBLE_TESTS_ADD_FM(board_reservation_flow, "board_manager");
   WAMBLE_TESTS_ADD_FM(board_move_transitions_to_active, "board_manager");
@@ -409,6 +540,8 @@ WAMBLE_TESTS_BEGIN_NAMED(board_manager_tests) {
                       "board_manager");
   WAMBLE_TESTS_ADD_FM(board_inactivity_dormant_enqueues_release_for_last_mover,
                       "board_manager");
+  WAMBLE_TESTS_ADD_FM(board_contributor_ledger_tracks_moves_across_state_reload,
+                      "board_manager");
   WAMBLE_TESTS_ADD_DB_FM(
       board_pairing_fails_closed_when_current_assignment_missing,
       "board_manager");
@@ -418,5 +551,7 @@ WAMBLE_TESTS_BEGIN_NAMED(board_manager_tests) {
   WAMBLE_TESTS_ADD_DB_FM(
       board_pairing_uses_persistent_treatment_without_live_network,
       "board_manager");
+  WAMBLE_TESTS_ADD_DB_FM(board_cache_eviction_does_not_leak_contributor_ledger,
+                         "board_manager");
 }
 WAMBLE_TESTS_END()
@@ -559,6 +559,8 @@ int test_db_apply_sql_file(const char *sql_path) {
   }
   free(buf);
   PQfinish(c);
+  db_invalidate_policy_index();
+  db_invalidate_treatment_index();
   return rc;
 #else
   (void)sql_path;
@@ -728,5 +730,8 @@ int wamble_test_prepare_db(const char *cfg_path, const char *cfg_suffix,
     fprintf(stderr, "[test-db] apply_sql failed path=%s\n", cfg_path);
     return -1;
   }
+  db_invalidate_leaderboard_index();
+  db_invalidate_policy_index();
+  db_invalidate_treatment_index();
   return 0;
 }
@@ -185,7 +185,8 @@ void wamble_emit_record_payout_with_canonical(uint64_t board_id,
                                               const uint8_t *token,
                                               double points,
                                               double canonical_points);
-void wamble_emit_update_player_rating(const uint8_t *token, double rating);
+void wamble_emit_update_player_rating(const uint8_t *token,
+                                      uint64_t session_id, double rating);
 void wamble_emit_resolve_prediction(uint64_t board_id, const uint8_t *token,
                                     int move_number, const char *status,
                                     double points_awarded);
@@ -296,20 +297,15 @@ typedef struct TransportDriveResult {
 typedef uint64_t TransportEndpointId;
 #define TRANSPORT_ENDPOINT_ID_INVALID ((TransportEndpointId)0)
 
-typedef struct TransportInboundEntry {
+typedef struct TransportPacketSlot {
   TransportPacketSource source;
   TransportEndpointId endpoint_id;
   struct sockaddr_in addr;
   size_t packet_len;
+  uint32_t next_free;
+  WambleMsgView view;
   uint8_t packet[WAMBLE_MAX_PACKET_SIZE];
-} TransportInboundEntry;
-
-typedef struct TransportDispatchEntry {
-  TransportPacketSource source;
-  TransportEndpointId endpoint_id;
-  struct sockaddr_in addr;
-  struct WambleMsg msg;
-} TransportDispatchEntry;
+} TransportPacketSlot;
 
 typedef struct TransportOutboundEntry {
   TransportOutboundVariant variant;
@@ -319,6 +315,7 @@ typedef struct TransportOutboundEntry {
   uint8_t token[TOKEN_LENGTH];
   uint8_t *payload;
   size_t payload_len;
+  struct TransportSharedPayload *shared;
   union {
     struct {
       uint32_t seq;
@@ -385,6 +382,7 @@ int server_protocol_thread_pending_login_challenge_count(void);
 int server_protocol_test_issue_login_challenge(const uint8_t *token,
                                                const uint8_t *public_key);
 void server_protocol_test_clear_login_challenges(void);
+void server_protocol_thread_cleanup(void);
 int board_manager_count_active_or_reserved(void);
 int spectator_collect_state_snapshot(const uint8_t *token,
                                      struct SpectatorUpdate *out, int max);
@@ -402,14 +400,23 @@ int network_enqueue_reliable(const struct WambleMsg *msg,
                              int max_retries);
 int network_enqueue_replayable_terminal(const struct WambleMsg *msg,
                                         const struct sockaddr_in *cliaddr);
+int network_set_endpoint_capabilities(const struct sockaddr_in *cliaddr,
+                                      const uint8_t *token, uint8_t caps);
 int network_enqueue_ack_after(const struct WambleMsg *msg,
                               const struct sockaddr_in *cliaddr);
 int network_enqueue_unreliable(const struct WambleMsg *msg,
                                const struct sockaddr_in *cliaddr);
+int network_endpoint_delivery_state(const struct sockaddr_in *addr,
+                                    uint32_t *out_srtt_ms,
+                                    uint32_t *out_backlog);
+int server_protocol_enqueue_spectator_batch(SpectatorUpdate *events, int count,
+                                            uint8_t ctrl);
 int network_get_client_addr_by_token(const uint8_t *token,
                                      struct sockaddr_in *out_addr);
 int network_protocol_thread_pending_packet_count(void);
 int network_protocol_thread_terminal_cache_packet_count(void);
+int network_protocol_thread_terminal_arena_capacity(void);
+int network_protocol_thread_session_count(void);
 int network_test_store_terminal_cache_packet(const uint8_t *token,
                                              const struct sockaddr_in *addr,
                                              uint32_t req_seq);
@@ -421,11 +428,17 @@ int network_enqueue_reliable_payload_bytes(uint8_t ctrl, const uint8_t *token,
                                            const struct sockaddr_in *cliaddr,
                                            int timeout_ms, int max_retries,
                                            int force_fragment);
-int transport_inbound_push(const TransportInboundEntry *entry);
-int transport_inbound_pop(TransportInboundEntry *out);
+int transport_packet_acquire(TransportPacketSource source,
+                             const struct sockaddr_in *addr,
+                             uint32_t *out_slot);
+TransportPacketSlot *transport_packet_get(uint32_t slot);
+void transport_packet_release(uint32_t slot);
+size_t transport_packet_available(void);
+int transport_inbound_push(uint32_t slot);
+int transport_inbound_pop(uint32_t *out_slot);
 size_t transport_inbound_count(void);
-int transport_dispatch_push(const TransportDispatchEntry *entry);
-int transport_dispatch_pop(TransportDispatchEntry *out);
+int transport_dispatch_push(uint32_t slot);
+int transport_dispatch_pop(uint32_t *out_slot);
 size_t transport_dispatch_count(void);
 int transport_outbound_push(const TransportOutboundEntry *entry);
 void transport_outbound_remove(size_t index);
@@ -438,6 +451,19 @@ int transport_endpoint_rebind_id(TransportEndpointId endpoint_id,
 int transport_endpoint_resolve_addr(TransportEndpointId endpoint_id,
                                     struct sockaddr_in *out);
 uint32_t transport_endpoint_rto_ms_by_id(TransportEndpointId endpoint_id);
+uint32_t transport_endpoint_cwnd_by_id(TransportEndpointId endpoint_id);
+int network_rate_limit_allow(const uint8_t *token, int max_per_sec);
+int login_verify_pool_init(void);
+void login_verify_pool_shutdown(void);
+uint64_t login_verify_submit(const uint8_t *signature,
+                             const uint8_t *public_key,
+                             const uint8_t *message, size_t message_len,
+                             wamble_socket_t wake_sockfd);
+int login_verify_poll(uint64_t *ticket, int *verified);
+int login_verify_pending(void);
+void login_verify_thread_discard(void);
+int network_addr_prefilter_allow(const struct sockaddr_in *addr,
+                                 int max_per_sec);
 int transport_endpoint_update_rto_by_id(TransportEndpointId endpoint_id,
                                         uint32_t sample_ms, int retransmitted);
 TransportDriveResult transport_drive_result_idle(void);
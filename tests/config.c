@@ -52,6 +52,8 @@ WAMBLE_TEST(config_defaults_no_file) {
   T_ASSERT_EQ_INT(get_config()->timeout_ms, 100);
   T_ASSERT_EQ_INT(get_config()->rto_cap_ms, 8000);
   T_ASSERT_EQ_INT(get_config()->rate_limit_requests_per_sec, 120);
+  T_ASSERT_EQ_INT(get_config()->rate_limit_addr_packets_per_sec, 2000);
+  T_ASSERT_EQ_INT(get_config()->udp_segment_offload, 1);
   T_ASSERT_EQ_INT(get_config()->experiment_enabled, 0);
   T_ASSERT_EQ_INT(get_config()->experiment_seed, 0);
   T_ASSERT_EQ_INT(get_config()->log_level, LOG_LEVEL_INFO);
@@ -1516,6 +1518,221 @@ WAMBLE_TEST(config_db_treatment_scopes_by_profile_source) {
   return 0;
 }
 
+static void policy_index_test_rule(WamblePolicyRuleRow *row, uint64_t id,
+                                   uint64_t identity_id, const char *action,
+                                   const char *resource, const char *scope,
+                                   const char *effect, int level) {
+  memset(row, 0, sizeof(*row));
+  row->id = id;
+  row->global_identity_id = identity_id;
+  row->permission_level = level;
+  row->not_before_at = INT64_MIN;
+  row->not_after_at = INT64_MAX;
+  snprintf(row->action, sizeof(row->action), "%s", action);
+  snprintf(row->resource, sizeof(row->resource), "%s", resource);
+  snprintf(row->scope, sizeof(row->scope), "%s", scope);
+  snprintf(row->effect, sizeof(row->effect), "%s", effect);
+  snprintf(row->policy_version, sizeof(row->policy_version), "v1");
+}
+
+WAMBLE_TEST(config_policy_index_follows_rule_precedence) {
+  const char *store = "test:policy_index";
+  WamblePolicyRuleRow rows[9];
+  WamblePolicyRuleRow out;
+  policy_index_reset(store);
+  T_ASSERT_EQ_INT(policy_index_resolve(store, 7, "game.move", "board", "", "",
+                                       NULL, NULL, 100, &out),
+                  -1);
+  policy_index_test_rule(&rows[0], 1, 0, "game.move", "*", "*", "allow", 1);
+  policy_index_test_rule(&rows[1], 2, 0, "game.move", "board",
+                         "profile_group:ranked", "allow", 2);
+  policy_index_test_rule(&rows[2], 3, 0, "game.move", "board", "profile:alpha",
+                         "allow", 3);
+  policy_index_test_rule(&rows[3], 4, 0, "game.move", "board", "profile:alpha",
+                         "deny", 0);
+  policy_index_test_rule(&rows[4], 5, 7, "game.move", "*", "*", "allow", 5);
+  policy_index_test_rule(&rows[5], 6, 0, "spectate", "board", "profile:alpha",
+                         "allow", 1);
+  policy_index_test_rule(&rows[6], 7, 0, "game.move", "board", "profile:alpha",
+                         "allow", 7);
+  rows[6].has_context = 1;
+  snprintf(rows[6].context_key, sizeof(rows[6].context_key), "mode");
+  snprintf(rows[6].context_value, sizeof(rows[6].context_value), "blitz");
+  policy_index_test_rule(&rows[7], 8, 9, "game.move", "board", "*", "allow",
+                         8);
+  rows[7].not_after_at = 50;
+  policy_index_test_rule(&rows[8], 9, 9, "game.move", "board", "*", "allow",
+                         9);
+  rows[8].not_before_at = 200;
+
+  uint64_t seed = policy_index_seed_begin(store);
+  T_ASSERT(seed != 0);
+  for (int i = 0; i < 9; i++)
+    T_ASSERT_EQ_INT(policy_index_seed_row(store, seed, &rows[i]), 0);
+  policy_index_reset(store);
+  T_ASSERT_EQ_INT(policy_index_seed_end(store, seed), -1);
+  T_ASSERT(!policy_index_ready(store));
+
+  seed = policy_index_seed_begin(store);
+  for (int i = 0; i < 9; i++)
+    T_ASSERT_EQ_INT(policy_index_seed_row(store, seed, &rows[i]), 0);
+  T_ASSERT_EQ_INT(policy_index_seed_end(store, seed), 0);
+
+  T_ASSERT_EQ_INT(policy_index_resolve(store, 7, "game.move", "board",
+                                       "profile:alpha", "profile_group:ranked",
+                                       NULL, NULL, 100, &out),
+                  1);
+  T_ASSERT(out.id == 5);
+  T_ASSERT_EQ_INT(policy_index_resolve(store, 3, "game.move", "board",
+                                       "profile:alpha", "profile_group:ranked",
+                                       NULL, NULL, 100, &out),
+                  1);
+  T_ASSERT(out.id == 4);
+  T_ASSERT_EQ_INT(policy_index_resolve(store, 3, "game.move", "board",
+                                       "profile:alpha", "profile_group:ranked",
+                                       "mode", "blitz", 100, &out),
+                  1);
+  T_ASSERT(out.id == 7);
+  T_ASSERT_EQ_INT(policy_index_resolve(store, 3, "game.move", "board",
+                                       "profile:beta", "profile_group:ranked",
+                                       NULL, NULL, 100, &out),
+                  1);
+  T_ASSERT(out.id == 2);
+  T_ASSERT_EQ_INT(policy_index_resolve(store, 3, "game.move", "pieces",
+                                       "profile:beta", "profile_group:casual",
+                                       NULL, NULL, 100, &out),
+                  1);
+  T_ASSERT(out.id == 1);
+  T_ASSERT_EQ_INT(policy_index_resolve(store, 9, "game.move", "board",
+                                       "profile:beta", "", NULL, NULL, 100,
+                                       &out),
+                  1);
+  T_ASSERT(out.id == 1);
+  T_ASSERT_EQ_INT(policy_index_resolve(store, 9, "game.move", "board",
+                                       "profile:beta", "", NULL, NULL, 300,
+                                       &out),
+                  1);
+  T_ASSERT(out.id == 9);
+  T_ASSERT_EQ_INT(policy_index_resolve(store, 3, "spectate", "board",
+                                       "profile:beta", "", NULL, NULL, 100,
+                                       &out),
+                  0);
+  T_ASSERT_EQ_INT(policy_index_has_action(store, "game.move", 1), 1);
+  T_ASSERT_EQ_INT(policy_index_has_action(store, "spectate", 0), 1);
+  T_ASSERT_EQ_INT(policy_index_has_action(store, "trust.tier", 0), 0);
+  policy_index_reset(store);
+  T_ASSERT_EQ_INT(policy_index_has_action(store, "game.move", 0), -1);
+  policy_index_test_rule(&rows[0], 1, 0, "trust.tier", "tier", "*", "allow",
+                         1);
+  seed = policy_index_seed_begin(store);
+  T_ASSERT_EQ_INT(policy_index_seed_row(store, seed, &rows[0]), 0);
+  T_ASSERT_EQ_INT(policy_index_seed_end(store, seed), 0);
+  T_ASSERT_EQ_INT(policy_index_has_action(store, "trust.tier", 0), 1);
+  T_ASSERT_EQ_INT(policy_index_has_action(store, "trust.tier", 1), 0);
+  policy_index_reset(store);
+  return 0;
+}
+
+static void treatment_index_test_output(WambleTreatmentOutputRow *row,
+                                        uint64_t id, const char *group_key,
+                                        const char *hook_name,
+                                        const char *output_key,
+                                        int64_t int_value) {
+  memset(row, 0, sizeof(*row));
+  row->id = id;
+  snprintf(row->group_key, sizeof(row->group_key), "%s", group_key);
+  snprintf(row->action.hook_name, sizeof(row->action.hook_name), "%s",
+           hook_name);
+  snprintf(row->action.output_kind, sizeof(row->action.output_kind),
+           "behavior");
+  snprintf(row->action.output_key, sizeof(row->action.output_key), "%s",
+           output_key);
+  row->action.value_type = WAMBLE_TREATMENT_VALUE_INT;
+  row->action.int_value = int_value;
+}
+
+WAMBLE_TEST(config_treatment_index_orders_hook_outputs) {
+  const char *store = "test:treatment_index";
+  const char *empty_store = "test:treatment_index_empty";
+  WambleTreatmentOutputRow rows[5];
+  WambleTreatmentAction out[8];
+  int count = 0;
+  treatment_index_reset(store);
+  T_ASSERT_EQ_INT(treatment_index_has_rules(store), -1);
+  T_ASSERT_EQ_INT(treatment_index_resolve(store, "vip", "board.read", NULL, 0,
+                                          out, 8, &count),
+                  -1);
+
+  treatment_index_test_output(&rows[0], 4, "vip", "*", "wild.late", 4);
+  treatment_index_test_output(&rows[1], 2, "vip", "board.read", "exact.late",
+                              2);
+  treatment_index_test_output(&rows[2], 1, "vip", "board.read", "exact.early",
+                              1);
+  treatment_index_test_output(&rows[3], 3, "vip", "*", "wild.early", 3);
+  treatment_index_test_output(&rows[4], 5, "control", "board.read", "ref", 0);
+  rows[4].action.value_type = WAMBLE_TREATMENT_VALUE_FACT_REF;
+  snprintf(rows[4].fact_ref, sizeof(rows[4].fact_ref), "board.ply");
+
+  uint64_t seed = treatment_index_seed_begin(store);
+  T_ASSERT(seed != 0);
+  for (int i = 0; i < 5; i++)
+    T_ASSERT_EQ_INT(treatment_index_seed_output(store, seed, &rows[i]), 0);
+  T_ASSERT_EQ_INT(treatment_index_seed_edge(store, seed, "vip", "control"), 0);
+  T_ASSERT_EQ_INT(treatment_index_seed_edge(store, seed, "control", "*"), 0);
+  T_ASSERT_EQ_INT(treatment_index_seed_end(store, seed, 1), 0);
+  T_ASSERT_EQ_INT(treatment_index_has_rules(store), 1);
+
+  T_ASSERT_EQ_INT(treatment_index_resolve(store, "vip", "board.read", NULL, 0,
+                                          out, 8, &count),
+                  0);
+  T_ASSERT_EQ_INT(count, 4);
+  T_ASSERT_STREQ(out[0].output_key, "exact.early");
+  T_ASSERT_STREQ(out[1].output_key, "exact.late");
+  T_ASSERT_STREQ(out[2].output_key, "wild.early");
+  T_ASSERT_STREQ(out[3].output_key, "wild.late");
+  T_ASSERT_EQ_INT(treatment_index_resolve(store, "vip", "board.read", NULL, 0,
+                                          out, 3, &count),
+                  0);
+  T_ASSERT_EQ_INT(count, 3);
+  T_ASSERT_EQ_INT(treatment_index_resolve(store, "vip", "*", NULL, 0, out, 8,
+                                          &count),
+                  0);
+  T_ASSERT_EQ_INT(count, 2);
+  T_ASSERT_STREQ(out[0].output_key, "wild.early");
+
+  WambleFact fact;
+  memset(&fact, 0, sizeof(fact));
+  snprintf(fact.key, sizeof(fact.key), "board.ply");
+  fact.value_type = WAMBLE_TREATMENT_VALUE_INT;
+  fact.int_value = 42;
+  T_ASSERT_EQ_INT(treatment_index_resolve(store, "control", "board.read",
+                                          &fact, 1, out, 8, &count),
+                  0);
+  T_ASSERT_EQ_INT(count, 1);
+  T_ASSERT_EQ_INT((int)out[0].value_type, (int)WAMBLE_TREATMENT_VALUE_INT);
+  T_ASSERT_EQ_INT((int)out[0].int_value, 42);
+  T_ASSERT_EQ_INT(treatment_index_resolve(store, "control", "board.read", NULL,
+                                          0, out, 8, &count),
+                  0);
+  T_ASSERT_EQ_INT(count, 1);
+  T_ASSERT_STREQ(out[0].output_key, "");
+
+  T_ASSERT_EQ_INT(treatment_index_edge_allows(store, "vip", "control"), 1);
+  T_ASSERT_EQ_INT(treatment_index_edge_allows(store, "vip", "beta"), 0);
+  T_ASSERT_EQ_INT(treatment_index_edge_allows(store, "control", "beta"), 1);
+  T_ASSERT_EQ_INT(treatment_index_edge_allows(store, "vip", ""), 1);
+
+  seed = treatment_index_seed_begin(empty_store);
+  T_ASSERT_EQ_INT(treatment_index_seed_end(empty_store, seed, 0), 0);
+  T_ASSERT_EQ_INT(treatment_index_has_rules(empty_store), 0);
+  T_ASSERT_EQ_INT(treatment_index_edge_allows(empty_store, "vip", "beta"), 1);
+
+  treatment_index_reset(NULL);
+  T_ASSERT_EQ_INT(treatment_index_has_rules(store), -1);
+  T_ASSERT_EQ_INT(treatment_index_edge_allows(store, "vip", "beta"), -1);
+  return 0;
+}
+
 WAMBLE_TESTS_BEGIN_NAMED(wamble_register_tests_config)
 WAMBLE_TESTS_ADD_FM(config_basic_eval, "config");
 WAMBLE_TESTS_ADD_FM(config_defaults_no_file, "config");
@@ -1531,6 +1748,8 @@ WAMBLE_TESTS_ADD_EX_SM(config_stress_many_profiles, WAMBLE_SUITE_STRESS,
 WAMBLE_TESTS_ADD_FM(config_parse_doubles_and_strings, "config");
 WAMBLE_TESTS_ADD_FM(config_db_fields_preserve_spacing_and_quotes, "config");
 WAMBLE_TESTS_ADD_FM(config_treatment_groups_parse, "config");
+WAMBLE_TESTS_ADD_FM(config_policy_index_follows_rule_precedence, "config");
+WAMBLE_TESTS_ADD_FM(config_treatment_index_orders_hook_outputs, "config");
 WAMBLE_TESTS_ADD_FM(config_profile_nested_policy_and_treatment_rejected,
                     "config");
 WAMBLE_TESTS_ADD_FM(
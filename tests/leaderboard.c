@@ -0,0 +1,141 @@
+#include "common/wamble_test.h"
+#include "wamble/wamble.h"
+
+#define LB_TEST_SESSIONS 300
+
+static WambleLeaderboardRow g_lb_expected[LB_TEST_SESSIONS];
+
+static int lb_test_before(const WambleLeaderboardRow *a,
+                          const WambleLeaderboardRow *b, uint8_t type) {
+  double a1 = type == WAMBLE_LEADERBOARD_RATING ? a->rating : a->score;
+  double b1 = type == WAMBLE_LEADERBOARD_RATING ? b->rating : b->score;
+  if (a1 != b1)
+    return a1 > b1;
+  double a2 = type == WAMBLE_LEADERBOARD_RATING ? a->score : a->rating;
+  double b2 = type == WAMBLE_LEADERBOARD_RATING ? b->score : b->rating;
+  if (a2 != b2)
+    return a2 > b2;
+  return a->session_id < b->session_id;
+}
+
+static uint32_t lb_test_rank(uint64_t session_id, uint8_t type) {
+  const WambleLeaderboardRow *self = &g_lb_expected[session_id - 1];
+  uint32_t rank = 1;
+  for (int i = 0; i < LB_TEST_SESSIONS; i++) {
+    if (lb_test_before(&g_lb_expected[i], self, type))
+      rank++;
+  }
+  return rank;
+}
+
+static int lb_test_check(const char *store, uint8_t type) {
+  WambleLeaderboardRow rows[WAMBLE_MAX_LEADERBOARD_ENTRIES];
+  WambleLeaderboardRow self;
+  int count = 0;
+  uint32_t self_rank = 0;
+  uint32_t total = 0;
+  for (int offset = 0; offset < LB_TEST_SESSIONS; offset += 37) {
+    uint64_t probe = (uint64_t)(offset % LB_TEST_SESSIONS) + 1;
+    T_ASSERT_EQ_INT(leaderboard_index_query(store, type, probe, 10, offset,
+                                            rows, &count, &self, &self_rank,
+                                            &total),
+                    0);
+    T_ASSERT_EQ_INT((int)total, LB_TEST_SESSIONS);
+    T_ASSERT_EQ_INT((int)self_rank, (int)lb_test_rank(probe, type));
+    T_ASSERT(self.session_id == probe);
+    int expected_count = LB_TEST_SESSIONS - offset < 10
+                             ? LB_TEST_SESSIONS - offset
+                             : 10;
+    T_ASSERT_EQ_INT(count, expected_count);
+    for (int i = 0; i < count; i++) {
+      T_ASSERT_EQ_INT((int)lb_test_rank(rows[i].session_id, type),
+                      offset + i + 1);
+      const WambleLeaderboardRow *want =
+          &g_lb_expected[rows[i].session_id - 1];
+      T_ASSERT(fabs(rows[i].score - want->score) < 1e-9);
+      T_ASSERT(fabs(rows[i].rating - want->rating) < 1e-9);
+      T_ASSERT_EQ_INT((int)rows[i].games_played, (int)want->games_played);
+    }
+  }
+  return 0;
+}
+
+WAMBLE_TEST(leaderboard_index_ranks_match_full_sort) {
+  const char *store = "test:leaderboard_ranks";
+  WambleLeaderboardRow rows[WAMBLE_MAX_LEADERBOARD_ENTRIES];
+  WambleLeaderboardRow self;
+  int count = 0;
+  uint32_t self_rank = 0;
+  uint32_t total = 0;
+  leaderboard_index_reset(store);
+  T_ASSERT_EQ_INT(leaderboard_index_query(store, WAMBLE_LEADERBOARD_SCORE, 1,
+                                          10, 0, rows, &count, &self,
+                                          &self_rank, &total),
+                  -1);
+
+  uint64_t seed = leaderboard_index_seed_begin(store);
+  T_ASSERT(seed != 0);
+  for (int i = 0; i < LB_TEST_SESSIONS; i++) {
+    WambleLeaderboardRow *row = &g_lb_expected[i];
+    memset(row, 0, sizeof(*row));
+    row->session_id = (uint64_t)i + 1;
+    row->player_id = (uint64_t)(i % 40) + 1;
+    row->score = (double)((i * 7919) % 53) / 4.0;
+    row->rating = 1200.0 + (double)((row->player_id * 31) % 17);
+    row->games_played = (uint32_t)(i % 9);
+    T_ASSERT_EQ_INT(leaderboard_index_seed_row(store, seed, row), 0);
+  }
+  T_ASSERT_EQ_INT(leaderboard_index_add_score(store, 1, 1.0), -1);
+  T_ASSERT_EQ_INT(leaderboard_index_seed_end(store, seed), -1);
+  T_ASSERT(!leaderboard_index_ready(store));
+
+  seed = leaderboard_index_seed_begin(store);
+  for (int i = 0; i < LB_TEST_SESSIONS; i++)
+    T_ASSERT_EQ_INT(leaderboard_index_seed_row(store, seed, &g_lb_expected[i]),
+                    0);
+  T_ASSERT_EQ_INT(leaderboard_index_seed_end(store, seed), 0);
+  T_ASSERT(leaderboard_index_ready(store));
+  T_ASSERT_EQ_INT(lb_test_check(store, WAMBLE_LEADERBOARD_SCORE), 0);
+  T_ASSERT_EQ_INT(lb_test_check(store, WAMBLE_LEADERBOARD_RATING), 0);
+
+  for (int i = 0; i < LB_TEST_SESSIONS; i += 3) {
+    T_ASSERT_EQ_INT(leaderboard_index_add_score(store, (uint64_t)i + 1, 2.5),
+                    0);
+    g_lb_expected[i].score += 2.5;
+  }
+  for (int i = 0; i < LB_TEST_SESSIONS; i += 11) {
+    T_ASSERT_EQ_INT(leaderboard_index_add_game(store, (uint64_t)i + 1), 0);
+    g_lb_expected[i].games_played++;
+  }
+  T_ASSERT_EQ_INT(leaderboard_index_set_rating(store, 5, 1500.25), 0);
+  for (int i = 0; i < LB_TEST_SESSIONS; i++) {
+    if (g_lb_expected[i].player_id == g_lb_expected[4].player_id)
+      g_lb_expected[i].rating = 1500.25;
+  }
+  WambleLeaderboardRow moved = g_lb_expected[9];
+  moved.player_id = 0;
+  moved.rating = 0.0;
+  moved.score = 99.0;
+  T_ASSERT_EQ_INT(leaderboard_index_put(store, &moved), 0);
+  g_lb_expected[9] = moved;
+  T_ASSERT_EQ_INT(leaderboard_index_set_rating(store, 10, 1800.0), 0);
+  T_ASSERT_EQ_INT(leaderboard_index_add_score(store, 100000, 1.0), -1);
+
+  T_ASSERT_EQ_INT(lb_test_check(store, WAMBLE_LEADERBOARD_SCORE), 0);
+  T_ASSERT_EQ_INT(lb_test_check(store, WAMBLE_LEADERBOARD_RATING), 0);
+  T_ASSERT_EQ_INT(leaderboard_index_query(store, WAMBLE_LEADERBOARD_SCORE, 10,
+                                          1, 0, rows, &count, &self,
+                                          &self_rank, &total),
+                  0);
+  T_ASSERT(rows[0].session_id == 10);
+  T_ASSERT_EQ_INT((int)self_rank, 1);
+
+  leaderboard_index_reset(store);
+  T_ASSERT(!leaderboard_index_ready(store));
+  return 0;
+}
+
+WAMBLE_TESTS_BEGIN_NAMED(leaderboard_tests) {
+  WAMBLE_TESTS_ADD_FM(leaderboard_index_ranks_match_full_sort, "leaderboard");
+}
+WAMBLE_TESTS_END()
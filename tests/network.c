@@ -5,6 +5,13 @@
 #include "wamble/wamble_db.h"
 
 #include <limits.h>
+#if defined(__linux__)
+#include <netinet/udp.h>
+#include <sys/uio.h>
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#endif
 
 void crypto_blake2b(uint8_t *hash, size_t hash_size, const uint8_t *msg,
                     size_t msg_size);
@@ -143,6 +150,14 @@ static void drive_runtime_until_idle(wamble_socket_t sockfd,
   }
 }
 
+static void drive_runtime_until_logins_settled(wamble_socket_t sockfd,
+                                               const char *profile_name) {
+  uint64_t deadline_ms = wamble_now_mono_millis() + 1000u;
+  while (login_verify_pending() > 0 && wamble_now_mono_millis() < deadline_ms)
+    (void)network_runtime_drive_once(sockfd, 1000, profile_name);
+  drive_runtime_until_idle(sockfd, profile_name);
+}
+
 static int recv_message_with_timeout(wamble_socket_t sock,
                                      struct WambleMsg *msg,
                                      struct sockaddr_in *from, int timeout_ms) {
@@ -1084,6 +1099,56 @@ WAMBLE_TEST(server_notification_ext_auto_fragment_reliable) {
   return 0;
 }
 
+WAMBLE_TEST(lz_codec_roundtrip_and_rejects_corrupt_input) {
+  static uint8_t text[WAMBLE_FRAGMENT_DATA_MAX * 4];
+  static uint8_t packed[WAMBLE_FRAGMENT_DATA_MAX * 5];
+  static uint8_t unpacked[WAMBLE_FRAGMENT_DATA_MAX * 4];
+  const char *phrase = "Terms of service: play fair, be kind. ";
+  size_t phrase_len = strlen(phrase);
+  for (size_t i = 0; i < sizeof(text); i++)
+    text[i] = (uint8_t)phrase[i % phrase_len];
+
+  size_t packed_len = 0;
+  T_ASSERT(wamble_lz_compress_bound(sizeof(text)) <= sizeof(packed));
+  T_ASSERT_EQ_INT(wamble_lz_compress(text, sizeof(text), packed,
+                                     sizeof(packed), &packed_len),
+                  0);
+  T_ASSERT(packed_len * 8 < sizeof(text));
+  size_t raw_len = 0;
+  T_ASSERT_EQ_INT(wamble_lz_decompressed_len(packed, packed_len, &raw_len), 0);
+  T_ASSERT_EQ_INT((int)raw_len, (int)sizeof(text));
+  size_t unpacked_len = 0;
+  T_ASSERT_EQ_INT(wamble_lz_decompress(packed, packed_len, unpacked,
+                                       sizeof(unpacked), &unpacked_len),
+                  0);
+  T_ASSERT_EQ_INT((int)unpacked_len, (int)sizeof(text));
+  T_ASSERT(memcmp(unpacked, text, sizeof(text)) == 0);
+
+  T_ASSERT(wamble_lz_decompress(packed, packed_len - 1, unpacked,
+                                sizeof(unpacked), &unpacked_len) != 0);
+  T_ASSERT(wamble_lz_decompress(packed, packed_len, unpacked,
+                                sizeof(text) - 1, &unpacked_len) != 0);
+
+  uint32_t state = 0x9e3779b9u;
+  for (size_t i = 0; i < 777; i++) {
+    state = state * 1103515245u + 12345u;
+    text[i] = (uint8_t)(state >> 24);
+  }
+  T_ASSERT_EQ_INT(wamble_lz_compress(text, 777, packed, sizeof(packed),
+                                     &packed_len),
+                  0);
+  T_ASSERT_EQ_INT(wamble_lz_decompress(packed, packed_len, unpacked,
+                                       sizeof(unpacked), &unpacked_len),
+                  0);
+  T_ASSERT_EQ_INT((int)unpacked_len, 777);
+  T_ASSERT(memcmp(unpacked, text, 777) == 0);
+
+  uint8_t bad[] = {0, 0, 0, 8, 0x14, 'a', 0x09, 0x00};
+  T_ASSERT(wamble_lz_decompress(bad, sizeof(bad), unpacked, sizeof(unpacked),
+                                &unpacked_len) != 0);
+  return 0;
+}
+
 WAMBLE_TEST(fragment_reassembly_api_complete_with_integrity_ok) {
   char full[WAMBLE_FRAGMENT_DATA_MAX * 2 + 23];
   size_t full_len = sizeof(full);
@@ -1250,6 +1315,37 @@ WAMBLE_TEST(fragment_reassembly_api_switches_transfers) {
   return 0;
 }
 
+WAMBLE_TEST(fragment_reassembly_api_rejects_oversized_lz_raw_len) {
+  uint8_t stream[6];
+  uint32_t raw_len_be = htonl((uint32_t)WAMBLE_FRAGMENT_REASSEMBLY_MAX + 1u);
+  memcpy(stream, &raw_len_be, sizeof(raw_len_be));
+  stream[4] = 0x10;
+  stream[5] = 'x';
+
+  struct WambleMsg frag = {0};
+  frag.ctrl = WAMBLE_CTRL_PROFILE_TOS_DATA;
+  frag.fragment.fragment_version = WAMBLE_FRAGMENT_VERSION;
+  frag.fragment.fragment_hash_algo = WAMBLE_FRAGMENT_HASH_BLAKE2B_256;
+  frag.fragment.fragment_codec = WAMBLE_FRAGMENT_CODEC_LZ;
+  frag.fragment.fragment_chunk_index = 0;
+  frag.fragment.fragment_chunk_count = 1;
+  frag.fragment.fragment_total_len = (uint32_t)sizeof(stream);
+  frag.fragment.fragment_transfer_id = 300;
+  crypto_blake2b(frag.fragment.fragment_hash, WAMBLE_FRAGMENT_HASH_LENGTH,
+                 stream, sizeof(stream));
+  frag.fragment.fragment_data_len = (uint16_t)sizeof(stream);
+  memcpy(frag.fragment.fragment_data, stream, sizeof(stream));
+
+  WambleFragmentReassembly reassembly;
+  wamble_fragment_reassembly_init(&reassembly);
+  T_ASSERT_EQ_INT(wamble_fragment_reassembly_push(&reassembly, &frag),
+                  WAMBLE_FRAGMENT_REASSEMBLY_ERR_INVALID);
+  T_ASSERT_EQ_INT((int)wamble_fragment_reassembly_integrity(&reassembly),
+                  WAMBLE_FRAGMENT_INTEGRITY_MISMATCH);
+  wamble_fragment_reassembly_free(&reassembly);
+  return 0;
+}
+
 WAMBLE_TEST(submit_prediction_roundtrip) {
   config_load(NULL, NULL, NULL, 0);
   wamble_socket_t srv = create_and_bind_socket(0);
@@ -2429,6 +2525,122 @@ WAMBLE_TEST(profile_info_endpoint_ext_roundtrip) {
   return 0;
 }
 
+WAMBLE_TEST(msg_view_decode_reuses_message_without_stale_fields) {
+  uint8_t buffer[WAMBLE_MAX_PACKET_SIZE];
+  size_t serialized = 0;
+  struct WambleMsg out = {0};
+  static struct WambleMsg in;
+  WambleMsgView view;
+
+  out.ctrl = WAMBLE_CTRL_GET_PROFILE_INFO;
+  out.seq_num = 41;
+  for (int i = 0; i < TOKEN_LENGTH; i++)
+    out.token[i] = (uint8_t)(0x21 + i);
+  snprintf(out.text.profile_name, sizeof(out.text.profile_name), "%s",
+           "alpha");
+  out.text.profile_name_len = (uint8_t)strlen(out.text.profile_name);
+  out.extensions.count = 1;
+  snprintf(out.extensions.fields[0].key, sizeof(out.extensions.fields[0].key),
+           "%s", "note");
+  out.extensions.fields[0].value_type = WAMBLE_TREATMENT_VALUE_BOOL;
+  out.extensions.fields[0].bool_value = 1;
+  T_ASSERT_EQ_INT(wamble_packet_serialize(&out, buffer, sizeof(buffer),
+                                          &serialized, 0),
+                  NET_OK);
+  T_ASSERT_EQ_INT(wamble_msg_view_parse(buffer, serialized, &view), NET_OK);
+  T_ASSERT_EQ_INT(view.ctrl, WAMBLE_CTRL_GET_PROFILE_INFO);
+  T_ASSERT_EQ_INT((int)view.seq_num, 41);
+  T_ASSERT(view.token == buffer + 4);
+  T_ASSERT_EQ_INT((int)view.payload_len,
+                  (int)(serialized - WAMBLE_HEADER_WIRE_SIZE));
+  T_ASSERT_EQ_INT(wamble_msg_view_decode(&view, &in), NET_OK);
+  T_ASSERT_STREQ(in.text.profile_name, "alpha");
+  T_ASSERT_EQ_INT((int)in.extensions.count, 1);
+
+  memset(&out, 0, sizeof(out));
+  out.ctrl = WAMBLE_CTRL_PLAYER_MOVE;
+  out.seq_num = 42;
+  out.board_id = 9;
+  out.token[0] = 1;
+  memcpy(out.text.uci, "e2e4", 4);
+  out.text.uci_len = 4;
+  T_ASSERT_EQ_INT(wamble_packet_serialize(&out, buffer, sizeof(buffer),
+                                          &serialized, 0),
+                  NET_OK);
+  T_ASSERT_EQ_INT(wamble_msg_view_parse(buffer, serialized, &view), NET_OK);
+  T_ASSERT_EQ_INT(wamble_msg_view_decode(&view, &in), NET_OK);
+  T_ASSERT_EQ_INT(in.ctrl, WAMBLE_CTRL_PLAYER_MOVE);
+  T_ASSERT_EQ_INT((int)in.board_id, 9);
+  T_ASSERT_EQ_INT((int)in.text.uci_len, 4);
+  T_ASSERT_EQ_INT(memcmp(in.text.uci, "e2e4", 4), 0);
+  T_ASSERT_EQ_INT((int)in.text.profile_name_len, 0);
+  T_ASSERT_STREQ(in.text.profile_name, "");
+  T_ASSERT_EQ_INT((int)in.extensions.count, 0);
+
+  T_ASSERT_EQ_INT(wamble_msg_view_parse(buffer, serialized - 1, &view),
+                  NET_ERR_TRUNCATED);
+  return 0;
+}
+
+WAMBLE_TEST(selective_ack_state_and_trailer_roundtrip) {
+  WambleAckState state = {0};
+  wamble_ack_state_record(&state, 1);
+  wamble_ack_state_record(&state, 2);
+  wamble_ack_state_record(&state, 4);
+  wamble_ack_state_record(&state, 6);
+  T_ASSERT_EQ_INT((int)state.highest_seq, 6);
+  T_ASSERT_EQ_INT((int)state.cumulative_seq, 2);
+  T_ASSERT(wamble_ack_state_covers(&state, 1));
+  T_ASSERT(wamble_ack_state_covers(&state, 4));
+  T_ASSERT(!wamble_ack_state_covers(&state, 3));
+  T_ASSERT(!wamble_ack_state_covers(&state, 5));
+  wamble_ack_state_record(&state, 3);
+  T_ASSERT_EQ_INT((int)state.cumulative_seq, 4);
+  T_ASSERT(wamble_ack_state_covers(&state, 3));
+
+  uint8_t buffer[WAMBLE_MAX_PACKET_SIZE];
+  size_t serialized = 0;
+  struct WambleMsg out = {0};
+  static struct WambleMsg in;
+  out.ctrl = WAMBLE_CTRL_ACK;
+  out.seq_num = state.highest_seq;
+  out.ack = state;
+  T_ASSERT_EQ_INT(wamble_packet_serialize(&out, buffer, sizeof(buffer),
+                                          &serialized, 0),
+                  NET_OK);
+  T_ASSERT_EQ_INT((int)serialized,
+                  WAMBLE_HEADER_WIRE_SIZE + WAMBLE_ACK_PAYLOAD_SIZE);
+  T_ASSERT_EQ_INT(wamble_packet_deserialize(buffer, serialized, &in, NULL),
+                  NET_OK);
+  T_ASSERT_EQ_INT(in.ctrl, WAMBLE_CTRL_ACK);
+  T_ASSERT_EQ_INT((int)in.ack.highest_seq, 6);
+  T_ASSERT_EQ_INT((int)in.ack.cumulative_seq, 4);
+  T_ASSERT_EQ_INT((int)in.ack.bitmap, (int)state.bitmap);
+
+  memset(&out, 0, sizeof(out));
+  out.ctrl = WAMBLE_CTRL_PLAYER_MOVE;
+  out.seq_num = 77;
+  out.board_id = 3;
+  memcpy(out.text.uci, "g1f3", 4);
+  out.text.uci_len = 4;
+  out.ack = state;
+  T_ASSERT_EQ_INT(wamble_packet_serialize(&out, buffer, sizeof(buffer),
+                                          &serialized, 0),
+                  NET_OK);
+  T_ASSERT_EQ_INT(buffer[3], WAMBLE_HEADER_OPT_ACK_TRAILER);
+  T_ASSERT_EQ_INT(wamble_packet_deserialize(buffer, serialized, &in, NULL),
+                  NET_OK);
+  T_ASSERT_EQ_INT(in.ctrl, WAMBLE_CTRL_PLAYER_MOVE);
+  T_ASSERT_EQ_INT((int)in.text.uci_len, 4);
+  T_ASSERT_EQ_INT(memcmp(in.text.uci, "g1f3", 4), 0);
+  T_ASSERT_EQ_INT((int)in.ack.highest_seq, 6);
+  T_ASSERT(wamble_ack_state_covers(&in.ack, 3));
+
+  buffer[3] = 0x02;
+  T_ASSERT(wamble_packet_deserialize(buffer, serialized, &in, NULL) != NET_OK);
+  return 0;
+}
+
 WAMBLE_TEST(profiles_list_roundtrip) {
   config_load(NULL, NULL, NULL, 0);
   UdpLoopbackPair pair;
@@ -2833,6 +3045,78 @@ WAMBLE_TEST(server_protocol_profile_info_advertises_profile_caps) {
   return 0;
 }
 
+WAMBLE_TEST(server_protocol_profiles_list_and_info_use_tier_catalog) {
+  const char *cfg_path = "build/test_network_profile_catalog.conf";
+  const char *cfg = "(def rate-limit-requests-per-sec 100)\n"
+                    "(defprofile zeta ((def port 19431) (def advertise 1)))\n"
+                    "(defprofile alpha ((def port 19432) (def advertise 1) "
+                    "(def visibility 2)))\n"
+                    "(defprofile mid ((def port 19433) (def advertise 1) "
+                    "(def visibility 1)))\n"
+                    "(defprofile hid ((def port 19434) (def advertise 0)))\n";
+  if (wamble_test_prepare_db(
+          cfg_path, cfg,
+          "INSERT INTO global_policy_rules "
+          "(global_identity_id, action, resource, scope, effect, "
+          "permission_level, reason, source) VALUES "
+          "(0, 'trust.tier', 'tier', '*', 'allow', 1, 'trust', 'test'), "
+          "(0, 'protocol.ctrl', 'list_profiles', '*', 'allow', 0, "
+          "'list_access', 'test'), "
+          "(0, 'protocol.ctrl', 'get_profile_info', '*', 'allow', 0, "
+          "'profile_info_access', 'test');") != 0) {
+    T_FAIL_SIMPLE("wamble_test_prepare_db failed");
+  }
+
+  UdpLoopbackPair pair;
+  T_ASSERT_STATUS_OK(init_udp_loopback_pair(&pair));
+
+  for (int round = 0; round < 3; round++) {
+    struct WambleMsg req = {0};
+    req.ctrl = WAMBLE_CTRL_LIST_PROFILES;
+    req.token[0] = (uint8_t)(0x51 + (round % 2));
+    WambleResponseCacheStats before = {0};
+    response_cache_stats(WAMBLE_RESPONSE_CACHE_PROFILES_LIST, &before);
+    RecvOneCtx rx = {.sock = pair.cli};
+    wamble_thread_t th;
+    T_ASSERT(wamble_thread_create(&th, recv_one_and_ack_thread, &rx) == 0);
+    T_ASSERT_EQ_INT(handle_message(pair.srv, &req, &pair.cliaddr, 1, "zeta"),
+                    SERVER_OK);
+    drive_runtime_until_idle(pair.srv, "zeta");
+    T_ASSERT_STATUS_OK(wamble_thread_join(th, NULL));
+    T_ASSERT_EQ_INT(rx.received, 1);
+    T_ASSERT_EQ_INT(rx.msg.ctrl, WAMBLE_CTRL_PROFILES_LIST);
+    T_ASSERT_STREQ(rx.msg.view.profiles_list, "mid,zeta");
+    WambleResponseCacheStats after = {0};
+    response_cache_stats(WAMBLE_RESPONSE_CACHE_PROFILES_LIST, &after);
+    T_ASSERT_EQ_INT((int)(after.hits - before.hits), 0);
+    T_ASSERT_EQ_INT((int)(after.stores - before.stores), 0);
+  }
+
+  struct WambleMsg req = {0};
+  req.ctrl = WAMBLE_CTRL_GET_PROFILE_INFO;
+  req.token[0] = 0x53;
+  req.text.profile_name_len = 3;
+  memcpy(req.text.profile_name, "mid", 3);
+  RecvOneCtx rx = {.sock = pair.cli};
+  wamble_thread_t th;
+  T_ASSERT(wamble_thread_create(&th, recv_one_and_ack_thread, &rx) == 0);
+  T_ASSERT_EQ_INT(handle_message(pair.srv, &req, &pair.cliaddr, 1, "zeta"),
+                  SERVER_OK);
+  drive_runtime_until_idle(pair.srv, "zeta");
+  T_ASSERT_STATUS_OK(wamble_thread_join(th, NULL));
+  T_ASSERT_EQ_INT(rx.received, 1);
+  T_ASSERT_EQ_INT(rx.msg.ctrl, WAMBLE_CTRL_PROFILE_INFO);
+  T_ASSERT_STREQ(rx.msg.text.profile_info, "mid;19433;1;1");
+  T_ASSERT(memcmp(rx.msg.token, req.token, TOKEN_LENGTH) == 0);
+  const WambleMessageExtField *accepted =
+      find_ext_field(&rx.msg, "profile.tos_accepted");
+  T_ASSERT(accepted != NULL);
+  T_ASSERT_EQ_INT((int)accepted->int_value, 1);
+
+  cleanup_udp_loopback_pair(&pair);
+  return 0;
+}
+
 WAMBLE_TEST(server_protocol_profile_info_omits_tos_cap_when_text_empty) {
   const char *cfg_path = "build/test_network_profile_info_empty_tos.conf";
   const char *cfg = "(def rate-limit-requests-per-sec 100)\n"
@@ -5558,9 +5842,9 @@ WAMBLE_TEST(server_protocol_login_uses_ed25519_challenge_response) {
   T_ASSERT(wamble_thread_create(&th_bad, recv_one_and_ack_thread, &rx_bad) ==
            0);
   ServerStatus bad_st = handle_message(srv, &bad_req, &cliaddr, 0, "p1");
-  drive_runtime_until_idle(srv, "p1");
+  drive_runtime_until_logins_settled(srv, "p1");
   T_ASSERT_STATUS_OK(wamble_thread_join(th_bad, NULL));
-  T_ASSERT_EQ_INT(bad_st, SERVER_ERR_LOGIN_FAILED);
+  T_ASSERT_EQ_INT(bad_st, SERVER_OK);
   T_ASSERT_EQ_INT(rx_bad.received, 1);
   T_ASSERT_EQ_INT(rx_bad.msg.ctrl, WAMBLE_CTRL_LOGIN_FAILED);
   T_ASSERT_EQ_INT(server_protocol_thread_pending_login_challenge_count(), 0);
@@ -5594,7 +5878,7 @@ WAMBLE_TEST(server_protocol_login_uses_ed25519_challenge_response) {
   wamble_thread_t th_ok;
   T_ASSERT(wamble_thread_create(&th_ok, recv_one_and_ack_thread, &rx_ok) == 0);
   ServerStatus ok_st = handle_message(srv, &good_req, &cliaddr, 0, "p1");
-  drive_runtime_until_idle(srv, "p1");
+  drive_runtime_until_logins_settled(srv, "p1");
   T_ASSERT_STATUS_OK(wamble_thread_join(th_ok, NULL));
   T_ASSERT_EQ_INT(ok_st, SERVER_OK);
   T_ASSERT_EQ_INT(rx_ok.received, 1);
@@ -5934,51 +6218,63 @@ WAMBLE_TEST(transport_runtime_state_queues_endpoints_and_drive_results) {
   for (int i = 0; i < TOKEN_LENGTH; i++)
     token[i] = (uint8_t)(i + 1);
 
+  size_t slots_free = transport_packet_available();
+  T_ASSERT(slots_free >= 2);
+
   uint8_t packet_a[] = {0xa1, 0xa2, 0xa3, 0xa4};
-  TransportInboundEntry inbound_a;
-  memset(&inbound_a, 0, sizeof(inbound_a));
-  inbound_a.source = TRANSPORT_PACKET_SOURCE_UDP;
-  inbound_a.addr = addr_a;
-  inbound_a.packet_len = sizeof(packet_a);
-  memcpy(inbound_a.packet, packet_a, sizeof(packet_a));
-  T_ASSERT_EQ_INT(transport_inbound_push(&inbound_a), 0);
+  uint32_t slot_a = 0;
+  T_ASSERT_EQ_INT(
+      transport_packet_acquire(TRANSPORT_PACKET_SOURCE_UDP, &addr_a, &slot_a),
+      0);
+  TransportPacketSlot *inbound_a = transport_packet_get(slot_a);
+  T_ASSERT(inbound_a != NULL);
+  inbound_a->packet_len = sizeof(packet_a);
+  memcpy(inbound_a->packet, packet_a, sizeof(packet_a));
+  T_ASSERT_EQ_INT(transport_inbound_push(slot_a), 0);
 
   uint8_t packet_b[] = {0xb1, 0xb2};
-  TransportInboundEntry inbound_b;
-  memset(&inbound_b, 0, sizeof(inbound_b));
-  inbound_b.source = TRANSPORT_PACKET_SOURCE_WS;
-  inbound_b.addr = addr_b;
-  inbound_b.packet_len = sizeof(packet_b);
-  memcpy(inbound_b.packet, packet_b, sizeof(packet_b));
-  T_ASSERT_EQ_INT(transport_inbound_push(&inbound_b), 0);
+  uint32_t slot_b = 0;
+  T_ASSERT_EQ_INT(
+      transport_packet_acquire(TRANSPORT_PACKET_SOURCE_WS, &addr_b, &slot_b),
+      0);
+  T_ASSERT(slot_b != slot_a);
+  TransportPacketSlot *inbound_b = transport_packet_get(slot_b);
+  inbound_b->packet_len = sizeof(packet_b);
+  memcpy(inbound_b->packet, packet_b, sizeof(packet_b));
+  T_ASSERT_EQ_INT(transport_inbound_push(slot_b), 0);
   T_ASSERT_EQ_INT((int)transport_inbound_count(), 2);
-
-  TransportInboundEntry inbound_out;
-  memset(&inbound_out, 0, sizeof(inbound_out));
-  T_ASSERT_EQ_INT(transport_inbound_pop(&inbound_out), 1);
-  T_ASSERT_EQ_INT(inbound_out.source, TRANSPORT_PACKET_SOURCE_UDP);
-  T_ASSERT_EQ_INT((int)inbound_out.packet_len, (int)sizeof(packet_a));
-  T_ASSERT_EQ_INT(memcmp(inbound_out.packet, packet_a, sizeof(packet_a)), 0);
-  T_ASSERT_EQ_INT(transport_inbound_pop(&inbound_out), 1);
-  T_ASSERT_EQ_INT(inbound_out.source, TRANSPORT_PACKET_SOURCE_WS);
+  T_ASSERT_EQ_INT((int)transport_packet_available(), (int)slots_free - 2);
+
+  uint32_t slot_out = 0;
+  T_ASSERT_EQ_INT(transport_inbound_pop(&slot_out), 1);
+  T_ASSERT_EQ_INT((int)slot_out, (int)slot_a);
+  TransportPacketSlot *inbound_out = transport_packet_get(slot_out);
+  T_ASSERT_EQ_INT(inbound_out->source, TRANSPORT_PACKET_SOURCE_UDP);
+  T_ASSERT_EQ_INT((int)inbound_out->packet_len, (int)sizeof(packet_a));
+  T_ASSERT_EQ_INT(memcmp(inbound_out->packet, packet_a, sizeof(packet_a)), 0);
+  T_ASSERT_EQ_INT(transport_inbound_pop(&slot_out), 1);
+  T_ASSERT_EQ_INT((int)slot_out, (int)slot_b);
+  T_ASSERT_EQ_INT(transport_packet_get(slot_out)->source,
+                  TRANSPORT_PACKET_SOURCE_WS);
   T_ASSERT_EQ_INT((int)transport_inbound_count(), 0);
-
-  TransportDispatchEntry dispatch;
-  memset(&dispatch, 0, sizeof(dispatch));
-  dispatch.source = TRANSPORT_PACKET_SOURCE_UDP;
-  dispatch.addr = addr_a;
-  dispatch.msg.ctrl = WAMBLE_CTRL_GET_PROFILE_INFO;
-  dispatch.msg.seq_num = 77;
-  memcpy(dispatch.msg.token, token, TOKEN_LENGTH);
-  T_ASSERT_EQ_INT(transport_dispatch_push(&dispatch), 0);
+  transport_packet_release(slot_b);
+
+  TransportPacketSlot *dispatch = transport_packet_get(slot_a);
+  memset(&dispatch->view, 0, sizeof(dispatch->view));
+  dispatch->view.ctrl = WAMBLE_CTRL_GET_PROFILE_INFO;
+  dispatch->view.seq_num = 77;
+  dispatch->view.token = token;
+  T_ASSERT_EQ_INT(transport_dispatch_push(slot_a), 0);
   T_ASSERT_EQ_INT((int)transport_dispatch_count(), 1);
 
-  TransportDispatchEntry dispatch_out;
-  memset(&dispatch_out, 0, sizeof(dispatch_out));
-  T_ASSERT_EQ_INT(transport_dispatch_pop(&dispatch_out), 1);
-  T_ASSERT_EQ_INT(dispatch_out.msg.ctrl, WAMBLE_CTRL_GET_PROFILE_INFO);
-  T_ASSERT_EQ_INT((int)dispatch_out.msg.seq_num, 77);
+  T_ASSERT_EQ_INT(transport_dispatch_pop(&slot_out), 1);
+  T_ASSERT_EQ_INT((int)slot_out, (int)slot_a);
+  T_ASSERT_EQ_INT(transport_packet_get(slot_out)->view.ctrl,
+                  WAMBLE_CTRL_GET_PROFILE_INFO);
+  T_ASSERT_EQ_INT((int)transport_packet_get(slot_out)->view.seq_num, 77);
   T_ASSERT_EQ_INT((int)transport_dispatch_count(), 0);
+  transport_packet_release(slot_out);
+  T_ASSERT_EQ_INT((int)transport_packet_available(), (int)slots_free);
 
   TransportEndpointId endpoint_id = TRANSPORT_ENDPOINT_ID_INVALID;
   T_ASSERT_EQ_INT(
@@ -6070,18 +6366,17 @@ static void test_runtime_fill_token(uint8_t token[TOKEN_LENGTH]) {
 static int test_push_inbound_serialized(TransportPacketSource source,
                                         const struct WambleMsg *msg,
                                         const struct sockaddr_in *addr) {
-  uint8_t packet[WAMBLE_MAX_PACKET_SIZE];
-  size_t packet_len = 0;
-  if (wamble_packet_serialize(msg, packet, sizeof(packet), &packet_len,
-                              msg ? msg->flags : 0) != NET_OK)
+  uint32_t slot = 0;
+  if (!msg || transport_packet_acquire(source, addr, &slot) != 0)
+    return -1;
+  TransportPacketSlot *inbound = transport_packet_get(slot);
+  if (wamble_packet_serialize(msg, inbound->packet, sizeof(inbound->packet),
+                              &inbound->packet_len, msg->flags) != NET_OK ||
+      transport_inbound_push(slot) != 0) {
+    transport_packet_release(slot);
     return -1;
-  TransportInboundEntry inbound;
-  memset(&inbound, 0, sizeof(inbound));
-  inbound.source = source;
-  inbound.addr = *addr;
-  inbound.packet_len = packet_len;
-  memcpy(inbound.packet, packet, packet_len);
-  return transport_inbound_push(&inbound);
+  }
+  return 0;
 }
 
 static int test_push_reliable_outbound(uint32_t seq,
@@ -6516,17 +6811,19 @@ WAMBLE_TEST(runtime_reload_readiness_blocks_dispatch_and_reliable_work) {
   uint8_t token[TOKEN_LENGTH];
   test_runtime_fill_token(token);
 
-  TransportDispatchEntry dispatch;
-  memset(&dispatch, 0, sizeof(dispatch));
-  dispatch.source = TRANSPORT_PACKET_SOURCE_UDP;
-  dispatch.addr = addr;
-  dispatch.msg.ctrl = WAMBLE_CTRL_PLAYER_MOVE;
-  dispatch.msg.header_version = WAMBLE_PROTO_VERSION;
-  dispatch.msg.seq_num = 7503;
-  memcpy(dispatch.msg.token, token, TOKEN_LENGTH);
-  T_ASSERT_EQ_INT(transport_dispatch_push(&dispatch), 0);
+  uint32_t slot = 0;
+  T_ASSERT_EQ_INT(
+      transport_packet_acquire(TRANSPORT_PACKET_SOURCE_UDP, &addr, &slot), 0);
+  TransportPacketSlot *dispatch = transport_packet_get(slot);
+  memset(&dispatch->view, 0, sizeof(dispatch->view));
+  dispatch->view.ctrl = WAMBLE_CTRL_PLAYER_MOVE;
+  dispatch->view.header_version = WAMBLE_PROTO_VERSION;
+  dispatch->view.seq_num = 7503;
+  dispatch->view.token = token;
+  T_ASSERT_EQ_INT(transport_dispatch_push(slot), 0);
   T_ASSERT_EQ_INT(network_runtime_reload_drain_complete(), 0);
-  T_ASSERT_EQ_INT(transport_dispatch_pop(&dispatch), 1);
+  T_ASSERT_EQ_INT(transport_dispatch_pop(&slot), 1);
+  transport_packet_release(slot);
   T_ASSERT_EQ_INT(network_runtime_reload_drain_complete(), 1);
 
   struct WambleMsg reliable;
@@ -6563,6 +6860,102 @@ WAMBLE_TEST(runtime_reload_readiness_blocks_terminal_cache_until_ttl) {
   return 0;
 }
 
+WAMBLE_TEST(runtime_terminal_cache_ring_indexes_by_request_seq) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+
+  struct sockaddr_in addr = test_runtime_loopback_addr(4312);
+  uint8_t token[TOKEN_LENGTH];
+  test_runtime_fill_token(token);
+  for (uint32_t seq = 7600; seq < 7608; seq++)
+    T_ASSERT_EQ_INT(network_test_store_terminal_cache_packet(token, &addr, seq),
+                    0);
+  T_ASSERT_EQ_INT(network_protocol_thread_terminal_cache_packet_count(), 8);
+
+  T_ASSERT_EQ_INT(network_test_store_terminal_cache_packet(token, &addr, 7608),
+                  0);
+  T_ASSERT_EQ_INT(network_protocol_thread_terminal_cache_packet_count(), 8);
+  T_ASSERT_EQ_INT(network_test_store_terminal_cache_packet(token, &addr, 7608),
+                  0);
+  T_ASSERT_EQ_INT(network_protocol_thread_terminal_cache_packet_count(), 9);
+  T_ASSERT_EQ_INT(network_test_store_terminal_cache_packet(token, &addr, 7616),
+                  0);
+  T_ASSERT_EQ_INT(network_protocol_thread_terminal_cache_packet_count(), 8);
+
+  network_init_thread_state();
+  T_ASSERT_EQ_INT(network_protocol_thread_terminal_cache_packet_count(), 0);
+  return 0;
+}
+
+WAMBLE_TEST(runtime_terminal_cache_expires_on_touch_and_shrinks_arena) {
+  const char *cfg_path = "build/test_network_terminal_cache_expiry.conf";
+  T_ASSERT_EQ_INT(wamble_test_write_optional_db_config_file(
+                      cfg_path, "(def terminal-cache-ttl-ms 200)\n"),
+                  0);
+  T_ASSERT_STATUS(config_load(cfg_path, NULL, NULL, 0), CONFIG_LOAD_OK);
+  network_init_thread_state();
+
+  uint8_t token[TOKEN_LENGTH];
+  test_runtime_fill_token(token);
+  struct sockaddr_in addr = test_runtime_loopback_addr(4340);
+  for (int i = 0; i < 100; i++)
+    T_ASSERT_EQ_INT(
+        network_test_store_terminal_cache_packet(token, &addr, 7800), 0);
+  T_ASSERT_EQ_INT(network_protocol_thread_terminal_arena_capacity(), 128);
+
+  cleanup_expired_sessions();
+  T_ASSERT_EQ_INT(network_protocol_thread_terminal_cache_packet_count(), 100);
+
+  wamble_sleep_ms(250);
+  T_ASSERT_EQ_INT(network_test_store_terminal_cache_packet(token, &addr, 7800),
+                  0);
+  T_ASSERT_EQ_INT(network_protocol_thread_terminal_arena_capacity(), 64);
+  T_ASSERT_EQ_INT(network_protocol_thread_terminal_cache_packet_count(), 1);
+
+  network_init_thread_state();
+  return 0;
+}
+
+WAMBLE_TEST(runtime_session_expiry_reuses_slots_without_losing_lookups) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+
+  uint8_t token[TOKEN_LENGTH];
+  test_runtime_fill_token(token);
+  struct sockaddr_in addrs[3];
+  for (int i = 0; i < 3; i++) {
+    addrs[i] = test_runtime_loopback_addr((uint16_t)(4320 + i));
+    T_ASSERT_EQ_INT(network_test_store_terminal_cache_packet(
+                        token, &addrs[i], (uint32_t)(7700 + i)),
+                    0);
+  }
+  T_ASSERT_EQ_INT(network_protocol_thread_session_count(), 3);
+  cleanup_expired_sessions();
+  T_ASSERT_EQ_INT(network_protocol_thread_session_count(), 3);
+  T_ASSERT_EQ_INT(network_protocol_thread_terminal_cache_packet_count(), 3);
+
+  WambleConfig cfg = *get_config();
+  cfg.session_timeout = 0;
+  wamble_config_push(&cfg);
+  cleanup_expired_sessions();
+  wamble_config_pop();
+  T_ASSERT_EQ_INT(network_protocol_thread_session_count(), 0);
+  T_ASSERT_EQ_INT(network_protocol_thread_terminal_cache_packet_count(), 0);
+
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < 2; i++)
+      T_ASSERT_EQ_INT(network_test_store_terminal_cache_packet(
+                          token, &addrs[i], (uint32_t)(7710 + i)),
+                      0);
+    T_ASSERT_EQ_INT(network_protocol_thread_session_count(), 2);
+  }
+  T_ASSERT_EQ_INT(network_protocol_thread_terminal_cache_packet_count(), 4);
+
+  network_init_thread_state();
+  T_ASSERT_EQ_INT(network_protocol_thread_session_count(), 0);
+  return 0;
+}
+
 WAMBLE_TEST(runtime_reload_readiness_blocks_reliable_fragment_bundle) {
   config_load(NULL, NULL, NULL, 0);
   network_init_thread_state();
@@ -6759,83 +7152,328 @@ WAMBLE_TEST(
   return 0;
 }
 
-WAMBLE_TEST(runtime_duplicate_request_does_not_duplicate_pending_terminal) {
+static wamble_socket_t test_bind_loopback_udp(struct sockaddr_in *out_addr) {
+  wamble_socket_t sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock == WAMBLE_INVALID_SOCKET)
+    return sock;
+  struct sockaddr_in bindaddr;
+  memset(&bindaddr, 0, sizeof(bindaddr));
+  bindaddr.sin_family = AF_INET;
+  bindaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  wamble_socklen_t len = (wamble_socklen_t)sizeof(*out_addr);
+  if (bind(sock, (struct sockaddr *)&bindaddr, sizeof(bindaddr)) != 0 ||
+      getsockname(sock, (struct sockaddr *)out_addr, &len) != 0) {
+    wamble_close_socket(sock);
+    return WAMBLE_INVALID_SOCKET;
+  }
+  return sock;
+}
+
+WAMBLE_TEST(runtime_outbound_burst_arrives_as_individual_datagrams) {
   config_load(NULL, NULL, NULL, 0);
   network_init_thread_state();
+  wamble_socket_t srv = create_and_bind_socket(0);
+  T_ASSERT(srv != WAMBLE_INVALID_SOCKET);
+  struct sockaddr_in cliaddr;
+  wamble_socket_t cli = test_bind_loopback_udp(&cliaddr);
+  T_ASSERT(cli != WAMBLE_INVALID_SOCKET);
 
-  struct sockaddr_in addr = test_runtime_loopback_addr(4312);
   uint8_t token[TOKEN_LENGTH];
   test_runtime_fill_token(token);
+  const char *texts[] = {"burst-0", "burst-1", "burst-2", "burst-3", "end"};
+  for (int i = 0; i < 5; i++) {
+    struct WambleMsg notice = {0};
+    notice.ctrl = WAMBLE_CTRL_SERVER_NOTIFICATION;
+    memcpy(notice.token, token, TOKEN_LENGTH);
+    snprintf(notice.view.fen, sizeof(notice.view.fen), "%s", texts[i]);
+    T_ASSERT_EQ_INT(network_enqueue_unreliable(&notice, &cliaddr), 0);
+  }
+  TransportDriveResult drive = network_runtime_drive_once(srv, 0, NULL);
+  T_ASSERT_EQ_INT((int)drive.error_count, 0);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 0);
 
-  struct WambleMsg req;
-  memset(&req, 0, sizeof(req));
-  req.ctrl = WAMBLE_CTRL_PLAYER_MOVE;
-  req.header_version = WAMBLE_PROTO_VERSION;
-  req.seq_num = 8003;
-  memcpy(req.token, token, TOKEN_LENGTH);
-  req.board_id = 99;
-  snprintf(req.text.uci, sizeof(req.text.uci), "%s", "e2e4");
-  req.text.uci_len = 4;
-
-  T_ASSERT_EQ_INT(
-      test_push_inbound_serialized(TRANSPORT_PACKET_SOURCE_UDP, &req, &addr),
-      0);
-  TransportDriveResult drive =
-      network_runtime_drive_once(WAMBLE_INVALID_SOCKET, 0, NULL);
-  T_ASSERT(drive.status != TRANSPORT_DRIVE_IDLE);
-  T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
-
-  T_ASSERT_EQ_INT(
-      test_push_inbound_serialized(TRANSPORT_PACKET_SOURCE_UDP, &req, &addr),
-      0);
-  drive = network_runtime_drive_once(WAMBLE_INVALID_SOCKET, 0, NULL);
-  T_ASSERT(drive.status != TRANSPORT_DRIVE_IDLE);
-  T_ASSERT_EQ_INT((int)transport_inbound_count(), 0);
-  T_ASSERT_EQ_INT((int)transport_dispatch_count(), 0);
-  T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
+  for (int i = 0; i < 5; i++) {
+    struct WambleMsg in = {0};
+    struct sockaddr_in from;
+    T_ASSERT(recv_message_with_timeout(cli, &in, &from, 1000) > 0);
+    T_ASSERT_EQ_INT(in.ctrl, WAMBLE_CTRL_SERVER_NOTIFICATION);
+    T_ASSERT_STREQ(in.view.fen, texts[i]);
+  }
+  struct WambleMsg extra = {0};
+  struct sockaddr_in extra_from;
+  T_ASSERT_EQ_INT(recv_message_with_timeout(cli, &extra, &extra_from, 50), 0);
 
+  wamble_close_socket(cli);
+  wamble_close_socket(srv);
   network_init_thread_state();
   return 0;
 }
 
-WAMBLE_TEST(direct_handler_enqueues_without_driving_transport) {
+WAMBLE_TEST(spectator_batch_shares_payload_and_patches_tokens) {
   config_load(NULL, NULL, NULL, 0);
   network_init_thread_state();
+  wamble_socket_t srv = create_and_bind_socket(0);
+  T_ASSERT(srv != WAMBLE_INVALID_SOCKET);
+  struct sockaddr_in addr_a;
+  struct sockaddr_in addr_b;
+  wamble_socket_t cli_a = test_bind_loopback_udp(&addr_a);
+  wamble_socket_t cli_b = test_bind_loopback_udp(&addr_b);
+  T_ASSERT(cli_a != WAMBLE_INVALID_SOCKET);
+  T_ASSERT(cli_b != WAMBLE_INVALID_SOCKET);
 
-  UdpLoopbackPair pair;
-  T_ASSERT_EQ_INT(init_udp_loopback_pair(&pair), 0);
-
-  struct WambleMsg req;
-  memset(&req, 0, sizeof(req));
-  req.ctrl = WAMBLE_CTRL_GET_PROFILE_TOS;
-  req.header_version = WAMBLE_PROTO_VERSION;
-  req.seq_num = 8101;
-  req.token[0] = 0x61;
-  snprintf(req.text.profile_name, sizeof(req.text.profile_name), "%s",
-           "missing-profile");
-  req.text.profile_name_len = (uint8_t)strlen(req.text.profile_name);
-
-  T_ASSERT_EQ_INT(handle_message(pair.srv, &req, &pair.cliaddr, 0, NULL),
-                  SERVER_ERR_FORBIDDEN);
-  T_ASSERT((int)transport_outbound_count() > 0);
-
-  struct WambleMsg rx;
-  struct sockaddr_in from;
-  memset(&rx, 0, sizeof(rx));
-  int got = recv_message_with_timeout(pair.cli, &rx, &from, 20);
-  T_ASSERT_EQ_INT(got, 0);
+  const char *shared_fen =
+      "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1";
+  SpectatorUpdate events[3];
+  memset(events, 0, sizeof(events));
+  for (int i = 0; i < 3; i++) {
+    memset(events[i].token, 0x30 + i, TOKEN_LENGTH);
+    events[i].board_id = i < 2 ? 41 : 42;
+    events[i].summary_generation = 7;
+    snprintf(events[i].fen, sizeof(events[i].fen), "%s",
+             i < 2 ? shared_fen : "8/8/8/8/8/8/8/K6k w - - 0 1");
+  }
+  events[0].addr = addr_a;
+  events[1].addr = addr_b;
+  events[2].addr = addr_a;
+  T_ASSERT_EQ_INT(server_protocol_enqueue_spectator_batch(
+                      events, 3, WAMBLE_CTRL_SPECTATE_UPDATE),
+                  0);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 3);
+  (void)network_runtime_drive_once(srv, 0, NULL);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 0);
 
-  TransportDriveResult drive = network_runtime_drive_once(pair.srv, 0, NULL);
-  T_ASSERT(drive.progress_count > 0);
-  got = recv_non_ack_with_timeout(pair.cli, &rx, &from, 200);
-  T_ASSERT(got > 0);
-  T_ASSERT_EQ_INT(rx.ctrl, WAMBLE_CTRL_ERROR);
+  const int expect_event[3] = {0, 2, 1};
+  wamble_socket_t socks[3] = {cli_a, cli_a, cli_b};
+  for (int k = 0; k < 3; k++) {
+    const SpectatorUpdate *ev = &events[expect_event[k]];
+    struct WambleMsg in = {0};
+    struct sockaddr_in from;
+    T_ASSERT(recv_message_with_timeout(socks[k], &in, &from, 1000) > 0);
+    T_ASSERT_EQ_INT(in.ctrl, WAMBLE_CTRL_SPECTATE_UPDATE);
+    T_ASSERT(memcmp(in.token, ev->token, TOKEN_LENGTH) == 0);
+    T_ASSERT_EQ_INT((int)in.board_id, (int)ev->board_id);
+    T_ASSERT_STREQ(in.view.fen, ev->fen);
+  }
 
-  cleanup_udp_loopback_pair(&pair);
+  wamble_close_socket(cli_a);
+  wamble_close_socket(cli_b);
+  wamble_close_socket(srv);
+  network_init_thread_state();
   return 0;
 }
 
-WAMBLE_TEST(direct_handler_dispatch_does_not_read_socket) {
+WAMBLE_TEST(spectator_summary_rate_backs_off_with_endpoint_backlog) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+  spectator_manager_init();
+  board_manager_init();
+  player_manager_init();
+  WamblePlayer *player = create_new_player();
+  T_ASSERT(player != NULL);
+  T_ASSERT(find_board_for_player(player) != NULL);
+
+  struct sockaddr_in addr = test_runtime_loopback_addr(40123);
+  uint8_t token[TOKEN_LENGTH];
+  test_runtime_fill_token(token);
+  struct WambleMsg req = {0};
+  req.ctrl = WAMBLE_CTRL_SPECTATE_GAME;
+  memcpy(req.token, token, TOKEN_LENGTH);
+  SpectatorState state = SPECTATOR_STATE_IDLE;
+  uint64_t focus = 0;
+  T_ASSERT_EQ_INT(
+      spectator_handle_request(&req, &addr, 0, 0, 1, &state, &focus),
+      SPECTATOR_OK_SUMMARY);
+
+  char full_mode[] = "full";
+  WambleConfig cfg = *get_config();
+  cfg.spectator_summary_hz = 50;
+  cfg.spectator_summary_mode = full_mode;
+  wamble_config_push(&cfg);
+
+  SpectatorUpdate updates[8];
+  T_ASSERT(spectator_collect_updates(updates, 8) > 0);
+  wamble_sleep_ms(30);
+  T_ASSERT(spectator_collect_updates(updates, 8) > 0);
+
+  struct WambleMsg filler = {0};
+  filler.ctrl = WAMBLE_CTRL_SERVER_NOTIFICATION;
+  memcpy(filler.token, token, TOKEN_LENGTH);
+  for (int i = 0; i < 32; i++)
+    T_ASSERT_EQ_INT(network_enqueue_unreliable(&filler, &addr), 0);
+  uint32_t srtt_ms = 1;
+  uint32_t backlog = 0;
+  T_ASSERT_EQ_INT(network_endpoint_delivery_state(&addr, &srtt_ms, &backlog),
+                  0);
+  T_ASSERT_EQ_INT((int)backlog, 32);
+  T_ASSERT_EQ_INT((int)srtt_ms, 0);
+
+  wamble_sleep_ms(30);
+  T_ASSERT_EQ_INT(spectator_collect_updates(updates, 8), 0);
+  wamble_sleep_ms(90);
+  T_ASSERT(spectator_collect_updates(updates, 8) > 0);
+
+  wamble_config_pop();
+  spectator_manager_shutdown();
+  network_init_thread_state();
+  return 0;
+}
+
+WAMBLE_TEST(runtime_inbound_splits_coalesced_datagrams) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+  wamble_socket_t srv = create_and_bind_socket(0);
+  T_ASSERT(srv != WAMBLE_INVALID_SOCKET);
+  struct sockaddr_in srvaddr = test_runtime_loopback_addr(
+      (uint16_t)wamble_socket_bound_port(srv));
+  struct sockaddr_in cliaddr;
+  wamble_socket_t cli = test_bind_loopback_udp(&cliaddr);
+  T_ASSERT(cli != WAMBLE_INVALID_SOCKET);
+
+  uint8_t token[TOKEN_LENGTH];
+  test_runtime_fill_token(token);
+  uint8_t burst[3 * WAMBLE_MAX_PACKET_SIZE];
+  size_t segment_size = 0;
+  for (int i = 0; i < 3; i++) {
+    struct WambleMsg req;
+    memset(&req, 0, sizeof(req));
+    req.ctrl = WAMBLE_CTRL_PLAYER_MOVE;
+    req.header_version = WAMBLE_PROTO_VERSION;
+    req.seq_num = (uint32_t)(9101 + i);
+    memcpy(req.token, token, TOKEN_LENGTH);
+    req.board_id = 99;
+    snprintf(req.text.uci, sizeof(req.text.uci), "%s", "e2e4");
+    req.text.uci_len = 4;
+    size_t len = 0;
+    uint8_t *out = burst + segment_size * (size_t)i;
+    T_ASSERT_EQ_INT(
+        wamble_packet_serialize(&req, out, WAMBLE_MAX_PACKET_SIZE, &len, 0),
+        NET_OK);
+    T_ASSERT(segment_size == 0 || len == segment_size);
+    segment_size = len;
+  }
+
+  int sent_segmented = 0;
+#if defined(__linux__)
+  char control[CMSG_SPACE(sizeof(uint16_t))];
+  memset(control, 0, sizeof(control));
+  struct iovec iov = {burst, segment_size * 3};
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = &srvaddr;
+  msg.msg_namelen = sizeof(srvaddr);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+  cm->cmsg_level = IPPROTO_UDP;
+  cm->cmsg_type = UDP_SEGMENT;
+  cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+  uint16_t gso_size = (uint16_t)segment_size;
+  memcpy(CMSG_DATA(cm), &gso_size, sizeof(gso_size));
+  sent_segmented = sendmsg(cli, &msg, 0) >= 0;
+#endif
+  for (int i = 0; !sent_segmented && i < 3; i++)
+    T_ASSERT(sendto(cli, (const char *)burst + segment_size * (size_t)i,
+                    segment_size, 0, (const struct sockaddr *)&srvaddr,
+                    sizeof(srvaddr)) > 0);
+
+  drive_runtime_until_idle(srv, NULL);
+  int acked[3] = {0};
+  for (int attempt = 0; attempt < 12; attempt++) {
+    struct WambleMsg in = {0};
+    struct sockaddr_in from;
+    if (recv_message_with_timeout(cli, &in, &from, 200) <= 0)
+      break;
+    if (in.ctrl == WAMBLE_CTRL_ACK && in.seq_num >= 9101 &&
+        in.seq_num <= 9103)
+      acked[in.seq_num - 9101] = 1;
+  }
+  T_ASSERT(acked[0] && acked[1] && acked[2]);
+
+  wamble_close_socket(cli);
+  wamble_close_socket(srv);
+  network_init_thread_state();
+  return 0;
+}
+
+WAMBLE_TEST(runtime_duplicate_request_does_not_duplicate_pending_terminal) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+
+  struct sockaddr_in addr = test_runtime_loopback_addr(4312);
+  uint8_t token[TOKEN_LENGTH];
+  test_runtime_fill_token(token);
+
+  struct WambleMsg req;
+  memset(&req, 0, sizeof(req));
+  req.ctrl = WAMBLE_CTRL_PLAYER_MOVE;
+  req.header_version = WAMBLE_PROTO_VERSION;
+  req.seq_num = 8003;
+  memcpy(req.token, token, TOKEN_LENGTH);
+  req.board_id = 99;
+  snprintf(req.text.uci, sizeof(req.text.uci), "%s", "e2e4");
+  req.text.uci_len = 4;
+
+  T_ASSERT_EQ_INT(
+      test_push_inbound_serialized(TRANSPORT_PACKET_SOURCE_UDP, &req, &addr),
+      0);
+  TransportDriveResult drive =
+      network_runtime_drive_once(WAMBLE_INVALID_SOCKET, 0, NULL);
+  T_ASSERT(drive.status != TRANSPORT_DRIVE_IDLE);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
+
+  T_ASSERT_EQ_INT(
+      test_push_inbound_serialized(TRANSPORT_PACKET_SOURCE_UDP, &req, &addr),
+      0);
+  drive = network_runtime_drive_once(WAMBLE_INVALID_SOCKET, 0, NULL);
+  T_ASSERT(drive.status != TRANSPORT_DRIVE_IDLE);
+  T_ASSERT_EQ_INT((int)transport_inbound_count(), 0);
+  T_ASSERT_EQ_INT((int)transport_dispatch_count(), 0);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
+
+  network_init_thread_state();
+  return 0;
+}
+
+WAMBLE_TEST(direct_handler_enqueues_without_driving_transport) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+
+  UdpLoopbackPair pair;
+  T_ASSERT_EQ_INT(init_udp_loopback_pair(&pair), 0);
+
+  struct WambleMsg req;
+  memset(&req, 0, sizeof(req));
+  req.ctrl = WAMBLE_CTRL_GET_PROFILE_TOS;
+  req.header_version = WAMBLE_PROTO_VERSION;
+  req.seq_num = 8101;
+  req.token[0] = 0x61;
+  snprintf(req.text.profile_name, sizeof(req.text.profile_name), "%s",
+           "missing-profile");
+  req.text.profile_name_len = (uint8_t)strlen(req.text.profile_name);
+
+  T_ASSERT_EQ_INT(handle_message(pair.srv, &req, &pair.cliaddr, 0, NULL),
+                  SERVER_ERR_FORBIDDEN);
+  T_ASSERT((int)transport_outbound_count() > 0);
+
+  struct WambleMsg rx;
+  struct sockaddr_in from;
+  memset(&rx, 0, sizeof(rx));
+  int got = recv_message_with_timeout(pair.cli, &rx, &from, 20);
+  T_ASSERT_EQ_INT(got, 0);
+
+  TransportDriveResult drive = network_runtime_drive_once(pair.srv, 0, NULL);
+  T_ASSERT(drive.progress_count > 0);
+  got = recv_non_ack_with_timeout(pair.cli, &rx, &from, 200);
+  T_ASSERT(got > 0);
+  T_ASSERT_EQ_INT(rx.ctrl, WAMBLE_CTRL_ERROR);
+
+  cleanup_udp_loopback_pair(&pair);
+  return 0;
+}
+
+WAMBLE_TEST(direct_handler_dispatch_does_not_read_socket) {
   config_load(NULL, NULL, NULL, 0);
   network_init_thread_state();
 
@@ -6995,6 +7633,156 @@ WAMBLE_TEST(runtime_pump_delivers_terminal_and_classifier_removes_ack) {
   return 0;
 }
 
+WAMBLE_TEST(runtime_selective_ack_clears_window_and_coalesces) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+
+  struct sockaddr_in addr = test_runtime_loopback_addr(4390);
+  uint8_t token[TOKEN_LENGTH];
+  test_runtime_fill_token(token);
+  T_ASSERT_EQ_INT(
+      network_set_endpoint_capabilities(&addr, token, WAMBLE_CAP_SELECTIVE_ACK),
+      0);
+
+  T_ASSERT_EQ_INT(test_push_reliable_outbound(501, token, &addr), 0);
+  T_ASSERT_EQ_INT(test_push_reliable_outbound(502, token, &addr), 0);
+  T_ASSERT_EQ_INT(test_push_reliable_outbound(504, token, &addr), 0);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 3);
+
+  struct WambleMsg ack;
+  memset(&ack, 0, sizeof(ack));
+  ack.ctrl = WAMBLE_CTRL_ACK;
+  ack.header_version = WAMBLE_PROTO_VERSION;
+  ack.seq_num = 502;
+  ack.ack.highest_seq = 502;
+  ack.ack.bitmap = 0x1u;
+  memcpy(ack.token, token, TOKEN_LENGTH);
+  T_ASSERT_EQ_INT(
+      test_push_inbound_serialized(TRANSPORT_PACKET_SOURCE_UDP, &ack, &addr),
+      0);
+  TransportDriveResult drive =
+      network_runtime_drive_once(WAMBLE_INVALID_SOCKET, 0, NULL);
+  T_ASSERT(drive.status != TRANSPORT_DRIVE_IDLE);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
+
+  struct WambleMsg request;
+  memset(&request, 0, sizeof(request));
+  request.ctrl = WAMBLE_CTRL_PLAYER_MOVE;
+  request.header_version = WAMBLE_PROTO_VERSION;
+  memcpy(request.token, token, TOKEN_LENGTH);
+  request.seq_num = 900;
+  T_ASSERT_EQ_INT(network_enqueue_ack_after(&request, &addr), 0);
+  request.seq_num = 901;
+  T_ASSERT_EQ_INT(network_enqueue_ack_after(&request, &addr), 0);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 2);
+
+  network_init_thread_state();
+  return 0;
+}
+
+WAMBLE_TEST(runtime_selective_ack_piggybacks_on_terminal) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+
+  UdpLoopbackPair pair;
+  T_ASSERT_STATUS_OK(init_udp_loopback_pair(&pair));
+  uint8_t token[TOKEN_LENGTH];
+  test_runtime_fill_token(token);
+  T_ASSERT_EQ_INT(network_set_endpoint_capabilities(&pair.cliaddr, token,
+                                                    WAMBLE_CAP_SELECTIVE_ACK),
+                  0);
+
+  struct WambleMsg request;
+  memset(&request, 0, sizeof(request));
+  request.ctrl = WAMBLE_CTRL_PLAYER_MOVE;
+  request.header_version = WAMBLE_PROTO_VERSION;
+  memcpy(request.token, token, TOKEN_LENGTH);
+  request.seq_num = 8201;
+  T_ASSERT_EQ_INT(network_enqueue_ack_after(&request, &pair.cliaddr), 0);
+
+  struct WambleMsg terminal;
+  memset(&terminal, 0, sizeof(terminal));
+  terminal.ctrl = WAMBLE_CTRL_ERROR;
+  terminal.header_version = WAMBLE_PROTO_VERSION;
+  terminal.board_id = 45;
+  memcpy(terminal.token, token, TOKEN_LENGTH);
+  T_ASSERT_EQ_INT(network_enqueue_replayable_terminal(&terminal, &pair.cliaddr),
+                  0);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 2);
+
+  TransportDriveResult drive = network_runtime_drive_once(pair.srv, 0, NULL);
+  T_ASSERT_EQ_INT(drive.status, TRANSPORT_DRIVE_PROGRESS);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
+
+  struct WambleMsg rx;
+  struct sockaddr_in from;
+  memset(&rx, 0, sizeof(rx));
+  T_ASSERT(recv_message_with_timeout(pair.cli, &rx, &from, 100) > 0);
+  T_ASSERT_EQ_INT(rx.ctrl, WAMBLE_CTRL_ERROR);
+  T_ASSERT_EQ_INT((int)rx.ack.highest_seq, 8201);
+  T_ASSERT(wamble_ack_state_covers(&rx.ack, 8201));
+  memset(&rx, 0, sizeof(rx));
+  T_ASSERT_EQ_INT(recv_message_with_timeout(pair.cli, &rx, &from, 30), 0);
+
+  cleanup_udp_loopback_pair(&pair);
+  network_init_thread_state();
+  return 0;
+}
+
+WAMBLE_TEST(runtime_rehello_resets_endpoint_ack_state) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+
+  UdpLoopbackPair pair;
+  T_ASSERT_STATUS_OK(init_udp_loopback_pair(&pair));
+  uint8_t token[TOKEN_LENGTH];
+  test_runtime_fill_token(token);
+  T_ASSERT_EQ_INT(network_set_endpoint_capabilities(&pair.cliaddr, token,
+                                                    WAMBLE_CAP_SELECTIVE_ACK),
+                  0);
+
+  struct WambleMsg request;
+  memset(&request, 0, sizeof(request));
+  request.ctrl = WAMBLE_CTRL_PLAYER_MOVE;
+  request.header_version = WAMBLE_PROTO_VERSION;
+  memcpy(request.token, token, TOKEN_LENGTH);
+  for (uint32_t seq = 1; seq <= 3; seq++) {
+    request.seq_num = seq;
+    T_ASSERT_EQ_INT(network_enqueue_ack_after(&request, &pair.cliaddr), 0);
+  }
+  T_ASSERT_EQ_INT(test_push_reliable_outbound(700, token, &pair.cliaddr), 0);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 2);
+
+  T_ASSERT_EQ_INT(network_set_endpoint_capabilities(&pair.cliaddr, token,
+                                                    WAMBLE_CAP_SELECTIVE_ACK),
+                  0);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
+  request.seq_num = 1;
+  T_ASSERT_EQ_INT(network_enqueue_ack_after(&request, &pair.cliaddr), 0);
+
+  (void)network_runtime_drive_once(pair.srv, 0, NULL);
+  fd_set rfds;
+  struct timeval tv = {0, 100 * 1000};
+  FD_ZERO(&rfds);
+  FD_SET(pair.cli, &rfds);
+  T_ASSERT(select((int)(pair.cli + 1), &rfds, NULL, NULL, &tv) > 0);
+  uint8_t buf[WAMBLE_MAX_PACKET_SIZE];
+  ssize_t got = recv(pair.cli, (char *)buf, sizeof(buf), 0);
+  T_ASSERT(got > 0);
+  struct WambleMsg rx;
+  T_ASSERT_EQ_INT(wamble_packet_deserialize(buf, (size_t)got, &rx, NULL),
+                  NET_OK);
+  T_ASSERT_EQ_INT(rx.ctrl, WAMBLE_CTRL_ACK);
+  T_ASSERT_EQ_INT((int)rx.ack.highest_seq, 1);
+  T_ASSERT(wamble_ack_state_covers(&rx.ack, 1));
+  T_ASSERT(!wamble_ack_state_covers(&rx.ack, 2));
+  T_ASSERT(!wamble_ack_state_covers(&rx.ack, 3));
+
+  cleanup_udp_loopback_pair(&pair);
+  network_init_thread_state();
+  return 0;
+}
+
 WAMBLE_TEST(accept_profile_tos_roundtrip) {
   config_load(NULL, NULL, NULL, 0);
   wamble_socket_t srv = create_and_bind_socket(0);
@@ -7058,14 +7846,314 @@ static void drain_replay_counts(wamble_socket_t sock,
     uint8_t flags = 0;
     if (wamble_packet_deserialize(buf, (size_t)r, &m, &flags) != NET_OK)
       continue;
-    if (m.ctrl == WAMBLE_CTRL_BOARD_UPDATE && m.board_id == expected_board_id)
-      (*out_board_update_count)++;
-    else if (m.ctrl == WAMBLE_CTRL_ACK && m.seq_num == expected_request_seq)
-      (*out_request_ack_count)++;
+    if (m.ctrl == WAMBLE_CTRL_BOARD_UPDATE && m.board_id == expected_board_id)
+      (*out_board_update_count)++;
+    else if (m.ctrl == WAMBLE_CTRL_ACK && m.seq_num == expected_request_seq)
+      (*out_request_ack_count)++;
+  }
+}
+
+WAMBLE_TEST(runtime_reliable_bundle_advances_one_fragment_per_ack) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+  wamble_socket_t srv = create_and_bind_socket(0);
+  T_ASSERT(srv != WAMBLE_INVALID_SOCKET);
+  wamble_socket_t cli = socket(AF_INET, SOCK_DGRAM, 0);
+  T_ASSERT(cli != WAMBLE_INVALID_SOCKET);
+  struct sockaddr_in bindaddr = {0};
+  bindaddr.sin_family = AF_INET;
+  bindaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bindaddr.sin_port = 0;
+  T_ASSERT_STATUS_OK(bind(cli, (struct sockaddr *)&bindaddr, sizeof(bindaddr)));
+  struct sockaddr_in cliaddr;
+  wamble_socklen_t slen = (wamble_socklen_t)sizeof(cliaddr);
+  T_ASSERT_STATUS_OK(getsockname(cli, (struct sockaddr *)&cliaddr, &slen));
+
+  uint8_t token[TOKEN_LENGTH];
+  for (int i = 0; i < TOKEN_LENGTH; i++)
+    token[i] = (uint8_t)(0x90 + i);
+  uint8_t payload[WAMBLE_FRAGMENT_DATA_MAX + 17];
+  for (size_t i = 0; i < sizeof(payload); i++)
+    payload[i] = (uint8_t)('a' + (i % 23));
+
+  T_ASSERT_EQ_INT(network_enqueue_reliable_payload_bytes(
+                      WAMBLE_CTRL_PROFILE_TOS_DATA, token, 0, payload,
+                      sizeof(payload), &cliaddr, 100, 3, 1),
+                  0);
+  TransportEndpointId endpoint_id = TRANSPORT_ENDPOINT_ID_INVALID;
+  T_ASSERT_EQ_INT(
+      transport_endpoint_bind_addr_token(&cliaddr, token, &endpoint_id), 0);
+  uint32_t rto_before_ack = transport_endpoint_rto_ms_by_id(endpoint_id);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
+  (void)network_runtime_drive_once(srv, 0, "p1");
+
+  RecvTosFragmentsCtx rx = {.sock = cli,
+                            .expected_ctrl = WAMBLE_CTRL_PROFILE_TOS_DATA};
+  for (int expected = 0; expected < 2; expected++) {
+    struct WambleMsg in = {0};
+    struct sockaddr_in from;
+    T_ASSERT(recv_message_with_timeout(cli, &in, &from, 1000) > 0);
+    T_ASSERT(recv_tos_fragment_ctx_accept(&rx, &in));
+    T_ASSERT_EQ_INT((int)in.fragment.fragment_chunk_index, expected);
+    T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
+    network_ack_received_message(cli, &in, &from);
+    (void)network_runtime_drive_once(srv, 0, "p1");
+    if (expected == 0)
+      T_ASSERT(transport_endpoint_rto_ms_by_id(endpoint_id) != rto_before_ack);
+  }
+  T_ASSERT_EQ_INT(rx.chunk_count, 2);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 0);
+  wamble_close_socket(cli);
+  wamble_close_socket(srv);
+  return 0;
+}
+
+WAMBLE_TEST(runtime_reliable_bundle_window_drains_queued_bundles_in_order) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+  wamble_socket_t srv = create_and_bind_socket(0);
+  T_ASSERT(srv != WAMBLE_INVALID_SOCKET);
+  wamble_socket_t cli[2];
+  struct sockaddr_in cliaddr[2];
+  uint8_t token[2][TOKEN_LENGTH];
+  for (int c = 0; c < 2; c++) {
+    cli[c] = socket(AF_INET, SOCK_DGRAM, 0);
+    T_ASSERT(cli[c] != WAMBLE_INVALID_SOCKET);
+    struct sockaddr_in bindaddr = {0};
+    bindaddr.sin_family = AF_INET;
+    bindaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bindaddr.sin_port = 0;
+    T_ASSERT_STATUS_OK(
+        bind(cli[c], (struct sockaddr *)&bindaddr, sizeof(bindaddr)));
+    wamble_socklen_t slen = (wamble_socklen_t)sizeof(cliaddr[c]);
+    T_ASSERT_STATUS_OK(
+        getsockname(cli[c], (struct sockaddr *)&cliaddr[c], &slen));
+    for (int i = 0; i < TOKEN_LENGTH; i++)
+      token[c][i] = (uint8_t)(0x30 + c * 0x20 + i);
+  }
+
+  uint8_t payload[WAMBLE_FRAGMENT_DATA_MAX + 9];
+  const char order[] = "aBc";
+  for (int n = 0; n < 3; n++) {
+    int c = n == 1 ? 1 : 0;
+    memset(payload, order[n], sizeof(payload));
+    T_ASSERT_EQ_INT(network_enqueue_reliable_payload_bytes(
+                        WAMBLE_CTRL_PROFILE_TOS_DATA, token[c], 0, payload,
+                        sizeof(payload), &cliaddr[c], 500, 3, 1),
+                    0);
+  }
+
+  char seen[2][8] = {{0}};
+  int seen_count[2] = {0, 0};
+  for (int iter = 0; iter < 200 && transport_outbound_count() > 0; iter++) {
+    (void)network_runtime_drive_once(srv, 0, "p1");
+    for (int c = 0; c < 2; c++) {
+      struct WambleMsg in = {0};
+      struct sockaddr_in from;
+      if (recv_message_with_timeout(cli[c], &in, &from, 5) <= 0)
+        continue;
+      T_ASSERT(seen_count[c] < 6);
+      seen[c][seen_count[c]++] = (char)in.fragment.fragment_data[0];
+      network_ack_received_message(cli[c], &in, &from);
+    }
+  }
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 0);
+  T_ASSERT_STREQ(seen[0], "aacc");
+  T_ASSERT_STREQ(seen[1], "BB");
+
+  for (int c = 0; c < 2; c++)
+    wamble_close_socket(cli[c]);
+  wamble_close_socket(srv);
+  network_init_thread_state();
+  return 0;
+}
+
+WAMBLE_TEST(runtime_reliable_bundle_retries_active_fragment_until_ack) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+  wamble_socket_t srv = create_and_bind_socket(0);
+  T_ASSERT(srv != WAMBLE_INVALID_SOCKET);
+  wamble_socket_t cli = socket(AF_INET, SOCK_DGRAM, 0);
+  T_ASSERT(cli != WAMBLE_INVALID_SOCKET);
+  struct sockaddr_in bindaddr = {0};
+  bindaddr.sin_family = AF_INET;
+  bindaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bindaddr.sin_port = 0;
+  T_ASSERT_STATUS_OK(bind(cli, (struct sockaddr *)&bindaddr, sizeof(bindaddr)));
+  struct sockaddr_in cliaddr;
+  wamble_socklen_t slen = (wamble_socklen_t)sizeof(cliaddr);
+  T_ASSERT_STATUS_OK(getsockname(cli, (struct sockaddr *)&cliaddr, &slen));
+
+  uint8_t token[TOKEN_LENGTH];
+  for (int i = 0; i < TOKEN_LENGTH; i++)
+    token[i] = (uint8_t)(0xb0 + i);
+  uint8_t payload[WAMBLE_FRAGMENT_DATA_MAX + 5];
+  memset(payload, 'r', sizeof(payload));
+  T_ASSERT_EQ_INT(network_enqueue_reliable_payload_bytes(
+                      WAMBLE_CTRL_PROFILE_TOS_DATA, token, 0, payload,
+                      sizeof(payload), &cliaddr, 20, 3, 1),
+                  0);
+
+  (void)network_runtime_drive_once(srv, 0, "p1");
+  struct WambleMsg first = {0};
+  struct sockaddr_in from;
+  T_ASSERT(recv_message_with_timeout(cli, &first, &from, 1000) > 0);
+  T_ASSERT_EQ_INT((int)first.fragment.fragment_chunk_index, 0);
+  uint32_t first_seq = first.seq_num;
+
+  wamble_sleep_ms(300);
+  (void)network_runtime_drive_once(srv, 0, "p1");
+  struct WambleMsg retry = {0};
+  T_ASSERT(recv_message_with_timeout(cli, &retry, &from, 1000) > 0);
+  T_ASSERT_EQ_INT((int)retry.fragment.fragment_chunk_index, 0);
+  T_ASSERT_EQ_INT((int)retry.seq_num, (int)first_seq);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
+
+  network_ack_received_message(cli, &retry, &from);
+  (void)network_runtime_drive_once(srv, 0, "p1");
+  struct WambleMsg second = {0};
+  T_ASSERT(recv_message_with_timeout(cli, &second, &from, 1000) > 0);
+  T_ASSERT_EQ_INT((int)second.fragment.fragment_chunk_index, 1);
+
+  wamble_close_socket(cli);
+  wamble_close_socket(srv);
+  return 0;
+}
+
+WAMBLE_TEST(runtime_reliable_bundle_does_not_block_unreliable_progress) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+  wamble_socket_t srv = create_and_bind_socket(0);
+  T_ASSERT(srv != WAMBLE_INVALID_SOCKET);
+  wamble_socket_t cli = socket(AF_INET, SOCK_DGRAM, 0);
+  T_ASSERT(cli != WAMBLE_INVALID_SOCKET);
+  struct sockaddr_in bindaddr = {0};
+  bindaddr.sin_family = AF_INET;
+  bindaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bindaddr.sin_port = 0;
+  T_ASSERT_STATUS_OK(bind(cli, (struct sockaddr *)&bindaddr, sizeof(bindaddr)));
+  struct sockaddr_in cliaddr;
+  wamble_socklen_t slen = (wamble_socklen_t)sizeof(cliaddr);
+  T_ASSERT_STATUS_OK(getsockname(cli, (struct sockaddr *)&cliaddr, &slen));
+
+  uint8_t token[TOKEN_LENGTH];
+  for (int i = 0; i < TOKEN_LENGTH; i++)
+    token[i] = (uint8_t)(0xa0 + i);
+  uint8_t payload[WAMBLE_FRAGMENT_DATA_MAX + 9];
+  memset(payload, 'z', sizeof(payload));
+  T_ASSERT_EQ_INT(network_enqueue_reliable_payload_bytes(
+                      WAMBLE_CTRL_PROFILE_TOS_DATA, token, 0, payload,
+                      sizeof(payload), &cliaddr, 1000, 3, 1),
+                  0);
+  struct WambleMsg notice = {0};
+  notice.ctrl = WAMBLE_CTRL_SERVER_NOTIFICATION;
+  memcpy(notice.token, token, TOKEN_LENGTH);
+  snprintf(notice.view.fen, sizeof(notice.view.fen), "unrelated");
+  T_ASSERT_EQ_INT(network_enqueue_unreliable(&notice, &cliaddr), 0);
+
+  (void)network_runtime_drive_once(srv, 0, "p1");
+  int saw_fragment = 0;
+  int saw_notice = 0;
+  for (int i = 0; i < 2; i++) {
+    struct WambleMsg in = {0};
+    struct sockaddr_in from;
+    T_ASSERT(recv_message_with_timeout(cli, &in, &from, 1000) > 0);
+    if (in.ctrl == WAMBLE_CTRL_PROFILE_TOS_DATA)
+      saw_fragment = 1;
+    if (in.ctrl == WAMBLE_CTRL_SERVER_NOTIFICATION)
+      saw_notice = 1;
+  }
+  T_ASSERT_EQ_INT(saw_fragment, 1);
+  T_ASSERT_EQ_INT(saw_notice, 1);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
+  wamble_close_socket(cli);
+  wamble_close_socket(srv);
+  return 0;
+}
+
+WAMBLE_TEST(runtime_reliable_bundle_window_grows_and_halves_on_loss) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+  wamble_socket_t srv = create_and_bind_socket(0);
+  T_ASSERT(srv != WAMBLE_INVALID_SOCKET);
+  wamble_socket_t cli = socket(AF_INET, SOCK_DGRAM, 0);
+  T_ASSERT(cli != WAMBLE_INVALID_SOCKET);
+  struct sockaddr_in bindaddr = {0};
+  bindaddr.sin_family = AF_INET;
+  bindaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bindaddr.sin_port = 0;
+  T_ASSERT_STATUS_OK(bind(cli, (struct sockaddr *)&bindaddr, sizeof(bindaddr)));
+  struct sockaddr_in cliaddr;
+  wamble_socklen_t slen = (wamble_socklen_t)sizeof(cliaddr);
+  T_ASSERT_STATUS_OK(getsockname(cli, (struct sockaddr *)&cliaddr, &slen));
+
+  uint8_t token[TOKEN_LENGTH];
+  for (int i = 0; i < TOKEN_LENGTH; i++)
+    token[i] = (uint8_t)(0xc0 + i);
+  uint8_t payload[WAMBLE_FRAGMENT_DATA_MAX * 3 + 1];
+  memset(payload, 'w', sizeof(payload));
+  T_ASSERT_EQ_INT(network_enqueue_reliable_payload_bytes(
+                      WAMBLE_CTRL_PROFILE_TOS_DATA, token, 0, payload,
+                      sizeof(payload), &cliaddr, 40, 5, 1),
+                  0);
+  TransportEndpointId endpoint_id = TRANSPORT_ENDPOINT_ID_INVALID;
+  T_ASSERT_EQ_INT(
+      transport_endpoint_bind_addr_token(&cliaddr, token, &endpoint_id), 0);
+  T_ASSERT_EQ_INT((int)transport_endpoint_cwnd_by_id(endpoint_id), 1);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
+
+  (void)network_runtime_drive_once(srv, 0, "p1");
+  struct WambleMsg in = {0};
+  struct sockaddr_in from;
+  T_ASSERT(recv_message_with_timeout(cli, &in, &from, 1000) > 0);
+  T_ASSERT_EQ_INT((int)in.fragment.fragment_chunk_index, 0);
+  network_ack_received_message(cli, &in, &from);
+  (void)network_runtime_drive_once(srv, 0, "p1");
+  T_ASSERT_EQ_INT((int)transport_endpoint_cwnd_by_id(endpoint_id), 2);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 2);
+
+  int received = 0;
+  for (int attempt = 0; attempt < 20 && received < 2; attempt++) {
+    memset(&in, 0, sizeof(in));
+    if (recv_message_with_timeout(cli, &in, &from, 50) > 0) {
+      T_ASSERT(in.fragment.fragment_chunk_index == 1 ||
+               in.fragment.fragment_chunk_index == 2);
+      received++;
+    } else {
+      (void)network_runtime_drive_once(srv, 0, "p1");
+    }
+  }
+  T_ASSERT_EQ_INT(received, 2);
+
+  wamble_sleep_ms(200);
+  (void)network_runtime_drive_once(srv, 0, "p1");
+  T_ASSERT_EQ_INT((int)transport_endpoint_cwnd_by_id(endpoint_id), 1);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 2);
+
+  received = 0;
+  for (int attempt = 0; attempt < 20 && received < 2; attempt++) {
+    memset(&in, 0, sizeof(in));
+    if (recv_message_with_timeout(cli, &in, &from, 50) <= 0) {
+      (void)network_runtime_drive_once(srv, 0, "p1");
+      continue;
+    }
+    T_ASSERT(in.fragment.fragment_chunk_index == 1 ||
+             in.fragment.fragment_chunk_index == 2);
+    network_ack_received_message(cli, &in, &from);
+    (void)network_runtime_drive_once(srv, 0, "p1");
+    T_ASSERT_EQ_INT((int)transport_endpoint_cwnd_by_id(endpoint_id), 1);
+    received++;
   }
+  T_ASSERT_EQ_INT(received, 2);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
+
+  wamble_close_socket(cli);
+  wamble_close_socket(srv);
+  network_init_thread_state();
+  return 0;
 }
 
-WAMBLE_TEST(runtime_reliable_bundle_advances_one_fragment_per_ack) {
+WAMBLE_TEST(runtime_reliable_bundle_recovers_early_loss_past_ack_window) {
   config_load(NULL, NULL, NULL, 0);
   network_init_thread_state();
   wamble_socket_t srv = create_and_bind_socket(0);
@@ -7083,44 +8171,79 @@ WAMBLE_TEST(runtime_reliable_bundle_advances_one_fragment_per_ack) {
 
   uint8_t token[TOKEN_LENGTH];
   for (int i = 0; i < TOKEN_LENGTH; i++)
-    token[i] = (uint8_t)(0x90 + i);
-  uint8_t payload[WAMBLE_FRAGMENT_DATA_MAX + 17];
+    token[i] = (uint8_t)(0xd0 + i);
+  T_ASSERT_EQ_INT(network_set_endpoint_capabilities(&cliaddr, token,
+                                                    WAMBLE_CAP_SELECTIVE_ACK),
+                  0);
+  enum { CHUNKS = 48 };
+  static uint8_t payload[WAMBLE_FRAGMENT_DATA_MAX * CHUNKS];
   for (size_t i = 0; i < sizeof(payload); i++)
-    payload[i] = (uint8_t)('a' + (i % 23));
-
+    payload[i] = (uint8_t)(i * 7u);
   T_ASSERT_EQ_INT(network_enqueue_reliable_payload_bytes(
                       WAMBLE_CTRL_PROFILE_TOS_DATA, token, 0, payload,
-                      sizeof(payload), &cliaddr, 100, 3, 1),
+                      sizeof(payload), &cliaddr, 60, 20, 1),
                   0);
   TransportEndpointId endpoint_id = TRANSPORT_ENDPOINT_ID_INVALID;
   T_ASSERT_EQ_INT(
       transport_endpoint_bind_addr_token(&cliaddr, token, &endpoint_id), 0);
-  uint32_t rto_before_ack = transport_endpoint_rto_ms_by_id(endpoint_id);
-  T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
-  (void)network_runtime_drive_once(srv, 0, "p1");
 
-  RecvTosFragmentsCtx rx = {.sock = cli,
-                            .expected_ctrl = WAMBLE_CTRL_PROFILE_TOS_DATA};
-  for (int expected = 0; expected < 2; expected++) {
+  WambleAckState state = {0};
+  uint8_t seen[CHUNKS] = {0};
+  int seen_count = 0;
+  int dropped = 0;
+  uint32_t max_cwnd = 0;
+  for (int iter = 0; iter < 4000 && transport_outbound_count() > 0; iter++) {
+    (void)network_runtime_drive_once(srv, 0, "p1");
+    uint32_t cwnd = transport_endpoint_cwnd_by_id(endpoint_id);
+    if (cwnd > max_cwnd)
+      max_cwnd = cwnd;
     struct WambleMsg in = {0};
     struct sockaddr_in from;
-    T_ASSERT(recv_message_with_timeout(cli, &in, &from, 1000) > 0);
-    T_ASSERT(recv_tos_fragment_ctx_accept(&rx, &in));
-    T_ASSERT_EQ_INT((int)in.fragment.fragment_chunk_index, expected);
-    T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
-    network_ack_received_message(cli, &in, &from);
-    (void)network_runtime_drive_once(srv, 0, "p1");
-    if (expected == 0)
-      T_ASSERT(transport_endpoint_rto_ms_by_id(endpoint_id) != rto_before_ack);
+    if (recv_message_with_timeout(cli, &in, &from, 5) <= 0 ||
+        in.ctrl != WAMBLE_CTRL_PROFILE_TOS_DATA)
+      continue;
+    uint16_t index = in.fragment.fragment_chunk_index;
+    T_ASSERT(index < CHUNKS);
+    if (index == 1 && !dropped) {
+      dropped = 1;
+      continue;
+    }
+    if (!seen[index]) {
+      seen[index] = 1;
+      seen_count++;
+    }
+    struct WambleMsg ack = {0};
+    ack.ctrl = WAMBLE_CTRL_ACK;
+    ack.header_version = WAMBLE_PROTO_VERSION;
+    memcpy(ack.token, token, TOKEN_LENGTH);
+    ack.seq_num = in.seq_num;
+    if (wamble_ack_state_record(&state, in.seq_num)) {
+      ack.seq_num = state.highest_seq;
+      ack.ack = state;
+    }
+    T_ASSERT_EQ_INT(
+        test_push_inbound_serialized(TRANSPORT_PACKET_SOURCE_UDP, &ack,
+                                     &cliaddr),
+        0);
   }
-  T_ASSERT_EQ_INT(rx.chunk_count, 2);
+  T_ASSERT_EQ_INT(dropped, 1);
+  T_ASSERT_EQ_INT(seen_count, CHUNKS);
   T_ASSERT_EQ_INT((int)transport_outbound_count(), 0);
+  T_ASSERT(max_cwnd <= WAMBLE_ACK_BITMAP_BITS);
+
+  WambleAckState late = {0};
+  T_ASSERT(wamble_ack_state_record(&late, 1));
+  T_ASSERT(wamble_ack_state_record(&late, 40));
+  T_ASSERT(!wamble_ack_state_record(&late, 2));
+  T_ASSERT(!wamble_ack_state_covers(&late, 2));
+
   wamble_close_socket(cli);
   wamble_close_socket(srv);
+  network_init_thread_state();
   return 0;
 }
 
-WAMBLE_TEST(runtime_reliable_bundle_retries_active_fragment_until_ack) {
+WAMBLE_TEST(runtime_reliable_bundle_window_halves_on_selective_ack_gap) {
   config_load(NULL, NULL, NULL, 0);
   network_init_thread_state();
   wamble_socket_t srv = create_and_bind_socket(0);
@@ -7138,41 +8261,66 @@ WAMBLE_TEST(runtime_reliable_bundle_retries_active_fragment_until_ack) {
 
   uint8_t token[TOKEN_LENGTH];
   for (int i = 0; i < TOKEN_LENGTH; i++)
-    token[i] = (uint8_t)(0xb0 + i);
-  uint8_t payload[WAMBLE_FRAGMENT_DATA_MAX + 5];
-  memset(payload, 'r', sizeof(payload));
+    token[i] = (uint8_t)(0xe0 + i);
+  T_ASSERT_EQ_INT(network_set_endpoint_capabilities(&cliaddr, token,
+                                                    WAMBLE_CAP_SELECTIVE_ACK),
+                  0);
+  static uint8_t payload[WAMBLE_FRAGMENT_DATA_MAX * 10];
+  memset(payload, 's', sizeof(payload));
   T_ASSERT_EQ_INT(network_enqueue_reliable_payload_bytes(
                       WAMBLE_CTRL_PROFILE_TOS_DATA, token, 0, payload,
-                      sizeof(payload), &cliaddr, 20, 3, 1),
+                      sizeof(payload), &cliaddr, 2000, 5, 1),
                   0);
+  TransportEndpointId endpoint_id = TRANSPORT_ENDPOINT_ID_INVALID;
+  T_ASSERT_EQ_INT(
+      transport_endpoint_bind_addr_token(&cliaddr, token, &endpoint_id), 0);
 
+  WambleAckState state = {0};
+  uint32_t peak = 0;
+  int dropped = 0;
+  int acked_after_drop = 0;
+  for (int iter = 0; iter < 400 && acked_after_drop < 3; iter++) {
+    (void)network_runtime_drive_once(srv, 0, "p1");
+    uint32_t cwnd = transport_endpoint_cwnd_by_id(endpoint_id);
+    if (cwnd > peak)
+      peak = cwnd;
+    struct WambleMsg in = {0};
+    struct sockaddr_in from;
+    if (recv_message_with_timeout(cli, &in, &from, 5) <= 0 ||
+        in.ctrl != WAMBLE_CTRL_PROFILE_TOS_DATA)
+      continue;
+    if (in.fragment.fragment_chunk_index == 3) {
+      T_ASSERT_EQ_INT(dropped, 0);
+      dropped = 1;
+      continue;
+    }
+    if (dropped)
+      acked_after_drop++;
+    struct WambleMsg ack = {0};
+    ack.ctrl = WAMBLE_CTRL_ACK;
+    ack.header_version = WAMBLE_PROTO_VERSION;
+    memcpy(ack.token, token, TOKEN_LENGTH);
+    T_ASSERT(wamble_ack_state_record(&state, in.seq_num));
+    ack.seq_num = state.highest_seq;
+    ack.ack = state;
+    T_ASSERT_EQ_INT(
+        test_push_inbound_serialized(TRANSPORT_PACKET_SOURCE_UDP, &ack,
+                                     &cliaddr),
+        0);
+  }
+  T_ASSERT_EQ_INT(dropped, 1);
+  T_ASSERT_EQ_INT(acked_after_drop, 3);
+  T_ASSERT(peak >= 4);
   (void)network_runtime_drive_once(srv, 0, "p1");
-  struct WambleMsg first = {0};
-  struct sockaddr_in from;
-  T_ASSERT(recv_message_with_timeout(cli, &first, &from, 1000) > 0);
-  T_ASSERT_EQ_INT((int)first.fragment.fragment_chunk_index, 0);
-  uint32_t first_seq = first.seq_num;
-
-  wamble_sleep_ms(300);
-  (void)network_runtime_drive_once(srv, 0, "p1");
-  struct WambleMsg retry = {0};
-  T_ASSERT(recv_message_with_timeout(cli, &retry, &from, 1000) > 0);
-  T_ASSERT_EQ_INT((int)retry.fragment.fragment_chunk_index, 0);
-  T_ASSERT_EQ_INT((int)retry.seq_num, (int)first_seq);
-  T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
-
-  network_ack_received_message(cli, &retry, &from);
-  (void)network_runtime_drive_once(srv, 0, "p1");
-  struct WambleMsg second = {0};
-  T_ASSERT(recv_message_with_timeout(cli, &second, &from, 1000) > 0);
-  T_ASSERT_EQ_INT((int)second.fragment.fragment_chunk_index, 1);
+  T_ASSERT(transport_endpoint_cwnd_by_id(endpoint_id) < peak);
 
   wamble_close_socket(cli);
   wamble_close_socket(srv);
+  network_init_thread_state();
   return 0;
 }
 
-WAMBLE_TEST(runtime_reliable_bundle_does_not_block_unreliable_progress) {
+WAMBLE_TEST(runtime_reliable_bundle_paces_fragments_by_srtt) {
   config_load(NULL, NULL, NULL, 0);
   network_init_thread_state();
   wamble_socket_t srv = create_and_bind_socket(0);
@@ -7190,36 +8338,344 @@ WAMBLE_TEST(runtime_reliable_bundle_does_not_block_unreliable_progress) {
 
   uint8_t token[TOKEN_LENGTH];
   for (int i = 0; i < TOKEN_LENGTH; i++)
-    token[i] = (uint8_t)(0xa0 + i);
-  uint8_t payload[WAMBLE_FRAGMENT_DATA_MAX + 9];
-  memset(payload, 'z', sizeof(payload));
+    token[i] = (uint8_t)(0xd0 + i);
+  TransportEndpointId endpoint_id = TRANSPORT_ENDPOINT_ID_INVALID;
+  T_ASSERT_EQ_INT(
+      transport_endpoint_bind_addr_token(&cliaddr, token, &endpoint_id), 0);
+  T_ASSERT_EQ_INT(transport_endpoint_update_rto_by_id(endpoint_id, 400, 0), 0);
+
+  uint8_t payload[WAMBLE_FRAGMENT_DATA_MAX * 3 + 1];
+  memset(payload, 'p', sizeof(payload));
   T_ASSERT_EQ_INT(network_enqueue_reliable_payload_bytes(
                       WAMBLE_CTRL_PROFILE_TOS_DATA, token, 0, payload,
-                      sizeof(payload), &cliaddr, 1000, 3, 1),
+                      sizeof(payload), &cliaddr, 2000, 3, 1),
                   0);
-  struct WambleMsg notice = {0};
-  notice.ctrl = WAMBLE_CTRL_SERVER_NOTIFICATION;
-  memcpy(notice.token, token, TOKEN_LENGTH);
-  snprintf(notice.view.fen, sizeof(notice.view.fen), "unrelated");
-  T_ASSERT_EQ_INT(network_enqueue_unreliable(&notice, &cliaddr), 0);
+  (void)network_runtime_drive_once(srv, 0, "p1");
+  struct WambleMsg in = {0};
+  struct sockaddr_in from;
+  T_ASSERT(recv_message_with_timeout(cli, &in, &from, 1000) > 0);
+  T_ASSERT_EQ_INT((int)in.fragment.fragment_chunk_index, 0);
+  network_ack_received_message(cli, &in, &from);
 
+  TransportDriveResult drive = network_runtime_drive_once(srv, 0, "p1");
+  T_ASSERT_EQ_INT((int)transport_endpoint_cwnd_by_id(endpoint_id), 2);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 2);
+  T_ASSERT(drive.next_deadline_at_ms > wamble_now_mono_millis());
+  memset(&in, 0, sizeof(in));
+  T_ASSERT(recv_message_with_timeout(cli, &in, &from, 1000) > 0);
+  T_ASSERT_EQ_INT((int)in.fragment.fragment_chunk_index, 1);
+  memset(&in, 0, sizeof(in));
+  T_ASSERT_EQ_INT(recv_message_with_timeout(cli, &in, &from, 30), 0);
+
+  wamble_sleep_ms(250);
   (void)network_runtime_drive_once(srv, 0, "p1");
-  int saw_fragment = 0;
-  int saw_notice = 0;
-  for (int i = 0; i < 2; i++) {
-    struct WambleMsg in = {0};
-    struct sockaddr_in from;
-    T_ASSERT(recv_message_with_timeout(cli, &in, &from, 1000) > 0);
-    if (in.ctrl == WAMBLE_CTRL_PROFILE_TOS_DATA)
-      saw_fragment = 1;
-    if (in.ctrl == WAMBLE_CTRL_SERVER_NOTIFICATION)
-      saw_notice = 1;
-  }
-  T_ASSERT_EQ_INT(saw_fragment, 1);
-  T_ASSERT_EQ_INT(saw_notice, 1);
-  T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
+  memset(&in, 0, sizeof(in));
+  T_ASSERT(recv_message_with_timeout(cli, &in, &from, 1000) > 0);
+  T_ASSERT_EQ_INT((int)in.fragment.fragment_chunk_index, 2);
+
   wamble_close_socket(cli);
   wamble_close_socket(srv);
+  network_init_thread_state();
+  return 0;
+}
+
+WAMBLE_TEST(runtime_reliable_bundle_compresses_for_negotiated_endpoint) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+
+  UdpLoopbackPair pair;
+  T_ASSERT_STATUS_OK(init_udp_loopback_pair(&pair));
+  uint8_t token[TOKEN_LENGTH];
+  test_runtime_fill_token(token);
+  T_ASSERT_EQ_INT(network_set_endpoint_capabilities(
+                      &pair.cliaddr, token, WAMBLE_CAP_PAYLOAD_COMPRESSION),
+                  0);
+
+  static uint8_t payload[WAMBLE_FRAGMENT_DATA_MAX * 3 + 7];
+  const char *phrase = "Moves are final once submitted. ";
+  size_t phrase_len = strlen(phrase);
+  for (size_t i = 0; i < sizeof(payload); i++)
+    payload[i] = (uint8_t)phrase[i % phrase_len];
+  T_ASSERT_EQ_INT(network_enqueue_reliable_payload_bytes(
+                      WAMBLE_CTRL_PROFILE_TOS_DATA, token, 0, payload,
+                      sizeof(payload), &pair.cliaddr, 1000, 3, 0),
+                  0);
+  T_ASSERT_EQ_INT((int)transport_outbound_count(), 1);
+
+  (void)network_runtime_drive_once(pair.srv, 0, "p1");
+  struct WambleMsg in = {0};
+  struct sockaddr_in from;
+  T_ASSERT(recv_message_with_timeout(pair.cli, &in, &from, 1000) > 0);
+  T_ASSERT_EQ_INT(in.ctrl, WAMBLE_CTRL_PROFILE_TOS_DATA);
+  T_ASSERT_EQ_INT(in.fragment.fragment_codec, WAMBLE_FRAGMENT_CODEC_LZ);
+  T_ASSERT_EQ_INT((int)in.fragment.fragment_chunk_count, 1);
+  T_ASSERT(in.fragment.fragment_total_len < sizeof(payload));
+
+  WambleFragmentReassembly reassembly;
+  wamble_fragment_reassembly_init(&reassembly);
+  T_ASSERT_EQ_INT(wamble_fragment_reassembly_push(&reassembly, &in),
+                  WAMBLE_FRAGMENT_REASSEMBLY_COMPLETE);
+  size_t data_len = 0;
+  const uint8_t *data = wamble_fragment_reassembly_data(&reassembly, &data_len);
+  T_ASSERT_EQ_INT((int)data_len, (int)sizeof(payload));
+  T_ASSERT(memcmp(data, payload, sizeof(payload)) == 0);
+  wamble_fragment_reassembly_free(&reassembly);
+
+  cleanup_udp_loopback_pair(&pair);
+  network_init_thread_state();
+  return 0;
+}
+
+WAMBLE_TEST(rate_limit_token_bucket_bursts_then_denies) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+  uint8_t token_a[TOKEN_LENGTH] = {0};
+  uint8_t token_b[TOKEN_LENGTH] = {0};
+  test_runtime_fill_token(token_a);
+  memcpy(token_b, token_a, TOKEN_LENGTH);
+  token_b[TOKEN_LENGTH - 1] ^= 0x5A;
+
+  for (int i = 0; i < 5; i++)
+    T_ASSERT_EQ_INT(network_rate_limit_allow(token_a, 5), 1);
+  T_ASSERT_EQ_INT(network_rate_limit_allow(token_a, 5), 0);
+  T_ASSERT_EQ_INT(network_rate_limit_allow(token_b, 5), 1);
+  T_ASSERT_EQ_INT(network_rate_limit_allow(token_a, 0), 1);
+
+  for (int i = 0; i < 600; i++) {
+    uint8_t other[TOKEN_LENGTH] = {0};
+    other[0] = 0xEE;
+    memcpy(&other[1], &i, sizeof(i));
+    T_ASSERT_EQ_INT(network_rate_limit_allow(other, 5), 1);
+  }
+  T_ASSERT_EQ_INT(network_rate_limit_allow(token_a, 5), 0);
+
+  network_init_thread_state();
+  T_ASSERT_EQ_INT(network_rate_limit_allow(token_a, 5), 1);
+  network_init_thread_state();
+  return 0;
+}
+
+WAMBLE_TEST(addr_prefilter_meters_per_source_ip) {
+  config_load(NULL, NULL, NULL, 0);
+  network_init_thread_state();
+  struct sockaddr_in a1 = test_runtime_loopback_addr(4400);
+  struct sockaddr_in a2 = test_runtime_loopback_addr(4401);
+  struct sockaddr_in other = test_runtime_loopback_addr(4400);
+  other.sin_addr.s_addr = htonl(0x7F000002u);
+
+  T_ASSERT_EQ_INT(network_addr_prefilter_allow(&a1, 3), 1);
+  T_ASSERT_EQ_INT(network_addr_prefilter_allow(&a2, 3), 1);
+  T_ASSERT_EQ_INT(network_addr_prefilter_allow(&a1, 3), 1);
+  T_ASSERT_EQ_INT(network_addr_prefilter_allow(&a2, 3), 0);
+  T_ASSERT_EQ_INT(network_addr_prefilter_allow(&other, 3), 1);
+  T_ASSERT_EQ_INT(network_addr_prefilter_allow(&a1, 0), 1);
+  T_ASSERT_EQ_INT(network_addr_prefilter_allow(NULL, 3), 1);
+
+  network_init_thread_state();
+  return 0;
+}
+
+typedef struct LoginVerifyPollCtx {
+  int polled;
+} LoginVerifyPollCtx;
+
+static void *login_verify_poll_other_thread(void *arg) {
+  LoginVerifyPollCtx *ctx = (LoginVerifyPollCtx *)arg;
+  uint64_t ticket = 0;
+  int verified = 0;
+  ctx->polled = login_verify_poll(&ticket, &verified);
+  return NULL;
+}
+
+static int test_login_proof(uint8_t seed_base, uint8_t public_key[32],
+                            uint8_t signature[64], uint8_t *message,
+                            size_t message_cap, size_t *message_len) {
+  uint8_t seed[32];
+  uint8_t secret_key[64];
+  uint8_t token[TOKEN_LENGTH];
+  uint8_t challenge[WAMBLE_LOGIN_CHALLENGE_LENGTH];
+  for (int i = 0; i < 32; i++)
+    seed[i] = (uint8_t)(seed_base + i);
+  test_runtime_fill_token(token);
+  memset(challenge, 0x5C, sizeof(challenge));
+  wamble_client_keygen(seed, public_key, secret_key);
+  if (wamble_client_sign_challenge(secret_key, token, public_key, challenge,
+                                   signature) != 0)
+    return -1;
+  *message_len = wamble_build_login_signature_message(
+      message, message_cap, token, public_key, challenge);
+  return *message_len ? 0 : -1;
+}
+
+WAMBLE_TEST(login_verify_pool_checks_proofs_off_thread) {
+  uint8_t public_key[32];
+  uint8_t signature[64];
+  uint8_t message[128];
+  size_t message_len = 0;
+  T_ASSERT_STATUS_OK(test_login_proof(0x30, public_key, signature, message,
+                                      sizeof(message), &message_len));
+  uint8_t bad_signature[64];
+  memcpy(bad_signature, signature, sizeof(bad_signature));
+  bad_signature[7] ^= 0x01;
+
+  T_ASSERT_STATUS_OK(login_verify_pool_init());
+  uint64_t good = login_verify_submit(signature, public_key, message,
+                                      message_len, WAMBLE_INVALID_SOCKET);
+  uint64_t bad = login_verify_submit(bad_signature, public_key, message,
+                                     message_len, WAMBLE_INVALID_SOCKET);
+  T_ASSERT(good != 0);
+  T_ASSERT(bad != 0 && bad != good);
+  T_ASSERT_EQ_INT(login_verify_pending(), 2);
+
+  int good_result = -1;
+  int bad_result = -1;
+  uint64_t deadline = wamble_now_mono_millis() + 2000u;
+  while (login_verify_pending() > 0 && wamble_now_mono_millis() < deadline) {
+    uint64_t ticket = 0;
+    int verified = 0;
+    if (login_verify_poll(&ticket, &verified) != 1)
+      continue;
+    if (ticket == good)
+      good_result = verified;
+    else if (ticket == bad)
+      bad_result = verified;
+  }
+  login_verify_pool_shutdown();
+  T_ASSERT_EQ_INT(login_verify_pending(), 0);
+  T_ASSERT_EQ_INT(good_result, 1);
+  T_ASSERT_EQ_INT(bad_result, 0);
+  return 0;
+}
+
+WAMBLE_TEST(login_thread_cleanup_releases_challenge_state) {
+  config_load(NULL, NULL, NULL, 0);
+  uint8_t token[TOKEN_LENGTH];
+  uint8_t public_key[WAMBLE_PUBLIC_KEY_LENGTH];
+  test_runtime_fill_token(token);
+  memset(public_key, 0x5a, sizeof(public_key));
+  T_ASSERT_EQ_INT(server_protocol_test_issue_login_challenge(token, public_key),
+                  0);
+  T_ASSERT_EQ_INT(server_protocol_thread_pending_login_challenge_count(), 1);
+
+  server_protocol_thread_cleanup();
+  T_ASSERT_EQ_INT(server_protocol_thread_pending_login_challenge_count(), 0);
+  T_ASSERT_EQ_INT(server_protocol_test_issue_login_challenge(token, public_key),
+                  0);
+  T_ASSERT_EQ_INT(server_protocol_thread_pending_login_challenge_count(), 1);
+  server_protocol_thread_cleanup();
+  return 0;
+}
+
+WAMBLE_TEST(login_thread_cleanup_discards_unpolled_verify_jobs) {
+  uint8_t public_key[32];
+  uint8_t signature[64];
+  uint8_t message[128];
+  size_t message_len = 0;
+  T_ASSERT_STATUS_OK(test_login_proof(0x51, public_key, signature, message,
+                                      sizeof(message), &message_len));
+  T_ASSERT(login_verify_submit(signature, public_key, message, message_len,
+                               WAMBLE_INVALID_SOCKET) != 0);
+  T_ASSERT(login_verify_submit(signature, public_key, message, message_len,
+                               WAMBLE_INVALID_SOCKET) != 0);
+  T_ASSERT_EQ_INT(login_verify_pending(), 2);
+
+  server_protocol_thread_cleanup();
+  T_ASSERT_EQ_INT(login_verify_pending(), 0);
+  uint64_t ticket = 0;
+  int verified = 0;
+  T_ASSERT_EQ_INT(login_verify_poll(&ticket, &verified), 0);
+
+  uint64_t next = login_verify_submit(signature, public_key, message,
+                                      message_len, WAMBLE_INVALID_SOCKET);
+  T_ASSERT(next != 0);
+  T_ASSERT_EQ_INT(login_verify_poll(&ticket, &verified), 1);
+  T_ASSERT(ticket == next);
+  T_ASSERT_EQ_INT(verified, 1);
+  T_ASSERT_EQ_INT(login_verify_pending(), 0);
+  return 0;
+}
+
+WAMBLE_TEST(login_verify_pool_wakes_only_the_submitting_thread) {
+  uint8_t public_key[32];
+  uint8_t signature[64];
+  uint8_t message[128];
+  size_t message_len = 0;
+  T_ASSERT_STATUS_OK(test_login_proof(0x50, public_key, signature, message,
+                                      sizeof(message), &message_len));
+  wamble_socket_t sock = create_and_bind_socket(0);
+  T_ASSERT(sock != WAMBLE_INVALID_SOCKET);
+
+  T_ASSERT_STATUS_OK(login_verify_pool_init());
+  uint64_t ticket =
+      login_verify_submit(signature, public_key, message, message_len, sock);
+  T_ASSERT(ticket != 0);
+
+  fd_set rfds;
+  struct timeval tv;
+  FD_ZERO(&rfds);
+  FD_SET(sock, &rfds);
+  tv.tv_sec = 2;
+  tv.tv_usec = 0;
+#ifdef WAMBLE_PLATFORM_WINDOWS
+  int ready = select(0, &rfds, NULL, NULL, &tv);
+#else
+  int ready = select(sock + 1, &rfds, NULL, NULL, &tv);
+#endif
+  T_ASSERT(ready > 0);
+  uint8_t wake = 0xFF;
+  struct sockaddr_in from;
+  wamble_socklen_t from_len = (wamble_socklen_t)sizeof(from);
+  T_ASSERT_EQ_INT((int)recvfrom(sock, (char *)&wake, 1, 0,
+                                (struct sockaddr *)&from, &from_len),
+                  1);
+  T_ASSERT_EQ_INT(wake, 0);
+
+  LoginVerifyPollCtx other = {-1};
+  wamble_thread_t th;
+  T_ASSERT(wamble_thread_create(&th, login_verify_poll_other_thread, &other) ==
+           0);
+  T_ASSERT_STATUS_OK(wamble_thread_join(th, NULL));
+  T_ASSERT_EQ_INT(other.polled, 0);
+
+  uint64_t polled_ticket = 0;
+  int verified = 0;
+  T_ASSERT_EQ_INT(login_verify_poll(&polled_ticket, &verified), 1);
+  T_ASSERT(polled_ticket == ticket);
+  T_ASSERT_EQ_INT(verified, 1);
+  login_verify_pool_shutdown();
+  wamble_close_socket(sock);
+  return 0;
+}
+
+WAMBLE_TEST(addr_prefilter_limits_cycling_sources_when_table_full) {
+  const char *cfg_path = "build/test_network_prefilter_full.conf";
+  T_ASSERT_EQ_INT(
+      wamble_test_write_optional_db_config_file(cfg_path,
+                                                "(def max-players 8)\n"),
+      0);
+  T_ASSERT_STATUS(config_load(cfg_path, NULL, NULL, 0), CONFIG_LOAD_OK);
+  network_init_thread_state();
+
+  struct sockaddr_in hot = test_runtime_loopback_addr(4402);
+  T_ASSERT_EQ_INT(network_addr_prefilter_allow(&hot, 1), 1);
+  T_ASSERT_EQ_INT(network_addr_prefilter_allow(&hot, 1), 0);
+  int admitted = 0;
+  int rejected = 0;
+  for (int round = 0; round < 2; round++) {
+    for (uint32_t i = 0; i < 512; i++) {
+      struct sockaddr_in src = test_runtime_loopback_addr(4402);
+      src.sin_addr.s_addr = htonl(0x0A000000u + i);
+      if (network_addr_prefilter_allow(&src, 1))
+        admitted++;
+      else
+        rejected++;
+    }
+  }
+  T_ASSERT(admitted <= 64 + 1);
+  T_ASSERT(rejected >= 2 * 512 - 64 - 1);
+  T_ASSERT_EQ_INT(network_addr_prefilter_allow(&hot, 1), 0);
+
+  network_init_thread_state();
   return 0;
 }
 
@@ -7881,12 +9337,16 @@ WAMBLE_TESTS_ADD_SM(server_notification_ext_auto_fragment_unreliable,
                     WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_SM(server_notification_ext_auto_fragment_reliable,
                     WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(lz_codec_roundtrip_and_rejects_corrupt_input,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_SM(fragment_reassembly_api_complete_with_integrity_ok,
                     WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_SM(fragment_reassembly_api_reports_hash_mismatch,
                     WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_SM(fragment_reassembly_api_switches_transfers,
                     WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(fragment_reassembly_api_rejects_oversized_lz_raw_len,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_SM(submit_prediction_roundtrip, WAMBLE_SUITE_FUNCTIONAL,
                     "network");
 WAMBLE_TESTS_ADD_SM(prediction_data_roundtrip, WAMBLE_SUITE_FUNCTIONAL,
@@ -7895,10 +9355,38 @@ WAMBLE_TESTS_ADD_SM(get_active_reservations_roundtrip, WAMBLE_SUITE_FUNCTIONAL,
                     "network");
 WAMBLE_TESTS_ADD_SM(runtime_reliable_bundle_advances_one_fragment_per_ack,
                     WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(
+    runtime_reliable_bundle_window_drains_queued_bundles_in_order,
+    WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_SM(runtime_reliable_bundle_retries_active_fragment_until_ack,
                     WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_SM(runtime_reliable_bundle_does_not_block_unreliable_progress,
                     WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(runtime_reliable_bundle_window_grows_and_halves_on_loss,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(
+    runtime_reliable_bundle_recovers_early_loss_past_ack_window,
+    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(runtime_reliable_bundle_window_halves_on_selective_ack_gap,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(runtime_reliable_bundle_paces_fragments_by_srtt,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(runtime_reliable_bundle_compresses_for_negotiated_endpoint,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(rate_limit_token_bucket_bursts_then_denies,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(addr_prefilter_meters_per_source_ip,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(addr_prefilter_limits_cycling_sources_when_table_full,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(login_verify_pool_checks_proofs_off_thread,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(login_thread_cleanup_releases_challenge_state,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(login_thread_cleanup_discards_unpolled_verify_jobs,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(login_verify_pool_wakes_only_the_submitting_thread,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_SM(active_reservations_data_roundtrip, WAMBLE_SUITE_FUNCTIONAL,
                     "network");
 WAMBLE_TESTS_ADD_DB_SM(reliable_ack_success, WAMBLE_SUITE_FUNCTIONAL,
@@ -7922,6 +9410,10 @@ WAMBLE_TESTS_ADD_SM(get_profile_info_long_name_roundtrip,
 WAMBLE_TESTS_ADD_SM(profile_info_roundtrip, WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_SM(profile_info_endpoint_ext_roundtrip,
                     WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(selective_ack_state_and_trailer_roundtrip,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(msg_view_decode_reuses_message_without_stale_fields,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_SM(profiles_list_roundtrip, WAMBLE_SUITE_FUNCTIONAL,
                     "network");
 WAMBLE_TESTS_ADD_DB_SM(server_protocol_client_hello_requires_policy,
@@ -7936,6 +9428,9 @@ WAMBLE_TESTS_ADD_DB_SM(
     WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_DB_SM(server_protocol_profile_info_advertises_profile_caps,
                        WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_DB_SM(
+    server_protocol_profiles_list_and_info_use_tier_catalog,
+    WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_DB_SM(
     server_protocol_profile_info_omits_tos_cap_when_text_empty,
     WAMBLE_SUITE_FUNCTIONAL, "network");
@@ -8070,6 +9565,13 @@ WAMBLE_TESTS_ADD_SM(runtime_reload_readiness_blocks_dispatch_and_reliable_work,
                     WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_SM(runtime_reload_readiness_blocks_terminal_cache_until_ttl,
                     WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(runtime_terminal_cache_expires_on_touch_and_shrinks_arena,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(runtime_terminal_cache_ring_indexes_by_request_seq,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(
+    runtime_session_expiry_reuses_slots_without_losing_lookups,
+    WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_SM(runtime_reload_readiness_blocks_reliable_fragment_bundle,
                     WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_SM(runtime_ack_updates_rto_for_non_retransmitted_entry,
@@ -8083,6 +9585,15 @@ WAMBLE_TESTS_ADD_SM(runtime_preserves_non_ack_packets_for_dispatch,
 WAMBLE_TESTS_ADD_SM(
     runtime_dispatch_handles_application_rejection_without_drive_error,
     WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(runtime_outbound_burst_arrives_as_individual_datagrams,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(runtime_inbound_splits_coalesced_datagrams,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(
+    spectator_summary_rate_backs_off_with_endpoint_backlog,
+    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(spectator_batch_shares_payload_and_patches_tokens,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_SM(
     runtime_duplicate_request_does_not_duplicate_pending_terminal,
     WAMBLE_SUITE_FUNCTIONAL, "network");
@@ -8096,4 +9607,10 @@ WAMBLE_TESTS_ADD_SM(runtime_pump_delivers_queued_request_ack_once,
                     WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_ADD_SM(runtime_pump_delivers_terminal_and_classifier_removes_ack,
                     WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(runtime_selective_ack_clears_window_and_coalesces,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(runtime_selective_ack_piggybacks_on_terminal,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
+WAMBLE_TESTS_ADD_SM(runtime_rehello_resets_endpoint_ack_state,
+                    WAMBLE_SUITE_FUNCTIONAL, "network");
 WAMBLE_TESTS_END()
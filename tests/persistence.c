@@ -339,6 +339,17 @@ static int read_case_session_by_token(const WambleQueryService *qs) {
   return 0;
 }
 
+static int read_case_sessions_by_tokens(const WambleQueryService *qs) {
+  uint8_t tokens[2 * TOKEN_LENGTH];
+  uint64_t out[2] = {0, 0};
+  memcpy(tokens, g_read_case_token, TOKEN_LENGTH);
+  memset(tokens + TOKEN_LENGTH, 0xfe, TOKEN_LENGTH);
+  T_ASSERT_STATUS(qs->get_sessions_by_tokens(tokens, 2, out), DB_OK);
+  T_ASSERT(out[0] == g_read_case_session_id);
+  T_ASSERT(out[1] == 0);
+  return 0;
+}
+
 static int read_case_terms_acceptance_check(const WambleQueryService *qs) {
   int accepted = -1;
   T_ASSERT_STATUS(qs->has_profile_terms_acceptance(g_read_case_token, "alpha",
@@ -586,6 +597,14 @@ static int read_case_policy_decision(const WambleQueryService *qs) {
   return 0;
 }
 
+static int read_case_policy_action_has_rules(const WambleQueryService *qs) {
+  int present = -1;
+  T_ASSERT_STATUS(qs->policy_action_has_rules("trust.tier", 1, &present),
+                  DB_OK);
+  T_ASSERT(present == 0 || present == 1);
+  return 0;
+}
+
 static int read_case_treatment_actions(const WambleQueryService *qs) {
   WambleFact facts[1] = {0};
   snprintf(facts[0].key, sizeof(facts[0].key), "%s", "session.games");
@@ -689,6 +708,7 @@ WAMBLE_TEST(persistence_db_query_service_read_contract) {
       {"get_active_session_count", read_case_active_session_count},
       {"get_max_board_id", read_case_max_board_id},
       {"get_session_by_token", read_case_session_by_token},
+      {"get_sessions_by_tokens", read_case_sessions_by_tokens},
       {"has_profile_terms_acceptance", read_case_terms_acceptance_check},
       {"has_profile_terms_acceptance_for_config",
        read_case_terms_acceptance_check_for_config},
@@ -732,6 +752,7 @@ WAMBLE_TEST(persistence_db_query_service_read_contract) {
       {"get_session_treatment_assignment",
        read_case_session_treatment_assignment},
       {"resolve_policy_decision", read_case_policy_decision},
+      {"policy_action_has_rules", read_case_policy_action_has_rules},
       {"resolve_treatment_actions", read_case_treatment_actions},
       {"treatment_edge_allows", read_case_treatment_edge_allows},
   };
@@ -1207,6 +1228,63 @@ WAMBLE_TEST(persistence_prefix_reconciliation_preserves_retry_and_suffix) {
   return 0;
 }
 
+static int g_rating_update_statements = 0;
+
+static void rating_update_audit_sink(const WambleAuditEvent *event,
+                                     void *userdata) {
+  (void)userdata;
+  if (event && event->kind == WAMBLE_AUDIT_EVENT_DB_SQL && event->detail &&
+      strncmp(event->detail, "UPDATE players", 14) == 0)
+    g_rating_update_statements++;
+}
+
+WAMBLE_TEST(persistence_rating_run_applies_as_one_update) {
+  T_ASSERT_EQ_INT(
+      wamble_test_prepare_db("build/test_persistence_rating_run.conf", "",
+                             NULL),
+      0);
+  T_ASSERT_EQ_INT(
+      test_db_apply_sql("INSERT INTO players(id, public_key, rating) VALUES "
+                        "(5101, decode(repeat('51', 32), 'hex'), 1200), "
+                        "(5102, decode(repeat('52', 32), 'hex'), 1200), "
+                        "(5103, decode(repeat('53', 32), 'hex'), 1200);"),
+      0);
+  uint8_t tokens[3][TOKEN_LENGTH];
+  uint64_t sids[3];
+  for (int i = 0; i < 3; i++) {
+    memset(tokens[i], 0x61 + i, TOKEN_LENGTH);
+    sids[i] = db_create_session(tokens[i], (uint64_t)(5101 + i));
+    T_ASSERT(sids[i] > 0);
+  }
+
+  WambleIntentBuffer intents;
+  wamble_intents_init(&intents);
+  wamble_set_intent_buffer(&intents);
+  wamble_emit_update_player_rating(tokens[0], sids[0], 1300.0);
+  wamble_emit_update_player_rating(tokens[1], 0, 1310.0);
+  wamble_emit_update_player_rating(tokens[2], 0, 1320.0);
+  wamble_emit_update_player_rating(tokens[0], sids[0], 1350.0);
+  g_rating_update_statements = 0;
+  wamble_audit_set_sink(rating_update_audit_sink, NULL);
+  int flushed = wamble_persistence_flush_buffer(
+      &intents, wamble_get_db_query_service(), 1, 16, 4096);
+  wamble_audit_set_sink(NULL, NULL);
+  T_ASSERT_EQ_INT(flushed, 1);
+  T_ASSERT_EQ_INT(intents.count, 0);
+  T_ASSERT_EQ_INT(g_rating_update_statements, 1);
+  long matched = 0;
+  T_ASSERT_EQ_INT(
+      test_db_query_int("SELECT COUNT(*) FROM players WHERE (id = 5101 AND "
+                        "rating = 1350) OR (id = 5102 AND rating = 1310) OR "
+                        "(id = 5103 AND rating = 1320)",
+                        &matched),
+      0);
+  T_ASSERT_EQ_INT((int)matched, 3);
+  wamble_set_intent_buffer(NULL);
+  wamble_intents_free(&intents);
+  return 0;
+}
+
 WAMBLE_TEST(persistence_board_move_meta_sql_executes) {
   T_ASSERT_EQ_INT(wamble_test_prepare_db(
                       "build/test_persistence_board_move_meta.conf", "", NULL),
@@ -1260,6 +1338,8 @@ WAMBLE_TESTS_BEGIN_NAMED(persistence_architecture_tests) {
   WAMBLE_TESTS_ADD_FM(
       persistence_prefix_reconciliation_preserves_retry_and_suffix,
       "persistence_architecture");
+  WAMBLE_TESTS_ADD_DB_FM(persistence_rating_run_applies_as_one_update,
+                         "persistence_architecture");
   WAMBLE_TESTS_ADD_DB_FM(persistence_board_move_meta_sql_executes,
                          "persistence_architecture");
 }
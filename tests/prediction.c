@@ -578,6 +578,256 @@ WAMBLE_TEST(prediction_max_pending_is_shared_for_same_branch_visibility) {
   return 0;
 }
 
+WAMBLE_TEST(prediction_resolution_and_lookup_are_scoped_per_board) {
+  const char *cfg_path = "build/test_prediction_board_index.conf";
+  const char *sql =
+      "INSERT INTO global_policy_rules "
+      "(global_identity_id, action, resource, scope, effect, permission_level, "
+      "reason, source) VALUES "
+      "(0, 'trust.tier', 'tier', '*', 'allow', 1, 'trust', 'test'), "
+      "(0, 'prediction.write', 'streak', '*', 'allow', 4, 'write', 'test');";
+  const char *start =
+      "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+  uint8_t token[TOKEN_LENGTH];
+  WambleBoard board_a;
+  WambleBoard board_b;
+  WamblePredictionView view;
+  uint64_t id_a = 0;
+  uint64_t id_b = 0;
+  uint64_t id_next = 0;
+
+  if (prediction_test_prepare_db_runtime(cfg_path, sql) != 0)
+    T_FAIL_SIMPLE("prediction_test_prepare_db_runtime failed");
+
+  prediction_test_fill_token(token, 0x31);
+  T_ASSERT_STATUS_OK(prediction_test_seed_session(token));
+  T_ASSERT_STATUS_OK(prediction_test_store_board(&board_a, 148, start));
+  T_ASSERT_STATUS_OK(prediction_test_store_board(&board_b, 149, start));
+
+  T_ASSERT_EQ_INT(
+      prediction_submit_with_parent(&board_a, token, "e2e4", 0, 0, &id_a),
+      PREDICTION_OK);
+  T_ASSERT_EQ_INT(
+      prediction_submit_with_parent(&board_b, token, "e2e4", 0, 0, &id_b),
+      PREDICTION_OK);
+
+  T_ASSERT_STATUS_OK(prediction_test_init_board(
+      &board_a, 148,
+      "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1"));
+  T_ASSERT_EQ_INT(prediction_resolve_move(&board_a, "e2e4"), PREDICTION_OK);
+  T_ASSERT_EQ_INT(prediction_get_view_by_id(id_a, &view), PREDICTION_OK);
+  T_ASSERT_STREQ(view.status, "CORRECT");
+  T_ASSERT_EQ_INT(prediction_get_view_by_id(id_b, &view), PREDICTION_OK);
+  T_ASSERT_STREQ(view.status, "PENDING");
+
+  prediction_expire_board(board_a.id);
+  T_ASSERT_EQ_INT(prediction_get_view_by_id(id_a, &view),
+                  PREDICTION_ERR_NOT_FOUND);
+  T_ASSERT_EQ_INT(prediction_get_view_by_id(id_b, &view), PREDICTION_OK);
+  T_ASSERT_EQ_INT((int)view.board_id, 149);
+
+  T_ASSERT_EQ_INT(
+      prediction_submit_with_parent(&board_a, token, "e7e5", 0, 0, &id_next),
+      PREDICTION_OK);
+  T_ASSERT_EQ_INT(prediction_get_view_by_id(id_next, &view), PREDICTION_OK);
+  T_ASSERT_EQ_INT(view.target_ply, 2);
+  T_ASSERT_STREQ(view.status, "PENDING");
+  return 0;
+}
+
+WAMBLE_TEST(prediction_tree_reads_list_parents_before_children) {
+  const char *cfg_path = "build/test_prediction_tree_order.conf";
+  const char *cfg = "(def prediction-mode 2)\n"
+                    "(def prediction-view-depth-limit 4)\n"
+                    "(def prediction-max-pending 4)\n"
+                    "(def prediction-max-per-parent 4)\n";
+  const char *sql =
+      "INSERT INTO global_policy_rules "
+      "(global_identity_id, action, resource, scope, effect, permission_level, "
+      "reason, source) VALUES "
+      "(0, 'trust.tier', 'tier', '*', 'allow', 1, 'trust', 'test'), "
+      "(0, 'prediction.write', 'streak', '*', 'allow', 4, 'write', 'test'), "
+      "(0, 'prediction.read', 'tree', '*', 'allow', 4, 'read', 'test');";
+  uint8_t token[TOKEN_LENGTH];
+  WambleBoard board;
+  uint64_t root_a = 0;
+  uint64_t root_b = 0;
+  uint64_t child = 0;
+  uint64_t grandchild = 0;
+  WamblePredictionView rows[16];
+  int count = 0;
+
+  if (prediction_test_prepare_db_runtime_with_cfg(cfg_path, cfg, sql) != 0)
+    T_FAIL_SIMPLE("prediction_test_prepare_db_runtime_with_cfg failed");
+
+  prediction_test_fill_token(token, 0x15);
+  T_ASSERT_STATUS_OK(prediction_test_seed_session(token));
+  T_ASSERT_STATUS_OK(prediction_test_store_board(
+      &board, 150, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
+
+  T_ASSERT_EQ_INT(
+      prediction_submit_with_parent(&board, token, "e2e4", 0, 0, &root_a),
+      PREDICTION_OK);
+  T_ASSERT_EQ_INT(
+      prediction_submit_with_parent(&board, token, "d2d4", 0, 0, &root_b),
+      PREDICTION_OK);
+  T_ASSERT_EQ_INT(
+      prediction_submit_with_parent(&board, token, "e7e5", root_a, 0, &child),
+      PREDICTION_OK);
+  T_ASSERT_EQ_INT(prediction_submit_with_parent(&board, token, "g1f3", child,
+                                                0, &grandchild),
+                  PREDICTION_OK);
+
+  T_ASSERT_EQ_INT(
+      prediction_collect_tree(board.id, token, 0, 4, rows, 16, &count),
+      PREDICTION_OK);
+  T_ASSERT_EQ_INT(count, 4);
+  T_ASSERT_EQ_INT((int)rows[0].id, (int)root_a);
+  T_ASSERT_EQ_INT((int)rows[1].id, (int)child);
+  T_ASSERT_EQ_INT((int)rows[2].id, (int)grandchild);
+  T_ASSERT_EQ_INT((int)rows[3].id, (int)root_b);
+
+  T_ASSERT_EQ_INT(
+      prediction_collect_tree(board.id, token, 0, 1, rows, 16, &count),
+      PREDICTION_OK);
+  T_ASSERT_EQ_INT(count, 3);
+  T_ASSERT(prediction_test_find_row(rows, count, grandchild) < 0);
+  return 0;
+}
+
+WAMBLE_TEST(prediction_deferred_resolution_runs_in_board_order) {
+  const char *cfg_path = "build/test_prediction_deferred.conf";
+  const char *sql =
+      "INSERT INTO global_policy_rules "
+      "(global_identity_id, action, resource, scope, effect, permission_level, "
+      "reason, source) VALUES "
+      "(0, 'trust.tier', 'tier', '*', 'allow', 1, 'trust', 'test'), "
+      "(0, 'prediction.write', 'streak', '*', 'allow', 4, 'write', 'test');";
+  const char *start =
+      "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+  const char *after_e4 =
+      "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1";
+  uint8_t token[TOKEN_LENGTH];
+  WambleBoard board_a;
+  WambleBoard board_b;
+  WamblePredictionView view;
+  uint64_t id_a = 0;
+  uint64_t id_b = 0;
+
+  if (prediction_test_prepare_db_runtime(cfg_path, sql) != 0)
+    T_FAIL_SIMPLE("prediction_test_prepare_db_runtime failed");
+
+  prediction_test_fill_token(token, 0x32);
+  T_ASSERT_STATUS_OK(prediction_test_seed_session(token));
+  T_ASSERT_STATUS_OK(prediction_test_store_board(&board_a, 151, start));
+  T_ASSERT_STATUS_OK(prediction_test_store_board(&board_b, 152, start));
+
+  T_ASSERT_EQ_INT(
+      prediction_submit_with_parent(&board_a, token, "e2e4", 0, 0, &id_a),
+      PREDICTION_OK);
+  T_ASSERT_EQ_INT(
+      prediction_submit_with_parent(&board_b, token, "e2e4", 0, 0, &id_b),
+      PREDICTION_OK);
+
+  T_ASSERT_STATUS_OK(prediction_test_init_board(&board_a, 151, after_e4));
+  T_ASSERT_STATUS_OK(prediction_test_init_board(&board_b, 152, after_e4));
+  T_ASSERT_EQ_INT(prediction_resolve_move_deferred(&board_a, "e2e4"),
+                  PREDICTION_OK);
+  T_ASSERT_EQ_INT(prediction_resolve_move_deferred(&board_b, "e2e4"),
+                  PREDICTION_OK);
+  prediction_expire_board(board_b.id);
+
+  T_ASSERT_EQ_INT(prediction_get_view_by_id(id_a, &view), PREDICTION_OK);
+  T_ASSERT_STREQ(view.status, "CORRECT");
+
+  T_ASSERT_EQ_INT(prediction_drain_deferred(1), 1);
+  T_ASSERT_EQ_INT(prediction_drain_deferred(0), 1);
+  T_ASSERT_EQ_INT(prediction_get_view_by_id(id_b, &view),
+                  PREDICTION_ERR_NOT_FOUND);
+  T_ASSERT_EQ_INT(prediction_drain_deferred(0), 0);
+  return 0;
+}
+
+WAMBLE_TEST(prediction_streaks_are_tracked_per_board_and_player) {
+  const char *cfg_path = "build/test_prediction_streak_table.conf";
+  const char *sql =
+      "INSERT INTO global_policy_rules "
+      "(global_identity_id, action, resource, scope, effect, permission_level, "
+      "reason, source) VALUES "
+      "(0, 'trust.tier', 'tier', '*', 'allow', 1, 'trust', 'test'), "
+      "(0, 'prediction.write', 'streak', '*', 'allow', 4, 'write', 'test');";
+  const char *start =
+      "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+  uint8_t steady[TOKEN_LENGTH];
+  uint8_t skipper[TOKEN_LENGTH];
+  WambleBoard board_a;
+  WambleBoard board_b;
+  WamblePredictionView view;
+  uint64_t id_a = 0;
+  uint64_t id_b = 0;
+  uint64_t id_skip = 0;
+
+  if (prediction_test_prepare_db_runtime(cfg_path, sql) != 0)
+    T_FAIL_SIMPLE("prediction_test_prepare_db_runtime failed");
+
+  prediction_test_fill_token(steady, 0x33);
+  prediction_test_fill_token(skipper, 0x34);
+  T_ASSERT_STATUS_OK(prediction_test_seed_session(steady));
+  T_ASSERT_STATUS_OK(prediction_test_seed_session(skipper));
+  T_ASSERT_STATUS_OK(prediction_test_store_board(&board_a, 153, start));
+  T_ASSERT_STATUS_OK(prediction_test_store_board(&board_b, 154, start));
+
+  T_ASSERT_EQ_INT(prediction_submit(&board_a, steady, "e2e4", 0),
+                  PREDICTION_OK);
+  T_ASSERT_EQ_INT(prediction_submit(&board_a, skipper, "e2e4", 0),
+                  PREDICTION_OK);
+  T_ASSERT_EQ_INT(prediction_submit(&board_b, steady, "e2e4", 0),
+                  PREDICTION_OK);
+  T_ASSERT_STATUS_OK(prediction_test_init_board(
+      &board_a, 153,
+      "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1"));
+  T_ASSERT_STATUS_OK(prediction_test_init_board(
+      &board_b, 154,
+      "rnbqkbnr/pppppppp/8/8/3P4/8/PPP1PPPP/RNBQKBNR b KQkq - 0 1"));
+  T_ASSERT_EQ_INT(prediction_resolve_move(&board_a, "e2e4"), PREDICTION_OK);
+  T_ASSERT_EQ_INT(prediction_resolve_move(&board_b, "d2d4"), PREDICTION_OK);
+
+  T_ASSERT_EQ_INT(
+      prediction_submit_with_parent(&board_a, steady, "e7e5", 0, 0, &id_a),
+      PREDICTION_OK);
+  T_ASSERT_EQ_INT(
+      prediction_submit_with_parent(&board_b, steady, "e7e5", 0, 0, &id_b),
+      PREDICTION_OK);
+  T_ASSERT_STATUS_OK(prediction_test_init_board(
+      &board_a, 153,
+      "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2"));
+  T_ASSERT_STATUS_OK(prediction_test_init_board(
+      &board_b, 154,
+      "rnbqkbnr/pppp1ppp/8/4p3/3P4/8/PPP1PPPP/RNBQKBNR w KQkq - 0 2"));
+  T_ASSERT_EQ_INT(prediction_resolve_move(&board_a, "e7e5"), PREDICTION_OK);
+  T_ASSERT_EQ_INT(prediction_resolve_move(&board_b, "e7e5"), PREDICTION_OK);
+  T_ASSERT_EQ_INT(prediction_get_view_by_id(id_a, &view), PREDICTION_OK);
+  T_ASSERT(fabs(view.points_awarded - 2.0) < 0.001);
+  T_ASSERT_EQ_INT(prediction_get_view_by_id(id_b, &view), PREDICTION_OK);
+  T_ASSERT(fabs(view.points_awarded - 1.0) < 0.001);
+
+  T_ASSERT_EQ_INT(
+      prediction_submit_with_parent(&board_a, steady, "g1f3", 0, 0, &id_a),
+      PREDICTION_OK);
+  T_ASSERT_EQ_INT(prediction_submit_with_parent(&board_a, skipper, "g1f3", 0,
+                                                0, &id_skip),
+                  PREDICTION_OK);
+  T_ASSERT_STATUS_OK(prediction_test_init_board(
+      &board_a, 153,
+      "rnbqkbnr/pppp1ppp/8/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 1 2"));
+  T_ASSERT_EQ_INT(prediction_resolve_move(&board_a, "g1f3"), PREDICTION_OK);
+  T_ASSERT_EQ_INT(prediction_get_view_by_id(id_a, &view), PREDICTION_OK);
+  T_ASSERT(fabs(view.points_awarded - 4.0) < 0.001);
+  T_ASSERT_EQ_INT(prediction_get_view_by_id(id_skip, &view), PREDICTION_OK);
+  T_ASSERT(fabs(view.points_awarded - 1.0) < 0.001);
+  return 0;
+}
+
 WAMBLE_TESTS_BEGIN_NAMED(prediction_tests) {
   WAMBLE_TESTS_ADD_FM(prediction_config_loads_prediction_options, "prediction");
   WAMBLE_TESTS_ADD_DB_EX_SM(prediction_tree_children_advance_target_ply,
@@ -604,5 +854,17 @@ WAMBLE_TESTS_BEGIN_NAMED(prediction_tests) {
   WAMBLE_TESTS_ADD_DB_EX_SM(
       prediction_max_pending_is_shared_for_same_branch_visibility,
       WAMBLE_SUITE_FUNCTIONAL, "prediction", NULL, prediction_test_teardown, 0);
+  WAMBLE_TESTS_ADD_DB_EX_SM(
+      prediction_resolution_and_lookup_are_scoped_per_board,
+      WAMBLE_SUITE_FUNCTIONAL, "prediction", NULL, prediction_test_teardown, 0);
+  WAMBLE_TESTS_ADD_DB_EX_SM(prediction_tree_reads_list_parents_before_children,
+                            WAMBLE_SUITE_FUNCTIONAL, "prediction", NULL,
+                            prediction_test_teardown, 0);
+  WAMBLE_TESTS_ADD_DB_EX_SM(prediction_deferred_resolution_runs_in_board_order,
+                            WAMBLE_SUITE_FUNCTIONAL, "prediction", NULL,
+                            prediction_test_teardown, 0);
+  WAMBLE_TESTS_ADD_DB_EX_SM(
+      prediction_streaks_are_tracked_per_board_and_player,
+      WAMBLE_SUITE_FUNCTIONAL, "prediction", NULL, prediction_test_teardown, 0);
 }
 WAMBLE_TESTS_END()
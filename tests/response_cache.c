@@ -0,0 +1,119 @@
+#include "common/wamble_test.h"
+#include "wamble/wamble.h"
+
+static int rc_test_store(int ns, int key, uint64_t tag, size_t value_len) {
+  unsigned char value[1024];
+  memset(value, key & 0xff, sizeof(value));
+  return response_cache_store(ns, &key, sizeof(key), tag, value, value_len)
+             ? 0
+             : -1;
+}
+
+static int rc_test_present(int ns, int key) {
+  size_t len = 0;
+  const unsigned char *v =
+      (const unsigned char *)response_cache_lookup(ns, &key, sizeof(key), &len);
+  return v && len > 0 && v[0] == (unsigned char)(key & 0xff);
+}
+
+WAMBLE_TEST(response_cache_evicts_lru_and_honours_generations) {
+  WambleConfig cfg = *get_config();
+  cfg.response_cache_bytes = 100000;
+  set_thread_config(&cfg);
+  response_cache_clear();
+  const int ns = WAMBLE_RESPONSE_CACHE_TRUST_TIER;
+  WambleResponseCacheStats stats;
+
+  T_ASSERT(!rc_test_present(ns, 1));
+  for (int key = 1; key <= 4; key++)
+    T_ASSERT_EQ_INT(rc_test_store(ns, key, 7, 1000), 0);
+  T_ASSERT(rc_test_present(ns, 1));
+  T_ASSERT_EQ_INT(rc_test_store(ns, 5, 7, 1000), 0);
+  T_ASSERT(rc_test_present(ns, 1));
+  T_ASSERT(!rc_test_present(ns, 2));
+  T_ASSERT(rc_test_present(ns, 5));
+  T_ASSERT(!rc_test_present(WAMBLE_RESPONSE_CACHE_SESSION_CAPS, 5));
+  response_cache_stats(ns, &stats);
+  T_ASSERT(stats.evictions >= 1);
+  T_ASSERT(stats.hits >= 3);
+  T_ASSERT(stats.bytes <= 5000);
+
+  cfg.response_cache_bytes = 1000;
+  T_ASSERT_EQ_INT(rc_test_store(ns, 9, 0, 1000), -1);
+  cfg.response_cache_bytes = 100000;
+
+  T_ASSERT_EQ_INT(rc_test_store(ns, 8, 3, 16), 0);
+  response_cache_invalidate_tag(WAMBLE_RESPONSE_CACHE_NAMESPACE_COUNT, 7);
+  T_ASSERT(!rc_test_present(ns, 1));
+  T_ASSERT(!rc_test_present(ns, 5));
+  T_ASSERT(rc_test_present(ns, 8));
+
+  int key = 8;
+  response_cache_invalidate(ns, &key, sizeof(key));
+  T_ASSERT(!rc_test_present(ns, 8));
+
+  T_ASSERT_EQ_INT(rc_test_store(ns, 10, 0, 16), 0);
+  T_ASSERT_EQ_INT(rc_test_store(WAMBLE_RESPONSE_CACHE_PROFILE_TERMS, 10, 0, 16),
+                  0);
+  response_cache_bump_generation(ns);
+  T_ASSERT(!rc_test_present(ns, 10));
+  T_ASSERT(rc_test_present(WAMBLE_RESPONSE_CACHE_PROFILE_TERMS, 10));
+
+  cfg.response_cache_bytes = 64 * 1024 * 1024;
+  for (int i = 0; i < 4000; i++)
+    T_ASSERT_EQ_INT(rc_test_store(WAMBLE_RESPONSE_CACHE_LEADERBOARD, i, 0, 8),
+                    0);
+  for (int i = 0; i < 4000; i++)
+    T_ASSERT(rc_test_present(WAMBLE_RESPONSE_CACHE_LEADERBOARD, i));
+  response_cache_stats(WAMBLE_RESPONSE_CACHE_LEADERBOARD, &stats);
+  T_ASSERT_EQ_INT(stats.entries, 4000);
+  T_ASSERT(stats.hits == 4000);
+
+  response_cache_clear();
+  response_cache_stats(WAMBLE_RESPONSE_CACHE_NAMESPACE_COUNT, &stats);
+  T_ASSERT_EQ_INT(stats.entries, 0);
+  set_thread_config(NULL);
+  return 0;
+}
+
+WAMBLE_TEST(response_cache_invalidates_tag_by_key_prefix) {
+  WambleConfig cfg = *get_config();
+  cfg.response_cache_bytes = 1024 * 1024;
+  set_thread_config(&cfg);
+  response_cache_clear();
+  const int ns = WAMBLE_RESPONSE_CACHE_SESSION_CAPS;
+  const char *keys[] = {"tok/alpha/1", "tok/alpha/2", "tok/beta/1",
+                        "other/alpha/1"};
+  const uint64_t tags[] = {11, 11, 11, 12};
+  int value = 1;
+  for (int i = 0; i < 4; i++)
+    T_ASSERT(response_cache_store(ns, keys[i], strlen(keys[i]), tags[i],
+                                  &value, sizeof(value)) != NULL);
+  for (int i = 0; i < 600; i++)
+    T_ASSERT_EQ_INT(rc_test_store(ns, i, (uint64_t)(1000 + i), 8), 0);
+
+  response_cache_invalidate_tag_prefix(ns, 11, "tok/alpha/", 10);
+  size_t len = 0;
+  T_ASSERT(!response_cache_lookup(ns, keys[0], strlen(keys[0]), &len));
+  T_ASSERT(!response_cache_lookup(ns, keys[1], strlen(keys[1]), &len));
+  T_ASSERT(response_cache_lookup(ns, keys[2], strlen(keys[2]), &len));
+  T_ASSERT(response_cache_lookup(ns, keys[3], strlen(keys[3]), &len));
+
+  response_cache_invalidate_tag(WAMBLE_RESPONSE_CACHE_NAMESPACE_COUNT, 11);
+  T_ASSERT(!response_cache_lookup(ns, keys[2], strlen(keys[2]), &len));
+  T_ASSERT(response_cache_lookup(ns, keys[3], strlen(keys[3]), &len));
+  for (int i = 0; i < 600; i++)
+    T_ASSERT(rc_test_present(ns, i));
+
+  response_cache_clear();
+  set_thread_config(NULL);
+  return 0;
+}
+
+WAMBLE_TESTS_BEGIN_NAMED(response_cache_tests) {
+  WAMBLE_TESTS_ADD_FM(response_cache_evicts_lru_and_honours_generations,
+                      "response_cache");
+  WAMBLE_TESTS_ADD_FM(response_cache_invalidates_tag_by_key_prefix,
+                      "response_cache");
+}
+WAMBLE_TESTS_END()
@@ -128,8 +128,10 @@ WAMBLE_TEST(spectator_summary_updates_emit_full_snapshots) {
   spectator_manager_tick();
   wamble_sleep_ms(2);
 
+  char full_mode[] = "full";
   WambleConfig cfg = *get_config();
   cfg.spectator_summary_hz = 1000;
+  cfg.spectator_summary_mode = full_mode;
   wamble_config_push(&cfg);
   count = spectator_collect_updates(updates, 32);
   wamble_config_pop();
@@ -747,8 +749,10 @@ WAMBLE_TEST(spectator_truncated_summary_retries_next_tick) {
   }
   T_ASSERT(saw_a != saw_b);
 
+  char full_mode[] = "full";
   WambleConfig cfg = *get_config();
   cfg.spectator_summary_hz = 1000;
+  cfg.spectator_summary_mode = full_mode;
   wamble_config_push(&cfg);
   wamble_sleep_ms(2);
   SpectatorUpdate updates2[16];
@@ -839,9 +843,315 @@ WAMBLE_TEST(spectator_truncated_focus_retries_next_tick) {
     if (tokens_equal(updates2[i].token, token_b))
       saw_b = 1;
   }
-  T_ASSERT(saw_a);
-  T_ASSERT(saw_b);
+  T_ASSERT(served_a ? saw_b : saw_a);
+  T_ASSERT(!(served_a ? saw_a : saw_b));
 
+  board_move_played(served_a ? board_a->id : board_b->id, NULL, NULL);
+  wamble_config_push(&cfg);
+  wamble_sleep_ms(2);
+  count2 = spectator_collect_updates(updates2, 8);
+  wamble_config_pop();
+  T_ASSERT_EQ_INT(count2, 1);
+  T_ASSERT(tokens_equal(updates2[0].token, served));
+
+  spectator_manager_shutdown();
+  return 0;
+}
+
+WAMBLE_TEST(spectator_focus_updates_follow_board_changes) {
+  char msg[128];
+  T_ASSERT_STATUS(config_load(NULL, NULL, msg, sizeof(msg)),
+                  CONFIG_LOAD_DEFAULTS);
+  spectator_manager_init();
+  board_manager_init();
+  player_manager_init();
+
+  WamblePlayer *player_a = create_new_player();
+  WamblePlayer *player_b = create_new_player();
+  T_ASSERT(player_a != NULL);
+  T_ASSERT(player_b != NULL);
+  WambleBoard *board_a = find_board_for_player(player_a);
+  WambleBoard *board_b = find_board_for_player(player_b);
+  T_ASSERT(board_a != NULL);
+  T_ASSERT(board_b != NULL);
+  uint64_t id_a = board_a->id;
+  uint64_t id_b = board_b->id;
+  board_move_played(id_a, NULL, NULL);
+  board_move_played(id_b, NULL, NULL);
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((uint16_t)get_config()->port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  uint8_t tokens[3][TOKEN_LENGTH] = {{41}, {42}, {43}};
+  struct WambleMsg req = {0};
+  req.ctrl = WAMBLE_CTRL_SPECTATE_GAME;
+  SpectatorState state = SPECTATOR_STATE_IDLE;
+  uint64_t focus = 0;
+  for (int i = 0; i < 3; i++) {
+    req.board_id = i < 2 ? id_a : id_b;
+    memcpy(req.token, tokens[i], TOKEN_LENGTH);
+    T_ASSERT_EQ_INT(
+        spectator_handle_request(&req, &addr, 0, 0, 1, &state, &focus),
+        SPECTATOR_OK_FOCUS);
+  }
+
+  SpectatorUpdate updates[8];
+  T_ASSERT_EQ_INT(spectator_collect_updates(updates, 8), 3);
+
+  WambleConfig cfg = *get_config();
+  cfg.spectator_focus_hz = 1000;
+  wamble_config_push(&cfg);
+  wamble_sleep_ms(2);
+  spectator_manager_tick();
+  T_ASSERT_EQ_INT(spectator_collect_updates(updates, 8), 0);
+
+  board_move_played(id_a, NULL, NULL);
+  wamble_sleep_ms(2);
+  int count = spectator_collect_updates(updates, 8);
+  T_ASSERT_EQ_INT(count, 2);
+  for (int i = 0; i < count; i++)
+    T_ASSERT_EQ_INT((int)updates[i].board_id, (int)id_a);
+
+  board_game_completed(id_b, GAME_RESULT_WHITE_WINS);
+  SpectatorUpdate notices[4];
+  count = spectator_collect_notifications(notices, 4);
+  T_ASSERT_EQ_INT(count, 1);
+  T_ASSERT(tokens_equal(notices[0].token, tokens[2]));
+  T_ASSERT_EQ_INT((int)notices[0].board_id, (int)id_b);
+  T_ASSERT((notices[0].flags & WAMBLE_FLAG_SPECTATE_NOTICE_SUMMARY_FALLBACK) !=
+           0);
+  T_ASSERT_EQ_INT(spectator_get_state_by_token(tokens[2], &state, &focus), 0);
+  T_ASSERT_EQ_INT(state, SPECTATOR_STATE_SUMMARY);
+  T_ASSERT_EQ_INT(spectator_get_state_by_token(tokens[0], &state, &focus), 0);
+  T_ASSERT_EQ_INT(state, SPECTATOR_STATE_FOCUS);
+
+  wamble_config_pop();
+  spectator_manager_shutdown();
+  return 0;
+}
+
+static int collect_summary_board_ids(const uint8_t *token, uint64_t *ids,
+                                     int max) {
+  char full_mode[] = "full";
+  WambleConfig cfg = *get_config();
+  cfg.spectator_summary_hz = 1000;
+  cfg.spectator_summary_mode = full_mode;
+  wamble_config_push(&cfg);
+  wamble_sleep_ms(2);
+  SpectatorUpdate updates[16];
+  int count = spectator_collect_updates(updates, 16);
+  wamble_config_pop();
+  int n = 0;
+  for (int i = 0; i < count && n < max; i++) {
+    if (tokens_equal(updates[i].token, token) && updates[i].board_id > 0)
+      ids[n++] = updates[i].board_id;
+  }
+  return n;
+}
+
+WAMBLE_TEST(spectator_summary_ranking_tracks_board_changes) {
+  char msg[128];
+  T_ASSERT_STATUS(config_load(NULL, NULL, msg, sizeof(msg)),
+                  CONFIG_LOAD_DEFAULTS);
+  spectator_manager_init();
+  board_manager_init();
+  player_manager_init();
+
+  WamblePlayer *player_a = create_new_player();
+  WamblePlayer *player_b = create_new_player();
+  T_ASSERT(player_a != NULL);
+  T_ASSERT(player_b != NULL);
+  WambleBoard *board_a = find_board_for_player(player_a);
+  WambleBoard *board_b = find_board_for_player(player_b);
+  T_ASSERT(board_a != NULL);
+  T_ASSERT(board_b != NULL);
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((uint16_t)get_config()->port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  uint8_t token[TOKEN_LENGTH] = {51};
+  struct WambleMsg req = {0};
+  req.ctrl = WAMBLE_CTRL_SPECTATE_GAME;
+  memcpy(req.token, token, TOKEN_LENGTH);
+  SpectatorState state = SPECTATOR_STATE_IDLE;
+  uint64_t focus = 0;
+  T_ASSERT_EQ_INT(
+      spectator_handle_request(&req, &addr, 0, 0, 1, &state, &focus),
+      SPECTATOR_OK_SUMMARY);
+
+  uint64_t ids[8];
+  T_ASSERT_EQ_INT(collect_summary_board_ids(token, ids, 8), 2);
+
+  time_t now = wamble_now_wall();
+  board_a->last_move_time = now + 20;
+  spectator_board_changed(board_a->id);
+  T_ASSERT_EQ_INT(collect_summary_board_ids(token, ids, 8), 2);
+  T_ASSERT_EQ_INT((int)ids[0], (int)board_a->id);
+  T_ASSERT_EQ_INT((int)ids[1], (int)board_b->id);
+
+  board_b->last_move_time = now + 40;
+  spectator_board_changed(board_b->id);
+  T_ASSERT_EQ_INT(collect_summary_board_ids(token, ids, 8), 2);
+  T_ASSERT_EQ_INT((int)ids[0], (int)board_b->id);
+  T_ASSERT_EQ_INT((int)ids[1], (int)board_a->id);
+
+  board_release_reservation(board_b->id);
+  T_ASSERT_EQ_INT(collect_summary_board_ids(token, ids, 8), 1);
+  T_ASSERT_EQ_INT((int)ids[0], (int)board_a->id);
+
+  spectator_manager_shutdown();
+  return 0;
+}
+
+WAMBLE_TEST(spectator_summary_ranking_reorders_tied_boards) {
+  char msg[128];
+  T_ASSERT_STATUS(config_load(NULL, NULL, msg, sizeof(msg)),
+                  CONFIG_LOAD_DEFAULTS);
+  spectator_manager_init();
+  board_manager_init();
+  player_manager_init();
+
+  enum { BOARDS = 4 };
+  WambleBoard *boards[BOARDS];
+  time_t now = wamble_now_wall();
+  for (int i = 0; i < BOARDS; i++) {
+    WamblePlayer *player = create_new_player();
+    T_ASSERT(player != NULL);
+    boards[i] = find_board_for_player(player);
+    T_ASSERT(boards[i] != NULL);
+  }
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((uint16_t)get_config()->port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  uint8_t token[TOKEN_LENGTH] = {57};
+  struct WambleMsg req = {0};
+  req.ctrl = WAMBLE_CTRL_SPECTATE_GAME;
+  memcpy(req.token, token, TOKEN_LENGTH);
+  SpectatorState state = SPECTATOR_STATE_IDLE;
+  uint64_t focus = 0;
+  T_ASSERT_EQ_INT(
+      spectator_handle_request(&req, &addr, 0, 0, 1, &state, &focus),
+      SPECTATOR_OK_SUMMARY);
+
+  for (int i = 0; i < BOARDS; i++) {
+    boards[i]->last_move_time = now + 10;
+    spectator_board_changed(boards[i]->id);
+  }
+  const int moved[] = {3, 0, 2, 3};
+  for (int m = 0; m < 4; m++) {
+    boards[moved[m]]->last_move_time = now + 100 + m;
+    spectator_board_changed(boards[moved[m]]->id);
+  }
+
+  uint64_t ids[8];
+  T_ASSERT_EQ_INT(collect_summary_board_ids(token, ids, 8), BOARDS);
+  T_ASSERT_EQ_INT((int)ids[0], (int)boards[3]->id);
+  T_ASSERT_EQ_INT((int)ids[1], (int)boards[2]->id);
+  T_ASSERT_EQ_INT((int)ids[2], (int)boards[0]->id);
+  T_ASSERT_EQ_INT((int)ids[3], (int)boards[1]->id);
+
+  board_release_reservation(boards[2]->id);
+  T_ASSERT_EQ_INT(collect_summary_board_ids(token, ids, 8), BOARDS - 1);
+  T_ASSERT_EQ_INT((int)ids[0], (int)boards[3]->id);
+  T_ASSERT_EQ_INT((int)ids[1], (int)boards[0]->id);
+
+  spectator_manager_shutdown();
+  return 0;
+}
+
+WAMBLE_TEST(spectator_summary_changes_mode_sends_deltas) {
+  char msg[128];
+  T_ASSERT_STATUS(config_load(NULL, NULL, msg, sizeof(msg)),
+                  CONFIG_LOAD_DEFAULTS);
+  spectator_manager_init();
+  board_manager_init();
+  player_manager_init();
+
+  WamblePlayer *player_a = create_new_player();
+  WamblePlayer *player_b = create_new_player();
+  T_ASSERT(player_a != NULL);
+  T_ASSERT(player_b != NULL);
+  WambleBoard *board_a = find_board_for_player(player_a);
+  WambleBoard *board_b = find_board_for_player(player_b);
+  T_ASSERT(board_a != NULL);
+  T_ASSERT(board_b != NULL);
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((uint16_t)get_config()->port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  uint8_t token[TOKEN_LENGTH] = {61};
+  struct WambleMsg req = {0};
+  req.ctrl = WAMBLE_CTRL_SPECTATE_GAME;
+  memcpy(req.token, token, TOKEN_LENGTH);
+  SpectatorState state = SPECTATOR_STATE_IDLE;
+  uint64_t focus = 0;
+  T_ASSERT_EQ_INT(
+      spectator_handle_request(&req, &addr, 0, 0, 1, &state, &focus),
+      SPECTATOR_OK_SUMMARY);
+
+  char changes_mode[] = "changes";
+  WambleConfig cfg = *get_config();
+  cfg.spectator_summary_hz = 1000;
+  cfg.spectator_summary_mode = changes_mode;
+  wamble_config_push(&cfg);
+
+  SpectatorUpdate updates[16];
+  int count = spectator_collect_updates(updates, 16);
+  T_ASSERT_EQ_INT(count, 3);
+  T_ASSERT_EQ_INT((int)updates[0].board_id, 0);
+  T_ASSERT_EQ_INT((int)updates[0].summary_base_generation, 0);
+  uint64_t gen0 = updates[0].summary_generation;
+  T_ASSERT(gen0 > 0);
+
+  wamble_sleep_ms(2);
+  T_ASSERT_EQ_INT(spectator_collect_updates(updates, 16), 0);
+
+  board_a->last_move_time = wamble_now_wall() + 20;
+  spectator_board_changed(board_a->id);
+  wamble_sleep_ms(2);
+  count = spectator_collect_updates(updates, 16);
+  T_ASSERT_EQ_INT(count, 2);
+  T_ASSERT_EQ_INT((int)updates[0].board_id, 0);
+  T_ASSERT_EQ_INT((int)updates[0].summary_base_generation, (int)gen0);
+  T_ASSERT_EQ_INT((int)updates[1].board_id, (int)board_a->id);
+  T_ASSERT(updates[1].fen[0] != '\0');
+  uint64_t gen1 = updates[0].summary_generation;
+  T_ASSERT(gen1 > gen0);
+
+  board_release_reservation(board_b->id);
+  wamble_sleep_ms(2);
+  count = spectator_collect_updates(updates, 16);
+  T_ASSERT_EQ_INT(count, 2);
+  T_ASSERT_EQ_INT((int)updates[0].summary_base_generation, (int)gen1);
+  T_ASSERT_EQ_INT((int)updates[1].board_id, (int)board_b->id);
+  T_ASSERT_EQ_INT(updates[1].fen[0], '\0');
+  uint64_t gen2 = updates[0].summary_generation;
+
+  board_release_reservation(board_a->id);
+  board_a->state = BOARD_STATE_ACTIVE;
+  board_a->last_move_time = wamble_now_wall() + 30;
+  spectator_board_changed(board_a->id);
+  wamble_sleep_ms(2);
+  count = spectator_collect_updates(updates, 16);
+  T_ASSERT_EQ_INT(count, 2);
+  T_ASSERT_EQ_INT((int)updates[0].summary_base_generation, (int)gen2);
+  T_ASSERT_EQ_INT((int)updates[1].board_id, (int)board_a->id);
+  T_ASSERT(updates[1].fen[0] != '\0');
+
+  wamble_config_pop();
   spectator_manager_shutdown();
   return 0;
 }
@@ -918,6 +1228,14 @@ WAMBLE_TESTS_BEGIN_NAMED(spectator_tests) {
   WAMBLE_TESTS_ADD_FM(spectator_truncated_summary_retries_next_tick,
                       "spectator");
   WAMBLE_TESTS_ADD_FM(spectator_truncated_focus_retries_next_tick, "spectator");
+  WAMBLE_TESTS_ADD_FM(spectator_focus_updates_follow_board_changes,
+                      "spectator");
+  WAMBLE_TESTS_ADD_FM(spectator_summary_ranking_tracks_board_changes,
+                      "spectator");
+  WAMBLE_TESTS_ADD_FM(spectator_summary_ranking_reorders_tied_boards,
+                      "spectator");
+  WAMBLE_TESTS_ADD_FM(spectator_summary_changes_mode_sends_deltas,
+                      "spectator");
   WAMBLE_TESTS_ADD_FM(
       spectator_focus_render_does_not_refresh_last_mover_liveness, "spectator");
 }